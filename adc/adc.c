@@ -29,6 +29,11 @@
 #include <stdio.h>
 #include <string.h>
 
+/* Size of the memory buffer given to Mira */
+#ifndef MIRA_MEM_BUFFER_SIZE
+#define MIRA_MEM_BUFFER_SIZE 7592
+#endif
+
 /*
  * ADC example.
  */
@@ -44,7 +49,7 @@ PROCESS(main_proc, "Main process");
 
 void mira_setup(void)
 {
-    MIRA_MEM_SET_BUFFER(7592);
+    MIRA_MEM_SET_BUFFER(MIRA_MEM_BUFFER_SIZE);
 
     mira_uart_config_t uart_config = { .baudrate = 115200,
                                        .tx_pin = MIRA_GPIO_PIN(0, 6),
@@ -31,6 +31,13 @@
 #include <string.h>
 #include "ble_led.h"
 #include "ble_app.h"
+#include "net_watch.h"
+#include "tx_queue.h"
+
+/* Size of the memory buffer given to Mira */
+#ifndef MIRA_MEM_BUFFER_SIZE
+#define MIRA_MEM_BUFFER_SIZE 8616
+#endif
 
 #define UART_ACTIVE (1)
 #define UART_TX_PORT (0)
@@ -47,7 +54,6 @@
 
 #define UDP_PORT 456
 #define MIRA_SEND_INTERVAL_S 60
-#define MIRA_CHECK_NET_INTERVAL_S 5
 
 MIRA_IODEFS(MIRA_IODEF_NONE,
 #if UART_ACTIVE
@@ -91,7 +97,7 @@ static const mira_net_config_t net_config = {
 
 void mira_setup(void)
 {
-    MIRA_MEM_SET_BUFFER(8616);
+    MIRA_MEM_SET_BUFFER(MIRA_MEM_BUFFER_SIZE);
 
 #if UART_ACTIVE
     mira_uart_config_t uart_config = { .baudrate = 115200,
@@ -179,10 +185,10 @@ PROCESS_THREAD(mira_proc, ev, data)
 
     static mira_net_udp_connection_t* udp_connection;
 
-    static mira_net_address_t net_address;
+    static const net_watch_info_t* net;
     static char buffer[MIRA_NET_MAX_ADDRESS_STR_LEN];
-    static mira_status_t res;
     static const char* message = "Hello Network";
+    static bool sending;
 
     PROCESS_BEGIN();
     /* Pause once, so we don't run anything before finish of startup */
@@ -204,36 +210,41 @@ PROCESS_THREAD(mira_proc, ev, data)
      */
     udp_connection = mira_net_udp_connect(NULL, 0, udp_listen_callback, NULL);
 
+    /* Send through the prioritized TX queue, which waits for room in the MAC queue */
+    tx_queue_init(udp_connection);
+
+    /* Get an event when the network state changes, instead of polling it */
+    net_watch_init();
+    net_watch_subscribe(&mira_proc);
+
     while (1) {
-        mira_net_state_t net_state = mira_net_get_state();
-
-        if (net_state != MIRA_NET_STATE_JOINED) {
-            printf("Waiting for network (state is %s)\n",
-                   net_state == MIRA_NET_STATE_NOT_ASSOCIATED ? "not associated"
-                   : net_state == MIRA_NET_STATE_ASSOCIATED   ? "associated"
-                   : net_state == MIRA_NET_STATE_JOINED       ? "joined"
-                                                              : "UNKNOWN");
-            etimer_set(&timer, MIRA_CHECK_NET_INTERVAL_S * CLOCK_SECOND);
-        } else {
-            /* Try to retrieve the root address. */
-            res = mira_net_get_root_address(&net_address);
-
-            if (res != MIRA_SUCCESS) {
-                printf("Waiting for root address (res: %d)\n", res);
-                etimer_set(&timer, MIRA_CHECK_NET_INTERVAL_S * CLOCK_SECOND);
-            } else {
-                /*
-                 * Root address is successfully retrieved, send a message to the
-                 * root node on the given UDP Port.
-                 */
-                printf("Sending to address: %s\n",
-                       mira_net_toolkit_format_address(buffer, &net_address));
-                mira_net_udp_send_to(
-                  udp_connection, &net_address, UDP_PORT, message, strlen(message));
-                etimer_set(&timer, MIRA_SEND_INTERVAL_S * CLOCK_SECOND);
+        PROCESS_WAIT_EVENT_UNTIL(ev == net_watch_event || ev == PROCESS_EVENT_TIMER);
+        net = net_watch_get();
+
+        if (ev == net_watch_event) {
+            if (net->state != MIRA_NET_STATE_JOINED || !net->has_root) {
+                if ((net_watch_change_t)(uintptr_t)data == NET_WATCH_STATE_CHANGED) {
+                    printf("Waiting for network (state is %s)\n",
+                           net->state == MIRA_NET_STATE_NOT_ASSOCIATED ? "not associated"
+                           : net->state == MIRA_NET_STATE_ASSOCIATED   ? "associated"
+                           : net->state == MIRA_NET_STATE_JOINED       ? "joined"
+                                                                       : "UNKNOWN");
+                }
+                etimer_stop(&timer);
+                sending = false;
+                continue;
+            }
+            if (sending) {
+                continue;
             }
+            /* Just joined, send right away */
+            sending = true;
         }
-        PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&timer));
+
+        /* Send a message to the root node on the given UDP Port. */
+        printf("Sending to address: %s\n", mira_net_toolkit_format_address(buffer, &net->root));
+        tx_queue_send(TX_QUEUE_NORMAL, &net->root, UDP_PORT, message, strlen(message));
+        etimer_set(&timer, MIRA_SEND_INTERVAL_S * CLOCK_SECOND);
     }
 
     mira_net_udp_close(udp_connection);
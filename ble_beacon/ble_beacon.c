@@ -27,6 +27,11 @@
 
 #include <mira.h>
 
+/* Size of the memory buffer given to Mira */
+#ifndef MIRA_MEM_BUFFER_SIZE
+#define MIRA_MEM_BUFFER_SIZE 7592
+#endif
+
 /**
  * Static Eddystone-URL payload
  */
@@ -46,7 +51,7 @@ PROCESS(main_proc, "Main process");
 
 void mira_setup(void)
 {
-    MIRA_MEM_SET_BUFFER(7592);
+    MIRA_MEM_SET_BUFFER(MIRA_MEM_BUFFER_SIZE);
     process_start(&main_proc, NULL);
 }
 
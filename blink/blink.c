@@ -28,6 +28,11 @@
 #include <mira.h>
 #include <stdio.h>
 
+/* Size of the memory buffer given to Mira */
+#ifndef MIRA_MEM_BUFFER_SIZE
+#define MIRA_MEM_BUFFER_SIZE 7592
+#endif
+
 #if MIRA_PLATFORM_MKW41Z
 #define LED1_PIN MIRA_GPIO_PIN('B', 0)
 #define LED2_PIN MIRA_GPIO_PIN('C', 1)
@@ -46,7 +51,7 @@ PROCESS(main_proc, "Main process");
 
 void mira_setup(void)
 {
-    MIRA_MEM_SET_BUFFER(7592);
+    MIRA_MEM_SET_BUFFER(MIRA_MEM_BUFFER_SIZE);
 
     mira_gpio_set_dir(LED1_PIN, MIRA_GPIO_DIR_OUT);
     mira_gpio_set_dir(LED2_PIN, MIRA_GPIO_DIR_OUT);
@@ -29,6 +29,11 @@
 #include <stdbool.h>
 #include <stdio.h>
 
+/* Size of the memory buffer given to Mira */
+#ifndef MIRA_MEM_BUFFER_SIZE
+#define MIRA_MEM_BUFFER_SIZE 14944
+#endif
+
 #if nrf52832 || nrf52832ble
 #define LED1_PIN MIRA_GPIO_PIN(0, 17)
 #define LED2_PIN MIRA_GPIO_PIN(0, 18)
@@ -99,7 +104,7 @@ void mira_setup(void)
 {
     mira_gpio_set_dir(LED_BLINK_PIN, MIRA_GPIO_DIR_OUT);
 
-    MIRA_MEM_SET_BUFFER(14944);
+    MIRA_MEM_SET_BUFFER(MIRA_MEM_BUFFER_SIZE);
 
     process_start(&main_proc, NULL);
     process_start(&time_callback_scheduler, NULL);
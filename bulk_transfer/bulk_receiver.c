@@ -0,0 +1,283 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 LumenRadio AB
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+#include <mira.h>
+#include <string.h>
+#include "bulk_transfer.h"
+
+#define MAX_CHUNKS ((BULK_MAX_SIZE + BULK_CHUNK_SIZE - 1) / BULK_CHUNK_SIZE)
+
+/* Acknowledge at least every this many chunks */
+#define ACK_EVERY 4
+
+/* Max time before received chunks are acknowledged */
+#define ACK_DELAY (CLOCK_SECOND / 16)
+
+typedef struct
+{
+    bool used;
+    bool complete;
+    bool ack_pending;
+    mira_net_address_t addr;
+    uint16_t port;
+    uint16_t id;
+    uint32_t len;
+    uint16_t n_chunks;
+    uint16_t n_received;
+    uint16_t in_sequence; /* All chunks before this are received */
+    uint8_t unacked;
+    clock_time_t last_activity;
+    uint8_t received[(MAX_CHUNKS + 7) / 8];
+} transfer_t;
+
+static transfer_t transfers[BULK_RECEIVER_MAX_TRANSFERS];
+static mira_net_udp_connection_t* receiver_connection;
+static bulk_write_callback_t receiver_write_callback;
+static bulk_complete_callback_t receiver_complete_callback;
+static void* receiver_storage;
+
+PROCESS(bulk_receiver_proc, "Bulk receiver");
+
+static void put_u16(uint8_t* p, uint16_t value)
+{
+    p[0] = value;
+    p[1] = value >> 8;
+}
+
+static uint16_t get_u16(const uint8_t* p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+static uint32_t get_u32(const uint8_t* p)
+{
+    return get_u16(p) | ((uint32_t)get_u16(p + 2) << 16);
+}
+
+static bool is_received(const transfer_t* transfer, uint16_t chunk)
+{
+    return (transfer->received[chunk / 8] & (1 << (chunk % 8))) != 0;
+}
+
+static void send_ack(const mira_net_address_t* addr, uint16_t port, const transfer_t* transfer)
+{
+    uint8_t packet[BULK_ACK_SIZE];
+    uint32_t sack = 0;
+
+    for (int i = 0; i < 32; ++i) {
+        uint32_t chunk = (uint32_t)transfer->in_sequence + 1 + i;
+        if (chunk < transfer->n_chunks && is_received(transfer, chunk)) {
+            sack |= (uint32_t)1 << i;
+        }
+    }
+
+    packet[0] = BULK_TYPE_ACK;
+    put_u16(&packet[1], transfer->id);
+    put_u16(&packet[3], transfer->in_sequence);
+    put_u16(&packet[5], sack);
+    put_u16(&packet[7], sack >> 16);
+    packet[9] = transfer->complete ? BULK_ACK_FLAG_COMPLETE : 0;
+    mira_net_udp_send_to(receiver_connection, addr, port, packet, sizeof(packet));
+}
+
+static void send_reject(const mira_net_address_t* addr, uint16_t port, uint16_t id)
+{
+    uint8_t packet[BULK_ACK_SIZE] = { BULK_TYPE_ACK };
+    put_u16(&packet[1], id);
+    packet[9] = BULK_ACK_FLAG_REJECTED;
+    mira_net_udp_send_to(receiver_connection, addr, port, packet, sizeof(packet));
+}
+
+/*
+ * Find the transfer from a sender, or start a new one. A sender has one
+ * transfer at a time, a new ID replaces the old one. When all entries are
+ * used, the least recently active one is replaced.
+ */
+static transfer_t* find_transfer(const mira_net_address_t* addr, uint16_t id, uint32_t len)
+{
+    transfer_t* found = NULL;
+    transfer_t* oldest = &transfers[0];
+
+    for (int i = 0; i < BULK_RECEIVER_MAX_TRANSFERS; ++i) {
+        transfer_t* transfer = &transfers[i];
+        if (transfer->used && memcmp(&transfer->addr, addr, sizeof(*addr)) == 0) {
+            found = transfer;
+            break;
+        }
+        if (!transfer->used) {
+            oldest = transfer;
+        } else if (oldest->used &&
+                   (clock_time_t)(clock_time() - transfer->last_activity) >
+                     (clock_time_t)(clock_time() - oldest->last_activity)) {
+            oldest = transfer;
+        }
+    }
+
+    if (found != NULL && found->id == id && found->len == len) {
+        return found;
+    }
+    if (found == NULL) {
+        found = oldest;
+    }
+
+    memset(found, 0, sizeof(*found));
+    found->used = true;
+    memcpy(&found->addr, addr, sizeof(found->addr));
+    found->id = id;
+    found->len = len;
+    found->n_chunks = (len + BULK_CHUNK_SIZE - 1) / BULK_CHUNK_SIZE;
+    return found;
+}
+
+static void handle_data(const uint8_t* packet,
+                        uint16_t len,
+                        const mira_net_udp_callback_metadata_t* metadata)
+{
+    uint16_t id = get_u16(&packet[1]);
+    uint32_t total_len = get_u32(&packet[3]);
+    uint16_t chunk = get_u16(&packet[7]);
+
+    if (total_len == 0 || total_len > BULK_MAX_SIZE) {
+        send_reject(metadata->source_address, metadata->source_port, id);
+        return;
+    }
+
+    transfer_t* transfer = find_transfer(metadata->source_address, id, total_len);
+    transfer->port = metadata->source_port;
+    transfer->last_activity = clock_time();
+
+    uint32_t offset = (uint32_t)chunk * BULK_CHUNK_SIZE;
+    uint16_t chunk_len = total_len - offset > BULK_CHUNK_SIZE ? BULK_CHUNK_SIZE : total_len - offset;
+    if (chunk >= transfer->n_chunks || len != BULK_DATA_HEADER_SIZE + chunk_len) {
+        return;
+    }
+
+    bool in_order = chunk == transfer->in_sequence;
+    if (!is_received(transfer, chunk)) {
+        transfer->received[chunk / 8] |= 1 << (chunk % 8);
+        transfer->n_received++;
+        while (transfer->in_sequence < transfer->n_chunks &&
+               is_received(transfer, transfer->in_sequence)) {
+            transfer->in_sequence++;
+        }
+        receiver_write_callback(&transfer->addr,
+                                transfer->id,
+                                offset,
+                                &packet[BULK_DATA_HEADER_SIZE],
+                                chunk_len,
+                                receiver_storage);
+    } else {
+        in_order = false;
+    }
+
+    if (!transfer->complete && transfer->n_received == transfer->n_chunks) {
+        transfer->complete = true;
+        receiver_complete_callback(&transfer->addr, transfer->id, transfer->len, receiver_storage);
+    }
+
+    /* Gaps, duplicates and the end are acknowledged right away, to speed up recovery */
+    if (!in_order || transfer->complete || ++transfer->unacked >= ACK_EVERY) {
+        send_ack(&transfer->addr, transfer->port, transfer);
+        transfer->unacked = 0;
+        transfer->ack_pending = false;
+    } else if (!transfer->ack_pending) {
+        transfer->ack_pending = true;
+        process_poll(&bulk_receiver_proc);
+    }
+}
+
+static void handle_query(const uint8_t* packet, const mira_net_udp_callback_metadata_t* metadata)
+{
+    uint16_t id = get_u16(&packet[1]);
+    uint32_t total_len = get_u32(&packet[3]);
+
+    if (total_len == 0 || total_len > BULK_MAX_SIZE) {
+        send_reject(metadata->source_address, metadata->source_port, id);
+        return;
+    }
+
+    transfer_t* transfer = find_transfer(metadata->source_address, id, total_len);
+    transfer->port = metadata->source_port;
+    transfer->last_activity = clock_time();
+    send_ack(&transfer->addr, transfer->port, transfer);
+}
+
+static void udp_listen_callback(mira_net_udp_connection_t* connection,
+                                const void* data,
+                                uint16_t data_len,
+                                const mira_net_udp_callback_metadata_t* metadata,
+                                void* storage)
+{
+    const uint8_t* packet = data;
+
+    receiver_connection = connection;
+
+#if BULK_INDUCED_LOSS > 0
+    if (mira_random_generate() % 100 < BULK_INDUCED_LOSS) {
+        return;
+    }
+#endif
+    if (data_len >= BULK_DATA_HEADER_SIZE && packet[0] == BULK_TYPE_DATA) {
+        handle_data(packet, data_len, metadata);
+    } else if (data_len >= BULK_QUERY_SIZE && packet[0] == BULK_TYPE_QUERY) {
+        handle_query(packet, metadata);
+    }
+}
+
+void bulk_receiver_init(bulk_write_callback_t write_callback,
+                        bulk_complete_callback_t complete_callback,
+                        void* storage)
+{
+    receiver_write_callback = write_callback;
+    receiver_complete_callback = complete_callback;
+    receiver_storage = storage;
+    mira_net_udp_listen(BULK_UDP_PORT, udp_listen_callback, NULL);
+    process_start(&bulk_receiver_proc, NULL);
+}
+
+PROCESS_THREAD(bulk_receiver_proc, ev, data)
+{
+    static struct etimer timer;
+
+    PROCESS_BEGIN();
+
+    while (1) {
+        PROCESS_WAIT_EVENT_UNTIL(ev == PROCESS_EVENT_POLL);
+        etimer_set(&timer, ACK_DELAY);
+        PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&timer));
+
+        for (int i = 0; i < BULK_RECEIVER_MAX_TRANSFERS; ++i) {
+            transfer_t* transfer = &transfers[i];
+            if (transfer->used && transfer->ack_pending) {
+                send_ack(&transfer->addr, transfer->port, transfer);
+                transfer->unacked = 0;
+                transfer->ack_pending = false;
+            }
+        }
+    }
+
+    PROCESS_END();
+}
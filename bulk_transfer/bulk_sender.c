@@ -0,0 +1,457 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 LumenRadio AB
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+#include <mira.h>
+#include <string.h>
+#include "bulk_transfer.h"
+
+#define MIN_RTO (CLOCK_SECOND / 4)
+#define MAX_RTO (16 * CLOCK_SECOND)
+#define INITIAL_RTO (2 * CLOCK_SECOND)
+
+/* Wait before checking the TX queue again, when it was full */
+#define TX_QUEUE_WAIT (CLOCK_SECOND / 16)
+
+/* Later chunks acknowledged before a missing one is sent again */
+#define FAST_RETRANSMIT_THRESHOLD 3
+
+typedef struct
+{
+    clock_time_t sent_time;
+    uint8_t transmissions;
+    bool acked;
+} chunk_slot_t;
+
+typedef enum {
+    STATE_IDLE,
+    STATE_QUERY,
+    STATE_SEND,
+} sender_state_t;
+
+static struct
+{
+    sender_state_t state;
+    mira_net_address_t addr;
+    uint16_t id;
+    uint32_t len;
+    uint16_t n_chunks;
+    bulk_read_callback_t read_callback;
+    bulk_done_callback_t done_callback;
+    void* storage;
+
+    /* Chunks before base are acknowledged. Slot of chunk n is n % BULK_MAX_WINDOW */
+    uint16_t base;
+    chunk_slot_t slots[BULK_MAX_WINDOW];
+    /* Highest chunk acknowledged, for fast retransmit */
+    uint16_t highest_acked;
+    /* No new window reduction until base passes this chunk */
+    uint16_t recovery_end;
+
+    /* Window, in chunks, with a fraction for the growth in congestion avoidance */
+    uint8_t window;
+    uint8_t window_fraction;
+    uint8_t slow_start_threshold;
+
+    /* Round trip times, in clock ticks */
+    clock_time_t srtt;
+    clock_time_t rttvar;
+    clock_time_t rto;
+    bool has_rtt;
+
+    clock_time_t query_time;
+    uint8_t retries;
+} tx;
+
+static mira_net_udp_connection_t* sender_connection;
+static bulk_sender_stats_t stats;
+
+PROCESS(bulk_sender_proc, "Bulk sender");
+
+static void put_u16(uint8_t* p, uint16_t value)
+{
+    p[0] = value;
+    p[1] = value >> 8;
+}
+
+static void put_u32(uint8_t* p, uint32_t value)
+{
+    put_u16(p, value);
+    put_u16(p + 2, value >> 16);
+}
+
+static uint16_t get_u16(const uint8_t* p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+static uint32_t get_u32(const uint8_t* p)
+{
+    return get_u16(p) | ((uint32_t)get_u16(p + 2) << 16);
+}
+
+static chunk_slot_t* slot_of(uint16_t chunk)
+{
+    return &tx.slots[chunk % BULK_MAX_WINDOW];
+}
+
+static uint16_t window_end(void)
+{
+    uint32_t end = (uint32_t)tx.base + tx.window;
+    return end > tx.n_chunks ? tx.n_chunks : end;
+}
+
+static void finish(bulk_status_t status)
+{
+    tx.state = STATE_IDLE;
+    stats.end_time = clock_time();
+    if (tx.done_callback != NULL) {
+        tx.done_callback(status, tx.storage);
+    }
+}
+
+/* Jacobson/Karels estimator, as in TCP */
+static void add_rtt_sample(clock_time_t rtt)
+{
+    if (!tx.has_rtt) {
+        tx.srtt = rtt;
+        tx.rttvar = rtt / 2;
+        tx.has_rtt = true;
+    } else {
+        clock_time_t diff = rtt > tx.srtt ? rtt - tx.srtt : tx.srtt - rtt;
+        tx.rttvar = (3 * tx.rttvar + diff) / 4;
+        tx.srtt = (7 * tx.srtt + rtt) / 8;
+    }
+    tx.rto = tx.srtt + (4 * tx.rttvar > 1 ? 4 * tx.rttvar : 1);
+    if (tx.rto < MIN_RTO) {
+        tx.rto = MIN_RTO;
+    } else if (tx.rto > MAX_RTO) {
+        tx.rto = MAX_RTO;
+    }
+}
+
+static void reduce_window(void)
+{
+    tx.slow_start_threshold = tx.window / 2 > 2 ? tx.window / 2 : 2;
+    tx.window = tx.slow_start_threshold;
+    tx.window_fraction = 0;
+    tx.recovery_end = window_end();
+}
+
+static void grow_window(void)
+{
+    if (tx.window >= BULK_MAX_WINDOW) {
+        return;
+    }
+    if (tx.window < tx.slow_start_threshold) {
+        tx.window++;
+    } else if (++tx.window_fraction >= tx.window) {
+        tx.window++;
+        tx.window_fraction = 0;
+    }
+}
+
+static void ack_chunk(uint16_t chunk, clock_time_t now)
+{
+    chunk_slot_t* slot = slot_of(chunk);
+    if (slot->acked || slot->transmissions == 0) {
+        return;
+    }
+    slot->acked = true;
+    /* Only chunks sent once give unambiguous round trip times */
+    if (slot->transmissions == 1) {
+        add_rtt_sample(now - slot->sent_time);
+    }
+    if ((int16_t)(chunk - tx.highest_acked) > 0) {
+        tx.highest_acked = chunk;
+    }
+    grow_window();
+}
+
+static void handle_ack(const uint8_t* packet, uint16_t len)
+{
+    clock_time_t now = clock_time();
+
+    if (len < BULK_ACK_SIZE || get_u16(&packet[1]) != tx.id || tx.state == STATE_IDLE) {
+        return;
+    }
+    uint16_t in_sequence = get_u16(&packet[3]);
+    uint32_t sack = get_u32(&packet[5]);
+    uint8_t flags = packet[9];
+
+    if (flags & BULK_ACK_FLAG_REJECTED) {
+        finish(BULK_STATUS_REJECTED);
+        return;
+    }
+    if (in_sequence > tx.n_chunks) {
+        return;
+    }
+
+    if (tx.state == STATE_QUERY) {
+        /* Continue from what the receiver already has */
+        tx.state = STATE_SEND;
+        tx.base = in_sequence;
+        tx.highest_acked = in_sequence;
+        tx.recovery_end = in_sequence;
+        memset(tx.slots, 0, sizeof(tx.slots));
+        add_rtt_sample(now - tx.query_time);
+        /* Chunks up to base + BULK_MAX_WINDOW - 1 have their own slots */
+        for (int i = 0; i < BULK_MAX_WINDOW - 1 && in_sequence + 1 + i < tx.n_chunks; ++i) {
+            if (sack & ((uint32_t)1 << i)) {
+                slot_of(in_sequence + 1 + i)->acked = true;
+            }
+        }
+    } else {
+        while ((int16_t)(in_sequence - tx.base) > 0) {
+            ack_chunk(tx.base, now);
+            memset(slot_of(tx.base), 0, sizeof(chunk_slot_t));
+            tx.base++;
+        }
+        for (int i = 0; i < 32; ++i) {
+            uint16_t chunk = in_sequence + 1 + i;
+            if ((sack & ((uint32_t)1 << i)) && chunk < window_end()) {
+                ack_chunk(chunk, now);
+            }
+        }
+    }
+    tx.retries = 0;
+
+    if (tx.base >= tx.n_chunks || (flags & BULK_ACK_FLAG_COMPLETE)) {
+        finish(BULK_STATUS_DONE);
+        return;
+    }
+    process_poll(&bulk_sender_proc);
+}
+
+static void ack_callback(mira_net_udp_connection_t* connection,
+                         const void* data,
+                         uint16_t data_len,
+                         const mira_net_udp_callback_metadata_t* metadata,
+                         void* storage)
+{
+    const uint8_t* packet = data;
+
+#if BULK_INDUCED_LOSS > 0
+    if (mira_random_generate() % 100 < BULK_INDUCED_LOSS) {
+        return;
+    }
+#endif
+    if (data_len > 0 && packet[0] == BULK_TYPE_ACK) {
+        handle_ack(packet, data_len);
+    }
+}
+
+static void send_query(void)
+{
+    uint8_t packet[BULK_QUERY_SIZE];
+    packet[0] = BULK_TYPE_QUERY;
+    put_u16(&packet[1], tx.id);
+    put_u32(&packet[3], tx.len);
+    tx.query_time = clock_time();
+    mira_net_udp_send_to(sender_connection, &tx.addr, BULK_UDP_PORT, packet, sizeof(packet));
+}
+
+static bool send_chunk(uint16_t chunk)
+{
+    uint8_t packet[BULK_DATA_HEADER_SIZE + BULK_CHUNK_SIZE];
+    uint32_t offset = (uint32_t)chunk * BULK_CHUNK_SIZE;
+    uint16_t len = tx.len - offset > BULK_CHUNK_SIZE ? BULK_CHUNK_SIZE : tx.len - offset;
+
+    packet[0] = BULK_TYPE_DATA;
+    put_u16(&packet[1], tx.id);
+    put_u32(&packet[3], tx.len);
+    put_u16(&packet[7], chunk);
+    tx.read_callback(offset, &packet[BULK_DATA_HEADER_SIZE], len, tx.storage);
+
+    if (mira_net_udp_send_to(sender_connection,
+                             &tx.addr,
+                             BULK_UDP_PORT,
+                             packet,
+                             BULK_DATA_HEADER_SIZE + len) != MIRA_SUCCESS) {
+        return false;
+    }
+
+    chunk_slot_t* slot = slot_of(chunk);
+    if (slot->transmissions > 0) {
+        stats.retransmissions++;
+    }
+    if (slot->transmissions < UINT8_MAX) {
+        slot->transmissions++;
+    }
+    slot->sent_time = clock_time();
+    stats.data_packets++;
+    stats.data_bytes += BULK_DATA_HEADER_SIZE + len;
+    return true;
+}
+
+/* Free slots in the MAC TX queue that may be used */
+static int tx_queue_room(void)
+{
+    mira_diag_mac_statistics_t mac_stats;
+    if (mira_diag_mac_get_statistics(&mac_stats) != MIRA_SUCCESS) {
+        return 1;
+    }
+    return BULK_TX_QUEUE_SIZE - BULK_TX_QUEUE_RESERVE - mac_stats.used_tx_queue;
+}
+
+/*
+ * Send the chunks in the window that haven't been sent, or have timed out,
+ * as far as the TX queue allows.
+ *
+ * Returns the time until the next chunk times out, or TX_QUEUE_WAIT if the
+ * TX queue was full.
+ */
+static clock_time_t send_window(void)
+{
+    clock_time_t now = clock_time();
+    clock_time_t next = tx.rto;
+    int room = tx_queue_room();
+    bool timed_out = false;
+
+    for (uint16_t chunk = tx.base; chunk < window_end(); ++chunk) {
+        chunk_slot_t* slot = slot_of(chunk);
+        if (slot->acked) {
+            continue;
+        }
+
+        bool lost = slot->transmissions > 0 &&
+                    (int16_t)(tx.highest_acked - chunk) >= FAST_RETRANSMIT_THRESHOLD &&
+                    slot->transmissions == 1;
+        clock_time_t age = now - slot->sent_time;
+        if (slot->transmissions > 0 && !lost && age < tx.rto) {
+            if (tx.rto - age < next) {
+                next = tx.rto - age;
+            }
+            continue;
+        }
+        if (slot->transmissions > 0 && !lost) {
+            timed_out = true;
+        }
+        if (slot->transmissions > 0 && (int16_t)(chunk - tx.recovery_end) >= 0) {
+            /* First loss in this window */
+            reduce_window();
+        }
+
+        if (room <= 0 || !send_chunk(chunk)) {
+            stats.tx_queue_waits++;
+            return TX_QUEUE_WAIT;
+        }
+        room--;
+    }
+
+    if (timed_out) {
+        stats.timeouts++;
+        tx.retries++;
+        /* Back off, the path may be broken */
+        tx.rto = tx.rto * 2 > MAX_RTO ? MAX_RTO : tx.rto * 2;
+        if (tx.retries > BULK_MAX_RETRIES) {
+            finish(BULK_STATUS_TIMEOUT);
+        }
+    }
+    return next > 0 ? next : 1;
+}
+
+mira_status_t bulk_sender_start(const mira_net_address_t* addr,
+                                uint16_t transfer_id,
+                                uint32_t len,
+                                bulk_read_callback_t read_callback,
+                                bulk_done_callback_t done_callback,
+                                void* storage)
+{
+    if (tx.state != STATE_IDLE) {
+        return MIRA_ERROR_RESOURCE_NOT_AVAILABLE;
+    }
+    if (len == 0 || (len + BULK_CHUNK_SIZE - 1) / BULK_CHUNK_SIZE > UINT16_MAX) {
+        return MIRA_ERROR_INVALID_VALUE;
+    }
+
+    if (sender_connection == NULL) {
+        sender_connection = mira_net_udp_connect(NULL, 0, ack_callback, NULL);
+        process_start(&bulk_sender_proc, NULL);
+    }
+
+    memset(&tx, 0, sizeof(tx));
+    memcpy(&tx.addr, addr, sizeof(tx.addr));
+    tx.id = transfer_id;
+    tx.len = len;
+    tx.n_chunks = (len + BULK_CHUNK_SIZE - 1) / BULK_CHUNK_SIZE;
+    tx.read_callback = read_callback;
+    tx.done_callback = done_callback;
+    tx.storage = storage;
+    tx.window = 2;
+    tx.slow_start_threshold = BULK_MAX_WINDOW;
+    tx.rto = INITIAL_RTO;
+    tx.state = STATE_QUERY;
+
+    memset(&stats, 0, sizeof(stats));
+    stats.start_time = clock_time();
+
+    process_poll(&bulk_sender_proc);
+    return MIRA_SUCCESS;
+}
+
+bool bulk_sender_busy(void)
+{
+    return tx.state != STATE_IDLE;
+}
+
+void bulk_sender_get_stats(bulk_sender_stats_t* result)
+{
+    memcpy(result, &stats, sizeof(stats));
+    result->srtt = tx.srtt;
+    result->rto = tx.rto;
+    result->window = tx.window;
+    if (tx.state != STATE_IDLE) {
+        result->end_time = clock_time();
+    }
+}
+
+PROCESS_THREAD(bulk_sender_proc, ev, data)
+{
+    static struct etimer timer;
+
+    PROCESS_BEGIN();
+
+    while (1) {
+        PROCESS_WAIT_EVENT_UNTIL(ev == PROCESS_EVENT_POLL || ev == PROCESS_EVENT_TIMER);
+
+        if (tx.state == STATE_QUERY) {
+            /* Ask the receiver what it has, until it answers */
+            if (ev == PROCESS_EVENT_POLL || tx.retries++ <= BULK_MAX_RETRIES) {
+                send_query();
+                etimer_set(&timer, tx.rto);
+                tx.rto = tx.rto * 2 > MAX_RTO ? MAX_RTO : tx.rto * 2;
+            } else {
+                finish(BULK_STATUS_TIMEOUT);
+            }
+        } else if (tx.state == STATE_SEND) {
+            etimer_set(&timer, send_window());
+        } else {
+            etimer_stop(&timer);
+        }
+    }
+
+    PROCESS_END();
+}
@@ -0,0 +1,189 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 LumenRadio AB
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+#ifndef BULK_TRANSFER_H
+#define BULK_TRANSFER_H
+
+#include <mira.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Reliable transfer of large blobs, up to tens of kilobytes, from a node to
+ * another node, typically the root, over UDP.
+ *
+ * The blob is split in chunks of BULK_CHUNK_SIZE bytes. The sender keeps a
+ * window of chunks in flight, and the receiver acknowledges them with the
+ * number of chunks received in sequence, and a bitmap of the 32 chunks
+ * after that (selective ACK). Lost chunks are sent again when their
+ * retransmission timeout, computed from the measured round trip times, has
+ * passed, or when 3 later chunks have been acknowledged.
+ *
+ * The window grows by one chunk per acknowledged window, and is halved on
+ * loss. New chunks are only sent while the MAC TX queue has room, so the
+ * transfer doesn't crowd out other traffic from the node.
+ *
+ * A transfer is identified by the sender address and a transfer ID. Before
+ * sending, the sender asks the receiver what it already has, so a transfer
+ * that was interrupted, for example by a lost route, continues where it
+ * left off when started again with the same ID.
+ *
+ * Packet formats, all fields little endian:
+ *
+ * Data, sender to receiver:
+ * <BULK_TYPE_DATA> (1 byte)
+ * <transfer ID> (2 bytes)
+ * <total length> (4 bytes)
+ * <chunk index> (2 bytes)
+ * <chunk data> (BULK_CHUNK_SIZE bytes, less for the last chunk)
+ *
+ * Query, sender to receiver:
+ * <BULK_TYPE_QUERY> (1 byte)
+ * <transfer ID> (2 bytes)
+ * <total length> (4 bytes)
+ *
+ * Ack, receiver to sender, in response to data and queries:
+ * <BULK_TYPE_ACK> (1 byte)
+ * <transfer ID> (2 bytes)
+ * <chunks received in sequence> (2 bytes)
+ * <selective ack> (4 bytes, bit n set if chunk in sequence + 1 + n is received)
+ * <flags> (1 byte, BULK_ACK_FLAG_*)
+ */
+
+#define BULK_UDP_PORT 459
+
+#define BULK_TYPE_DATA 1
+#define BULK_TYPE_QUERY 2
+#define BULK_TYPE_ACK 3
+
+#define BULK_ACK_FLAG_COMPLETE 0x01
+#define BULK_ACK_FLAG_REJECTED 0x02
+
+#define BULK_DATA_HEADER_SIZE 9
+#define BULK_QUERY_SIZE 7
+#define BULK_ACK_SIZE 10
+
+/* Data bytes per chunk */
+#ifndef BULK_CHUNK_SIZE
+#define BULK_CHUNK_SIZE 64
+#endif
+
+/* Max chunks in flight, limited by the selective ack bitmap */
+#define BULK_MAX_WINDOW 32
+
+/* Largest blob the receiver accepts */
+#ifndef BULK_MAX_SIZE
+#define BULK_MAX_SIZE 32768
+#endif
+
+/* Size of the MAC TX queue, and how much of it to leave for other traffic */
+#ifndef BULK_TX_QUEUE_SIZE
+#define BULK_TX_QUEUE_SIZE 8
+#endif
+#ifndef BULK_TX_QUEUE_RESERVE
+#define BULK_TX_QUEUE_RESERVE 2
+#endif
+
+/* Consecutive timeouts without progress before the transfer fails */
+#ifndef BULK_MAX_RETRIES
+#define BULK_MAX_RETRIES 8
+#endif
+
+/* Percentage of received packets to drop, to test under loss */
+#ifndef BULK_INDUCED_LOSS
+#define BULK_INDUCED_LOSS 0
+#endif
+
+typedef enum {
+    BULK_STATUS_DONE,
+    BULK_STATUS_TIMEOUT,
+    BULK_STATUS_REJECTED,
+} bulk_status_t;
+
+typedef struct
+{
+    uint32_t data_packets; /* Including retransmissions */
+    uint32_t data_bytes;   /* Including headers and retransmissions */
+    uint32_t retransmissions;
+    uint32_t timeouts;
+    uint32_t tx_queue_waits; /* Times sending waited for TX queue room */
+    clock_time_t start_time;
+    clock_time_t end_time;
+    clock_time_t srtt;
+    clock_time_t rto;
+    uint8_t window;
+} bulk_sender_stats_t;
+
+/* Copy len bytes at offset of the blob to buf */
+typedef void (*bulk_read_callback_t)(uint32_t offset, uint8_t* buf, uint16_t len, void* storage);
+
+typedef void (*bulk_done_callback_t)(bulk_status_t status, void* storage);
+
+/*
+ * Start sending a blob. Only one transfer is sent at a time.
+ *
+ * Starting a transfer with the same ID and length as an interrupted one
+ * continues it.
+ *
+ * Returns MIRA_ERROR_RESOURCE_NOT_AVAILABLE if a transfer is in progress,
+ * and MIRA_ERROR_INVALID_VALUE if the blob is too large.
+ */
+mira_status_t bulk_sender_start(const mira_net_address_t* addr,
+                                uint16_t transfer_id,
+                                uint32_t len,
+                                bulk_read_callback_t read_callback,
+                                bulk_done_callback_t done_callback,
+                                void* storage);
+
+bool bulk_sender_busy(void);
+
+/* Statistics of the current, or the latest, transfer */
+void bulk_sender_get_stats(bulk_sender_stats_t* stats);
+
+/* Called with the data of each chunk, the first time it's received */
+typedef void (*bulk_write_callback_t)(const mira_net_address_t* addr,
+                                      uint16_t transfer_id,
+                                      uint32_t offset,
+                                      const uint8_t* data,
+                                      uint16_t len,
+                                      void* storage);
+
+/* Called when all chunks of a transfer have been received */
+typedef void (*bulk_complete_callback_t)(const mira_net_address_t* addr,
+                                         uint16_t transfer_id,
+                                         uint32_t len,
+                                         void* storage);
+
+/* Max number of senders with transfers in progress at the receiver */
+#ifndef BULK_RECEIVER_MAX_TRANSFERS
+#define BULK_RECEIVER_MAX_TRANSFERS 4
+#endif
+
+void bulk_receiver_init(bulk_write_callback_t write_callback,
+                        bulk_complete_callback_t complete_callback,
+                        void* storage);
+
+#endif
@@ -0,0 +1,155 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 LumenRadio AB
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+#include <mira.h>
+#include <stdio.h>
+#include <string.h>
+#include "bulk_transfer.h"
+
+/* Size of the memory buffer given to Mira */
+#ifndef MIRA_MEM_BUFFER_SIZE
+#define MIRA_MEM_BUFFER_SIZE 14944
+#endif
+
+#ifndef BULK_NET_RATE
+#define BULK_NET_RATE MIRA_NET_RATE_MID
+#endif
+
+static const mira_net_config_t net_config = {
+    .pan_id = 0x13243548,
+    .key = { 0x11,
+             0x12,
+             0x13,
+             0x14,
+             0x21,
+             0x22,
+             0x23,
+             0x24,
+             0x31,
+             0x32,
+             0x33,
+             0x34,
+             0x41,
+             0x42,
+             0x43,
+             0x44 },
+    /* Prioritize initial network startup, which is good for testing.
+     *
+     * This has the drawback that the network takes a much
+     * longer time to recover if the root node is restarted. */
+    .mode = MIRA_NET_MODE_ROOT_NO_RECONNECT,
+
+    .rate = BULK_NET_RATE,
+    .antenna = 0,
+    .prefix = NULL /* default prefix */
+};
+
+MIRA_IODEFS(MIRA_IODEF_NONE,    /* fd 0: stdin */
+            MIRA_IODEF_UART(0), /* fd 1: stdout */
+            MIRA_IODEF_NONE     /* fd 2: stderr */
+                                /* More file descriptors can be added, for use with dprintf(); */
+);
+
+/* Bytes not matching the sender's pattern, since the last completed transfer */
+static uint32_t n_errors;
+
+/*
+ * A real application would store the data, here it's only verified against
+ * the pattern sent by the example sender.
+ */
+static void write_chunk(const mira_net_address_t* addr,
+                        uint16_t transfer_id,
+                        uint32_t offset,
+                        const uint8_t* data,
+                        uint16_t len,
+                        void* storage)
+{
+    for (uint16_t i = 0; i < len; ++i) {
+        if (data[i] != ((offset + i + transfer_id) & 0xff)) {
+            n_errors++;
+        }
+    }
+}
+
+static void transfer_complete(const mira_net_address_t* addr,
+                              uint16_t transfer_id,
+                              uint32_t len,
+                              void* storage)
+{
+    char buffer[MIRA_NET_MAX_ADDRESS_STR_LEN];
+
+    printf("{\"type\":\"bulk_received\",\"source\":\"%s\",\"id\":%u,\"size\":%lu,"
+           "\"errors\":%lu}\n",
+           mira_net_toolkit_format_address(buffer, addr),
+           transfer_id,
+           (unsigned long)len,
+           (unsigned long)n_errors);
+    n_errors = 0;
+}
+
+PROCESS(main_proc, "Main process");
+
+void mira_setup(void)
+{
+    mira_status_t uart_ret;
+    mira_uart_config_t uart_config = {
+        .baudrate = 115200,
+#if MIRA_PLATFORM_MKW41Z
+        .tx_pin = MIRA_GPIO_PIN('C', 7),
+        .rx_pin = MIRA_GPIO_PIN('C', 6)
+#else
+        .tx_pin = MIRA_GPIO_PIN(0, 6),
+        .rx_pin = MIRA_GPIO_PIN(0, 8)
+#endif
+    };
+
+    MIRA_MEM_SET_BUFFER(MIRA_MEM_BUFFER_SIZE);
+
+    uart_ret = mira_uart_init(0, &uart_config);
+    if (uart_ret != MIRA_SUCCESS) {
+        /* Nowhere to send an error message */
+    }
+
+    process_start(&main_proc, NULL);
+}
+
+PROCESS_THREAD(main_proc, ev, data)
+{
+    PROCESS_BEGIN();
+    /* Pause once, so we don't run anything before finish of startup */
+    PROCESS_PAUSE();
+
+    mira_status_t result = mira_net_init(&net_config);
+    if (result) {
+        printf("FAILURE: mira_net_init returned %d\n", result);
+        while (1)
+            ;
+    }
+
+    bulk_receiver_init(write_chunk, transfer_complete, NULL);
+
+    PROCESS_END();
+}
@@ -0,0 +1,209 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 LumenRadio AB
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+#include <mira.h>
+#include <stdio.h>
+#include <string.h>
+#include "bulk_transfer.h"
+
+/* Size of the memory buffer given to Mira */
+#ifndef MIRA_MEM_BUFFER_SIZE
+#define MIRA_MEM_BUFFER_SIZE 8340
+#endif
+
+/* Size of the blob to send, in bytes */
+#ifndef BULK_TRANSFER_SIZE
+#define BULK_TRANSFER_SIZE 16384
+#endif
+
+/* Seconds between the end of a transfer and the start of the next */
+#ifndef BULK_TRANSFER_INTERVAL
+#define BULK_TRANSFER_INTERVAL 30
+#endif
+
+#ifndef BULK_NET_RATE
+#define BULK_NET_RATE MIRA_NET_RATE_MID
+#endif
+
+#define CHECK_NET_INTERVAL 1
+
+static const mira_net_config_t net_config = {
+    .pan_id = 0x13243548,
+    .key = { 0x11,
+             0x12,
+             0x13,
+             0x14,
+             0x21,
+             0x22,
+             0x23,
+             0x24,
+             0x31,
+             0x32,
+             0x33,
+             0x34,
+             0x41,
+             0x42,
+             0x43,
+             0x44 },
+    .mode = MIRA_NET_MODE_MESH,
+    .rate = BULK_NET_RATE,
+    .antenna = 0,
+    .prefix = NULL, /* default prefix */
+    .max_connections = 1,
+};
+
+MIRA_IODEFS(MIRA_IODEF_NONE,    /* fd 0: stdin */
+            MIRA_IODEF_UART(0), /* fd 1: stdout */
+            MIRA_IODEF_NONE     /* fd 2: stderr */
+                                /* More file descriptors can be added, for use with dprintf(); */
+);
+
+static uint16_t transfer_id;
+static bulk_status_t transfer_status;
+
+PROCESS(main_proc, "Main process");
+
+/* The blob is a pattern the receiver can verify, instead of real data */
+static void read_blob(uint32_t offset, uint8_t* buf, uint16_t len, void* storage)
+{
+    for (uint16_t i = 0; i < len; ++i) {
+        buf[i] = (offset + i + transfer_id) & 0xff;
+    }
+}
+
+static void transfer_done(bulk_status_t status, void* storage)
+{
+    transfer_status = status;
+    process_poll(&main_proc);
+}
+
+static void print_stats(void)
+{
+    static const char* status_names[] = { "done", "timeout", "rejected" };
+    bulk_sender_stats_t stats;
+    bulk_sender_get_stats(&stats);
+
+    unsigned long ms = (stats.end_time - stats.start_time) * 1000UL / CLOCK_SECOND;
+    if (ms == 0) {
+        ms = 1;
+    }
+
+    /* Throughput counts all bytes sent, goodput only the blob */
+    printf("{\"type\":\"bulk_done\",\"id\":%u,\"status\":\"%s\",\"size\":%d,\"ms\":%lu,"
+           "\"throughput_bps\":%lu,\"goodput_bps\":%lu,\"packets\":%lu,"
+           "\"retransmissions\":%lu,\"timeouts\":%lu,\"tx_queue_waits\":%lu,"
+           "\"srtt_ms\":%lu,\"rto_ms\":%lu,\"window\":%u}\n",
+           transfer_id,
+           status_names[transfer_status],
+           BULK_TRANSFER_SIZE,
+           ms,
+           (unsigned long)((uint64_t)stats.data_bytes * 8000 / ms),
+           (unsigned long)((uint64_t)BULK_TRANSFER_SIZE * 8000 / ms),
+           (unsigned long)stats.data_packets,
+           (unsigned long)stats.retransmissions,
+           (unsigned long)stats.timeouts,
+           (unsigned long)stats.tx_queue_waits,
+           (unsigned long)(stats.srtt * 1000UL / CLOCK_SECOND),
+           (unsigned long)(stats.rto * 1000UL / CLOCK_SECOND),
+           stats.window);
+}
+
+void mira_setup(void)
+{
+    mira_status_t uart_ret;
+    mira_uart_config_t uart_config = {
+        .baudrate = 115200,
+#if MIRA_PLATFORM_MKW41Z
+        .tx_pin = MIRA_GPIO_PIN('C', 7),
+        .rx_pin = MIRA_GPIO_PIN('C', 6)
+#else
+        .tx_pin = MIRA_GPIO_PIN(0, 6),
+        .rx_pin = MIRA_GPIO_PIN(0, 8)
+#endif
+    };
+
+    MIRA_MEM_SET_BUFFER(MIRA_MEM_BUFFER_SIZE);
+
+    uart_ret = mira_uart_init(0, &uart_config);
+    if (uart_ret != MIRA_SUCCESS) {
+        /* Nowhere to send an error message */
+    }
+
+    process_start(&main_proc, NULL);
+}
+
+PROCESS_THREAD(main_proc, ev, data)
+{
+    static struct etimer timer;
+    static mira_net_address_t root_address;
+
+    PROCESS_BEGIN();
+    /* Pause once, so we don't run anything before finish of startup */
+    PROCESS_PAUSE();
+
+    printf("{\"type\":\"bulk_config\",\"size\":%d,\"chunk\":%d,\"max_window\":%d,"
+           "\"induced_loss\":%d}\n",
+           BULK_TRANSFER_SIZE,
+           BULK_CHUNK_SIZE,
+           BULK_MAX_WINDOW,
+           BULK_INDUCED_LOSS);
+
+    mira_status_t result = mira_net_init(&net_config);
+    if (result) {
+        printf("FAILURE: mira_net_init returned %d\n", result);
+        while (1)
+            ;
+    }
+
+    transfer_id = mira_random_generate();
+
+    while (1) {
+        while (mira_net_get_state() != MIRA_NET_STATE_JOINED ||
+               mira_net_get_root_address(&root_address) != MIRA_SUCCESS) {
+            etimer_set(&timer, CHECK_NET_INTERVAL * CLOCK_SECOND);
+            PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&timer));
+        }
+
+        result = bulk_sender_start(
+          &root_address, transfer_id, BULK_TRANSFER_SIZE, read_blob, transfer_done, NULL);
+        if (result != MIRA_SUCCESS) {
+            printf("FAILURE: bulk_sender_start returned %d\n", result);
+            while (1)
+                ;
+        }
+        PROCESS_WAIT_EVENT_UNTIL(ev == PROCESS_EVENT_POLL && !bulk_sender_busy());
+        print_stats();
+
+        /* A timed out transfer is continued with the same ID */
+        if (transfer_status != BULK_STATUS_TIMEOUT) {
+            transfer_id++;
+            etimer_set(&timer, BULK_TRANSFER_INTERVAL * CLOCK_SECOND);
+            PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&timer));
+        }
+    }
+
+    PROCESS_END();
+}
@@ -29,6 +29,11 @@
 #include <inttypes.h>
 #include <stdint.h>
 
+/* Size of the memory buffer given to Mira */
+#ifndef MIRA_MEM_BUFFER_SIZE
+#define MIRA_MEM_BUFFER_SIZE 7592
+#endif
+
 #define WRITE_AREA_SIZE 0x10000
 
 MIRA_IODEFS(MIRA_IODEF_NONE,    /* fd 0: stdin */
@@ -62,7 +67,7 @@ void mira_setup(void)
 #endif
     };
 
-    MIRA_MEM_SET_BUFFER(7592);
+    MIRA_MEM_SET_BUFFER(MIRA_MEM_BUFFER_SIZE);
 
     uart_ret = mira_uart_init(0, &uart_config);
     if (uart_ret != MIRA_SUCCESS) {
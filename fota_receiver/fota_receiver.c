@@ -31,6 +31,11 @@
 #include <inttypes.h>
 #include "mira_diag_log.h"
 
+/* Size of the memory buffer given to Mira */
+#ifndef MIRA_MEM_BUFFER_SIZE
+#define MIRA_MEM_BUFFER_SIZE 8616
+#endif
+
 static const mira_net_config_t net_config = {
     .pan_id = 0x12345678,
     .key = { 0xaa,
@@ -190,7 +195,7 @@ void mira_setup(void)
     };
     mira_diag_log_set_callbacks(&cbs);
 
-    MIRA_MEM_SET_BUFFER(8616);
+    MIRA_MEM_SET_BUFFER(MIRA_MEM_BUFFER_SIZE);
 
     uart_ret = mira_uart_init(0, &uart_config);
     if (uart_ret != MIRA_SUCCESS) {
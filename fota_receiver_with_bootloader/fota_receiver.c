@@ -31,6 +31,11 @@
 #include <stdio.h>
 #include <string.h>
 
+/* Size of the memory buffer given to Mira */
+#ifndef MIRA_MEM_BUFFER_SIZE
+#define MIRA_MEM_BUFFER_SIZE 13312
+#endif
+
 // #define NEW_VERSION
 
 static const mira_net_config_t net_config = {
@@ -77,7 +82,7 @@ void mira_setup(void)
                                        .tx_pin = MIRA_GPIO_PIN(0, 6),
                                        .rx_pin = MIRA_GPIO_PIN(0, 8) };
 
-    MIRA_MEM_SET_BUFFER(13312);
+    MIRA_MEM_SET_BUFFER(MIRA_MEM_BUFFER_SIZE);
 
     uart_ret = mira_uart_init(0, &uart_config);
     if (uart_ret != MIRA_SUCCESS) {
@@ -32,6 +32,11 @@
 
 #include "../fota_sender_with_driver/fota_driver.h"
 
+/* Size of the memory buffer given to Mira */
+#ifndef MIRA_MEM_BUFFER_SIZE
+#define MIRA_MEM_BUFFER_SIZE 8616
+#endif
+
 static const mira_net_config_t net_config = {
     .pan_id = 0x12345678,
     .key = { 0xaa,
@@ -76,7 +81,7 @@ void mira_setup(void)
                                        .tx_pin = MIRA_GPIO_PIN(0, 6),
                                        .rx_pin = MIRA_GPIO_PIN(0, 8) };
 
-    MIRA_MEM_SET_BUFFER(8616);
+    MIRA_MEM_SET_BUFFER(MIRA_MEM_BUFFER_SIZE);
 
     uart_ret = mira_uart_init(0, &uart_config);
     if (uart_ret != MIRA_SUCCESS) {
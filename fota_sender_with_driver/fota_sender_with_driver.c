@@ -32,6 +32,12 @@
 
 #include "fota_crc_tool.h"
 #include "fota_driver.h"
+
+/* Size of the memory buffer given to Mira */
+#ifndef MIRA_MEM_BUFFER_SIZE
+#define MIRA_MEM_BUFFER_SIZE 14944
+#endif
+
 #define HEADER_SIZE 12
 
 static const mira_net_config_t net_config = {
@@ -79,7 +85,7 @@ void mira_setup(void)
                                        .tx_pin = MIRA_GPIO_PIN(0, 6),
                                        .rx_pin = MIRA_GPIO_PIN(0, 8) };
 
-    MIRA_MEM_SET_BUFFER(14944);
+    MIRA_MEM_SET_BUFFER(MIRA_MEM_BUFFER_SIZE);
 
     uart_ret = mira_uart_init(0, &uart_config);
     if (uart_ret != MIRA_SUCCESS) {
@@ -0,0 +1,243 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 LumenRadio AB
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+#ifndef MIRA_H
+#define MIRA_H
+
+/*
+ * The parts of mira.h needed to build the examples' modules on the host, for
+ * the benchmarks and tests in their bench directories, which add this
+ * directory to the include path. Implemented by mira_host.c, or by a test
+ * that needs a clock and timers of its own. Not for the nodes.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+typedef enum {
+    MIRA_SUCCESS = 0,
+    MIRA_ERROR_NOT_SUPPORTED,
+    MIRA_ERROR_INVALID_VALUE,
+    MIRA_ERROR_RESOURCE_NOT_AVAILABLE,
+    MIRA_ERROR_NO_MEMORY,
+    MIRA_FAILURE
+} mira_status_t;
+
+typedef unsigned char process_event_t;
+typedef void* process_data_t;
+
+#define PROCESS_EVENT_NONE 0x80
+#define PROCESS_EVENT_INIT 0x81
+#define PROCESS_EVENT_POLL 0x82
+#define PROCESS_EVENT_EXIT 0x83
+#define PROCESS_EVENT_CONTINUE 0x85
+#define PROCESS_EVENT_EXITED 0x87
+#define PROCESS_EVENT_TIMER 0x88
+
+#define PT_WAITING 0
+#define PT_YIELDED 1
+#define PT_EXITED 2
+#define PT_ENDED 3
+
+struct pt
+{
+    unsigned short lc;
+};
+
+struct process
+{
+    struct process* next;
+    const char* name;
+    char (*thread)(struct pt*, process_event_t, process_data_t);
+    struct pt pt;
+    unsigned char state;
+    /* Set by the input threads of the benchmarks too */
+    volatile unsigned char needspoll;
+};
+
+#define PROCESS_THREAD(name, ev, data) \
+    static char process_thread_##name(struct pt* process_pt, process_event_t ev, process_data_t data)
+#define PROCESS(name, strname)     \
+    PROCESS_THREAD(name, ev, data); \
+    struct process name = { NULL, strname, process_thread_##name, { 0 }, 0, 0 }
+#define PROCESS_NAME(name) extern struct process name
+
+/* Protothreads, with the line number as the continuation */
+#define PROCESS_BEGIN()        \
+    {                          \
+        char yield_flag = 1;   \
+        (void)yield_flag;      \
+        (void)ev;              \
+        (void)data;            \
+        switch (process_pt->lc) { \
+            case 0:
+#define PROCESS_END()        \
+    }                        \
+    process_pt->lc = 0;      \
+    return PT_ENDED;         \
+    }
+#define PROCESS_WAIT_EVENT_UNTIL(c)            \
+    do {                                       \
+        yield_flag = 0;                        \
+        process_pt->lc = __LINE__;             \
+        __attribute__((fallthrough));          \
+        case __LINE__:                         \
+            if (yield_flag == 0 || !(c)) {     \
+                return PT_YIELDED;             \
+            }                                  \
+    } while (0)
+#define PROCESS_WAIT_EVENT() PROCESS_WAIT_EVENT_UNTIL(1)
+#define PROCESS_YIELD() PROCESS_WAIT_EVENT_UNTIL(1)
+/* Without yielding if already true */
+#define PROCESS_WAIT_UNTIL(c)         \
+    do {                              \
+        process_pt->lc = __LINE__;    \
+        __attribute__((fallthrough)); \
+        case __LINE__:                \
+            if (!(c)) {               \
+                return PT_WAITING;    \
+            }                         \
+    } while (0)
+#define PROCESS_WAIT_WHILE(c) PROCESS_WAIT_UNTIL(!(c))
+#define PROCESS_PAUSE()                                            \
+    do {                                                           \
+        process_post(PROCESS_CURRENT(), PROCESS_EVENT_CONTINUE, NULL); \
+        PROCESS_WAIT_EVENT_UNTIL(ev == PROCESS_EVENT_CONTINUE);    \
+    } while (0)
+#define PROCESS_EXIT()      \
+    do {                    \
+        process_pt->lc = 0; \
+        return PT_EXITED;   \
+    } while (0)
+
+#define PROCESS_CURRENT() process_current
+extern struct process* process_current;
+
+void process_start(struct process* p, process_data_t data);
+int process_post(struct process* p, process_event_t ev, process_data_t data);
+void process_poll(struct process* p);
+int process_is_running(struct process* p);
+
+/* Host only: run polls and posted events, returns the number left */
+int process_run(void);
+
+/*
+ * Clock and event timers. The clock is only advanced by clock_advance(), so
+ * the timers expire when the tools say so.
+ */
+#define CLOCK_SECOND 128
+
+typedef uint32_t clock_time_t;
+
+struct etimer
+{
+    struct etimer* next;
+    struct process* p;
+    clock_time_t start;
+    clock_time_t interval;
+    int expired;
+};
+
+clock_time_t clock_time(void);
+
+void etimer_set(struct etimer* et, clock_time_t interval);
+void etimer_reset(struct etimer* et);
+void etimer_restart(struct etimer* et);
+void etimer_stop(struct etimer* et);
+int etimer_expired(struct etimer* et);
+clock_time_t etimer_expiration_time(struct etimer* et);
+
+/* Host only: advance the clock, posting PROCESS_EVENT_TIMER for expired timers */
+void clock_advance(clock_time_t ticks);
+
+/*
+ * System
+ */
+void mira_sys_reset(void);
+
+/* Host only: number of calls to mira_sys_reset() */
+extern unsigned int mira_host_resets;
+
+/*
+ * Config storage, in a file on the host
+ */
+mira_status_t mira_config_read(void* config, size_t size);
+mira_status_t mira_config_write(const void* config, size_t size);
+int mira_config_is_working(void);
+
+/* Host only: the file of the config storage */
+extern const char* mira_host_config_file;
+
+/*
+ * Network. The addresses are fixed, and the network never joins.
+ */
+#define MIRA_NET_MAX_ADDRESS_STR_LEN 40
+
+#define MIRA_NET_MODE_MESH 0
+#define MIRA_NET_MODE_ROOT 1
+#define MIRA_NET_MODE_ROOT_NO_RECONNECT 2
+
+typedef struct
+{
+    uint8_t u8[16];
+} mira_net_address_t;
+
+typedef enum {
+    MIRA_NET_STATE_NOT_ASSOCIATED,
+    MIRA_NET_STATE_ASSOCIATED,
+    MIRA_NET_STATE_JOINED,
+    MIRA_NET_STATE_IS_COORDINATOR
+} mira_net_state_t;
+
+typedef struct
+{
+    uint32_t pan_id;
+    uint8_t key[16];
+    int mode;
+    int rate;
+    int antenna;
+    const char* prefix;
+    int max_connections;
+} mira_net_config_t;
+
+mira_status_t mira_net_init(const mira_net_config_t* config);
+mira_status_t mira_net_reinit(const mira_net_config_t* config);
+int mira_net_is_init(void);
+mira_net_state_t mira_net_get_state(void);
+mira_status_t mira_net_get_ll_address(mira_net_address_t* addr);
+mira_status_t mira_net_get_address(mira_net_address_t* addr);
+const char* mira_net_toolkit_format_address(char* buf, const mira_net_address_t* addr);
+
+/*
+ * Host only: the calls to mira_net_init() and mira_net_reinit(), with the
+ * config of the last one, and a line per call in the log if set.
+ */
+extern unsigned int mira_host_net_init_calls;
+extern mira_net_config_t mira_host_net_config;
+extern FILE* mira_host_net_log;
+
+#endif
@@ -0,0 +1,372 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 LumenRadio AB
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+/*
+ * Host implementation of the Mira API declared in mira.h, for the benchmarks
+ * and tools of the examples. Events are delivered in the order they are
+ * posted, polls before events, as on the nodes. Not for the nodes.
+ */
+
+#include <mira.h>
+
+#include <arpa/inet.h>
+#include <string.h>
+
+#define EVENT_QUEUE_SIZE 64
+
+#define STATE_NONE 0
+#define STATE_RUNNING 1
+#define STATE_CALLED 2
+
+struct process* process_current;
+
+static struct process* process_list;
+static volatile int poll_requested;
+
+static struct
+{
+    struct process* p;
+    process_event_t ev;
+    process_data_t data;
+} events[EVENT_QUEUE_SIZE];
+static int first_event;
+static int n_events;
+
+static void exit_process(struct process* p);
+
+static void call_process(struct process* p, process_event_t ev, process_data_t data)
+{
+    struct process* caller = process_current;
+    char ret;
+
+    /* Not while running already, as on the nodes */
+    if (p->state != STATE_RUNNING) {
+        return;
+    }
+    process_current = p;
+    p->state = STATE_CALLED;
+    ret = p->thread(&p->pt, ev, data);
+    process_current = caller;
+    if (ret == PT_EXITED || ret == PT_ENDED || ev == PROCESS_EVENT_EXIT) {
+        exit_process(p);
+    } else {
+        p->state = STATE_RUNNING;
+    }
+}
+
+static void exit_process(struct process* p)
+{
+    struct process** link;
+    struct process* q;
+
+    if (p->state == STATE_NONE) {
+        return;
+    }
+    p->state = STATE_NONE;
+    for (link = &process_list; *link != NULL; link = &(*link)->next) {
+        if (*link == p) {
+            *link = p->next;
+            break;
+        }
+    }
+    for (q = process_list; q != NULL; q = q->next) {
+        call_process(q, PROCESS_EVENT_EXITED, p);
+    }
+}
+
+void process_start(struct process* p, process_data_t data)
+{
+    if (p->state != STATE_NONE) {
+        return;
+    }
+    p->next = process_list;
+    process_list = p;
+    p->state = STATE_RUNNING;
+    p->needspoll = 0;
+    p->pt.lc = 0;
+    call_process(p, PROCESS_EVENT_INIT, data);
+}
+
+int process_post(struct process* p, process_event_t ev, process_data_t data)
+{
+    int idx;
+    if (n_events == EVENT_QUEUE_SIZE) {
+        return 1;
+    }
+    idx = (first_event + n_events++) % EVENT_QUEUE_SIZE;
+    events[idx].p = p;
+    events[idx].ev = ev;
+    events[idx].data = data;
+    return 0;
+}
+
+void process_poll(struct process* p)
+{
+    if (p != NULL && p->state != STATE_NONE) {
+        p->needspoll = 1;
+        poll_requested = 1;
+    }
+}
+
+int process_is_running(struct process* p)
+{
+    return p->state != STATE_NONE;
+}
+
+int process_run(void)
+{
+    struct process* p;
+
+    while (poll_requested) {
+        poll_requested = 0;
+        for (p = process_list; p != NULL; p = p->next) {
+            if (p->needspoll) {
+                p->needspoll = 0;
+                call_process(p, PROCESS_EVENT_POLL, NULL);
+            }
+        }
+    }
+
+    if (n_events > 0) {
+        struct process* target = events[first_event].p;
+        process_event_t ev = events[first_event].ev;
+        process_data_t data = events[first_event].data;
+
+        first_event = (first_event + 1) % EVENT_QUEUE_SIZE;
+        n_events--;
+        if (target == NULL) {
+            for (p = process_list; p != NULL; p = p->next) {
+                call_process(p, ev, data);
+            }
+        } else {
+            call_process(target, ev, data);
+        }
+    }
+    return n_events + poll_requested;
+}
+
+/*
+ * Clock and event timers
+ */
+static clock_time_t current_time;
+static struct etimer* timer_list;
+
+clock_time_t clock_time(void)
+{
+    return current_time;
+}
+
+static void etimer_add(struct etimer* et)
+{
+    struct etimer* t;
+
+    et->p = process_current;
+    et->expired = 0;
+    for (t = timer_list; t != NULL; t = t->next) {
+        if (t == et) {
+            return;
+        }
+    }
+    et->next = timer_list;
+    timer_list = et;
+}
+
+void etimer_set(struct etimer* et, clock_time_t interval)
+{
+    et->start = current_time;
+    et->interval = interval;
+    etimer_add(et);
+}
+
+void etimer_reset(struct etimer* et)
+{
+    et->start += et->interval;
+    etimer_add(et);
+}
+
+void etimer_restart(struct etimer* et)
+{
+    et->start = current_time;
+    etimer_add(et);
+}
+
+void etimer_stop(struct etimer* et)
+{
+    struct etimer** link;
+
+    for (link = &timer_list; *link != NULL; link = &(*link)->next) {
+        if (*link == et) {
+            *link = et->next;
+            break;
+        }
+    }
+    et->expired = 1;
+}
+
+int etimer_expired(struct etimer* et)
+{
+    return et->expired;
+}
+
+clock_time_t etimer_expiration_time(struct etimer* et)
+{
+    return et->start + et->interval;
+}
+
+void clock_advance(clock_time_t ticks)
+{
+    struct etimer** link = &timer_list;
+
+    current_time += ticks;
+    while (*link != NULL) {
+        struct etimer* et = *link;
+
+        if ((clock_time_t)(current_time - et->start) >= et->interval) {
+            *link = et->next;
+            et->expired = 1;
+            process_post(et->p, PROCESS_EVENT_TIMER, et);
+        } else {
+            link = &et->next;
+        }
+    }
+}
+
+/*
+ * System
+ */
+unsigned int mira_host_resets;
+
+void mira_sys_reset(void)
+{
+    mira_host_resets++;
+}
+
+/*
+ * Config storage
+ */
+const char* mira_host_config_file = "mira_config.bin";
+
+mira_status_t mira_config_read(void* config, size_t size)
+{
+    FILE* f = fopen(mira_host_config_file, "rb");
+    size_t length;
+
+    if (f == NULL) {
+        return MIRA_FAILURE;
+    }
+    length = fread(config, 1, size, f);
+    fclose(f);
+    return length == size ? MIRA_SUCCESS : MIRA_FAILURE;
+}
+
+mira_status_t mira_config_write(const void* config, size_t size)
+{
+    FILE* f = fopen(mira_host_config_file, "wb");
+    size_t length;
+
+    if (f == NULL) {
+        return MIRA_FAILURE;
+    }
+    length = fwrite(config, 1, size, f);
+    if (fclose(f) != 0 || length != size) {
+        return MIRA_FAILURE;
+    }
+    return MIRA_SUCCESS;
+}
+
+int mira_config_is_working(void)
+{
+    return 0;
+}
+
+/*
+ * Network
+ */
+unsigned int mira_host_net_init_calls;
+mira_net_config_t mira_host_net_config;
+FILE* mira_host_net_log;
+
+static mira_status_t net_record(const char* call, const mira_net_config_t* config)
+{
+    int i;
+
+    mira_host_net_init_calls++;
+    mira_host_net_config = *config;
+    if (mira_host_net_log != NULL) {
+        fprintf(mira_host_net_log,
+                "%s: pan_id %08lx, mode %d, rate %d, antenna %d, key ",
+                call,
+                (unsigned long)config->pan_id,
+                config->mode,
+                config->rate,
+                config->antenna);
+        for (i = 0; i < 16; i++) {
+            fprintf(mira_host_net_log, "%02x", config->key[i]);
+        }
+        fprintf(mira_host_net_log, "\n");
+    }
+    return MIRA_SUCCESS;
+}
+
+mira_status_t mira_net_init(const mira_net_config_t* config)
+{
+    return net_record("mira_net_init", config);
+}
+
+mira_status_t mira_net_reinit(const mira_net_config_t* config)
+{
+    return net_record("mira_net_reinit", config);
+}
+
+int mira_net_is_init(void)
+{
+    return mira_host_net_init_calls > 0;
+}
+
+mira_net_state_t mira_net_get_state(void)
+{
+    return MIRA_NET_STATE_NOT_ASSOCIATED;
+}
+
+mira_status_t mira_net_get_ll_address(mira_net_address_t* addr)
+{
+    static const mira_net_address_t ll_address = { {
+      0xfe, 0x80, 0, 0, 0, 0, 0, 0, 0x02, 0x00, 0x00, 0xff, 0xfe, 0x00, 0x00, 0x01 } };
+
+    *addr = ll_address;
+    return MIRA_SUCCESS;
+}
+
+mira_status_t mira_net_get_address(mira_net_address_t* addr)
+{
+    (void)addr;
+    return MIRA_ERROR_RESOURCE_NOT_AVAILABLE;
+}
+
+const char* mira_net_toolkit_format_address(char* buf, const mira_net_address_t* addr)
+{
+    return inet_ntop(AF_INET6, addr->u8, buf, MIRA_NET_MAX_ADDRESS_STR_LEN);
+}
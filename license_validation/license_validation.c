@@ -28,6 +28,11 @@
 #include <mira.h>
 #include <stdio.h>
 
+/* Size of the memory buffer given to Mira */
+#ifndef MIRA_MEM_BUFFER_SIZE
+#define MIRA_MEM_BUFFER_SIZE 7592
+#endif
+
 MIRA_IODEFS(MIRA_IODEF_NONE,    /* fd 0: stdin */
             MIRA_IODEF_UART(0), /* fd 1: stdout */
             MIRA_IODEF_NONE     /* fd 2: stderr */
@@ -50,7 +55,7 @@ void mira_setup(void)
 #endif
     };
 
-    MIRA_MEM_SET_BUFFER(7592);
+    MIRA_MEM_SET_BUFFER(MIRA_MEM_BUFFER_SIZE);
 
     uart_ret = mira_uart_init(0, &uart_config);
     if (uart_ret != MIRA_SUCCESS) {
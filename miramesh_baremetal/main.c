@@ -34,6 +34,11 @@
 #include "nrf_soc.h"
 #include "nrf_sdm.h"
 
+/* Size of the memory buffer given to Mira */
+#ifndef MIRA_MEM_BUFFER_SIZE
+#define MIRA_MEM_BUFFER_SIZE 14944
+#endif
+
 #define UDP_PORT 456
 
 extern uint8_t __CertificateStart[];
@@ -137,7 +142,7 @@ int main(void)
     miramesh_init(&miramesh_config, NULL);
 
     /* Allow some memory to networking */
-    MIRA_MEM_SET_BUFFER(14944);
+    MIRA_MEM_SET_BUFFER(MIRA_MEM_BUFFER_SIZE);
 
     /* Start networking */
     mira_net_init(&net_config);
@@ -0,0 +1,129 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 LumenRadio AB
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+/*
+ * Benchmark of monitoring_parser.c on the host. A corpus of valid packets,
+ * reports to the root and packets to nodes, is built and then decoded
+ * record by record, as by the monitoring aggregator and the nodes, see
+ * parser_records.h. Prints the records and bytes decoded per second:
+ *
+ *   ./parser_bench [packets] [passes]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "parser_records.h"
+
+typedef struct
+{
+    uint8_t data[PARSER_RECORDS_PACKET_SIZE];
+    int len;
+} packet_t;
+
+/* Decode all packets once, returns the number of records */
+static unsigned long decode_corpus(const packet_t* packets, int n_packets, uint32_t* sum)
+{
+    unsigned long records = 0;
+    monitoring_reader_t reader;
+    monitoring_reader_t record;
+    uint32_t id;
+    int i;
+
+    for (i = 0; i < n_packets; ++i) {
+        monitoring_reader_init(&reader, packets[i].data, packets[i].len);
+        while (monitoring_reader_record(&reader, &id, &record)) {
+            if (!parser_records_decode(id, &record, sum)) {
+                fprintf(stderr, "parser_bench: packet %d has an invalid record %lu\n", i,
+                        (unsigned long)id);
+                exit(1);
+            }
+            records++;
+        }
+        if (reader.error) {
+            fprintf(stderr, "parser_bench: packet %d is invalid\n", i);
+            exit(1);
+        }
+    }
+    return records;
+}
+
+int main(int argc, char** argv)
+{
+    int n_packets = argc > 1 ? atoi(argv[1]) : 4096;
+    int passes = argc > 2 ? atoi(argv[2]) : 500;
+    unsigned long expected = 0;
+    unsigned long records = 0;
+    unsigned long bytes = 0;
+    uint32_t rng_state = 2463534242u;
+    uint32_t sum = 0;
+    struct timespec start;
+    struct timespec end;
+    packet_t* packets;
+    double seconds;
+    int n;
+    int i;
+
+    if (n_packets < 1 || passes < 1) {
+        fprintf(stderr, "usage: %s [packets] [passes]\n", argv[0]);
+        return 1;
+    }
+    packets = malloc(n_packets * sizeof(packets[0]));
+    if (packets == NULL) {
+        return 1;
+    }
+    for (i = 0; i < n_packets; ++i) {
+        packets[i].len = parser_records_build(packets[i].data, &rng_state, &n);
+        expected += n;
+        bytes += packets[i].len;
+    }
+    if (decode_corpus(packets, n_packets, &sum) != expected) {
+        fprintf(stderr, "parser_bench: records missing in the decoded corpus\n");
+        return 1;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < passes; ++i) {
+        records += decode_corpus(packets, n_packets, &sum);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    seconds = end.tv_sec - start.tv_sec + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+    printf("%d packets, %lu records, %lu bytes, %d passes in %.2f s\n",
+           n_packets,
+           expected,
+           bytes,
+           passes,
+           seconds);
+    printf("%.0f records/s, %.1f MB/s, %.1f ns/record (sum %08lx)\n",
+           records / seconds,
+           bytes * passes / seconds / 1e6,
+           seconds * 1e9 / records,
+           (unsigned long)sum);
+    free(packets);
+    return 0;
+}
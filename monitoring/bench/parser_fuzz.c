@@ -0,0 +1,259 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 LumenRadio AB
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+/*
+ * Fuzzer of monitoring_parser.c on the host. Each input is read as a packet,
+ * record by record, and each record is decoded as by the aggregator and the
+ * nodes, see parser_records.h, and also parsed as a config. Then the readers
+ * are checked: records within the packet, no reads past the end, errors
+ * that stick, and a parsed config encoding back to the bytes it was parsed
+ * from. Any failed check aborts, as do the sanitizers of `make fuzz`.
+ *
+ * Standalone, the inputs are mutations of valid packets, from a seed, so a
+ * run can be repeated:
+ *
+ *   ./parser_fuzz [iterations] [seed]
+ *
+ * With PARSER_FUZZ_LIBFUZZER defined, LLVMFuzzerTestOneInput() is built
+ * instead, for libFuzzer with clang -fsanitize=fuzzer, see `make libfuzz`.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "monitoring.h"
+#include "parser_records.h"
+
+#define MAX_INPUT_SIZE 512
+
+static void check(bool ok, const char* what)
+{
+    if (!ok) {
+        fprintf(stderr, "parser_fuzz: %s\n", what);
+        abort();
+    }
+}
+
+static void check_reader(const monitoring_reader_t* reader)
+{
+    uint8_t byte;
+
+    check(reader->pos >= 0 && reader->pos <= reader->len, "read past the end");
+    if (reader->error) {
+        monitoring_reader_t copy = *reader;
+
+        check(monitoring_reader_left(&copy) == 0, "bytes left after an error");
+        check(!monitoring_reader_u8(&copy, &byte), "read after an error");
+        check(copy.pos == reader->pos, "moved after an error");
+    }
+}
+
+/* A config that parses has valid values and is encoded canonically */
+static void check_config(const monitoring_reader_t* record)
+{
+    monitoring_reader_t reader = *record;
+    monitoring_config_t config;
+    uint8_t encoded[64];
+    int len;
+    int id;
+
+    if (!monitoring_parse_config(&reader, &config)) {
+        check_reader(&reader);
+        return;
+    }
+    check_reader(&reader);
+    check(config.send_interval >= 1, "config with a zero interval");
+    for (id = 0; id <= MONITORING_CONF_MAX_ID; ++id) {
+        check(config.fields[id] == 0 ||
+                  ((config.ids & (1 << id)) && id != MIRA_MON_CONF_CONFIG_VERSION),
+              "config fields of an ID that isn't set");
+    }
+    len = parser_records_put_config(encoded, &config);
+    check(len == reader.pos, "config encodes to another length");
+    check(memcmp(encoded, record->data, len) == 0, "config encodes to other bytes");
+}
+
+static void fuzz_one(const uint8_t* data, size_t size)
+{
+    monitoring_reader_t reader;
+    monitoring_reader_t record;
+    uint32_t sum = 0;
+    uint32_t id;
+    int end = 0;
+
+    monitoring_reader_init(&reader, data, size);
+    while (monitoring_reader_record(&reader, &id, &record)) {
+        check_reader(&reader);
+        check(id != 0, "record with the end marker ID");
+        check(record.data >= data && record.data + record.len == data + reader.pos,
+              "record outside the packet");
+        check(record.data >= data + end, "records overlapping");
+        end = reader.pos;
+
+        check_config(&record);
+        parser_records_decode(id, &record, &sum);
+        check_reader(&record);
+    }
+    check_reader(&reader);
+}
+
+#ifdef PARSER_FUZZ_LIBFUZZER
+
+int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+    if (size <= MAX_INPUT_SIZE) {
+        fuzz_one(data, size);
+    }
+    return 0;
+}
+
+#else
+
+typedef struct
+{
+    uint8_t data[MAX_INPUT_SIZE];
+    size_t size;
+} input_t;
+
+static input_t corpus[64];
+static int corpus_size;
+
+static uint64_t rng_state;
+
+static uint32_t rng(void)
+{
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state >> 32;
+}
+
+static void build_corpus(uint32_t seed)
+{
+    uint32_t state = seed | 1;
+    int records;
+
+    for (corpus_size = 0; corpus_size < (int)(sizeof(corpus) / sizeof(corpus[0]));
+         corpus_size++) {
+        corpus[corpus_size].size = parser_records_build(corpus[corpus_size].data, &state, &records);
+    }
+}
+
+static void mutate(input_t* input)
+{
+    /* MBI edges: continuation bits, the leading zero digit, the largest */
+    static const uint8_t interesting[] = { 0, 1, 0x7f, 0x80, 0x81, 0x8f, 0x90, 0xff };
+    size_t pos = input->size > 0 ? rng() % input->size : 0;
+    const input_t* other;
+    size_t length;
+
+    switch (rng() % 7) {
+        case 0:
+            if (pos < input->size) {
+                input->data[pos] ^= 1 << (rng() % 8);
+            }
+            break;
+        case 1:
+            if (pos < input->size) {
+                input->data[pos] = rng();
+            }
+            break;
+        case 2:
+            if (pos < input->size) {
+                input->data[pos] = interesting[rng() % sizeof(interesting)];
+            }
+            break;
+        case 3:
+            /* Insert a byte */
+            if (input->size < MAX_INPUT_SIZE) {
+                memmove(&input->data[pos + 1], &input->data[pos], input->size - pos);
+                input->data[pos] = interesting[rng() % sizeof(interesting)];
+                input->size++;
+            }
+            break;
+        case 4:
+            /* Delete bytes */
+            length = rng() % 8;
+            if (pos + length <= input->size) {
+                memmove(&input->data[pos], &input->data[pos + length], input->size - pos - length);
+                input->size -= length;
+            }
+            break;
+        case 5:
+            /* Append another input */
+            other = &corpus[rng() % corpus_size];
+            if (input->size + other->size <= MAX_INPUT_SIZE) {
+                memcpy(&input->data[input->size], other->data, other->size);
+                input->size += other->size;
+            }
+            break;
+        case 6:
+            input->size = rng() % (input->size + 1);
+            break;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    unsigned long iterations = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000000;
+    unsigned long seed = argc > 2 ? strtoul(argv[2], NULL, 10) : 1;
+    unsigned long bytes = 0;
+    struct timespec start;
+    struct timespec end;
+    unsigned long i;
+    double seconds;
+    input_t input;
+    int n;
+
+    rng_state = seed * 0x9e3779b97f4a7c15ULL + 1;
+    build_corpus(seed);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < iterations; i++) {
+        input = corpus[rng() % corpus_size];
+        for (n = 1 + rng() % 4; n > 0; n--) {
+            mutate(&input);
+        }
+        fuzz_one(input.data, input.size);
+        bytes += input.size;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    seconds = end.tv_sec - start.tv_sec + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+    fprintf(stderr,
+            "%lu inputs, %lu bytes in %.2f s, %.0f inputs/s, seed %lu\n",
+            iterations,
+            bytes,
+            seconds,
+            iterations / seconds,
+            seed);
+    return 0;
+}
+
+#endif
@@ -0,0 +1,305 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 LumenRadio AB
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include <string.h>
+
+#include "monitoring.h"
+#include "parser_records.h"
+
+/* Size of the fields in the records, in bytes, or MBI encoded */
+#define MBI 0
+
+static const int mac_stats_sizes[] = { 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 1 };
+static const int memory_sizes[] = { MBI, MBI, MBI, MBI };
+static const int topology_sizes[] = { 8, 2, 2 };
+
+#define N_FIELDS(sizes) (int)(sizeof(sizes) / sizeof(sizes[0]))
+
+static uint32_t rng(uint32_t* state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+    return *state;
+}
+
+/* Random values of all MBI lengths */
+static uint32_t random_value(uint32_t* state)
+{
+    return rng(state) >> (rng(state) % 32);
+}
+
+static int put_mbi(uint8_t* data, uint32_t value)
+{
+    int len = 1;
+    int i;
+
+    while (len < 5 && (value >> (7 * len)) != 0) {
+        len++;
+    }
+    for (i = 0; i < len; ++i) {
+        data[i] = ((value >> (7 * (len - 1 - i))) & 0x7f) | (i < len - 1 ? 0x80 : 0);
+    }
+    return len;
+}
+
+static int put_value(uint8_t* data, int size, uint32_t value)
+{
+    int i;
+
+    if (size == MBI) {
+        return put_mbi(data, value);
+    }
+    for (i = 0; i < size; ++i) {
+        data[i] = i < 4 ? value >> (8 * i) : value;
+    }
+    return size;
+}
+
+static int put_record(uint8_t* data, uint32_t id, const uint8_t* body, int body_len)
+{
+    int len = put_mbi(data, id);
+
+    len += put_mbi(&data[len], body_len);
+    memcpy(&data[len], body, body_len);
+    return len + body_len;
+}
+
+/* A record with a bit field and the fields set in it */
+static int put_fields_record(uint8_t* data,
+                             uint32_t id,
+                             uint32_t fields,
+                             const int* sizes,
+                             int n_fields,
+                             uint32_t* state)
+{
+    uint8_t body[64];
+    int len = put_mbi(body, fields);
+    int field;
+
+    for (field = 0; field < n_fields; ++field) {
+        if (fields & (1 << field)) {
+            len += put_value(&body[len], sizes[field], random_value(state));
+        }
+    }
+    return put_record(data, id, body, len);
+}
+
+int parser_records_put_config(uint8_t* data, const monitoring_config_t* config)
+{
+    int len = 0;
+    int id;
+
+    data[len++] = config->version;
+    len += put_mbi(&data[len], config->send_interval);
+    len += put_mbi(&data[len], config->ids);
+    for (id = 0; id <= MONITORING_CONF_MAX_ID; ++id) {
+        if ((config->ids & (1 << id)) && id != MIRA_MON_CONF_CONFIG_VERSION) {
+            len += put_mbi(&data[len], config->fields[id]);
+        }
+    }
+    return len;
+}
+
+/* The first packet of a report, as sent by a node */
+static int build_report(uint8_t* data, uint32_t* state, int* records)
+{
+    uint8_t body[16];
+    int len = 0;
+    int n;
+
+    len += put_fields_record(&data[len],
+                             MIRA_MON_ID_MAC_STATS,
+                             1 + rng(state) % 0x7ff,
+                             mac_stats_sizes,
+                             N_FIELDS(mac_stats_sizes),
+                             state);
+
+    body[0] = rng(state);
+    len += put_record(&data[len], MIRA_MON_ID_CONFIG_VERSION, body, 1);
+
+    n = put_value(body, 2, rng(state));
+    len += put_record(&data[len], MIRA_MON_ID_REPORT_SLOT, body, n);
+
+    len += put_fields_record(&data[len],
+                             MIRA_MON_ID_MEMORY,
+                             1 + rng(state) % 0xf,
+                             memory_sizes,
+                             N_FIELDS(memory_sizes),
+                             state);
+
+    /* Latency probe, the echo field has no data */
+    n = put_mbi(body, rng(state) % 4);
+    n += put_value(&body[n], 1, rng(state));
+    n += put_value(&body[n], 4, rng(state));
+    if (body[0] & (1 << MIRA_MON_CONF_LATENCY_PROBE_RTT)) {
+        n += put_mbi(&body[n], random_value(state));
+    }
+    len += put_record(&data[len], MIRA_MON_ID_LATENCY_PROBE, body, n);
+
+    len += put_fields_record(&data[len],
+                             MIRA_MON_ID_NET_TOPOLOGY,
+                             1 + rng(state) % 7,
+                             topology_sizes,
+                             N_FIELDS(topology_sizes),
+                             state);
+    *records = 6;
+    return len;
+}
+
+/* A packet from the root to a node */
+static int build_to_node(uint8_t* data, uint32_t* state, int* records)
+{
+    monitoring_config_t config;
+    uint8_t body[64];
+    int len = 0;
+    int n;
+    int id;
+
+    memset(&config, 0, sizeof(config));
+    config.version = rng(state);
+    config.send_interval = 1 + rng(state) % 60;
+    config.ids = rng(state);
+    for (id = 0; id <= MONITORING_CONF_MAX_ID; ++id) {
+        if ((config.ids & (1 << id)) && id != MIRA_MON_CONF_CONFIG_VERSION) {
+            config.fields[id] = random_value(state);
+        }
+    }
+    n = parser_records_put_config(body, &config);
+    len += put_record(&data[len], MIRA_MON_ID_CONFIG, body, n);
+
+    n = put_value(body, 2, rng(state));
+    len += put_record(&data[len], MIRA_MON_ID_REPORT_SLOT_ASSIGN, body, n);
+
+    n = put_value(body, 1, rng(state));
+    n += put_value(&body[n], 4, rng(state));
+    len += put_record(&data[len], MIRA_MON_ID_LATENCY_ECHO, body, n);
+
+    *records = 3;
+    return len;
+}
+
+int parser_records_build(uint8_t* data, uint32_t* rng_state, int* records)
+{
+    if (rng(rng_state) % 4 != 0) {
+        return build_report(data, rng_state, records);
+    }
+    return build_to_node(data, rng_state, records);
+}
+
+static bool read_field(monitoring_reader_t* record, int size, uint32_t* sum)
+{
+    uint32_t value;
+    uint16_t u16;
+    uint8_t u8;
+    int i;
+
+    switch (size) {
+        case MBI:
+            if (!monitoring_reader_mbi(record, &value)) {
+                return false;
+            }
+            *sum += value;
+            return true;
+        case 1:
+            if (!monitoring_reader_u8(record, &u8)) {
+                return false;
+            }
+            *sum += u8;
+            return true;
+        case 2:
+            if (!monitoring_reader_u16(record, &u16)) {
+                return false;
+            }
+            *sum += u16;
+            return true;
+    }
+    for (i = 0; i < size; i += 4) {
+        if (!monitoring_reader_u32(record, &value)) {
+            return false;
+        }
+        *sum += value;
+    }
+    return true;
+}
+
+static bool read_fields(monitoring_reader_t* record, const int* sizes, int n_fields, uint32_t* sum)
+{
+    uint32_t fields;
+    int field;
+
+    if (!monitoring_reader_mbi(record, &fields)) {
+        return false;
+    }
+    for (field = 0; field < n_fields; ++field) {
+        if ((fields & (1 << field)) && !read_field(record, sizes[field], sum)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool parser_records_decode(uint32_t id, monitoring_reader_t* record, uint32_t* sum)
+{
+    monitoring_config_t config;
+    uint32_t fields;
+    int i;
+
+    switch (id) {
+        case MIRA_MON_ID_MAC_STATS:
+            return read_fields(record, mac_stats_sizes, N_FIELDS(mac_stats_sizes), sum);
+        case MIRA_MON_ID_MEMORY:
+            return read_fields(record, memory_sizes, N_FIELDS(memory_sizes), sum);
+        case MIRA_MON_ID_NET_TOPOLOGY:
+            return read_fields(record, topology_sizes, N_FIELDS(topology_sizes), sum);
+        case MIRA_MON_ID_LATENCY_PROBE:
+            if (!monitoring_reader_mbi(record, &fields) || !read_field(record, 1, sum) ||
+                !read_field(record, 4, sum)) {
+                return false;
+            }
+            return (fields & (1 << MIRA_MON_CONF_LATENCY_PROBE_RTT)) == 0 ||
+                   read_field(record, MBI, sum);
+        case MIRA_MON_ID_CONFIG_VERSION:
+            return read_field(record, 1, sum);
+        case MIRA_MON_ID_REPORT_SLOT:
+        case MIRA_MON_ID_REPORT_SLOT_ASSIGN:
+            return read_field(record, 2, sum);
+        case MIRA_MON_ID_LATENCY_ECHO:
+            return read_field(record, 1, sum) && read_field(record, 4, sum);
+        case MIRA_MON_ID_CONFIG:
+            if (!monitoring_parse_config(record, &config)) {
+                return false;
+            }
+            *sum += config.version + config.send_interval + config.ids;
+            for (i = 0; i <= MONITORING_CONF_MAX_ID; ++i) {
+                *sum += config.fields[i];
+            }
+            return true;
+    }
+    /* Unknown records are skipped, as by the nodes and the root */
+    return true;
+}
@@ -0,0 +1,62 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 LumenRadio AB
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#ifndef PARSER_RECORDS_H
+#define PARSER_RECORDS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "monitoring_parser.h"
+
+/*
+ * Monitoring records on the host, for the benchmark and the fuzzer of
+ * monitoring_parser.c. Packets are built with random values, the way
+ * monitoring.c and the monitoring aggregator build them, and the records are
+ * decoded the way they read them, see monitoring.h.
+ */
+
+/* As MONITOR_PACKET_SIZE in monitoring.c */
+#define PARSER_RECORDS_PACKET_SIZE 150
+
+/*
+ * Build a valid packet, a report to the root or a packet to a node, from
+ * the random state. Returns the length, and the number of records in
+ * records.
+ */
+int parser_records_build(uint8_t* data, uint32_t* rng_state, int* records);
+
+/*
+ * Decode the data of a record. The values are added to sum, so the decoding
+ * can't be optimized away. Returns false if the record is malformed.
+ */
+bool parser_records_decode(uint32_t id, monitoring_reader_t* record, uint32_t* sum);
+
+/* Encode the data of a MIRA_MON_ID_CONFIG record. Returns the length. */
+int parser_records_put_config(uint8_t* data, const monitoring_config_t* config);
+
+#endif
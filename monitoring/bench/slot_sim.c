@@ -0,0 +1,229 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 LumenRadio AB
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+/*
+ * Host simulation of the report schedulers, for the load on the root.
+ *
+ * For each number of nodes, the reports of one interval are counted per
+ * window of time, with the slots assigned by the root and the slots hashed
+ * from the node addresses, from monitoring_slot.c, and with the random
+ * +-25% interval of monitoring.c. Prints the average and worst busiest
+ * window over many sets of addresses, and the share of reports sharing a
+ * window with another report.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "monitoring_slot.h"
+
+/* A one minute interval in 10 ms network time ticks, as in monitoring.c */
+#define INTERVAL_TICKS 6000
+
+/* Sets of addresses simulated per number of nodes */
+#define TRIALS 1000
+
+/* Intervals run with the random scheduler before counting */
+#define RANDOM_WARMUP_INTERVALS 20
+
+static const int node_counts[] = { 100, 200, 500 };
+
+/* Window sizes, in ticks */
+static const int windows[] = { 10, 100 };
+
+static uint32_t rng_state = 2463534242u;
+
+static uint32_t rng(void)
+{
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+typedef enum {
+    IIDS_RANDOM,
+    IIDS_SEQUENTIAL,
+} iid_kind_t;
+
+/*
+ * Interface identifiers, either random, or a batch of devices from one
+ * vendor, with the same upper bytes and consecutive serial numbers.
+ */
+static void make_iids(uint8_t (*iids)[8], int n, iid_kind_t kind)
+{
+    uint32_t base = rng();
+    uint32_t vendor = rng();
+
+    for (int i = 0; i < n; ++i) {
+        uint32_t lower = kind == IIDS_SEQUENTIAL ? base + i : rng();
+        uint32_t upper = kind == IIDS_SEQUENTIAL ? vendor : rng();
+        for (int j = 0; j < 4; ++j) {
+            iids[i][j] = upper >> (24 - 8 * j);
+            iids[i][4 + j] = lower >> (24 - 8 * j);
+        }
+    }
+}
+
+/* Report times within the interval, in ticks */
+static void assigned_times(uint32_t* times, int n)
+{
+    for (int i = 0; i < n; ++i) {
+        times[i] = monitoring_slot_assigned_offset(monitoring_slot_assign(i), INTERVAL_TICKS);
+    }
+}
+
+static void hashed_times(uint32_t* times, uint8_t (*iids)[8], int n)
+{
+    for (int i = 0; i < n; ++i) {
+        times[i] = monitoring_slot_offset(iids[i], INTERVAL_TICKS);
+    }
+}
+
+/*
+ * Each node starts at a random time and waits 75% to 125% of the interval
+ * between reports, as monitoring_random_interval(). The reports in one
+ * interval after the warmup are counted; a node reports 0 to 2 times.
+ */
+static int random_times(uint32_t* times, int n)
+{
+    const uint32_t start = RANDOM_WARMUP_INTERVALS * INTERVAL_TICKS;
+    int count = 0;
+
+    for (int i = 0; i < n; ++i) {
+        uint32_t t = rng() % INTERVAL_TICKS;
+        while (t < start + INTERVAL_TICKS) {
+            if (t >= start) {
+                times[count++] = t - start;
+            }
+            t += 3 * INTERVAL_TICKS / 4 + rng() % (INTERVAL_TICKS / 2 + 1);
+        }
+    }
+    return count;
+}
+
+typedef struct
+{
+    int peak;   /* Reports in the busiest window */
+    int shared; /* Reports sharing a window with another report */
+} window_load_t;
+
+/* Windows wrap around the interval, as the schedule repeats */
+static window_load_t window_load(const uint32_t* times, int n, int window)
+{
+    static int counts[INTERVAL_TICKS];
+    window_load_t load = { 0, 0 };
+    int n_windows = INTERVAL_TICKS / window;
+
+    memset(counts, 0, sizeof(counts));
+    for (int i = 0; i < n; ++i) {
+        counts[times[i] / window]++;
+    }
+    for (int i = 0; i < n_windows; ++i) {
+        if (counts[i] > load.peak) {
+            load.peak = counts[i];
+        }
+        if (counts[i] > 1) {
+            load.shared += counts[i];
+        }
+    }
+    return load;
+}
+
+typedef struct
+{
+    long peak_sum;
+    int peak_max;
+    long shared;
+    long reports;
+} load_stats_t;
+
+static void add_load(load_stats_t* stats, const uint32_t* times, int n, int window)
+{
+    window_load_t load = window_load(times, n, window);
+    stats->peak_sum += load.peak;
+    if (load.peak > stats->peak_max) {
+        stats->peak_max = load.peak;
+    }
+    stats->shared += load.shared;
+    stats->reports += n;
+}
+
+static void print_load(const char* name, const load_stats_t* stats)
+{
+    printf("  %-18s busiest window avg %5.2f max %2d, reports sharing a window %5.1f%%\n",
+           name,
+           (double)stats->peak_sum / TRIALS,
+           stats->peak_max,
+           100.0 * stats->shared / stats->reports);
+}
+
+int main(void)
+{
+    for (size_t w = 0; w < sizeof(windows) / sizeof(windows[0]); ++w) {
+        int window = windows[w];
+
+        for (size_t c = 0; c < sizeof(node_counts) / sizeof(node_counts[0]); ++c) {
+            int n = node_counts[c];
+            uint8_t(*iids)[8] = malloc(n * sizeof(*iids));
+            uint32_t* times = malloc(2 * n * sizeof(*times));
+            load_stats_t assigned = { 0 };
+            load_stats_t hashed_random = { 0 };
+            load_stats_t hashed_sequential = { 0 };
+            load_stats_t random = { 0 };
+
+            for (int trial = 0; trial < TRIALS; ++trial) {
+                assigned_times(times, n);
+                add_load(&assigned, times, n, window);
+
+                make_iids(iids, n, IIDS_RANDOM);
+                hashed_times(times, iids, n);
+                add_load(&hashed_random, times, n, window);
+
+                make_iids(iids, n, IIDS_SEQUENTIAL);
+                hashed_times(times, iids, n);
+                add_load(&hashed_sequential, times, n, window);
+
+                add_load(&random, times, random_times(times, n), window);
+            }
+
+            printf("%d nodes, %d ms windows, %d per interval, %.2f reports per window avg\n",
+                   n,
+                   window * 10,
+                   INTERVAL_TICKS / window,
+                   (double)n * window / INTERVAL_TICKS);
+            print_load("assigned slots", &assigned);
+            print_load("hashed, random", &hashed_random);
+            print_load("hashed, serial", &hashed_sequential);
+            print_load("random interval", &random);
+
+            free(iids);
+            free(times);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,94 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 LumenRadio AB
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include <malloc.h>
+#include <stdint.h>
+#include "mem_watermark.h"
+
+#define STACK_PATTERN 0xa5
+
+/* Keep this much below the current stack pointer untouched when filling */
+#define STACK_MARGIN 64
+
+/* Provided by the linker script, if available */
+extern uint8_t __StackLimit __attribute__((weak));
+extern uint8_t __StackTop __attribute__((weak));
+
+static uint8_t* stack_limit(void)
+{
+    return &__StackLimit;
+}
+
+static uint8_t* stack_top(void)
+{
+    return &__StackTop;
+}
+
+void mem_watermark_init(void)
+{
+    uint8_t here;
+    uint8_t* limit = stack_limit();
+
+    if (limit == NULL || stack_top() == NULL) {
+        return;
+    }
+    for (uint8_t* p = limit; p < &here - STACK_MARGIN; ++p) {
+        *p = STACK_PATTERN;
+    }
+}
+
+uint32_t mem_watermark_stack_peak(void)
+{
+    uint8_t* limit = stack_limit();
+    uint8_t* top = stack_top();
+    uint8_t* p;
+
+    if (limit == NULL || top == NULL) {
+        return 0;
+    }
+    for (p = limit; p < top && *p == STACK_PATTERN; ++p) {
+    }
+    return top - p;
+}
+
+uint32_t mem_watermark_stack_size(void)
+{
+    if (stack_limit() == NULL || stack_top() == NULL) {
+        return 0;
+    }
+    return stack_top() - stack_limit();
+}
+
+uint32_t mem_watermark_heap_peak(void)
+{
+    return mallinfo().arena;
+}
+
+uint32_t mem_watermark_heap_used(void)
+{
+    return mallinfo().uordblks;
+}
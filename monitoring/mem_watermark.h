@@ -0,0 +1,60 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 LumenRadio AB
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#ifndef MEM_WATERMARK_H
+#define MEM_WATERMARK_H
+
+#include <stdint.h>
+
+/*
+ * Memory high-water marks
+ *
+ * The stack is filled with a pattern at start, and the peak usage is found
+ * by looking for the deepest overwritten byte. This requires the linker
+ * script to provide __StackLimit and __StackTop, otherwise the stack usage
+ * is reported as 0.
+ *
+ * The heap usage is taken from the C library allocator. The arena only
+ * grows, so its size is the peak heap usage.
+ */
+
+/* Fill the unused part of the stack, call as early as possible */
+void mem_watermark_init(void);
+
+/* Peak stack usage in bytes, 0 if unknown */
+uint32_t mem_watermark_stack_peak(void);
+
+/* Size of the stack in bytes, 0 if unknown */
+uint32_t mem_watermark_stack_size(void);
+
+/* Peak heap usage in bytes */
+uint32_t mem_watermark_heap_peak(void);
+
+/* Current heap usage in bytes */
+uint32_t mem_watermark_heap_used(void);
+
+#endif
@@ -0,0 +1,346 @@
+#!/usr/bin/env python3
+
+# Mesh topology from monitoring reports, see MIRA_MON_ID_NET_TOPOLOGY in
+# monitoring.h
+#
+#
+# MIT License
+#
+# Copyright (c) 2023 LumenRadio AB
+#
+# SPDX-License-Identifier: MIT
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+#
+#
+#
+# Reads packets in the same format as monitoring_decoder.py, and keeps a graph
+# of the routing tree and neighbour links, updated with each report. Writes
+# snapshots as DOT or JSON, and answers queries on the tree.
+
+import argparse
+import heapq
+import ipaddress
+import json
+import random
+import sys
+import time
+
+from monitoring_decoder import DecodeError, MonitoringDecoder
+
+
+def normalize(address):
+    return str(ipaddress.IPv6Address(address))
+
+
+class MeshGraph:
+    """Routing tree and neighbour links of a mesh.
+
+    The size of each subtree is kept up to date when a parent changes, which
+    costs time proportional to the depth of the tree. This keeps the subtree
+    size query constant time.
+
+    Reports from different nodes can be out of date relative to each other,
+    so a parent change can form a loop. Such a change is kept aside, and
+    applied when a later change breaks the loop.
+    """
+
+    def __init__(self):
+        self.parent = {}
+        self.children = {}
+        self.size = {}
+        # node -> {neighbour: link attributes}, as last reported by the node
+        self.neighbours = {}
+        # node -> parent, for changes that would form a loop
+        self.pending = {}
+
+    def _add_node(self, node):
+        if node not in self.size:
+            self.size[node] = 1
+            self.children[node] = set()
+            self.neighbours[node] = {}
+
+    def _ancestors(self, node):
+        node = self.parent.get(node)
+        while node is not None:
+            yield node
+            node = self.parent.get(node)
+
+    def _apply(self, node, parent):
+        if parent == node or node in self._ancestors(parent):
+            return False
+        old = self.parent.get(node)
+        size = self.size[node]
+        if old is not None:
+            self.children[old].discard(node)
+            self.size[old] -= size
+            for ancestor in self._ancestors(old):
+                self.size[ancestor] -= size
+        self.parent[node] = parent
+        self.children[parent].add(node)
+        self.size[parent] += size
+        for ancestor in self._ancestors(parent):
+            self.size[ancestor] += size
+        return True
+
+    def set_parent(self, node, parent):
+        self._add_node(node)
+        self._add_node(parent)
+        if self.parent.get(node) == parent:
+            self.pending.pop(node, None)
+            return
+        if not self._apply(node, parent):
+            self.pending[node] = parent
+            return
+        self.pending.pop(node, None)
+
+        # The change may have broken a loop that kept others aside
+        applied = True
+        while applied and self.pending:
+            applied = False
+            for pending_node, pending_parent in list(self.pending.items()):
+                if self._apply(pending_node, pending_parent):
+                    del self.pending[pending_node]
+                    applied = True
+
+    def set_link(self, node, neighbour, **attrs):
+        self._add_node(node)
+        self._add_node(neighbour)
+        self.neighbours[node][neighbour] = attrs
+
+    def set_neighbours(self, node, neighbours):
+        self._add_node(node)
+        self.neighbours[node] = {}
+        for neighbour, attrs in neighbours.items():
+            self.set_link(node, neighbour, **attrs)
+
+    def hop_count(self, node):
+        """Hops to the root of the node's tree, 0 for a root"""
+        return sum(1 for _ in self._ancestors(node))
+
+    def subtree_size(self, node):
+        """Number of nodes routing through the node, including itself"""
+        return self.size.get(node, 0)
+
+    def roots(self):
+        return [node for node in self.size if node not in self.parent]
+
+    def critical_nodes(self, count):
+        """The nodes forwarding for the most other nodes, excluding roots.
+
+        Returns a list of (node, number of nodes routing through it).
+        """
+        best = heapq.nlargest(count, self.parent, key=self.size.__getitem__)
+        return [(node, self.size[node] - 1) for node in best if self.size[node] > 1]
+
+    def to_json(self):
+        return {
+            "nodes": [
+                {
+                    "address": node,
+                    "parent": self.parent.get(node),
+                    "hops": self.hop_count(node),
+                    "subtree_size": self.size[node],
+                }
+                for node in self.size
+            ],
+            "links": [
+                dict(source=node, target=neighbour, **attrs)
+                for node, neighbours in self.neighbours.items()
+                for neighbour, attrs in neighbours.items()
+            ],
+        }
+
+    def to_dot(self):
+        lines = ["digraph mesh {"]
+        for node in self.size:
+            lines.append(
+                '  "%s" [label="%s\\nhops %d, subtree %d"];'
+                % (node, node, self.hop_count(node), self.size[node])
+            )
+        for node, parent in self.parent.items():
+            lines.append('  "%s" -> "%s";' % (node, parent))
+        for node, neighbours in self.neighbours.items():
+            for neighbour, attrs in neighbours.items():
+                if self.parent.get(node) == neighbour:
+                    continue
+                label = ""
+                if "etx" in attrs:
+                    label = ' label="%.2f"' % attrs["etx"]
+                lines.append(
+                    '  "%s" -> "%s" [style=dashed constraint=false%s];'
+                    % (node, neighbour, label)
+                )
+        lines.append("}")
+        return "\n".join(lines) + "\n"
+
+
+def update_graph(graph, source, name, record):
+    source = normalize(source)
+    if name == "net_topology" and "parent" in record:
+        graph.set_parent(source, record["parent"])
+        link = {key: record[key] for key in ("etx", "rssi") if key in record}
+        if link:
+            graph.set_link(source, record["parent"], **link)
+    elif name == "net_neighbours":
+        graph.set_neighbours(
+            source,
+            {
+                nbr["address"]: {
+                    key: nbr[key] for key in ("etx", "rssi") if key in nbr
+                }
+                for nbr in record
+            },
+        )
+
+
+def write_snapshots(graph, args):
+    if args.json:
+        with open(args.json, "w") as f:
+            json.dump(graph.to_json(), f, indent=1)
+    if args.dot:
+        with open(args.dot, "w") as f:
+            f.write(graph.to_dot())
+
+
+def benchmark(nodes, changes):
+    """Time the updates and queries on a random tree"""
+    rng = random.Random(1)
+    graph = MeshGraph()
+    addresses = [normalize("fd00::%x" % (i + 1)) for i in range(nodes)]
+
+    # Each node picks a parent among the earlier ones, to make a tree
+    start = time.perf_counter()
+    for i in range(1, nodes):
+        graph.set_parent(addresses[i], addresses[rng.randrange(max(0, i - 20), i)])
+    build = time.perf_counter() - start
+
+    start = time.perf_counter()
+    for _ in range(changes):
+        i = rng.randrange(1, nodes)
+        graph.set_parent(addresses[i], addresses[rng.randrange(max(0, i - 20), i)])
+    update = (time.perf_counter() - start) / changes
+
+    start = time.perf_counter()
+    for address in addresses:
+        graph.subtree_size(address)
+    subtree = (time.perf_counter() - start) / nodes
+
+    start = time.perf_counter()
+    for address in addresses:
+        graph.hop_count(address)
+    hops = (time.perf_counter() - start) / nodes
+
+    repeats = 100
+    start = time.perf_counter()
+    for _ in range(repeats):
+        graph.critical_nodes(10)
+    critical = (time.perf_counter() - start) / repeats
+
+    return {
+        "nodes": nodes,
+        "max_hops": max(graph.hop_count(address) for address in addresses),
+        "build_ms": build * 1e3,
+        "update_us": update * 1e6,
+        "subtree_size_us": subtree * 1e6,
+        "hop_count_us": hops * 1e6,
+        "critical_nodes_10_us": critical * 1e6,
+    }
+
+
+def arg_build_parser():
+    parser = argparse.ArgumentParser(description="Mira mesh topology from monitoring reports")
+    parser.add_argument(
+        "input",
+        nargs="?",
+        type=argparse.FileType("r"),
+        default=sys.stdin,
+        help="File with one '<source> <hex payload>' per line (default: stdin)",
+    )
+    parser.add_argument("--dot", help="Write a DOT snapshot to this file")
+    parser.add_argument("--json", help="Write a JSON snapshot to this file")
+    parser.add_argument(
+        "--snapshot-interval",
+        type=int,
+        default=0,
+        help="Also write the snapshots every this many packets",
+    )
+    parser.add_argument(
+        "--subtree",
+        action="append",
+        default=[],
+        help="Print the subtree size of this node when done",
+    )
+    parser.add_argument(
+        "--critical",
+        type=int,
+        default=0,
+        help="Print this many nodes forwarding for the most other nodes when done",
+    )
+    parser.add_argument(
+        "--benchmark",
+        type=int,
+        nargs="+",
+        metavar="NODES",
+        help="Time the graph operations on random trees of these sizes",
+    )
+    return parser
+
+
+if __name__ == "__main__":
+    args = arg_build_parser().parse_args()
+
+    if args.benchmark:
+        for nodes in args.benchmark:
+            print(json.dumps(benchmark(nodes, 1000)))
+        sys.exit(0)
+
+    graph = MeshGraph()
+    decoder = MonitoringDecoder()
+    packets = 0
+
+    for line in args.input:
+        parts = line.split()
+        if len(parts) != 2:
+            continue
+        try:
+            for source, name, record in decoder.decode(parts[0], bytes.fromhex(parts[1])):
+                update_graph(graph, source, name, record)
+        except (ValueError, DecodeError) as e:
+            print(
+                "Could not decode packet from " + parts[0] + ": " + str(e),
+                file=sys.stderr,
+            )
+            continue
+        packets += 1
+        if args.snapshot_interval and packets % args.snapshot_interval == 0:
+            write_snapshots(graph, args)
+
+    write_snapshots(graph, args)
+    for node in args.subtree:
+        print(json.dumps({"node": node, "subtree_size": graph.subtree_size(normalize(node))}))
+    if args.critical:
+        print(
+            json.dumps(
+                [
+                    {"node": node, "forwards_for": count}
+                    for node, count in graph.critical_nodes(args.critical)
+                ]
+            )
+        )
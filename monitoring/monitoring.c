@@ -30,49 +30,118 @@
 #include <string.h>
 #include <stdbool.h>
 #include "monitoring.h"
+#include "mem_watermark.h"
+#include "monitoring_parser.h"
+#include "monitoring_slot.h"
+#include "process_profiler.h"
 
-#define MONITOR_UDP_PORT 6960
+/*
+ * Reports are by default sent in a per-node slot of the report interval,
+ * assigned by the root, or hashed from the node address until then, see
+ * monitoring_slot.h. The interval is aligned to the network time, so the
+ * slots of all nodes line up. Set to 0 to use a random interval of +-25%
+ * instead.
+ */
+#ifndef MONITOR_SLOTTED_SCHEDULING
+#define MONITOR_SLOTTED_SCHEDULING 1
+#endif
+
+/* Network time is assumed to run with 10ms ticks */
+#define MONITOR_NET_TIME_TICKS_PER_SECOND 100
 
-static uint8_t monitor_conf_id =
+static uint16_t monitor_conf_id =
   (1 << MIRA_MON_CONF_MAC_STATS) | (1 << MIRA_MON_CONF_NET_NEIGHBOURS);
 
 static uint16_t monitor_conf_send_interval = 1;
 static uint16_t monitor_conf_mac_stats = 0x7ff;
 static uint16_t monitor_conf_net_neighbours = 0x7;
+static uint16_t monitor_conf_net_neighbour_histograms = 0x3;
+static uint16_t monitor_conf_latency_probe = 0;
+static uint16_t monitor_conf_process_profile = 0xf;
+static uint16_t monitor_conf_memory = 0xf;
+static uint16_t monitor_conf_net_topology = 0x7;
 static uint8_t monitor_conf_version = 0;
 
-static uint32_t read_mbi(const uint8_t* data, int* pos, int data_len)
-{
-    uint32_t result = 0;
-    while ((*pos < data_len)) {
-        result = result << 7;
-        result |= data[*pos] & 0x7f;
-        pos++;
-        if ((data[*pos - 1] & 0x80) == 0) {
-            break;
-        }
-    }
-    return result;
-}
+/* Slot assigned by the root, see monitoring_slot.h */
+static uint16_t monitor_report_slot;
+static bool monitor_has_report_slot;
+
+/*
+ * Max time, in seconds, from receiving a config until it's acknowledged.
+ * Spreads the acknowledgements when the config is sent to all nodes at once.
+ */
+#ifndef MONITOR_CONFIG_ACK_JITTER
+#define MONITOR_CONFIG_ACK_JITTER 10
+#endif
+
+static mira_net_udp_connection_t* udp_connection;
 
-static void handle_config(const uint8_t* data, int pos, int data_len)
+PROCESS_NAME(monitoring_ack_proc);
+
+static void handle_config(monitoring_reader_t* record)
 {
-    if (pos >= data_len)
-        return;
-    uint32_t conf_version = data[pos++];
-    uint32_t send_interval = read_mbi(data, &pos, data_len);
-    if (send_interval < 1)
+    monitoring_config_t conf;
+
+    /* Nothing is changed unless the whole config is valid */
+    if (!monitoring_parse_config(record, &conf)) {
         return;
+    }
+
+    monitor_conf_version = conf.version;
+    monitor_conf_send_interval = conf.send_interval;
 
-    monitor_conf_version = conf_version;
-    monitor_conf_send_interval = send_interval;
+    /* Also when the version is unchanged, the previous ack may have been lost */
+    process_poll(&monitoring_ack_proc);
 
-    monitor_conf_id = read_mbi(data, &pos, data_len);
+    monitor_conf_id = conf.ids;
     if ((monitor_conf_id & (1 << MIRA_MON_CONF_MAC_STATS)) != 0) {
-        monitor_conf_mac_stats = read_mbi(data, &pos, data_len);
+        monitor_conf_mac_stats = conf.fields[MIRA_MON_CONF_MAC_STATS];
     }
     if ((monitor_conf_id & (1 << MIRA_MON_CONF_NET_NEIGHBOURS)) != 0) {
-        monitor_conf_net_neighbours = read_mbi(data, &pos, data_len);
+        monitor_conf_net_neighbours = conf.fields[MIRA_MON_CONF_NET_NEIGHBOURS];
+    }
+    if ((monitor_conf_id & (1 << MIRA_MON_CONF_NET_NEIGHBOUR_HISTOGRAMS)) != 0) {
+        monitor_conf_net_neighbour_histograms = conf.fields[MIRA_MON_CONF_NET_NEIGHBOUR_HISTOGRAMS];
+    }
+    if ((monitor_conf_id & (1 << MIRA_MON_CONF_LATENCY_PROBE)) != 0) {
+        monitor_conf_latency_probe = conf.fields[MIRA_MON_CONF_LATENCY_PROBE];
+    }
+    if ((monitor_conf_id & (1 << MIRA_MON_CONF_PROCESS_PROFILE)) != 0) {
+        monitor_conf_process_profile = conf.fields[MIRA_MON_CONF_PROCESS_PROFILE];
+    }
+    if ((monitor_conf_id & (1 << MIRA_MON_CONF_MEMORY)) != 0) {
+        monitor_conf_memory = conf.fields[MIRA_MON_CONF_MEMORY];
+    }
+    if ((monitor_conf_id & (1 << MIRA_MON_CONF_NET_TOPOLOGY)) != 0) {
+        monitor_conf_net_topology = conf.fields[MIRA_MON_CONF_NET_TOPOLOGY];
+    }
+}
+
+/* Sequence number of the latest latency probe */
+static uint8_t latency_probe_seq;
+/* Round trip time of the latest echoed probe, in network time ticks */
+static uint32_t latency_probe_rtt;
+static bool latency_probe_has_rtt;
+
+static void handle_latency_echo(monitoring_reader_t* record)
+{
+    uint8_t seq;
+    uint32_t tx_time;
+    uint32_t now;
+    if (!monitoring_reader_u8(record, &seq) || !monitoring_reader_u32(record, &tx_time) ||
+        seq != latency_probe_seq || mira_net_time_get_time(&now) != MIRA_SUCCESS) {
+        return;
+    }
+    latency_probe_rtt = now - tx_time;
+    latency_probe_has_rtt = true;
+}
+
+static void handle_report_slot_assign(monitoring_reader_t* record)
+{
+    uint16_t slot;
+    if (monitoring_reader_u16(record, &slot)) {
+        monitor_report_slot = slot;
+        monitor_has_report_slot = true;
     }
 }
 
@@ -82,27 +151,62 @@ static void udp_listen_callback(mira_net_udp_connection_t* connection,
                                 const mira_net_udp_callback_metadata_t* metadata,
                                 void* storage)
 {
-    int pos = 0;
-    while (pos < data_len) {
-        int id = read_mbi(data, &pos, data_len);
-        int len = read_mbi(data, &pos, data_len);
+    monitoring_reader_t reader;
+    monitoring_reader_t record;
+    uint32_t id;
+
+    monitoring_reader_init(&reader, data, data_len);
+    while (monitoring_reader_record(&reader, &id, &record)) {
         switch (id) {
             case MIRA_MON_ID_CONFIG:
-                handle_config(data, pos, data_len);
+                handle_config(&record);
+                break;
+            case MIRA_MON_ID_LATENCY_ECHO:
+                handle_latency_echo(&record);
+                break;
+            case MIRA_MON_ID_REPORT_SLOT_ASSIGN:
+                handle_report_slot_assign(&record);
                 break;
         }
-        pos += len;
     }
 }
 
-#define MAX_NEIGHBOURS 4
+/*
+ * Number of neighbours to report, the best ones by link metric are kept.
+ * The parent is always kept.
+ */
+#ifndef MONITOR_MAX_NEIGHBOURS
+#define MONITOR_MAX_NEIGHBOURS 4
+#endif
+
+#if MONITOR_MAX_NEIGHBOURS < 1 || MONITOR_MAX_NEIGHBOURS > 32
+#error "MONITOR_MAX_NEIGHBOURS must be within 1..32"
+#endif
+
+#define MONITOR_PACKET_SIZE 150
+
+/* Largest record data that fits with a one byte MBI length */
+#define MONITOR_MAX_RECORD_DATA 127
+
 typedef struct
 {
-    mira_diag_net_neighbour_data_t nbr[MAX_NEIGHBOURS];
+    /* Min-heap, with the worst neighbour at index 0 */
+    mira_diag_net_neighbour_data_t nbr[MONITOR_MAX_NEIGHBOURS];
     mira_net_address_t parent;
     int n_nbrs;
 } neighbour_info_t;
 
+typedef struct
+{
+    neighbour_info_t info;
+    int next_nbr;       /* Index of the next neighbour to report */
+    uint8_t seq;        /* Sequence number, same for all fragments of a report */
+    uint8_t frag_idx;   /* Index of the next fragment */
+    uint8_t frag_count; /* Number of fragments, 0 if not fragmented */
+} neighbour_report_t;
+
+static neighbour_report_t neighbour_report;
+
 static bool is_parent(const neighbour_info_t* info, const mira_diag_net_neighbour_data_t* nbr)
 {
     return memcmp(&info->parent, &nbr->addr, sizeof(info->parent)) == 0;
@@ -121,29 +225,55 @@ static bool is_better_neighbour(const neighbour_info_t* info,
     return old->link_met > new->link_met;
 }
 
+static void neighbour_swap(neighbour_info_t* info, int a, int b)
+{
+    mira_diag_net_neighbour_data_t tmp;
+    memcpy(&tmp, &info->nbr[a], sizeof(tmp));
+    memcpy(&info->nbr[a], &info->nbr[b], sizeof(tmp));
+    memcpy(&info->nbr[b], &tmp, sizeof(tmp));
+}
+
+static void neighbour_sift_down(neighbour_info_t* info, int idx)
+{
+    while (1) {
+        int worst = idx;
+        int left = 2 * idx + 1;
+        int right = left + 1;
+        if (left < info->n_nbrs && is_better_neighbour(info, &info->nbr[left], &info->nbr[worst])) {
+            worst = left;
+        }
+        if (right < info->n_nbrs &&
+            is_better_neighbour(info, &info->nbr[right], &info->nbr[worst])) {
+            worst = right;
+        }
+        if (worst == idx) {
+            return;
+        }
+        neighbour_swap(info, idx, worst);
+        idx = worst;
+    }
+}
+
 static void neighbour_callback(const mira_diag_net_neighbour_data_t* nbr, void* storage)
 {
     neighbour_info_t* info = storage;
-    int idx = info->n_nbrs;
-    if (idx >= MAX_NEIGHBOURS) {
-        /* Replace the one with the worse link_met that
-         * isn't the parent.
-         */
-        idx = 0;
-        for (int i = 1; i < MAX_NEIGHBOURS; ++i) {
-            if (is_better_neighbour(info, &info->nbr[i], &info->nbr[idx])) {
-                // The old idx should be kept, this neighbour is worse.
-                idx = i;
+    if (info->n_nbrs < MONITOR_MAX_NEIGHBOURS) {
+        /* Not full, add at the end and move it up past better neighbours */
+        int idx = info->n_nbrs++;
+        memcpy(&info->nbr[idx], nbr, sizeof(info->nbr[0]));
+        while (idx > 0) {
+            int up = (idx - 1) / 2;
+            if (!is_better_neighbour(info, &info->nbr[idx], &info->nbr[up])) {
+                break;
             }
+            neighbour_swap(info, idx, up);
+            idx = up;
         }
-        if (!is_better_neighbour(info, &info->nbr[idx], nbr)) {
-            // The new neighbour is worse than the old one, so keep the old one.
-            return;
-        }
-    } else {
-        info->n_nbrs++;
+    } else if (is_better_neighbour(info, &info->nbr[0], nbr)) {
+        /* Replace the worst neighbour, which never is the parent */
+        memcpy(&info->nbr[0], nbr, sizeof(info->nbr[0]));
+        neighbour_sift_down(info, 0);
     }
-    memcpy(&info->nbr[idx], nbr, sizeof(info->nbr[0]));
 }
 
 static void monitor_add_vle(uint32_t val, uint8_t** data, int* len, int* max_len)
@@ -181,6 +311,15 @@ static void monitor_add_vle(uint32_t val, uint8_t** data, int* len, int* max_len
     }
 }
 
+static int monitor_vle_size(uint32_t val)
+{
+    int size = 1;
+    while (size < 5 && val >= (1UL << (7 * size))) {
+        size++;
+    }
+    return size;
+}
+
 #define MON_ADD_U8(byte)     \
     do {                     \
         *(*data)++ = (byte); \
@@ -227,6 +366,19 @@ static int monitor_add_config_version(uint8_t** data, int* max_len)
     return len;
 }
 
+static int monitor_add_report_slot(uint8_t** data, int* max_len)
+{
+    int len = 0;
+
+    if (monitor_has_report_slot && *max_len >= (1 + 1 + 2)) {
+        MON_ADD_U8(MIRA_MON_ID_REPORT_SLOT);
+        MON_ADD_U8(2);
+        MON_ADD_U16(monitor_report_slot);
+    }
+
+    return len;
+}
+
 static int monitor_add_mac_stats(uint8_t** data, int* max_len)
 {
     int len = 0;
@@ -283,53 +435,626 @@ static int monitor_add_mac_stats(uint8_t** data, int* max_len)
     return len;
 }
 
+static int monitor_neighbour_entry_size(void)
+{
+    int size = 8;
+    if (monitor_conf_net_neighbours & (1 << MIRA_MON_CONF_NET_NEIGHBOURS_ETX)) {
+        size += 2;
+    }
+    if (monitor_conf_net_neighbours & (1 << MIRA_MON_CONF_NET_NEIGHBOURS_ETX_SAMPLE_COUNT)) {
+        size += 1;
+    }
+    if (monitor_conf_net_neighbours & (1 << MIRA_MON_CONF_NET_NEIGHBOURS_RSSI)) {
+        size += 2;
+    }
+    return size;
+}
+
+/*
+ * Number of neighbours that fits in a record, given the space left in the
+ * packet. One byte is reserved for the terminating zero.
+ */
+static int monitor_neighbours_per_record(int max_len, bool fragmented)
+{
+    int space = max_len - 1 - 2;
+    if (space > MONITOR_MAX_RECORD_DATA) {
+        space = MONITOR_MAX_RECORD_DATA;
+    }
+    space -= monitor_vle_size(monitor_conf_net_neighbours) + 8;
+    if (fragmented) {
+        space -= 3;
+    }
+    if (space < 0) {
+        return 0;
+    }
+    return space / monitor_neighbour_entry_size();
+}
+
+static void monitor_collect_neighbours(void)
+{
+    neighbour_report.info.n_nbrs = 0;
+    neighbour_report.next_nbr = 0;
+    neighbour_report.frag_idx = 0;
+    neighbour_report.frag_count = 0;
+
+    if (((monitor_conf_id & (1 << MIRA_MON_CONF_NET_NEIGHBOURS)) == 0) ||
+        (mira_net_get_parent_address(&neighbour_report.info.parent) != MIRA_SUCCESS) ||
+        (mira_diag_net_get_neighbour_info(&neighbour_callback, &neighbour_report.info) !=
+         MIRA_SUCCESS)) {
+        neighbour_report.info.n_nbrs = 0;
+    }
+}
+
+static bool monitor_neighbours_pending(void)
+{
+    return neighbour_report.next_nbr < neighbour_report.info.n_nbrs;
+}
+
 static int monitor_add_net_neighbour_info(uint8_t** data, int* max_len)
 {
     int len = 0;
+    neighbour_info_t* info = &neighbour_report.info;
 
-    neighbour_info_t neighbour_info;
-    mira_net_get_parent_address(&neighbour_info.parent);
-    neighbour_info.n_nbrs = 0;
-    if (((monitor_conf_id & (1 << MIRA_MON_CONF_NET_NEIGHBOURS)) != 0) &&
-        (*max_len >= (1 + 1 + 1 + 8 + MAX_NEIGHBOURS * (8 + 2 + 1 + 2))) &&
-        (mira_diag_net_get_neighbour_info(&neighbour_callback, &neighbour_info) == MIRA_SUCCESS)) {
-
-        if (neighbour_info.n_nbrs > 0) {
-            MON_ADD_U8(MIRA_MON_ID_NET_NEIGHBOURS);
-            uint8_t* len_pos = *data;
-            MON_ADD_U8(0); // Add a temp value for length.
-
-            MON_ADD_VLE(monitor_conf_net_neighbours);
-            MON_ADD_MEM(&neighbour_info.nbr[0].addr, 8);
-            for (int i = 0; i < neighbour_info.n_nbrs; ++i) {
-                MON_ADD_MEM(&neighbour_info.nbr[i].addr.u8[8], 8);
-                if (monitor_conf_net_neighbours & (1 << MIRA_MON_CONF_NET_NEIGHBOURS_ETX)) {
-                    MON_ADD_U16(neighbour_info.nbr[i].link_met);
-                }
-                if (monitor_conf_net_neighbours &
-                    (1 << MIRA_MON_CONF_NET_NEIGHBOURS_ETX_SAMPLE_COUNT)) {
-                    MON_ADD_U8(neighbour_info.nbr[i].link_met_measurements);
-                }
-                if (monitor_conf_net_neighbours & (1 << MIRA_MON_CONF_NET_NEIGHBOURS_RSSI)) {
-                    MON_ADD_U16(neighbour_info.nbr[i].rssi);
-                }
-            }
-            *len_pos = (*data) - len_pos - 1;
+    if (!monitor_neighbours_pending()) {
+        return 0;
+    }
+
+    int n_left = info->n_nbrs - neighbour_report.next_nbr;
+    if (neighbour_report.next_nbr == 0 && neighbour_report.frag_idx == 0) {
+        if (monitor_neighbours_per_record(*max_len, false) >= n_left) {
+            /* Everything fits in this packet, no need to fragment */
+        } else {
+            int first = monitor_neighbours_per_record(*max_len, true);
+            int per_frag = monitor_neighbours_per_record(MONITOR_PACKET_SIZE, true);
+            neighbour_report.seq++;
+            neighbour_report.frag_count =
+              (first > 0 ? 1 : 0) + (n_left - first + per_frag - 1) / per_frag;
+        }
+    }
+
+    bool fragmented = neighbour_report.frag_count > 0;
+    int count = monitor_neighbours_per_record(*max_len, fragmented);
+    if (count == 0) {
+        /* No room in this packet, continue in the next one */
+        return 0;
+    }
+    if (count > n_left) {
+        count = n_left;
+    }
+
+    MON_ADD_U8(fragmented ? MIRA_MON_ID_NET_NEIGHBOURS_FRAGMENT : MIRA_MON_ID_NET_NEIGHBOURS);
+    uint8_t* len_pos = *data;
+    MON_ADD_U8(0); // Add a temp value for length.
+
+    if (fragmented) {
+        MON_ADD_U8(neighbour_report.seq);
+        MON_ADD_U8(neighbour_report.frag_idx);
+        MON_ADD_U8(neighbour_report.frag_count);
+        neighbour_report.frag_idx++;
+    }
+
+    MON_ADD_VLE(monitor_conf_net_neighbours);
+    MON_ADD_MEM(&info->nbr[0].addr, 8);
+    for (int i = neighbour_report.next_nbr; i < neighbour_report.next_nbr + count; ++i) {
+        MON_ADD_MEM(&info->nbr[i].addr.u8[8], 8);
+        if (monitor_conf_net_neighbours & (1 << MIRA_MON_CONF_NET_NEIGHBOURS_ETX)) {
+            MON_ADD_U16(info->nbr[i].link_met);
+        }
+        if (monitor_conf_net_neighbours & (1 << MIRA_MON_CONF_NET_NEIGHBOURS_ETX_SAMPLE_COUNT)) {
+            MON_ADD_U8(info->nbr[i].link_met_measurements);
+        }
+        if (monitor_conf_net_neighbours & (1 << MIRA_MON_CONF_NET_NEIGHBOURS_RSSI)) {
+            MON_ADD_U16(info->nbr[i].rssi);
+        }
+    }
+    neighbour_report.next_nbr += count;
+    *len_pos = (*data) - len_pos - 1;
+
+    return len;
+}
+
+/*
+ * Neighbour histograms
+ *
+ * The neighbour table is sampled periodically, and the RSSI and link metric
+ * of the tracked neighbours are counted in fixed buckets until the next
+ * report.
+ */
+
+/* Number of neighbours with histograms */
+#ifndef MONITOR_HISTOGRAM_NEIGHBOURS
+#define MONITOR_HISTOGRAM_NEIGHBOURS 4
+#endif
+
+/* How often, in seconds, the neighbour table is sampled */
+#ifndef MONITOR_HISTOGRAM_SAMPLE_INTERVAL
+#define MONITOR_HISTOGRAM_SAMPLE_INTERVAL 10
+#endif
+
+#define MONITOR_HISTOGRAM_BUCKETS 8
+
+/* Lower limits of the link metric buckets, ETX multiplied by 128 */
+static const uint16_t link_met_bucket_limits[MONITOR_HISTOGRAM_BUCKETS] = {
+    0, 160, 192, 256, 384, 512, 768, 1024,
+};
+
+typedef struct
+{
+    uint8_t iid[8];     /* Lower 64 bits of the neighbour address */
+    uint16_t n_samples; /* Samples the neighbour was seen in */
+    uint16_t rssi[MONITOR_HISTOGRAM_BUCKETS];
+    uint16_t link_met[MONITOR_HISTOGRAM_BUCKETS];
+    bool used;
+    bool seen;      /* Seen in the current sample */
+    bool seen_last; /* Seen in the previous sample */
+} neighbour_histogram_t;
+
+static struct
+{
+    neighbour_histogram_t nbr[MONITOR_HISTOGRAM_NEIGHBOURS];
+    uint8_t prefix[8];
+    uint16_t n_samples; /* Samples taken since the last report */
+} histograms;
+
+/*
+ * Neighbours without a slot, seen in the current sample. They are given
+ * slots after the whole neighbour table has been walked, when it's known
+ * which tracked neighbours are missing from it.
+ */
+static struct
+{
+    mira_diag_net_neighbour_data_t nbr[MONITOR_HISTOGRAM_NEIGHBOURS];
+    int n;
+} new_neighbours;
+
+static int rssi_bucket(int16_t rssi)
+{
+    int bucket = (rssi + 100) / 6;
+    if (rssi < -100 || bucket < 0) {
+        return 0;
+    }
+    if (bucket >= MONITOR_HISTOGRAM_BUCKETS) {
+        return MONITOR_HISTOGRAM_BUCKETS - 1;
+    }
+    return bucket;
+}
+
+static int link_met_bucket(uint16_t link_met)
+{
+    int bucket = MONITOR_HISTOGRAM_BUCKETS - 1;
+    while (bucket > 0 && link_met < link_met_bucket_limits[bucket]) {
+        bucket--;
+    }
+    return bucket;
+}
+
+static void histogram_count(uint16_t* counter)
+{
+    if (*counter < UINT16_MAX) {
+        (*counter)++;
+    }
+}
+
+static void histogram_add_sample(neighbour_histogram_t* hist,
+                                 const mira_diag_net_neighbour_data_t* nbr)
+{
+    hist->seen = true;
+    histogram_count(&hist->n_samples);
+    histogram_count(&hist->rssi[rssi_bucket(nbr->rssi)]);
+    histogram_count(&hist->link_met[link_met_bucket(nbr->link_met)]);
+}
+
+static void histogram_neighbour_callback(const mira_diag_net_neighbour_data_t* nbr,
+                                         void* storage)
+{
+    for (int i = 0; i < MONITOR_HISTOGRAM_NEIGHBOURS; ++i) {
+        neighbour_histogram_t* slot = &histograms.nbr[i];
+        if (slot->used && memcmp(slot->iid, &nbr->addr.u8[8], 8) == 0) {
+            histogram_add_sample(slot, nbr);
+            return;
+        }
+    }
+
+    /*
+     * Whether a slot can be taken over isn't known until the sample is
+     * complete, as its neighbour may still come later in the table.
+     */
+    if (new_neighbours.n < MONITOR_HISTOGRAM_NEIGHBOURS) {
+        new_neighbours.nbr[new_neighbours.n++] = *nbr;
+    }
+}
+
+static void histogram_add_new_neighbours(void)
+{
+    int slot = 0;
+
+    for (int i = 0; i < new_neighbours.n; ++i) {
+        const mira_diag_net_neighbour_data_t* nbr = &new_neighbours.nbr[i];
+        neighbour_histogram_t* hist;
+
+        /* Take over a free slot, or one of a neighbour missing from two samples */
+        while (slot < MONITOR_HISTOGRAM_NEIGHBOURS && histograms.nbr[slot].used &&
+               (histograms.nbr[slot].seen || histograms.nbr[slot].seen_last)) {
+            slot++;
+        }
+        if (slot == MONITOR_HISTOGRAM_NEIGHBOURS) {
+            /* All slots are used by neighbours still present */
+            break;
+        }
+        hist = &histograms.nbr[slot];
+        memset(hist, 0, sizeof(*hist));
+        memcpy(hist->iid, &nbr->addr.u8[8], 8);
+        memcpy(histograms.prefix, &nbr->addr.u8[0], 8);
+        hist->used = true;
+        histogram_add_sample(hist, nbr);
+    }
+    new_neighbours.n = 0;
+}
+
+static void monitor_sample_histograms(void)
+{
+    for (int i = 0; i < MONITOR_HISTOGRAM_NEIGHBOURS; ++i) {
+        histograms.nbr[i].seen_last = histograms.nbr[i].seen;
+        histograms.nbr[i].seen = false;
+    }
+    new_neighbours.n = 0;
+    if (mira_diag_net_get_neighbour_info(&histogram_neighbour_callback, NULL) == MIRA_SUCCESS) {
+        histogram_add_new_neighbours();
+        histogram_count(&histograms.n_samples);
+    }
+}
+
+static int histogram_size(const uint16_t* buckets)
+{
+    int size = 1;
+    for (int i = 0; i < MONITOR_HISTOGRAM_BUCKETS; ++i) {
+        if (buckets[i] > 0) {
+            size += monitor_vle_size(buckets[i]);
+        }
+    }
+    return size;
+}
+
+static int histogram_neighbour_size(const neighbour_histogram_t* hist)
+{
+    int size = 8 + monitor_vle_size(hist->n_samples);
+    if (monitor_conf_net_neighbour_histograms & (1 << MIRA_MON_CONF_NET_NEIGHBOUR_HISTOGRAMS_RSSI)) {
+        size += histogram_size(hist->rssi);
+    }
+    if (monitor_conf_net_neighbour_histograms &
+        (1 << MIRA_MON_CONF_NET_NEIGHBOUR_HISTOGRAMS_LINK_MET)) {
+        size += histogram_size(hist->link_met);
+    }
+    return size;
+}
+
+/* Bit field of the non-empty buckets, followed by their counts */
+static int monitor_add_histogram(const uint16_t* buckets, uint8_t** data, int* max_len)
+{
+    int len = 0;
+    uint8_t used = 0;
+    for (int i = 0; i < MONITOR_HISTOGRAM_BUCKETS; ++i) {
+        if (buckets[i] > 0) {
+            used |= 1 << i;
+        }
+    }
+    MON_ADD_U8(used);
+    for (int i = 0; i < MONITOR_HISTOGRAM_BUCKETS; ++i) {
+        if (buckets[i] > 0) {
+            MON_ADD_VLE(buckets[i]);
+        }
+    }
+    return len;
+}
+
+static int monitor_add_net_neighbour_histograms(uint8_t** data, int* max_len)
+{
+    int len = 0;
+
+    if (((monitor_conf_id & (1 << MIRA_MON_CONF_NET_NEIGHBOUR_HISTOGRAMS)) == 0) ||
+        histograms.n_samples == 0) {
+        return 0;
+    }
+
+    int space = *max_len - 1 - 2;
+    if (space > MONITOR_MAX_RECORD_DATA) {
+        space = MONITOR_MAX_RECORD_DATA;
+    }
+    space -= monitor_vle_size(monitor_conf_net_neighbour_histograms) +
+             monitor_vle_size(histograms.n_samples) + 8;
+    if (space < 0) {
+        return 0;
+    }
+
+    MON_ADD_U8(MIRA_MON_ID_NET_NEIGHBOUR_HISTOGRAMS);
+    uint8_t* len_pos = *data;
+    MON_ADD_U8(0); // Add a temp value for length.
+
+    MON_ADD_VLE(monitor_conf_net_neighbour_histograms);
+    MON_ADD_VLE(histograms.n_samples);
+    MON_ADD_MEM(histograms.prefix, 8);
+
+    for (int i = 0; i < MONITOR_HISTOGRAM_NEIGHBOURS; ++i) {
+        neighbour_histogram_t* hist = &histograms.nbr[i];
+        if (!hist->used || hist->n_samples == 0) {
+            continue;
+        }
+        int size = histogram_neighbour_size(hist);
+        if (size > space) {
+            /* Neighbours that don't fit are left out of this report */
+            continue;
+        }
+        space -= size;
+
+        MON_ADD_MEM(hist->iid, 8);
+        MON_ADD_VLE(hist->n_samples);
+        if (monitor_conf_net_neighbour_histograms &
+            (1 << MIRA_MON_CONF_NET_NEIGHBOUR_HISTOGRAMS_RSSI)) {
+            len += monitor_add_histogram(hist->rssi, data, max_len);
+        }
+        if (monitor_conf_net_neighbour_histograms &
+            (1 << MIRA_MON_CONF_NET_NEIGHBOUR_HISTOGRAMS_LINK_MET)) {
+            len += monitor_add_histogram(hist->link_met, data, max_len);
         }
     }
+    *len_pos = (*data) - len_pos - 1;
+
+    /* Start over for the next report, but keep tracking the same neighbours */
+    histograms.n_samples = 0;
+    for (int i = 0; i < MONITOR_HISTOGRAM_NEIGHBOURS; ++i) {
+        neighbour_histogram_t* hist = &histograms.nbr[i];
+        hist->n_samples = 0;
+        memset(hist->rssi, 0, sizeof(hist->rssi));
+        memset(hist->link_met, 0, sizeof(hist->link_met));
+    }
 
     return len;
 }
 
-static int monitoring_fill_buffer(uint8_t* data, int max_len)
+static int monitor_add_latency_probe(uint8_t** data, int* max_len)
+{
+    int len = 0;
+    uint32_t now;
+    uint16_t fields = monitor_conf_latency_probe;
+
+    if (!latency_probe_has_rtt) {
+        fields &= ~(1 << MIRA_MON_CONF_LATENCY_PROBE_RTT);
+    }
+
+    if (((monitor_conf_id & (1 << MIRA_MON_CONF_LATENCY_PROBE)) != 0) &&
+        (*max_len >= (1 + 1 + 1 + 1 + 4 + 5 + 1)) &&
+        (mira_net_time_get_time(&now) == MIRA_SUCCESS)) {
+
+        MON_ADD_U8(MIRA_MON_ID_LATENCY_PROBE);
+        uint8_t* len_pos = *data;
+        MON_ADD_U8(0); // Add a temp value for length.
+
+        MON_ADD_VLE(fields);
+        MON_ADD_U8(++latency_probe_seq);
+        MON_ADD_U32(now);
+        if (fields & (1 << MIRA_MON_CONF_LATENCY_PROBE_RTT)) {
+            MON_ADD_VLE(latency_probe_rtt);
+            latency_probe_has_rtt = false;
+        }
+        *len_pos = (*data) - len_pos - 1;
+    }
+
+    return len;
+}
+
+/* Longest process name sent, longer names are truncated */
+#define MONITOR_PROCESS_NAME_LEN 8
+
+static int process_profile_size(const process_profile_t* profile)
+{
+    int name_len = strlen(profile->name);
+    int size = 1 + (name_len > MONITOR_PROCESS_NAME_LEN ? MONITOR_PROCESS_NAME_LEN : name_len);
+    if (monitor_conf_process_profile & (1 << MIRA_MON_CONF_PROCESS_PROFILE_DISPATCHES)) {
+        size += monitor_vle_size(profile->dispatches);
+    }
+    if (monitor_conf_process_profile & (1 << MIRA_MON_CONF_PROCESS_PROFILE_TOTAL_RUN_TIME)) {
+        size += monitor_vle_size(profile->total_run_time_us);
+    }
+    if (monitor_conf_process_profile & (1 << MIRA_MON_CONF_PROCESS_PROFILE_MAX_RUN_TIME)) {
+        size += monitor_vle_size(profile->max_run_time_us);
+    }
+    if (monitor_conf_process_profile & (1 << MIRA_MON_CONF_PROCESS_PROFILE_MAX_LATENESS)) {
+        size += monitor_vle_size(profile->max_timer_lateness_ms);
+    }
+    return size;
+}
+
+static int monitor_add_process_profile(uint8_t** data, int* max_len)
+{
+    int len = 0;
+
+    if (((monitor_conf_id & (1 << MIRA_MON_CONF_PROCESS_PROFILE)) == 0) ||
+        process_profiler_first() == NULL) {
+        return 0;
+    }
+
+    int space = *max_len - 1 - 2;
+    if (space > MONITOR_MAX_RECORD_DATA) {
+        space = MONITOR_MAX_RECORD_DATA;
+    }
+    space -= monitor_vle_size(monitor_conf_process_profile);
+    if (space < 0) {
+        return 0;
+    }
+
+    MON_ADD_U8(MIRA_MON_ID_PROCESS_PROFILE);
+    uint8_t* len_pos = *data;
+    MON_ADD_U8(0); // Add a temp value for length.
+
+    MON_ADD_VLE(monitor_conf_process_profile);
+    for (const process_profile_t* profile = process_profiler_first(); profile != NULL;
+         profile = profile->next) {
+        int size = process_profile_size(profile);
+        if (size > space) {
+            /* Processes that don't fit are left out of this report */
+            continue;
+        }
+        space -= size;
+
+        int name_len = strlen(profile->name);
+        if (name_len > MONITOR_PROCESS_NAME_LEN) {
+            name_len = MONITOR_PROCESS_NAME_LEN;
+        }
+        MON_ADD_U8(name_len);
+        MON_ADD_MEM(profile->name, name_len);
+        if (monitor_conf_process_profile & (1 << MIRA_MON_CONF_PROCESS_PROFILE_DISPATCHES)) {
+            MON_ADD_VLE(profile->dispatches);
+        }
+        if (monitor_conf_process_profile & (1 << MIRA_MON_CONF_PROCESS_PROFILE_TOTAL_RUN_TIME)) {
+            MON_ADD_VLE(profile->total_run_time_us);
+        }
+        if (monitor_conf_process_profile & (1 << MIRA_MON_CONF_PROCESS_PROFILE_MAX_RUN_TIME)) {
+            MON_ADD_VLE(profile->max_run_time_us);
+        }
+        if (monitor_conf_process_profile & (1 << MIRA_MON_CONF_PROCESS_PROFILE_MAX_LATENESS)) {
+            MON_ADD_VLE(profile->max_timer_lateness_ms);
+        }
+    }
+    *len_pos = (*data) - len_pos - 1;
+
+    /* The report holds the statistics since the previous report */
+    process_profiler_reset();
+
+    return len;
+}
+
+static int monitor_add_memory(uint8_t** data, int* max_len)
+{
+    int len = 0;
+    uint32_t values[] = {
+        [MIRA_MON_CONF_MEMORY_STACK_PEAK] = mem_watermark_stack_peak(),
+        [MIRA_MON_CONF_MEMORY_STACK_SIZE] = mem_watermark_stack_size(),
+        [MIRA_MON_CONF_MEMORY_HEAP_PEAK] = mem_watermark_heap_peak(),
+        [MIRA_MON_CONF_MEMORY_HEAP_USED] = mem_watermark_heap_used(),
+    };
+    const int num_values = sizeof(values) / sizeof(values[0]);
+
+    if ((monitor_conf_id & (1 << MIRA_MON_CONF_MEMORY)) == 0) {
+        return 0;
+    }
+
+    int size = monitor_vle_size(monitor_conf_memory);
+    for (int i = 0; i < num_values; ++i) {
+        if (monitor_conf_memory & (1 << i)) {
+            size += monitor_vle_size(values[i]);
+        }
+    }
+    if (*max_len < 1 + 1 + size) {
+        return 0;
+    }
+
+    MON_ADD_U8(MIRA_MON_ID_MEMORY);
+    MON_ADD_U8(size);
+    MON_ADD_VLE(monitor_conf_memory);
+    for (int i = 0; i < num_values; ++i) {
+        if (monitor_conf_memory & (1 << i)) {
+            MON_ADD_VLE(values[i]);
+        }
+    }
+
+    return len;
+}
+
+typedef struct
+{
+    mira_net_address_t parent;
+    mira_diag_net_neighbour_data_t link;
+    bool has_link;
+} topology_info_t;
+
+static void topology_neighbour_callback(const mira_diag_net_neighbour_data_t* nbr, void* storage)
+{
+    topology_info_t* info = storage;
+    if (memcmp(&nbr->addr, &info->parent, sizeof(info->parent)) == 0) {
+        memcpy(&info->link, nbr, sizeof(info->link));
+        info->has_link = true;
+    }
+}
+
+static int monitor_add_net_topology(uint8_t** data, int* max_len)
 {
     int len = 0;
+    topology_info_t info;
+    uint16_t fields = monitor_conf_net_topology;
 
-    if (monitor_conf_version != 0) {
-        len += monitor_add_config_version(&data, &max_len);
+    if (((monitor_conf_id & (1 << MIRA_MON_CONF_NET_TOPOLOGY)) == 0) ||
+        (mira_net_get_parent_address(&info.parent) != MIRA_SUCCESS)) {
+        return 0;
+    }
+
+    info.has_link = false;
+    if (fields & ((1 << MIRA_MON_CONF_NET_TOPOLOGY_LINK_MET) |
+                  (1 << MIRA_MON_CONF_NET_TOPOLOGY_RSSI))) {
+        mira_diag_net_get_neighbour_info(&topology_neighbour_callback, &info);
+        if (!info.has_link) {
+            /* The parent isn't in the neighbour table, send the parent only */
+            fields &= (1 << MIRA_MON_CONF_NET_TOPOLOGY_PARENT);
+        }
+    }
+
+    int size = monitor_vle_size(fields);
+    if (fields & (1 << MIRA_MON_CONF_NET_TOPOLOGY_PARENT)) {
+        size += 8;
+    }
+    if (fields & (1 << MIRA_MON_CONF_NET_TOPOLOGY_LINK_MET)) {
+        size += 2;
     }
+    if (fields & (1 << MIRA_MON_CONF_NET_TOPOLOGY_RSSI)) {
+        size += 2;
+    }
+    if (*max_len < 1 + 1 + size) {
+        return 0;
+    }
+
+    MON_ADD_U8(MIRA_MON_ID_NET_TOPOLOGY);
+    MON_ADD_U8(size);
+    MON_ADD_VLE(fields);
+    if (fields & (1 << MIRA_MON_CONF_NET_TOPOLOGY_PARENT)) {
+        MON_ADD_MEM(&info.parent.u8[8], 8);
+    }
+    if (fields & (1 << MIRA_MON_CONF_NET_TOPOLOGY_LINK_MET)) {
+        MON_ADD_U16(info.link.link_met);
+    }
+    if (fields & (1 << MIRA_MON_CONF_NET_TOPOLOGY_RSSI)) {
+        MON_ADD_U16(info.link.rssi);
+    }
+
+    return len;
+}
+
+/*
+ * Fill a packet. The first packet of a report holds all records, the
+ * following ones the remaining fragments of the neighbour report.
+ */
+static int monitoring_fill_buffer(uint8_t* data, int max_len, bool first)
+{
+    int len = 0;
+
+    if (first) {
+        if (monitor_conf_version != 0) {
+            len += monitor_add_config_version(&data, &max_len);
+        }
+
+        len += monitor_add_report_slot(&data, &max_len);
 
-    len += monitor_add_mac_stats(&data, &max_len);
+        len += monitor_add_mac_stats(&data, &max_len);
+
+        len += monitor_add_net_neighbour_histograms(&data, &max_len);
+
+        len += monitor_add_process_profile(&data, &max_len);
+
+        len += monitor_add_memory(&data, &max_len);
+
+        len += monitor_add_net_topology(&data, &max_len);
+
+        /* Last, so the timestamp is as close to sending as possible */
+        len += monitor_add_latency_probe(&data, &max_len);
+    }
 
     len += monitor_add_net_neighbour_info(&data, &max_len);
 
@@ -343,17 +1068,127 @@ static int monitoring_fill_buffer(uint8_t* data, int max_len)
     return len;
 }
 
-PROCESS(monitoring_proc, "Monitoring process");
+static uint64_t monitoring_random_interval(void)
+{
+    uint64_t interval = monitor_conf_send_interval * 60 * CLOCK_SECOND;
+    interval = (3 * interval) / 4 + mira_random_generate() * interval / (MIRA_RANDOM_MAX * 2);
+    if (interval > UINT32_MAX) {
+        interval = UINT32_MAX - 60 * CLOCK_SECOND;
+        interval += mira_random_generate() * 60 * CLOCK_SECOND / MIRA_RANDOM_MAX;
+    }
+    return interval;
+}
+
+#if MONITOR_SLOTTED_SCHEDULING
+static uint32_t monitoring_node_slot_offset(uint32_t interval_ticks)
+{
+    mira_net_address_t addr;
+
+    if (monitor_has_report_slot) {
+        return monitoring_slot_assigned_offset(monitor_report_slot, interval_ticks);
+    }
+    if (mira_net_get_ll_address(&addr) != MIRA_SUCCESS) {
+        return mira_random_generate() % interval_ticks;
+    }
+    return monitoring_slot_offset(&addr.u8[8], interval_ticks);
+}
+
+/*
+ * Time until the next start of this node's slot, in clock ticks.
+ *
+ * The slot repeats every interval in network time, so all nodes agree on
+ * where the interval starts, and each node gets a fixed offset within it.
+ *
+ * Falls back to the random interval while network time isn't available.
+ */
+static uint64_t monitoring_slotted_interval(bool after_report)
+{
+    uint32_t net_time;
+    uint32_t interval_ticks =
+      monitor_conf_send_interval * 60 * MONITOR_NET_TIME_TICKS_PER_SECOND;
+
+    if (mira_net_time_get_time(&net_time) != MIRA_SUCCESS) {
+        return monitoring_random_interval();
+    }
+
+    uint32_t offset = monitoring_node_slot_offset(interval_ticks);
+    uint32_t phase = net_time % interval_ticks;
+    uint32_t wait = (offset + interval_ticks - phase) % interval_ticks;
+    if (wait == 0 || (after_report && wait < interval_ticks / 2)) {
+        /* The timer fired slightly early, don't report twice in one slot */
+        wait += interval_ticks;
+    }
+    uint64_t interval = (uint64_t)wait * CLOCK_SECOND / MONITOR_NET_TIME_TICKS_PER_SECOND;
+    if (interval > UINT32_MAX) {
+        interval = UINT32_MAX - 60 * CLOCK_SECOND;
+        interval += mira_random_generate() * 60 * CLOCK_SECOND / MIRA_RANDOM_MAX;
+    }
+    return interval;
+}
+#endif
+
+PROFILED_PROCESS(monitoring_proc, "Monitoring process");
+PROFILED_PROCESS(monitoring_sampler_proc, "Monitoring sampler");
+PROFILED_PROCESS(monitoring_ack_proc, "Monitoring config ack");
 
 void monitoring_init(void)
 {
     process_start(&monitoring_proc, NULL);
+    process_start(&monitoring_sampler_proc, NULL);
+    process_start(&monitoring_ack_proc, NULL);
+}
+
+PROCESS_THREAD(monitoring_ack_proc, ev, data)
+{
+    static struct etimer timer;
+
+    PROCESS_BEGIN();
+
+    while (1) {
+        PROCESS_WAIT_EVENT_UNTIL(ev == PROCESS_EVENT_POLL);
+
+        etimer_set(&timer,
+                   mira_random_generate() * (MONITOR_CONFIG_ACK_JITTER * CLOCK_SECOND) /
+                     MIRA_RANDOM_MAX);
+        PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&timer));
+
+        mira_net_address_t net_address;
+        if (udp_connection != NULL && monitor_conf_version != 0 &&
+            mira_net_get_root_address(&net_address) == MIRA_SUCCESS) {
+            uint8_t ack[] = { MIRA_MON_ID_CONFIG_VERSION, 1, monitor_conf_version, 0 };
+            mira_net_udp_send_to(
+              udp_connection, &net_address, MONITOR_UDP_PORT, ack, sizeof(ack));
+        }
+    }
+
+    PROCESS_END();
+}
+
+PROCESS_THREAD(monitoring_sampler_proc, ev, data)
+{
+    static struct etimer timer;
+
+    PROCESS_BEGIN();
+
+    etimer_set(&timer, MONITOR_HISTOGRAM_SAMPLE_INTERVAL * CLOCK_SECOND);
+    while (1) {
+        PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&timer));
+        etimer_reset(&timer);
+
+        if ((monitor_conf_id & (1 << MIRA_MON_CONF_NET_NEIGHBOUR_HISTOGRAMS)) != 0) {
+            monitor_sample_histograms();
+        }
+    }
+
+    PROCESS_END();
 }
 
 PROCESS_THREAD(monitoring_proc, ev, data)
 {
     static struct etimer timer;
-    static mira_net_udp_connection_t* udp_connection;
+#if MONITOR_SLOTTED_SCHEDULING
+    static bool after_report = false;
+#endif
 
     PROCESS_BEGIN();
     /* Pause once, so we don't run anything before finish of startup */
@@ -363,29 +1198,40 @@ PROCESS_THREAD(monitoring_proc, ev, data)
      * Open a connection, but don't specify target address yet, which means
      * only mira_net_udp_send_to() can be used to send packets later.
      */
-    udp_connection = mira_net_udp_connect(NULL, MONITOR_UDP_PORT, udp_listen_callback, NULL);
+    udp_connection = mira_net_udp_connect(NULL, MONITOR_UDP_PORT, NULL, NULL);
+
+    /* Everything the root sends, to one node or to all, comes to the port */
+    mira_net_udp_listen(MONITOR_UDP_PORT, udp_listen_callback, NULL);
 
     while (1) {
-        uint64_t interval = monitor_conf_send_interval * 60 * CLOCK_SECOND;
-        interval = (3 * interval) / 4 + mira_random_generate() * interval / (MIRA_RANDOM_MAX * 2);
-        if (interval > UINT32_MAX) {
-            interval = UINT32_MAX - 60 * CLOCK_SECOND;
-            interval += mira_random_generate() * 60 * CLOCK_SECOND / MIRA_RANDOM_MAX;
-        }
+#if MONITOR_SLOTTED_SCHEDULING
+        uint64_t interval = monitoring_slotted_interval(after_report);
+#else
+        uint64_t interval = monitoring_random_interval();
+#endif
         etimer_set(&timer, interval);
         PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&timer));
+#if MONITOR_SLOTTED_SCHEDULING
+        after_report = true;
+#endif
 
         mira_net_address_t net_address;
         mira_status_t res = mira_net_get_root_address(&net_address);
         if (res == MIRA_SUCCESS) {
-            uint8_t buffer[150];
-            int len = monitoring_fill_buffer(buffer, sizeof(buffer));
+            bool first = true;
+            monitor_collect_neighbours();
+            do {
+                uint8_t buffer[MONITOR_PACKET_SIZE];
+                int len = monitoring_fill_buffer(buffer, sizeof(buffer), first);
+                first = false;
 
-            if (len > 0) {
-                printf("Sending mon info\n");
-                // build message
-                mira_net_udp_send_to(udp_connection, &net_address, MONITOR_UDP_PORT, buffer, len);
-            }
+                if (len > 0) {
+                    printf("Sending mon info\n");
+                    // build message
+                    mira_net_udp_send_to(
+                      udp_connection, &net_address, MONITOR_UDP_PORT, buffer, len);
+                }
+            } while (monitor_neighbours_pending());
         }
     }
     PROCESS_END();
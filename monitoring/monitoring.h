@@ -28,6 +28,9 @@
 #ifndef MONITORING_H
 #define MONITORING_H
 
+/* UDP port used for monitoring packets, both to and from the nodes */
+#define MONITOR_UDP_PORT 6960
+
 void monitoring_init(void);
 
 /* Packet format:
@@ -96,6 +99,123 @@ void monitoring_init(void);
  *
  */
 
+/* Fragment of info about neighbours */
+#define MIRA_MON_ID_NET_NEIGHBOURS_FRAGMENT 8
+/* Sent instead of MIRA_MON_ID_NET_NEIGHBOURS when the neighbours don't fit
+ * in one packet.
+ *
+ * Data format:
+ *
+ * <report sequence number> (1 byte, same for all fragments of a report)
+ * <fragment index> (1 byte, 0 .. fragment count - 1)
+ * <fragment count> (1 byte)
+ * <The same data as MIRA_MON_ID_NET_NEIGHBOURS, for a subset of the neighbours>
+ *
+ * Each fragment is sent in a separate packet. The neighbours of the report
+ * are the neighbours of all fragments with the same sequence number.
+ */
+
+/* Histograms of RSSI and link metric per neighbour */
+#define MIRA_MON_ID_NET_NEIGHBOUR_HISTOGRAMS 10
+/* The neighbour table is sampled periodically between the reports, and the
+ * RSSI and link metric of up to a fixed number of neighbours are counted in
+ * buckets. The histograms are cleared after each report.
+ *
+ * Data format:
+ *
+ * <MBI encoded bit field saying which histograms are sent>
+ * <MBI encoded number of samples since the last report>
+ * <IP-address-prefix> (Top 8 bytes of address).
+ *
+ * Repeated once per neighbour:
+ * - address (8 bytes)
+ * - MBI encoded number of samples the neighbour was seen in
+ * - The histograms according to the bit field
+ *
+ * Each histogram is encoded as:
+ * <bit field of the non-empty buckets> (1 byte)
+ * <MBI encoded count, for each non-empty bucket>
+ *
+ * Field # (in bit field) and histogram:
+ * 0 RSSI, bucket n covers -100 + 6 * n to -95 + 6 * n dBm. Bucket 0 also
+ *   covers everything below, bucket 7 everything above.
+ * 1 link metric, ETX buckets: < 1.25, 1.25 - 1.5, 1.5 - 2, 2 - 3, 3 - 4,
+ *   4 - 6, 6 - 8, >= 8.
+ */
+
+/* Latency probe */
+#define MIRA_MON_ID_LATENCY_PROBE 12
+/* Data format:
+ *
+ * <MBI encoded bit field saying which fields are sent>
+ * <sequence number> (1 byte, incremented for every probe)
+ * <transmit time> (4 bytes, network time when the packet was built)
+ *
+ * <Fields according to the bit field>
+ *
+ * Field # (in bit field) and type:
+ * 0 echo requested (no data), the root answers with MIRA_MON_ID_LATENCY_ECHO
+ * 1 round trip time of the latest echoed probe (MBI, network time ticks)
+ *
+ * Network time is shared by all nodes in the network, so the receiver gets
+ * the one-way latency as its network time minus the transmit time. The
+ * resolution is one network time tick, 10ms.
+ */
+
+/* Process profile, requires a build with PROCESS_PROFILER=1 */
+#define MIRA_MON_ID_PROCESS_PROFILE 14
+/* Holds the statistics since the previous report, for the processes
+ * declared with PROFILED_PROCESS(), see process_profiler.h.
+ *
+ * Data format:
+ *
+ * <MBI encoded bit field saying which fields are sent>
+ *
+ * Repeated once per process:
+ * - name length (1 byte)
+ * - name (name length bytes, at most 8, truncated)
+ * - Fields according to the bit field
+ *
+ * Field # (in bit field) and type:
+ * 0 number of times the process was run (MBI)
+ * 1 total run time in microseconds (MBI)
+ * 2 max run time in microseconds (MBI)
+ * 3 max etimer lateness, time from expiry to run, in milliseconds (MBI)
+ */
+
+#define MIRA_MON_ID_MEMORY 16
+/* Memory high-water marks since boot, see mem_watermark.h.
+ *
+ * Data format:
+ *
+ * <MBI encoded bit field saying which fields are sent>
+ * Fields according to the bit field
+ *
+ * Field # (in bit field) and type:
+ * 0 peak stack usage in bytes, 0 if unknown (MBI)
+ * 1 stack size in bytes, 0 if unknown (MBI)
+ * 2 peak heap usage in bytes (MBI)
+ * 3 current heap usage in bytes (MBI)
+ */
+
+#define MIRA_MON_ID_NET_TOPOLOGY 18
+/* The node's parent in the routing tree. Not sent before the node has a
+ * parent. There is no hop count field, Mira doesn't give the node its hop
+ * count or rank. The hop count follows from the parents of all nodes, see
+ * mesh_topology.py.
+ *
+ * Data format:
+ *
+ * <MBI encoded bit field saying which fields are sent>
+ * Fields according to the bit field
+ *
+ * Field # (in bit field) and type:
+ * 0 lower 64 bits of the parent address, the upper ones are the same as
+ *   for the node (8 bytes)
+ * 1 link metric to the parent, ETX*128 (2 bytes)
+ * 2 RSSI from the parent (2 bytes, signed)
+ */
+
 #define MIRA_MON_ID_CONFIG_VERSION 6
 /* Data format:
  * <config version> 1 byte.
@@ -103,6 +223,14 @@ void monitoring_init(void);
  * This packet is not sent if the config version is zero.
  */
 
+#define MIRA_MON_ID_REPORT_SLOT 20
+/* Data format:
+ * <report slot> 2 bytes, as assigned by MIRA_MON_ID_REPORT_SLOT_ASSIGN.
+ *
+ * Sent in the first packet of each report once the root has assigned a slot,
+ * so the root can tell whether the assignment arrived.
+ */
+
 /************************/
 /* Packets sent to node */
 
@@ -116,6 +244,27 @@ void monitoring_init(void);
  * <MBI encoded bit field saying which fields are to be sent>
  */
 
+#define MIRA_MON_ID_REPORT_SLOT_ASSIGN 5
+/* Data format:
+ *
+ * <report slot> (2 bytes, the offset of the node's reports within the report
+ * interval, in 1/65536 of the interval.)
+ *
+ * Sent by the root to a node whose reports don't carry the slot it assigned,
+ * see MIRA_MON_ID_REPORT_SLOT. Until a node has a slot assigned, it uses one
+ * hashed from its address.
+ */
+
+#define MIRA_MON_ID_LATENCY_ECHO 3
+/* Data format:
+ *
+ * <sequence number> (1 byte, copied from the probe)
+ * <transmit time> (4 bytes, copied from the probe)
+ *
+ * Sent by the root in response to a MIRA_MON_ID_LATENCY_PROBE with the echo
+ * field set.
+ */
+
 #define MIRA_MON_CONF_MAC_STATS 0
 /* Bit per field: */
 #define MIRA_MON_CONF_MAC_STATS_TX_ALL_LLMC_PKTS 0
@@ -139,4 +288,34 @@ void monitoring_init(void);
 #define MIRA_MON_CONF_CONFIG_VERSION 2
 /* No optional fields */
 
+#define MIRA_MON_CONF_NET_NEIGHBOUR_HISTOGRAMS 3
+/* Bit per field: */
+#define MIRA_MON_CONF_NET_NEIGHBOUR_HISTOGRAMS_RSSI 0
+#define MIRA_MON_CONF_NET_NEIGHBOUR_HISTOGRAMS_LINK_MET 1
+
+#define MIRA_MON_CONF_LATENCY_PROBE 4
+/* Bit per field: */
+#define MIRA_MON_CONF_LATENCY_PROBE_ECHO 0
+#define MIRA_MON_CONF_LATENCY_PROBE_RTT 1
+
+#define MIRA_MON_CONF_PROCESS_PROFILE 5
+/* Bit per field: */
+#define MIRA_MON_CONF_PROCESS_PROFILE_DISPATCHES 0
+#define MIRA_MON_CONF_PROCESS_PROFILE_TOTAL_RUN_TIME 1
+#define MIRA_MON_CONF_PROCESS_PROFILE_MAX_RUN_TIME 2
+#define MIRA_MON_CONF_PROCESS_PROFILE_MAX_LATENESS 3
+
+#define MIRA_MON_CONF_MEMORY 6
+/* Bit per field: */
+#define MIRA_MON_CONF_MEMORY_STACK_PEAK 0
+#define MIRA_MON_CONF_MEMORY_STACK_SIZE 1
+#define MIRA_MON_CONF_MEMORY_HEAP_PEAK 2
+#define MIRA_MON_CONF_MEMORY_HEAP_USED 3
+
+#define MIRA_MON_CONF_NET_TOPOLOGY 7
+/* Bit per field: */
+#define MIRA_MON_CONF_NET_TOPOLOGY_PARENT 0
+#define MIRA_MON_CONF_NET_TOPOLOGY_LINK_MET 1
+#define MIRA_MON_CONF_NET_TOPOLOGY_RSSI 2
+
 #endif
@@ -0,0 +1,326 @@
+#!/usr/bin/env python3
+
+# Decoder for monitoring packets, as described in monitoring.h
+#
+#
+# MIT License
+#
+# Copyright (c) 2023 LumenRadio AB
+#
+# SPDX-License-Identifier: MIT
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+#
+#
+# Reads one packet per line from a file or stdin, formatted as:
+#   <source address> <payload as hex>
+# and prints one JSON object per decoded record.
+
+import argparse
+import ipaddress
+import json
+import sys
+
+MIRA_MON_ID_MAC_STATS = 2
+MIRA_MON_ID_NET_NEIGHBOURS = 4
+MIRA_MON_ID_CONFIG_VERSION = 6
+MIRA_MON_ID_NET_NEIGHBOURS_FRAGMENT = 8
+MIRA_MON_ID_NET_NEIGHBOUR_HISTOGRAMS = 10
+MIRA_MON_ID_LATENCY_PROBE = 12
+MIRA_MON_ID_PROCESS_PROFILE = 14
+MIRA_MON_ID_MEMORY = 16
+MIRA_MON_ID_NET_TOPOLOGY = 18
+MIRA_MON_ID_REPORT_SLOT = 20
+
+MAC_STATS_FIELDS = [
+    ("tx_all_nodes_llmc_packets", 2),
+    ("tx_unicast_packets", 2),
+    ("tx_custom_llmc_packets", 2),
+    ("rx_all_nodes_llmc_packets", 2),
+    ("rx_unicast_packets", 2),
+    ("rx_custom_llmc_packets", 2),
+    ("rx_missed_slots", 2),
+    ("rx_not_for_us_packets", 2),
+    ("tx_dropped", 2),
+    ("tx_failed", 2),
+    ("used_tx_queue", 1),
+]
+
+NET_NEIGHBOURS_FIELDS = [
+    ("etx", 2, False),
+    ("etx_sample_count", 1, False),
+    ("rssi", 2, True),
+]
+
+NET_NEIGHBOUR_HISTOGRAMS = ["rssi", "etx"]
+
+PROCESS_PROFILE_FIELDS = [
+    "dispatches",
+    "total_run_time_us",
+    "max_run_time_us",
+    "max_timer_lateness_ms",
+]
+MEMORY_FIELDS = ["stack_peak", "stack_size", "heap_peak", "heap_used"]
+
+HISTOGRAM_BUCKETS = 8
+
+
+class DecodeError(Exception):
+    pass
+
+
+class Reader:
+    def __init__(self, data):
+        self.data = data
+        self.pos = 0
+
+    def left(self):
+        return len(self.data) - self.pos
+
+    def mbi(self):
+        value = 0
+        for _ in range(5):
+            if self.pos >= len(self.data):
+                raise DecodeError("truncated MBI")
+            byte = self.data[self.pos]
+            self.pos += 1
+            value = (value << 7) | (byte & 0x7F)
+            if (byte & 0x80) == 0:
+                return value
+        raise DecodeError("MBI too long")
+
+    def uint(self, size, signed=False):
+        if self.left() < size:
+            raise DecodeError("truncated field")
+        value = int.from_bytes(
+            self.data[self.pos : self.pos + size], "little", signed=signed
+        )
+        self.pos += size
+        return value
+
+    def mem(self, size):
+        if self.left() < size:
+            raise DecodeError("truncated field")
+        value = self.data[self.pos : self.pos + size]
+        self.pos += size
+        return value
+
+
+def decode_mac_stats(reader):
+    fields = reader.mbi()
+    result = {}
+    for bit, (name, size) in enumerate(MAC_STATS_FIELDS):
+        if fields & (1 << bit):
+            result[name] = reader.uint(size)
+    return result
+
+
+def decode_net_neighbours(reader):
+    fields = reader.mbi()
+    prefix = reader.mem(8)
+    neighbours = []
+    while reader.left() > 0:
+        nbr = {"address": str(ipaddress.IPv6Address(prefix + reader.mem(8)))}
+        for bit, (name, size, signed) in enumerate(NET_NEIGHBOURS_FIELDS):
+            if fields & (1 << bit):
+                nbr[name] = reader.uint(size, signed)
+        if "etx" in nbr:
+            nbr["etx"] /= 128
+        neighbours.append(nbr)
+    return neighbours
+
+
+def decode_histogram(reader):
+    used = reader.uint(1)
+    return [
+        reader.mbi() if used & (1 << bucket) else 0
+        for bucket in range(HISTOGRAM_BUCKETS)
+    ]
+
+
+def decode_net_neighbour_histograms(reader):
+    fields = reader.mbi()
+    result = {"samples": reader.mbi(), "neighbours": []}
+    prefix = reader.mem(8)
+    while reader.left() > 0:
+        nbr = {
+            "address": str(ipaddress.IPv6Address(prefix + reader.mem(8))),
+            "samples": reader.mbi(),
+        }
+        for bit, name in enumerate(NET_NEIGHBOUR_HISTOGRAMS):
+            if fields & (1 << bit):
+                nbr[name] = decode_histogram(reader)
+        result["neighbours"].append(nbr)
+    return result
+
+
+def decode_latency_probe(reader):
+    fields = reader.mbi()
+    result = {
+        "sequence": reader.uint(1),
+        "transmit_time": reader.uint(4),
+        "echo": (fields & 1) != 0,
+    }
+    if fields & 2:
+        result["rtt"] = reader.mbi()
+    return result
+
+
+def decode_process_profile(reader):
+    fields = reader.mbi()
+    processes = []
+    while reader.left() > 0:
+        process = {"name": reader.mem(reader.uint(1)).decode(errors="replace")}
+        for bit, name in enumerate(PROCESS_PROFILE_FIELDS):
+            if fields & (1 << bit):
+                process[name] = reader.mbi()
+        processes.append(process)
+    return processes
+
+
+def decode_memory(reader):
+    fields = reader.mbi()
+    return {
+        name: reader.mbi()
+        for bit, name in enumerate(MEMORY_FIELDS)
+        if fields & (1 << bit)
+    }
+
+
+def decode_net_topology(reader, source):
+    fields = reader.mbi()
+    result = {}
+    if fields & 1:
+        prefix = ipaddress.IPv6Address(source).packed[:8]
+        result["parent"] = str(ipaddress.IPv6Address(prefix + reader.mem(8)))
+    if fields & 2:
+        result["etx"] = reader.uint(2) / 128
+    if fields & 4:
+        result["rssi"] = reader.uint(2, True)
+    return result
+
+
+class MonitoringDecoder:
+    """Decodes monitoring packets, and reassembles fragmented reports.
+
+    decode() returns a list of (source, record name, record) tuples.
+    """
+
+    def __init__(self):
+        # (source, sequence number) -> {fragment index: neighbours}
+        self.fragments = {}
+
+    def _neighbour_fragment(self, source, reader):
+        seq = reader.uint(1)
+        idx = reader.uint(1)
+        count = reader.uint(1)
+        if idx >= count:
+            raise DecodeError("invalid fragment index")
+
+        # A new sequence number from a source discards any incomplete report
+        for key in [k for k in self.fragments if k[0] == source and k[1] != seq]:
+            del self.fragments[key]
+
+        frags = self.fragments.setdefault((source, seq), {})
+        frags[idx] = decode_net_neighbours(reader)
+        if len(frags) < count:
+            return None
+
+        del self.fragments[(source, seq)]
+        return [nbr for i in range(count) for nbr in frags[i]]
+
+    def decode(self, source, payload):
+        records = []
+        reader = Reader(payload)
+        while reader.left() > 0:
+            record_id = reader.mbi()
+            if record_id == 0:
+                break
+            length = reader.mbi()
+            record = Reader(reader.mem(length))
+
+            if record_id == MIRA_MON_ID_MAC_STATS:
+                records.append((source, "mac_stats", decode_mac_stats(record)))
+            elif record_id == MIRA_MON_ID_NET_NEIGHBOURS:
+                records.append(
+                    (source, "net_neighbours", decode_net_neighbours(record))
+                )
+            elif record_id == MIRA_MON_ID_NET_NEIGHBOURS_FRAGMENT:
+                neighbours = self._neighbour_fragment(source, record)
+                if neighbours is not None:
+                    records.append((source, "net_neighbours", neighbours))
+            elif record_id == MIRA_MON_ID_NET_NEIGHBOUR_HISTOGRAMS:
+                records.append(
+                    (
+                        source,
+                        "net_neighbour_histograms",
+                        decode_net_neighbour_histograms(record),
+                    )
+                )
+            elif record_id == MIRA_MON_ID_LATENCY_PROBE:
+                records.append((source, "latency_probe", decode_latency_probe(record)))
+            elif record_id == MIRA_MON_ID_PROCESS_PROFILE:
+                records.append(
+                    (source, "process_profile", decode_process_profile(record))
+                )
+            elif record_id == MIRA_MON_ID_MEMORY:
+                records.append((source, "memory", decode_memory(record)))
+            elif record_id == MIRA_MON_ID_NET_TOPOLOGY:
+                records.append(
+                    (source, "net_topology", decode_net_topology(record, source))
+                )
+            elif record_id == MIRA_MON_ID_CONFIG_VERSION:
+                records.append((source, "config_version", record.uint(1)))
+            elif record_id == MIRA_MON_ID_REPORT_SLOT:
+                records.append((source, "report_slot", record.uint(2)))
+            else:
+                records.append((source, "unknown", {"id": record_id}))
+        return records
+
+
+def arg_build_parser():
+    parser = argparse.ArgumentParser(description="Mira monitoring packet decoder")
+    parser.add_argument(
+        "input",
+        nargs="?",
+        type=argparse.FileType("r"),
+        default=sys.stdin,
+        help="File with one '<source> <hex payload>' per line (default: stdin)",
+    )
+    return parser
+
+
+if __name__ == "__main__":
+    args = arg_build_parser().parse_args()
+    decoder = MonitoringDecoder()
+
+    for line in args.input:
+        parts = line.split()
+        if len(parts) != 2:
+            continue
+        try:
+            records = decoder.decode(parts[0], bytes.fromhex(parts[1]))
+        except (ValueError, DecodeError) as e:
+            print(
+                "Could not decode packet from " + parts[0] + ": " + str(e),
+                file=sys.stderr,
+            )
+            continue
+        for source, name, record in records:
+            print(json.dumps({"source": source, "record": name, "data": record}))
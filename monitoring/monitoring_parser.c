@@ -0,0 +1,158 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 LumenRadio AB
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include <string.h>
+#include "monitoring.h"
+#include "monitoring_parser.h"
+
+/* IDs that are configured without a field bit field */
+#define CONF_IDS_WITHOUT_FIELDS (1 << MIRA_MON_CONF_CONFIG_VERSION)
+
+void monitoring_reader_init(monitoring_reader_t* reader, const void* data, int len)
+{
+    reader->data = data;
+    reader->len = len < 0 ? 0 : len;
+    reader->pos = 0;
+    reader->error = false;
+}
+
+int monitoring_reader_left(const monitoring_reader_t* reader)
+{
+    return reader->error ? 0 : reader->len - reader->pos;
+}
+
+static bool reader_fail(monitoring_reader_t* reader)
+{
+    reader->error = true;
+    return false;
+}
+
+bool monitoring_reader_mbi(monitoring_reader_t* reader, uint32_t* value)
+{
+    uint32_t result = 0;
+
+    /* At most 5 bytes, 4 * 7 + 4 bits */
+    for (int i = 0; i < 5; ++i) {
+        if (monitoring_reader_left(reader) < 1) {
+            return reader_fail(reader);
+        }
+        uint8_t byte = reader->data[reader->pos++];
+        if (i == 0 && byte == 0x80) {
+            /* Leading zero digits, not produced by the encoder */
+            return reader_fail(reader);
+        }
+        if ((result >> 25) != 0) {
+            return reader_fail(reader);
+        }
+        result = (result << 7) | (byte & 0x7f);
+        if ((byte & 0x80) == 0) {
+            *value = result;
+            return true;
+        }
+    }
+    return reader_fail(reader);
+}
+
+bool monitoring_reader_u8(monitoring_reader_t* reader, uint8_t* value)
+{
+    if (monitoring_reader_left(reader) < 1) {
+        return reader_fail(reader);
+    }
+    *value = reader->data[reader->pos++];
+    return true;
+}
+
+bool monitoring_reader_u16(monitoring_reader_t* reader, uint16_t* value)
+{
+    if (monitoring_reader_left(reader) < 2) {
+        return reader_fail(reader);
+    }
+    const uint8_t* p = &reader->data[reader->pos];
+    *value = p[0] | (p[1] << 8);
+    reader->pos += 2;
+    return true;
+}
+
+bool monitoring_reader_u32(monitoring_reader_t* reader, uint32_t* value)
+{
+    if (monitoring_reader_left(reader) < 4) {
+        return reader_fail(reader);
+    }
+    const uint8_t* p = &reader->data[reader->pos];
+    *value = p[0] | (p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+    reader->pos += 4;
+    return true;
+}
+
+bool monitoring_reader_record(monitoring_reader_t* reader,
+                              uint32_t* id,
+                              monitoring_reader_t* record)
+{
+    uint32_t len;
+
+    if (monitoring_reader_left(reader) < 1 || !monitoring_reader_mbi(reader, id) || *id == 0) {
+        return false;
+    }
+    if (!monitoring_reader_mbi(reader, &len) || len > (uint32_t)monitoring_reader_left(reader)) {
+        return reader_fail(reader);
+    }
+    monitoring_reader_init(record, &reader->data[reader->pos], len);
+    reader->pos += len;
+    return true;
+}
+
+bool monitoring_parse_config(monitoring_reader_t* record, monitoring_config_t* config)
+{
+    uint32_t value;
+
+    memset(config, 0, sizeof(*config));
+
+    if (!monitoring_reader_u8(record, &config->version)) {
+        return false;
+    }
+
+    if (!monitoring_reader_mbi(record, &value) || value < 1 || value > UINT16_MAX) {
+        return false;
+    }
+    config->send_interval = value;
+
+    if (!monitoring_reader_mbi(record, &value) || value > UINT16_MAX) {
+        return false;
+    }
+    config->ids = value;
+
+    for (int id = 0; id <= MONITORING_CONF_MAX_ID; ++id) {
+        if ((config->ids & (1 << id)) == 0 || (CONF_IDS_WITHOUT_FIELDS & (1 << id)) != 0) {
+            continue;
+        }
+        if (!monitoring_reader_mbi(record, &value) || value > UINT16_MAX) {
+            return false;
+        }
+        config->fields[id] = value;
+    }
+    return true;
+}
@@ -0,0 +1,91 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 LumenRadio AB
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#ifndef MONITORING_PARSER_H
+#define MONITORING_PARSER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Bounds checked parsing of monitoring packets, see monitoring.h.
+ *
+ * Used both by the nodes and the root, for packets received from the
+ * network. Only depends on the C library, so it can be built on a host.
+ *
+ * A read past the end of the data, or an MBI that doesn't fit in 32 bits,
+ * sets the error flag of the reader, and all following reads fail.
+ */
+
+typedef struct
+{
+    const uint8_t* data;
+    int len;
+    int pos;
+    bool error;
+} monitoring_reader_t;
+
+void monitoring_reader_init(monitoring_reader_t* reader, const void* data, int len);
+
+/* Bytes left to read */
+int monitoring_reader_left(const monitoring_reader_t* reader);
+
+bool monitoring_reader_mbi(monitoring_reader_t* reader, uint32_t* value);
+bool monitoring_reader_u8(monitoring_reader_t* reader, uint8_t* value);
+/* Little endian */
+bool monitoring_reader_u16(monitoring_reader_t* reader, uint16_t* value);
+bool monitoring_reader_u32(monitoring_reader_t* reader, uint32_t* value);
+
+/*
+ * Read the next record. The record data is set up as a separate reader,
+ * which can't read past the end of the record.
+ *
+ * Returns false at the end marker, the end of the data, or on error.
+ */
+bool monitoring_reader_record(monitoring_reader_t* reader,
+                              uint32_t* id,
+                              monitoring_reader_t* record);
+
+/* Highest MIRA_MON_CONF_* ID */
+#define MONITORING_CONF_MAX_ID 15
+
+typedef struct
+{
+    uint8_t version;
+    uint16_t send_interval;
+    uint16_t ids;                                /* Bit per MIRA_MON_CONF_* ID */
+    uint16_t fields[MONITORING_CONF_MAX_ID + 1]; /* Bit field per ID in ids */
+} monitoring_config_t;
+
+/*
+ * Parse the data of a MIRA_MON_ID_CONFIG record.
+ *
+ * Returns false, with the config partly filled, if the config is invalid.
+ */
+bool monitoring_parse_config(monitoring_reader_t* record, monitoring_config_t* config);
+
+#endif
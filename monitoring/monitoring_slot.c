@@ -0,0 +1,56 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 LumenRadio AB
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include "monitoring_slot.h"
+
+uint16_t monitoring_slot_assign(uint32_t node)
+{
+    uint16_t slot = 0;
+
+    /* Node IDs above 16 bits share the slots of the lower ones */
+    for (int i = 0; i < 16; ++i) {
+        slot = (slot << 1) | ((node >> i) & 1);
+    }
+    return slot;
+}
+
+uint32_t monitoring_slot_assigned_offset(uint16_t slot, uint32_t interval_ticks)
+{
+    return ((uint64_t)slot * interval_ticks) >> 16;
+}
+
+uint32_t monitoring_slot_offset(const uint8_t iid[8], uint32_t interval_ticks)
+{
+    uint32_t hash = 2166136261u;
+
+    /* FNV-1a */
+    for (int i = 0; i < 8; ++i) {
+        hash ^= iid[i];
+        hash *= 16777619u;
+    }
+    return hash % interval_ticks;
+}
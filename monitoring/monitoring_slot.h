@@ -0,0 +1,63 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 LumenRadio AB
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#ifndef MONITORING_SLOT_H
+#define MONITORING_SLOT_H
+
+#include <stdint.h>
+
+/*
+ * Report slots
+ *
+ * Each node reports at a fixed offset within the report interval, its slot.
+ *
+ * The root assigns the slots, see MIRA_MON_ID_REPORT_SLOT_ASSIGN in
+ * monitoring.h, from the node IDs it gives the nodes in the order they are
+ * first heard. Node ID n gets the bits of n reversed, so the first N nodes
+ * are spread evenly over the interval, at least 1/(2N) of it apart, however
+ * many nodes there are.
+ *
+ * Until a node has been assigned a slot, it uses one hashed from its
+ * interface identifier, the lower 64 bits of its address. Those need no
+ * coordination, but are independent, so some nodes share a slot, like people
+ * sharing a birthday: with N nodes and S slots per interval, a node shares its
+ * slot with probability 1 - (1 - 1/S)^(N - 1), and the busiest slot gets a
+ * few times the average load, see README.md.
+ *
+ * Only depends on the C library, so it can be built on a host.
+ */
+
+/* Slot of the node with the given node ID, in 1/65536 of the interval */
+uint16_t monitoring_slot_assign(uint32_t node);
+
+/* Offset of an assigned slot, 0 to interval_ticks - 1 */
+uint32_t monitoring_slot_assigned_offset(uint16_t slot, uint32_t interval_ticks);
+
+/* Offset of the slot hashed from an interface identifier, 0 to interval_ticks - 1 */
+uint32_t monitoring_slot_offset(const uint8_t iid[8], uint32_t interval_ticks);
+
+#endif
@@ -28,12 +28,19 @@
 #include <mira.h>
 #include <stdio.h>
 #include <string.h>
+#include "mem_watermark.h"
 #include "monitoring.h"
+#include "process_profiler.h"
 
 #define UDP_PORT 456
 #define SEND_INTERVAL 60
 #define CHECK_NET_INTERVAL 1
 
+/* Size of the memory buffer given to Mira, see README.md on how to tune it */
+#ifndef MIRA_MEM_BUFFER_SIZE
+#define MIRA_MEM_BUFFER_SIZE 8616
+#endif
+
 /*
  * Identifies as a node.
  * Sends data to the root.
@@ -86,11 +93,13 @@ static void udp_listen_callback(mira_net_udp_connection_t* connection,
     printf("\n");
 }
 
-PROCESS(main_proc, "Main process");
+PROFILED_PROCESS(main_proc, "Main process");
 
 void mira_setup(void)
 {
     mira_status_t uart_ret;
+
+    mem_watermark_init();
     mira_uart_config_t uart_config = {
         .baudrate = 115200,
 #if MIRA_PLATFORM_MKW41Z
@@ -102,7 +111,7 @@ void mira_setup(void)
 #endif
     };
 
-    MIRA_MEM_SET_BUFFER(8616);
+    MIRA_MEM_SET_BUFFER(MIRA_MEM_BUFFER_SIZE);
 
     uart_ret = mira_uart_init(0, &uart_config);
     if (uart_ret != MIRA_SUCCESS) {
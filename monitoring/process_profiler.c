@@ -0,0 +1,100 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 LumenRadio AB
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include <mira.h>
+#include <string.h>
+#include "process_profiler.h"
+
+static process_profile_t* profiles;
+
+#if PROCESS_PROFILER
+
+/* Use the rtimer for run times if available, it has better resolution */
+#ifdef RTIMER_SECOND
+#define PROFILER_NOW() RTIMER_NOW()
+#define PROFILER_SECOND RTIMER_SECOND
+#else
+#define PROFILER_NOW() clock_time()
+#define PROFILER_SECOND CLOCK_SECOND
+#endif
+
+char process_profiler_run(process_profile_t* profile,
+                          char (*thread)(struct pt*, process_event_t, process_data_t),
+                          struct pt* pt,
+                          process_event_t ev,
+                          process_data_t data)
+{
+    if (!profile->listed) {
+        /* First run, add to the list */
+        profile->next = profiles;
+        profiles = profile;
+        profile->listed = true;
+    }
+
+    if (ev == PROCESS_EVENT_TIMER && data != NULL) {
+        /* data is the expired etimer */
+        uint32_t lateness = clock_time() - etimer_expiration_time((struct etimer*)data);
+        lateness = (uint64_t)lateness * 1000 / CLOCK_SECOND;
+        profile->timer_events++;
+        profile->total_timer_lateness_ms += lateness;
+        if (lateness > profile->max_timer_lateness_ms) {
+            profile->max_timer_lateness_ms = lateness;
+        }
+    }
+
+    uint32_t start = PROFILER_NOW();
+    char ret = thread(pt, ev, data);
+    uint32_t run_time = (uint32_t)(PROFILER_NOW() - start);
+    run_time = (uint64_t)run_time * 1000000 / PROFILER_SECOND;
+
+    profile->dispatches++;
+    profile->total_run_time_us += run_time;
+    if (run_time > profile->max_run_time_us) {
+        profile->max_run_time_us = run_time;
+    }
+
+    return ret;
+}
+
+#endif
+
+const process_profile_t* process_profiler_first(void)
+{
+    return profiles;
+}
+
+void process_profiler_reset(void)
+{
+    for (process_profile_t* profile = profiles; profile != NULL; profile = profile->next) {
+        profile->dispatches = 0;
+        profile->total_run_time_us = 0;
+        profile->max_run_time_us = 0;
+        profile->max_timer_lateness_ms = 0;
+        profile->timer_events = 0;
+        profile->total_timer_lateness_ms = 0;
+    }
+}
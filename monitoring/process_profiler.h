@@ -0,0 +1,97 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 LumenRadio AB
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#ifndef PROCESS_PROFILER_H
+#define PROCESS_PROFILER_H
+
+#include <mira.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Process profiler
+ *
+ * Processes declared with PROFILED_PROCESS() instead of PROCESS() are
+ * profiled when built with PROCESS_PROFILER=1. Every time the scheduler runs
+ * the process, the dispatch count and run time are recorded. When the process
+ * is run for an expired etimer, the time from expiry to dispatch is recorded
+ * as the timer lateness.
+ *
+ * Without PROCESS_PROFILER, PROFILED_PROCESS() is the same as PROCESS().
+ */
+
+#ifndef PROCESS_PROFILER
+#define PROCESS_PROFILER 0
+#endif
+
+typedef struct process_profile
+{
+    struct process_profile* next;
+    const char* name;
+    uint32_t dispatches;
+    uint32_t total_run_time_us;
+    uint32_t max_run_time_us;
+    uint32_t max_timer_lateness_ms;
+    uint32_t timer_events;
+    uint32_t total_timer_lateness_ms;
+    bool listed;
+} process_profile_t;
+
+#if PROCESS_PROFILER
+
+char process_profiler_run(process_profile_t* profile,
+                          char (*thread)(struct pt*, process_event_t, process_data_t),
+                          struct pt* pt,
+                          process_event_t ev,
+                          process_data_t data);
+
+#define PROFILED_PROCESS(name, strname)                                                      \
+    PROCESS_THREAD(name, ev, data);                                                          \
+    static process_profile_t process_profile_##name = { NULL, strname };                     \
+    static char profiled_thread_##name(struct pt* pt, process_event_t ev, process_data_t data) \
+    {                                                                                        \
+        return process_profiler_run(                                                         \
+          &process_profile_##name, process_thread_##name, pt, ev, data);                     \
+    }                                                                                        \
+    struct process name = { NULL, strname, profiled_thread_##name }
+
+#else
+
+#define PROFILED_PROCESS(name, strname) PROCESS(name, strname)
+
+#endif
+
+/*
+ * First profile in the list of processes that have been run at least once,
+ * or NULL if none.
+ */
+const process_profile_t* process_profiler_first(void);
+
+/* Clear the statistics of all processes */
+void process_profiler_reset(void);
+
+#endif
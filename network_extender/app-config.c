@@ -35,6 +35,7 @@
 #include <math.h>
 
 #include "nrf52.h"
+#include "process_profiler.h"
 
 #define APP_CONFIG_EXPOSE_KEY 0
 #define APP_CONFIG_VERSION 1
@@ -44,7 +45,7 @@ app_config_t app_config;
 static app_config_t new_config;
 static bool configuration_is_updated;
 
-PROCESS(app_config_writer, "Config writer");
+PROFILED_PROCESS(app_config_writer, "Config writer");
 
 void print_config(void)
 {
@@ -58,7 +59,7 @@ void print_config(void)
         mira_net_toolkit_format_address(address_buf, &addr);
         printf("IP address: %s\n", address_buf);
     }
-    printf("PAN ID: %8lx\n", app_config.net_pan_id);
+    printf("PAN ID: %8lx\n", (unsigned long)app_config.net_pan_id);
 #if APP_CONFIG_EXPOSE_KEY
     printf("Net key:");
     for (uint8_t i = 0; i < sizeof(app_config.net_key); i++) {
@@ -111,60 +112,16 @@ int app_config_is_configured(void)
     return app_config.net_pan_id != 0xffffffff && app_config.net_rate != 0xff;
 }
 
-static int dehexstr(void* tgt, const char* src, int len)
-{
-    int i;
-    int nibble;
-    uint8_t* tgt_i = tgt;
-    for (i = 0; i < len; i++) {
-
-        tgt_i[i] = 0;
-
-        for (nibble = 0; nibble < 2; nibble++) {
-            char c = src[i * 2 + nibble];
-            if (c >= '0' && c <= '9') {
-                tgt_i[i] |= (c - '0') << (4 * (1 - nibble));
-            } else if (c >= 'a' && c <= 'f') {
-                tgt_i[i] |= (c - 'a' + 10) << (4 * (1 - nibble));
-            } else if (c >= 'A' && c <= 'F') {
-                tgt_i[i] |= (c - 'A' + 10) << (4 * (1 - nibble));
-            } else {
-                return -1;
-            }
-        }
-    }
-    return 0;
-}
-static int dehexint(uint32_t* tgt, const char* src, int len)
-{
-    *tgt = 0;
-
-    uint8_t buf[4];
-    memset(buf, 0, 4);
-    if (dehexstr(buf + 4 - len, src, len)) {
-        return -1;
-    }
-    *tgt |= ((uint32_t)buf[0]) << 24;
-    *tgt |= ((uint32_t)buf[1]) << 16;
-    *tgt |= ((uint32_t)buf[2]) << 8;
-    *tgt |= ((uint32_t)buf[3]) << 0;
-
-    return 0;
-}
-
 static void app_config_store()
 {
     configuration_is_updated = true;
     process_poll(&app_config_writer);
 }
 
-void app_config_set_key(const char* payload)
+void app_config_set_key(const uint8_t key[16])
 {
-    if (strlen(payload) != 32 || dehexstr(new_config.net_key, payload, 16)) {
-        printf("Invalid net_key\n");
-        return;
-    }
-    if (new_config.net_key == app_config.net_key) {
+    memcpy(new_config.net_key, key, sizeof(new_config.net_key));
+    if (memcmp(new_config.net_key, app_config.net_key, sizeof(app_config.net_key)) == 0) {
         return;
     }
     app_config_store();
@@ -179,14 +136,9 @@ void app_config_set_rate(int rate)
     app_config_store();
 }
 
-void app_config_set_pan_id(const char* payload)
+void app_config_set_pan_id(uint32_t pan_id)
 {
-    uint32_t tmp;
-    if (strlen(payload) != 8 || dehexint(&tmp, payload, 4)) {
-        printf("Invalid net_pan_id \n");
-        return;
-    }
-    new_config.net_pan_id = tmp;
+    new_config.net_pan_id = pan_id;
     if (new_config.net_pan_id == app_config.net_pan_id) {
         return;
     }
@@ -213,7 +165,7 @@ PROCESS_THREAD(app_config_writer, ev, data)
         etimer_set(&timer, CLOCK_SECOND * 2);
         PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&timer));
         printf("Writing config, Pan ID: %08lx rate: %02x antenna: %u\n",
-               new_config.net_pan_id,
+               (unsigned long)new_config.net_pan_id,
                new_config.net_rate,
                new_config.antenna);
 
@@ -54,9 +54,9 @@ int app_config_is_configured(void);
 
 void get_nrf_device_id(uint8_t mac_addr[6]);
 
-void app_config_set_key(const char* payload);
+void app_config_set_key(const uint8_t key[16]);
 
-void app_config_set_pan_id(const char* payload);
+void app_config_set_pan_id(uint32_t pan_id);
 
 void app_config_set_rate(int rate);
 
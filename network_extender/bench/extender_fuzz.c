@@ -0,0 +1,336 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 LumenRadio AB
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+/*
+ * Fuzzer of the command stack of the extender on the host, see
+ * extender_host.h. The inputs are fed to rpc_interface_input_byte(), as
+ * received on the serial port, and the processes and the config writer are
+ * run after each. Then the config is checked: the rate within 0..15, also
+ * as given to the network, and the config file matching the config in use.
+ * Any failed check aborts, as do the sanitizers of `make fuzz`.
+ *
+ * Standalone, the inputs are mutations of command lines and frames built
+ * into this file, from a seed, so a run can be repeated:
+ *
+ *   ./extender_fuzz [iterations] [seed]
+ *
+ * Frames are fixed up to a valid length and CRC after most mutations, to
+ * get past the checks of the frame header. The state of the RPC interface
+ * carries over from one input to the next, as on the serial port.
+ *
+ * With EXTENDER_FUZZ_LIBFUZZER defined, LLVMFuzzerTestOneInput() is built
+ * instead, for libFuzzer with clang -fsanitize=fuzzer.
+ */
+
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <mira.h>
+
+#include "app-config.h"
+#include "extender_host.h"
+#include "rpc-interface.h"
+
+#define CONFIG_FILE "extender_fuzz_config.bin"
+
+#define MAX_INPUT_SIZE 1024
+
+static void check(bool ok, const char* what)
+{
+    if (!ok) {
+        fprintf(stderr, "extender_fuzz: %s\n", what);
+        abort();
+    }
+}
+
+static void fuzz_init(void)
+{
+    int fd = open("/dev/null", O_WRONLY);
+
+    /* printf() output of the commands is not checked */
+    check(freopen("/dev/null", "w", stdout) != NULL, "no /dev/null");
+    unlink(CONFIG_FILE);
+    extender_host_init(CONFIG_FILE, fd);
+}
+
+static void fuzz_one(const uint8_t* data, size_t size)
+{
+    app_config_t stored;
+
+    extender_host_input(data, size);
+    extender_host_settle();
+
+    check(app_config.net_rate == 0xff || app_config.net_rate <= 15, "rate out of range");
+    check(mira_host_net_config.rate <= 15, "rate out of range in network config");
+    if (mira_config_read(&stored, sizeof(stored)) == MIRA_SUCCESS) {
+        check(memcmp(&stored, &app_config, sizeof(stored)) == 0, "stored config differs");
+    }
+}
+
+#ifdef EXTENDER_FUZZ_LIBFUZZER
+
+int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+    static bool initialized;
+
+    if (!initialized) {
+        fuzz_init();
+        initialized = true;
+    }
+    fuzz_one(data, size);
+    return 0;
+}
+
+#else
+
+typedef struct
+{
+    uint8_t data[MAX_INPUT_SIZE];
+    size_t size;
+    bool frame;
+} input_t;
+
+static input_t corpus[32];
+static int corpus_size;
+
+static uint64_t rng_state;
+
+static uint32_t rng(void)
+{
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state >> 32;
+}
+
+static void add_line(const char* line)
+{
+    input_t* input = &corpus[corpus_size++];
+
+    input->size = sprintf((char*)input->data, "%s\n", line);
+    input->frame = false;
+}
+
+static uint16_t crc16(const uint8_t* data, size_t length)
+{
+    uint16_t crc = 0xffff;
+    size_t i;
+    int bit;
+
+    for (i = 0; i < length; i++) {
+        crc ^= (uint16_t)data[i] << 8;
+        for (bit = 0; bit < 8; bit++) {
+            crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+/* Set the length and the CRC of the frame in an input */
+static void fix_frame(input_t* input)
+{
+    size_t length;
+    uint16_t crc;
+
+    if (input->size < 8) {
+        return;
+    }
+    length = input->size - 6;
+    input->data[0] = RPC_IF_FRAME_MAGIC_0;
+    input->data[1] = RPC_IF_FRAME_MAGIC_1;
+    input->data[2] = length & 0xff;
+    input->data[3] = length >> 8;
+    crc = crc16(&input->data[2], input->size - 4);
+    input->data[input->size - 2] = crc & 0xff;
+    input->data[input->size - 1] = crc >> 8;
+}
+
+/* A frame with a command and values, as type characters and raw values */
+static void add_frame(const char* command, const uint8_t* values, size_t values_size)
+{
+    input_t* input = &corpus[corpus_size++];
+    size_t command_size = strlen(command) + 1;
+
+    input->data[4] = corpus_size;
+    input->data[5] = 0;
+    memcpy(&input->data[6], command, command_size);
+    if (values_size > 0) {
+        memcpy(&input->data[6 + command_size], values, values_size);
+    }
+    input->size = 6 + command_size + values_size + 2;
+    input->frame = true;
+    fix_frame(input);
+}
+
+static void build_corpus(void)
+{
+    static const uint8_t key[] = { 'b', 16, 0,   0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66,
+                                   0x77, 0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff };
+    static const uint8_t rate[] = { 'i', 3, 0, 0, 0 };
+    static const uint8_t pan_id[] = { 'x', 0xef, 0xbe, 0xad, 0xde };
+    static const uint8_t antenna[] = { 'i', 1, 0, 0, 0, 's', 'x', 0 };
+
+    add_line("help");
+    add_line("version");
+    add_line("input");
+    add_line("config");
+    add_line("config show");
+    add_line("config set_rate 3");
+    add_line("config set_rate");
+    add_line("config set_pan_id deadbeef");
+    add_line("config set_antenna 1");
+    add_line("config set_key 00112233445566778899aabbccddeeff");
+    add_line("profiler show");
+    add_line("profiler reset");
+    add_frame("config show", NULL, 0);
+    add_frame("config set_key", key, sizeof(key));
+    add_frame("config set_rate", rate, sizeof(rate));
+    add_frame("config set_pan_id", pan_id, sizeof(pan_id));
+    add_frame("config set_antenna", antenna, sizeof(antenna));
+    add_frame("version", NULL, 0);
+}
+
+static void mutate(input_t* input)
+{
+    static const uint8_t interesting[] = { 0,   0xff, 0x7f, 0x80, RPC_IF_FRAME_MAGIC_0,
+                                           RPC_IF_FRAME_MAGIC_1, ' ', '\n', '\r', ':', '-',
+                                           'b', 'i', 's', 'x' };
+    /* Mutate the body of frames, the header and the CRC are fixed after */
+    size_t start = input->frame ? 6 : 0;
+    size_t end = input->frame ? input->size - 2 : input->size;
+    size_t pos = end > start ? start + rng() % (end - start) : start;
+    const input_t* other;
+    size_t length;
+
+    switch (rng() % 8) {
+        case 0:
+            if (pos < end) {
+                input->data[pos] ^= 1 << (rng() % 8);
+            }
+            break;
+        case 1:
+            if (pos < end) {
+                input->data[pos] = rng();
+            }
+            break;
+        case 2:
+            if (pos < end) {
+                input->data[pos] = interesting[rng() % sizeof(interesting)];
+            }
+            break;
+        case 3:
+            /* Insert a byte */
+            if (input->size < MAX_INPUT_SIZE) {
+                memmove(&input->data[pos + 1], &input->data[pos], input->size - pos);
+                input->data[pos] = interesting[rng() % sizeof(interesting)];
+                input->size++;
+            }
+            break;
+        case 4:
+            /* Delete bytes */
+            length = rng() % 8;
+            if (pos + length <= end) {
+                memmove(&input->data[pos], &input->data[pos + length], input->size - pos - length);
+                input->size -= length;
+            }
+            break;
+        case 5:
+            /* Repeat bytes */
+            length = rng() % 64;
+            if (pos + length <= end && input->size + length <= MAX_INPUT_SIZE) {
+                memmove(&input->data[pos + length], &input->data[pos], input->size - pos);
+                input->size += length;
+            }
+            break;
+        case 6:
+            /* Append another input, the frame being no longer fixed */
+            other = &corpus[rng() % corpus_size];
+            if (input->size + other->size <= MAX_INPUT_SIZE) {
+                memcpy(&input->data[input->size], other->data, other->size);
+                input->size += other->size;
+                input->frame = false;
+            }
+            break;
+        case 7:
+            /* Truncate, the frame being no longer fixed */
+            input->size = rng() % (input->size + 1);
+            input->frame = false;
+            break;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    unsigned long iterations = argc > 1 ? strtoul(argv[1], NULL, 10) : 100000;
+    unsigned long seed = argc > 2 ? strtoul(argv[2], NULL, 10) : 1;
+    unsigned long bytes = 0;
+    struct timespec start;
+    struct timespec end;
+    unsigned long i;
+    double seconds;
+    input_t input;
+    int n;
+
+    rng_state = seed * 0x9e3779b97f4a7c15ULL + 1;
+    build_corpus();
+    fuzz_init();
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < iterations; i++) {
+        input = corpus[rng() % corpus_size];
+        for (n = 1 + rng() % 4; n > 0; n--) {
+            mutate(&input);
+        }
+        if (input.frame && rng() % 4 != 0) {
+            fix_frame(&input);
+        }
+        fuzz_one(input.data, input.size);
+        bytes += input.size;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    seconds = end.tv_sec - start.tv_sec + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+    fprintf(stderr,
+            "%lu inputs, %lu bytes in %.2f s, %.0f inputs/s, seed %lu\n",
+            iterations,
+            bytes,
+            seconds,
+            iterations / seconds,
+            seed);
+    fprintf(stderr,
+            "network initialized %u times, %u resets\n",
+            mira_host_net_init_calls,
+            mira_host_resets);
+    unlink(CONFIG_FILE);
+    return 0;
+}
+
+#endif
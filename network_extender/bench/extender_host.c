@@ -0,0 +1,92 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 LumenRadio AB
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+#include "extender_host.h"
+
+#include <mira.h>
+#include <string.h>
+
+#include "app-config.h"
+#include "command_defs.h"
+#include "reboot.h"
+#include "rpc-interface.h"
+#include "serial_input.h"
+
+/* The longest timer of the stack, the config writer's */
+#define SETTLE_TICKS (CLOCK_SECOND * 2)
+
+uint32_t nrf_host_gpregret[2];
+
+static void extender_host_run(void)
+{
+    while (process_run() > 0) {
+    }
+}
+
+void extender_host_init(const char* config_file, int output_fd)
+{
+    mira_net_config_t netconf;
+
+    mira_host_config_file = config_file;
+    rpc_interface_init(rpc_interface_command_handler, output_fd, command_defs);
+    serial_input_init();
+    extender_host_run();
+
+    /* As main_proc, for the first config */
+    app_config_init();
+    memset(&netconf, 0, sizeof(mira_net_config_t));
+    netconf.pan_id = app_config.net_pan_id;
+    memcpy(netconf.key, app_config.net_key, 16);
+    netconf.mode = MIRA_NET_MODE_MESH;
+    netconf.antenna = app_config.antenna;
+    netconf.rate = app_config.net_rate;
+    if (netconf.rate > 15) {
+        netconf.rate = 15;
+    }
+    mira_net_init(&netconf);
+    extender_host_run();
+}
+
+void extender_host_input(const uint8_t* data, size_t length)
+{
+    size_t i;
+
+    for (i = 0; i < length; i++) {
+        /* Binary frames can hold any bytes, also the reboot sequence */
+        if (!rpc_interface_frame_active()) {
+            reboot_parser_input(data[i]);
+        }
+        rpc_interface_input_byte(data[i]);
+        extender_host_run();
+    }
+}
+
+void extender_host_settle(void)
+{
+    extender_host_run();
+    clock_advance(SETTLE_TICKS);
+    extender_host_run();
+}
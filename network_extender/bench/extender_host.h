@@ -0,0 +1,55 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 LumenRadio AB
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+#ifndef EXTENDER_HOST_H
+#define EXTENDER_HOST_H
+
+/*
+ * The command stack of the extender on the host: the RPC interface, the
+ * commands of command_defs.c, and the configuration of app-config.c, on top
+ * of mira_host.c. The config storage is a file, and the calls to initialize
+ * the network are recorded, see mira.h. Not for the nodes.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Start as main.c does, with the config from config_file, and the output of
+ * the RPC interface to output_fd
+ */
+void extender_host_init(const char* config_file, int output_fd);
+
+/*
+ * Handle received bytes with the reboot parser and
+ * rpc_interface_input_byte(), running the processes after each byte
+ */
+void extender_host_input(const uint8_t* data, size_t length);
+
+/* Run the processes until idle, and until the config writer is done */
+void extender_host_settle(void);
+
+#endif
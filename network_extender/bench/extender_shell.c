@@ -0,0 +1,88 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 LumenRadio AB
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+/*
+ * The command stack of the extender on the host, with the commands read from
+ * stdin and the output to stdout, as on the serial port of a node:
+ *
+ *   ./extender_shell [config file]
+ *   config set_rate 3
+ *   config show
+ *
+ * The config is kept in the file, extender_config.bin by default, and the
+ * calls to initialize the network are printed to stderr. The clock follows
+ * the time of the host.
+ */
+
+#define _DEFAULT_SOURCE
+
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <mira.h>
+
+#include "extender_host.h"
+
+static clock_time_t host_ticks(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * CLOCK_SECOND + now.tv_nsec / (1000000000 / CLOCK_SECOND);
+}
+
+int main(int argc, char** argv)
+{
+    struct pollfd pfd = { .fd = STDIN_FILENO, .events = POLLIN };
+    clock_time_t last = host_ticks();
+    uint8_t buf[256];
+    ssize_t len = 1;
+
+    mira_host_net_log = stderr;
+    setvbuf(stdout, NULL, _IONBF, 0);
+    extender_host_init(argc > 1 ? argv[1] : "extender_config.bin", STDOUT_FILENO);
+
+    while (len > 0) {
+        clock_time_t now;
+
+        if (poll(&pfd, 1, 100) > 0) {
+            len = read(STDIN_FILENO, buf, sizeof(buf));
+            if (len > 0) {
+                extender_host_input(buf, len);
+            }
+        }
+        now = host_ticks();
+        clock_advance(now - last);
+        last = now;
+        while (process_run() > 0) {
+        }
+    }
+
+    /* Let a pending config write finish */
+    extender_host_settle();
+    return 0;
+}
@@ -0,0 +1,51 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 LumenRadio AB
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+#ifndef NRF_SOC_H
+#define NRF_SOC_H
+
+/*
+ * The SoftDevice calls of reboot.c in the host build, where the retained
+ * register is kept in a variable. Not for the nodes.
+ */
+
+#include <stdint.h>
+
+extern uint32_t nrf_host_gpregret[2];
+
+static inline uint32_t sd_power_gpregret_clr(uint32_t gpregret_id, uint32_t gpregret_msk)
+{
+    nrf_host_gpregret[gpregret_id] &= ~gpregret_msk;
+    return 0;
+}
+
+static inline uint32_t sd_power_gpregret_set(uint32_t gpregret_id, uint32_t gpregret_msk)
+{
+    nrf_host_gpregret[gpregret_id] |= gpregret_msk;
+    return 0;
+}
+
+#endif
@@ -0,0 +1,202 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 LumenRadio AB
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+/*
+ * Host benchmark of the argument parsing of rpc-interface.c. Prints the cost
+ * of rpc_interface_get_args() for a few formats, from a command line, and
+ * from the values of a frame, for comparison. The time for the text includes
+ * copying the arguments, as they are split in place.
+ */
+
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* Included, to be able to set up the values of a frame */
+#include "../rpc-interface.c"
+
+#define CALLS 1000000
+
+typedef struct
+{
+    const char* name;
+    const char* text;
+    const uint8_t* values;
+    size_t values_size;
+    int (*parse)(char* line);
+} args_case_t;
+
+static volatile int sink;
+
+static int parse_i(char* line)
+{
+    int a;
+    int ret = rpc_interface_get_args(line, "i", &a);
+    sink = a;
+    return ret;
+}
+
+static int parse_x(char* line)
+{
+    uint32_t a;
+    int ret = rpc_interface_get_args(line, "x", &a);
+    sink = a;
+    return ret;
+}
+
+static int parse_iii(char* line)
+{
+    int a, b, c;
+    int ret = rpc_interface_get_args(line, "iii", &a, &b, &c);
+    sink = a + b + c;
+    return ret;
+}
+
+static int parse_s(char* line)
+{
+    const char* a;
+    int ret = rpc_interface_get_args(line, "s", &a);
+    sink = a[0];
+    return ret;
+}
+
+static int parse_xii(char* line)
+{
+    uint32_t a;
+    int b, c;
+    int ret = rpc_interface_get_args(line, "xii", &a, &b, &c);
+    sink = a + b + c;
+    return ret;
+}
+
+static int parse_b(char* line)
+{
+    uint8_t data[128];
+    int size = sizeof(data);
+    int ret = rpc_interface_get_args(line, "b", data, &size);
+    sink = data[size - 1];
+    return ret;
+}
+
+static int parse_optional(char* line)
+{
+    int a;
+    int b = 0;
+    int ret = rpc_interface_get_args(line, "i:i", &a, &b);
+    sink = a + b;
+    return ret;
+}
+
+static const uint8_t values_i[] = { 'i', 0xd2, 0x04, 0, 0 };
+static const uint8_t values_x[] = { 'x', 0xef, 0xbe, 0xad, 0xde };
+static const uint8_t values_iii[] = { 'i', 1, 0, 0, 0, 'i', 2, 0, 0, 0, 'i', 3, 0, 0, 0 };
+static const uint8_t values_s[] = { 's', 'h', 'e', 'l', 'l', 'o', 0 };
+static const uint8_t values_xii[] = { 'x', 0xcd, 0xab, 0x34, 0x12, 'i', 7, 0, 0, 0, 'i', 1, 0, 0, 0 };
+static const uint8_t values_optional[] = { 'i', 0xd2, 0x04, 0, 0 };
+static uint8_t values_b16[3 + 16] = { 'b', 16, 0 };
+static uint8_t values_b128[3 + 128] = { 'b', 128, 0 };
+static char text_b16[2 * 16 + 1];
+static char text_b128[2 * 128 + 1];
+
+static args_case_t cases[] = {
+    { "i", "1234", values_i, sizeof(values_i), parse_i },
+    { "x", "deadbeef", values_x, sizeof(values_x), parse_x },
+    { "iii", "1 2 3", values_iii, sizeof(values_iii), parse_iii },
+    { "s", "hello", values_s, sizeof(values_s), parse_s },
+    { "xii", "1234abcd 7 1", values_xii, sizeof(values_xii), parse_xii },
+    { "i:i", "1234", values_optional, sizeof(values_optional), parse_optional },
+    { "b 16", text_b16, values_b16, sizeof(values_b16), parse_b },
+    { "b 128", text_b128, values_b128, sizeof(values_b128), parse_b },
+};
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static double text_ns(const args_case_t* c)
+{
+    size_t size = strlen(c->text) + 1;
+    char line[2 * 128 + 1];
+
+    frame_request = false;
+    double start = now_ns();
+    for (int i = 0; i < CALLS; ++i) {
+        memcpy(line, c->text, size);
+        if (c->parse(line) != 0) {
+            fprintf(stderr, "%s: could not parse '%s'\n", c->name, c->text);
+            exit(1);
+        }
+    }
+    return (now_ns() - start) / CALLS;
+}
+
+static double frame_ns(const args_case_t* c)
+{
+    frame_request = true;
+    frame_values = c->values;
+    frame_values_end = c->values + c->values_size;
+    double start = now_ns();
+    for (int i = 0; i < CALLS; ++i) {
+        if (c->parse(NULL) != 0) {
+            fprintf(stderr, "%s: could not parse the frame values\n", c->name);
+            exit(1);
+        }
+    }
+    frame_request = false;
+    return (now_ns() - start) / CALLS;
+}
+
+int main(void)
+{
+    for (int i = 0; i < 128; ++i) {
+        values_b128[3 + i] = i * 7;
+        sprintf(&text_b128[2 * i], "%02x", values_b128[3 + i]);
+        if (i < 16) {
+            values_b16[3 + i] = i * 7;
+            sprintf(&text_b16[2 * i], "%02x", values_b16[3 + i]);
+        }
+    }
+
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i) {
+        double text = text_ns(&cases[i]);
+        double frame = frame_ns(&cases[i]);
+
+        printf("{\"format\": \"%s\", \"text_bytes\": %zu, \"text_ns\": %.1f, "
+               "\"text_mb_s\": %.1f, \"frame_ns\": %.1f}\n",
+               cases[i].name,
+               strlen(cases[i].text),
+               text,
+               strlen(cases[i].text) / text * 1e3,
+               frame);
+    }
+    return 0;
+}
@@ -0,0 +1,172 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 LumenRadio AB
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+/*
+ * Host benchmark of the command dispatch in rpc-interface.c. Builds command
+ * trees of different depths and widths, and prints the cost of dispatching a
+ * command line to a leaf command through the hash index, and through a
+ * linear search of the tables, for comparison.
+ */
+
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* Included, to be able to turn the hash index off between rounds */
+#include "../rpc-interface.c"
+
+#define MAX_DEPTH 4
+#define MAX_WIDTH 48
+#define N_LINES 4096
+#define DISPATCHES 2000000
+
+static const char* const words[MAX_WIDTH] = {
+    "reset",     "dfumode",   "config",    "profiler", "version",   "show",     "set_key",
+    "set_rate",  "set_pan_id", "set_antenna", "get_key", "get_rate", "get_pan_id",
+    "get_antenna", "stats",   "clear",     "monitor",  "neighbours", "parent",  "route",
+    "rssi",      "etx",       "latency",   "memory",   "topology",  "enable",   "disable",
+    "start",     "stop",      "status",    "interval", "channel",   "power",    "led",
+    "button",    "sensor",    "sample",    "period",   "threshold", "calibrate", "dump",
+    "load",      "save",      "erase",     "info",     "uptime",    "ping",     "echo",
+};
+
+static rpc_interface_command_t tables[MAX_DEPTH][MAX_WIDTH + 1];
+static char lines[N_LINES][MAX_DEPTH * 16];
+static char line[MAX_DEPTH * 16];
+static volatile long leaf_calls;
+
+static uint32_t rng_state = 2463534242u;
+
+static uint32_t rng(void)
+{
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void leaf_handler(char* line, const void* storage)
+{
+    (void)line;
+    (void)storage;
+    leaf_calls++;
+}
+
+/*
+ * Every command of a level leads to the table of the next level, so a tree
+ * of depth 4 and width 48 has 48^4 command lines, but only 4 tables.
+ */
+static void make_tree(int depth, int width)
+{
+    for (int level = 0; level < depth; ++level) {
+        for (int i = 0; i < width; ++i) {
+            rpc_interface_command_t* cmd = &tables[level][i];
+            cmd->command = words[(i + 7 * level) % MAX_WIDTH];
+            cmd->help_args = "";
+            cmd->help = "";
+            if (level + 1 < depth) {
+                cmd->handler = rpc_interface_command_handler;
+                cmd->storage = tables[level + 1];
+            } else {
+                cmd->handler = leaf_handler;
+                cmd->storage = NULL;
+            }
+        }
+        memset(&tables[level][width], 0, sizeof(tables[level][width]));
+    }
+
+    for (int i = 0; i < N_LINES; ++i) {
+        lines[i][0] = '\0';
+        for (int level = 0; level < depth; ++level) {
+            if (level > 0) {
+                strcat(lines[i], " ");
+            }
+            strcat(lines[i], tables[level][rng() % width].command);
+        }
+    }
+}
+
+static double dispatch_ns(void)
+{
+    double start = now_ns();
+    for (int i = 0; i < DISPATCHES; ++i) {
+        strcpy(line, lines[i % N_LINES]);
+        prefix_buffer[0] = '\0';
+        prefix_buffer_length = 0;
+        rpc_interface_command_handler(line, tables[0]);
+    }
+    return (now_ns() - start) / DISPATCHES;
+}
+
+int main(void)
+{
+    static const int depths[] = { 1, 2, 4 };
+    static const int widths[] = { 5, 16, 48 };
+
+    for (size_t d = 0; d < sizeof(depths) / sizeof(depths[0]); ++d) {
+        for (size_t w = 0; w < sizeof(widths) / sizeof(widths[0]); ++w) {
+            int depth = depths[d];
+            int width = widths[w];
+
+            make_tree(depth, width);
+            n_hash_tables = 0;
+            hash_pool_used = 0;
+            rpc_interface_init(rpc_interface_command_handler, -1, tables[0]);
+            if (n_hash_tables != depth) {
+                fprintf(stderr, "only %d of %d tables indexed\n", n_hash_tables, depth);
+                return 1;
+            }
+
+            leaf_calls = 0;
+            double hash_ns = dispatch_ns();
+            n_hash_tables = 0;
+            double linear_ns = dispatch_ns();
+            if (leaf_calls != 2L * DISPATCHES) {
+                fprintf(stderr, "%ld of %d dispatches reached a leaf\n", leaf_calls, 2 * DISPATCHES);
+                return 1;
+            }
+
+            printf("{\"depth\": %d, \"width\": %d, \"hash_ns\": %.1f, \"linear_ns\": %.1f, "
+                   "\"index_bytes\": %zu}\n",
+                   depth,
+                   width,
+                   hash_ns,
+                   linear_ns,
+                   hash_pool_used);
+        }
+    }
+    return 0;
+}
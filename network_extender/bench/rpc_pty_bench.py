@@ -0,0 +1,162 @@
+#!/usr/bin/env python3
+
+# Round trip latency and throughput of the network extender RPC interface,
+# text lines against binary frames, and stop-and-wait against pipelined
+# requests, over a pty to rpc_pty_device
+#
+#
+# MIT License
+#
+# Copyright (c) 2023 LumenRadio AB
+#
+# SPDX-License-Identifier: MIT
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+#
+#
+
+import os
+import subprocess
+import sys
+import time
+import tty
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), ".."))
+import rpc_frame  # noqa: E402
+
+REQUESTS = 5000
+# The longest echo that fits in a line of 256 characters, and in a frame
+TEXT_ECHO_SIZE = 125
+FRAME_ECHO_SIZE = 502
+
+
+def text_request(fd, line):
+    os.write(fd, line)
+    response = b""
+    while not response.endswith(b"\n"):
+        response += os.read(fd, 4096)
+    if not response.startswith(b"success"):
+        raise rpc_frame.RpcError(response.decode())
+    return response
+
+
+def run(name, payload_size, wire_bytes, request):
+    start = time.monotonic()
+    for _ in range(REQUESTS):
+        request()
+    elapsed = time.monotonic() - start
+    print(
+        "%-16s %8.1f %12d %14.0f %10d"
+        % (
+            name,
+            elapsed / REQUESTS * 1e6,
+            REQUESTS / elapsed,
+            payload_size * REQUESTS / elapsed,
+            wire_bytes,
+        )
+    )
+
+
+def run_pipelined(client, command, args, delay_us, window):
+    # Fewer requests through the delay, they take longer
+    n = REQUESTS if delay_us == 0 else REQUESTS // 25
+    start = time.monotonic()
+    if window == 1:
+        responses = [client.request(command, *args) for _ in range(n)]
+    else:
+        responses = client.pipeline([(command, args)] * n, window)
+    elapsed = time.monotonic() - start
+    if not all(response.success for response in responses):
+        raise rpc_frame.RpcError(command + " failed")
+    print("%-16s %8d %8d %12d" % (command, delay_us, window, n / elapsed))
+
+
+def frame_wire_bytes(command, args, values):
+    response_body = 3 + sum(len(rpc_frame.encode_value(v)) for v in values)
+    return len(rpc_frame.encode_request(0, command, *args)) + 2 + 2 + response_body + 2
+
+
+def start_device(path, delay_us=0):
+    device = subprocess.Popen([path, str(delay_us)], stdout=subprocess.PIPE)
+    fd = os.open(device.stdout.readline().decode().strip(), os.O_RDWR | os.O_NOCTTY)
+    tty.setraw(fd)
+    return device, fd
+
+
+def main():
+    path = sys.argv[1] if len(sys.argv) > 1 else "./rpc_pty_device"
+
+    device, fd = start_device(path)
+    try:
+        client = rpc_frame.RpcClient(fd)
+
+        text_echo = b"echo " + bytes(range(TEXT_ECHO_SIZE)).hex().encode() + b"\n"
+        frame_echo = bytes(i & 0xFF for i in range(FRAME_ECHO_SIZE))
+        if client.call("echo", frame_echo) != [frame_echo]:
+            raise rpc_frame.RpcError("echo mismatch")
+
+        set_rate = b"config set_rate 3\n"
+        print(
+            "%-16s %8s %12s %14s %10s"
+            % ("request", "rtt us", "requests/s", "payload B/s", "wire bytes")
+        )
+        run(
+            "text set_rate",
+            0,
+            len(set_rate) + len(b"success\n"),
+            lambda: text_request(fd, set_rate),
+        )
+        run(
+            "frame set_rate",
+            0,
+            frame_wire_bytes("config set_rate", [3], []),
+            lambda: client.call("config set_rate", 3),
+        )
+        run(
+            "text echo",
+            TEXT_ECHO_SIZE,
+            len(text_echo) + len(text_request(fd, text_echo)),
+            lambda: text_request(fd, text_echo),
+        )
+        run(
+            "frame echo",
+            FRAME_ECHO_SIZE,
+            frame_wire_bytes("echo", [frame_echo], [frame_echo]),
+            lambda: client.call("echo", frame_echo),
+        )
+    finally:
+        device.kill()
+
+    print()
+    print("%-16s %8s %8s %12s" % ("request", "delay us", "window", "requests/s"))
+    for delay_us in (0, 1000):
+        device, fd = start_device(path, delay_us)
+        try:
+            client = rpc_frame.RpcClient(fd)
+            # Requests for process commands are limited by the queue
+            for window in (1, 4, 16):
+                run_pipelined(client, "config set_rate", [3], delay_us, window)
+            for window in (1, 4):
+                run_pipelined(client, "work", [1], delay_us, window)
+        finally:
+            device.kill()
+
+
+if __name__ == "__main__":
+    main()
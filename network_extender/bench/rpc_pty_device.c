@@ -0,0 +1,140 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 LumenRadio AB
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+/*
+ * The RPC interface on the host, behind a pty, for rpc_pty_bench.py. Prints
+ * the name of the pty, and handles the bytes written to it with
+ * rpc_interface_input_byte(), as the extender does with its serial input.
+ *
+ * Commands:
+ *   config set_rate <rate> - check and drop the rate
+ *   echo <hex>             - send the bytes back
+ *   work [steps]           - a process, yields steps times before responding
+ *
+ * Processes are run between the reads from the pty. With a delay in
+ * microseconds as argument, the handling of each read waits for that long, as
+ * input from a link with that latency, like the 1 ms frames of USB.
+ */
+
+#define _DEFAULT_SOURCE
+#define _XOPEN_SOURCE 600
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <mira.h>
+
+#include "rpc-interface.h"
+
+static void set_rate(char* line, const void* storage)
+{
+    int rate;
+
+    (void)storage;
+    RPC_IF_EXPECT_ARGS(line, "i", &rate);
+    if (rate < 0 || rate > 15) {
+        rpc_interface_send_response(false, "Argument is not within 0..15");
+        return;
+    }
+    rpc_interface_send_response(true, NULL);
+}
+
+static void echo(char* line, const void* storage)
+{
+    static uint8_t data[RPC_IF_FRAME_SIZE];
+    int size = sizeof(data);
+
+    (void)storage;
+    RPC_IF_EXPECT_ARGS(line, "b", data, &size);
+    rpc_interface_send_result("b", data, size);
+}
+
+PROCESS(work_proc, "Work");
+
+PROCESS_THREAD(work_proc, ev, data)
+{
+    static int steps;
+    static int i;
+
+    PROCESS_BEGIN();
+    steps = 0;
+    RPC_IF_PROCESS_EXPECT_ARGS(":i", &steps);
+    for (i = 0; i < steps; ++i) {
+        PROCESS_PAUSE();
+    }
+    rpc_interface_send_result("i", steps);
+    PROCESS_END();
+}
+
+static const rpc_interface_command_t command_defs[] = RPC_IF_CMDS(
+  RPC_IF_SUB_CMDS("config", RPC_IF_CMD_HANDLER("set_rate", set_rate, NULL, "<rate>", "set rate")),
+  RPC_IF_CMD_HANDLER("echo", echo, NULL, "<hex>", "send the bytes back"),
+  RPC_IF_CMD_PROCESS("work", work_proc, "[steps]", "yield steps times, then respond"));
+
+int main(int argc, char** argv)
+{
+    useconds_t delay = argc > 1 ? strtoul(argv[1], NULL, 10) : 0;
+    struct termios tio;
+    uint8_t buf[4096];
+    ssize_t len;
+    int master;
+    int slave;
+
+    master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0) {
+        perror("pty");
+        return 1;
+    }
+
+    /* Raw, and kept open, so the pty stays up between clients */
+    slave = open(ptsname(master), O_RDWR | O_NOCTTY);
+    if (slave < 0 || tcgetattr(slave, &tio) != 0) {
+        perror("pty");
+        return 1;
+    }
+    cfmakeraw(&tio);
+    tcsetattr(slave, TCSANOW, &tio);
+
+    printf("%s\n", ptsname(master));
+    fflush(stdout);
+
+    rpc_interface_init(rpc_interface_command_handler, master, command_defs);
+
+    while ((len = read(master, buf, sizeof(buf))) > 0) {
+        if (delay > 0) {
+            usleep(delay);
+        }
+        for (ssize_t i = 0; i < len; ++i) {
+            rpc_interface_input_byte(buf[i]);
+        }
+        while (process_run() > 0) {
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,317 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 LumenRadio AB
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+/*
+ * Stress test of the serial input of the extender, on the host. A producer
+ * thread pushes a stream of commands into the ring buffers of
+ * serial_input.c, in chunks, at the rate of a USB full speed serial port,
+ * while the main thread runs the processes, as the nodes do.
+ *
+ * The stream mixes command lines and binary frames, each with a sequence
+ * number, and the frames carry the reboot sequence among random bytes. Once
+ * the stream is sent, the sequence numbers, the overrun counts and the bytes
+ * seen by the reboot parser are checked. The reboot parser gets the bytes
+ * of the lines, and the first magic byte of each frame.
+ *
+ * Usage: serial_stress [bytes per second] [uart|usb] [kilobytes]
+ *
+ * The rate defaults to 1000000. With 0, the producer waits for room in the
+ * ring instead of overrunning it, and the rate is that of the input
+ * handling. With uart, the bytes are passed one at a time through the UART
+ * input callback.
+ */
+
+#define _DEFAULT_SOURCE
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <mira.h>
+
+#include "reboot.h"
+#include "rpc-interface.h"
+#include "serial_input.h"
+
+#define CHUNK_SIZE 64
+#define FRAME_INTERVAL 8
+
+/* As matched by reboot_parser_input() in reboot.c */
+static const uint8_t reboot_sequence[] = { 0x7e, 0x02, 0xff, 0x8f, 0x33, 0x7e };
+
+static uint32_t rate = 1000000;
+static bool use_uart;
+static size_t total_size = 4 << 20;
+
+static uint8_t stream[1 << 16];
+static size_t stream_length;
+
+static uint32_t commands_sent;
+static uint32_t commands_seen;
+static uint32_t sequence_errors;
+static size_t text_bytes_sent;
+static size_t frames_sent;
+static size_t reboot_parser_bytes;
+static bool reboot_requested;
+
+static volatile bool producer_done;
+static long long max_lateness;
+
+void reboot_to_dfu(void)
+{
+    reboot_requested = true;
+}
+
+void reboot_parser_input(char c)
+{
+    static size_t position;
+
+    reboot_parser_bytes++;
+    if ((uint8_t)c == reboot_sequence[position]) {
+        if (++position >= sizeof(reboot_sequence)) {
+            reboot_to_dfu();
+        }
+    } else {
+        position = 0;
+    }
+}
+
+static void sequence(char* line, const void* storage)
+{
+    static uint8_t data[RPC_IF_FRAME_SIZE];
+    int size = sizeof(data);
+    int seq;
+
+    (void)storage;
+    RPC_IF_EXPECT_ARGS(line, "i:b", &seq, data, &size);
+    if ((uint32_t)seq != commands_seen) {
+        sequence_errors++;
+    }
+    commands_seen = seq + 1;
+    rpc_interface_send_response(true, NULL);
+}
+
+static const rpc_interface_command_t command_defs[] = RPC_IF_CMDS(
+  RPC_IF_CMD_HANDLER("seq", sequence, NULL, "<n> [hex]", "check sequence number"));
+
+static uint16_t crc16(const uint8_t* data, size_t length)
+{
+    uint16_t crc = 0xffff;
+    size_t i;
+    int bit;
+
+    for (i = 0; i < length; i++) {
+        crc ^= (uint16_t)data[i] << 8;
+        for (bit = 0; bit < 8; bit++) {
+            crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+static void put16(uint8_t* p, uint16_t value)
+{
+    p[0] = value & 0xff;
+    p[1] = value >> 8;
+}
+
+static void add_frame(uint32_t seq)
+{
+    uint8_t* frame = &stream[stream_length];
+    size_t n_random = 16 + rand() % 64;
+    size_t pos = 6;
+    size_t i;
+
+    frame[0] = RPC_IF_FRAME_MAGIC_0;
+    frame[1] = RPC_IF_FRAME_MAGIC_1;
+    put16(&frame[4], seq);
+    memcpy(&frame[pos], "seq", 4);
+    pos += 4;
+    frame[pos++] = 'i';
+    memcpy(&frame[pos], &seq, 4);
+    pos += 4;
+    frame[pos++] = 'b';
+    put16(&frame[pos], n_random + sizeof(reboot_sequence));
+    pos += 2;
+    for (i = 0; i < n_random; i++) {
+        frame[pos++] = rand();
+    }
+    memcpy(&frame[pos], reboot_sequence, sizeof(reboot_sequence));
+    pos += sizeof(reboot_sequence);
+    put16(&frame[2], pos - 4);
+    put16(&frame[pos], crc16(&frame[2], pos - 2));
+    stream_length += pos + 2;
+    frames_sent++;
+}
+
+/* One pass of commands, as much as fits the stream buffer */
+static void build_stream(void)
+{
+    while (stream_length + RPC_IF_FRAME_SIZE < sizeof(stream)) {
+        if (commands_sent % FRAME_INTERVAL == 0) {
+            add_frame(commands_sent);
+        } else {
+            size_t length = sprintf((char*)&stream[stream_length],
+                                    "seq %lu\n",
+                                    (unsigned long)commands_sent);
+            stream_length += length;
+            text_bytes_sent += length;
+        }
+        commands_sent++;
+    }
+}
+
+static void push(const uint8_t* data, size_t length)
+{
+    size_t i;
+
+    if (rate == 0) {
+        /* Wait for room, to measure how fast the input is handled */
+        while (serial_input_space(SERIAL_INPUT_USB) < length) {
+            sched_yield();
+        }
+        serial_input_push(SERIAL_INPUT_USB, data, length);
+    } else if (use_uart) {
+        for (i = 0; i < length; i++) {
+            serial_input_uart_callback(data[i], NULL);
+        }
+    } else {
+        serial_input_push(SERIAL_INPUT_USB, data, length);
+    }
+}
+
+static void* producer(void* arg)
+{
+    struct timespec next;
+    struct timespec now;
+    long long late;
+    size_t pos = 0;
+    long interval = rate > 0 ? 1000000000LL * CHUNK_SIZE / rate : 0;
+
+    (void)arg;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    while (pos < stream_length) {
+        size_t length = stream_length - pos < CHUNK_SIZE ? stream_length - pos : CHUNK_SIZE;
+
+        if (interval > 0) {
+            next.tv_nsec += interval;
+            if (next.tv_nsec >= 1000000000) {
+                next.tv_nsec -= 1000000000;
+                next.tv_sec++;
+            }
+            clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            late = (now.tv_sec - next.tv_sec) * 1000000000LL + now.tv_nsec - next.tv_nsec;
+            if (late > max_lateness) {
+                max_lateness = late;
+            }
+            /* No catching up faster than the line rate, after being late */
+            if (late > interval) {
+                next = now;
+            }
+        }
+        push(&stream[pos], length);
+        pos += length;
+    }
+    producer_done = true;
+    return NULL;
+}
+
+int main(int argc, char** argv)
+{
+    serial_input_port_t port;
+    serial_input_stats_t stats;
+    struct timespec start;
+    struct timespec end;
+    pthread_t thread;
+    size_t passes;
+    size_t pass;
+    double seconds;
+    int fd;
+
+    if (argc > 1) {
+        rate = strtoul(argv[1], NULL, 10);
+    }
+    use_uart = argc > 2 && strcmp(argv[2], "uart") == 0;
+    if (argc > 3) {
+        total_size = strtoul(argv[3], NULL, 10) << 10;
+    }
+    port = use_uart ? SERIAL_INPUT_UART : SERIAL_INPUT_USB;
+
+    fd = open("/dev/null", O_WRONLY);
+    rpc_interface_init(rpc_interface_command_handler, fd, command_defs);
+    serial_input_init();
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    passes = (total_size + sizeof(stream) - 1) / sizeof(stream);
+    for (pass = 0; pass < passes; pass++) {
+        stream_length = 0;
+        build_stream();
+        producer_done = false;
+        pthread_create(&thread, NULL, producer, NULL);
+        while (!producer_done) {
+            if (process_run() == 0) {
+                /* Let the producer run on time, also on a single core */
+                sched_yield();
+            }
+        }
+        pthread_join(thread, NULL);
+        while (process_run() > 0) {
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    seconds = end.tv_sec - start.tv_sec + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+    serial_input_get_stats(port, &stats);
+    printf("%s, %lu bytes/s: %lu bytes in %.2f s, %.0f bytes/s\n",
+           use_uart ? "UART" : "USB",
+           (unsigned long)rate,
+           (unsigned long)stats.received,
+           seconds,
+           stats.received / seconds);
+    printf("  overruns %lu, commands %lu of %lu, sequence errors %lu\n",
+           (unsigned long)stats.overruns,
+           (unsigned long)commands_seen,
+           (unsigned long)commands_sent,
+           (unsigned long)sequence_errors);
+    printf("  max lateness %lld us\n", max_lateness / 1000);
+    printf("  reboot parser: %lu of %lu bytes outside frames%s\n",
+           (unsigned long)reboot_parser_bytes,
+           (unsigned long)(text_bytes_sent + frames_sent),
+           reboot_requested ? ", reboot requested" : "");
+
+    if (stats.overruns > 0 || sequence_errors > 0 || commands_seen != commands_sent ||
+        reboot_parser_bytes != text_bytes_sent + frames_sent || reboot_requested) {
+        printf("FAILED\n");
+        return 1;
+    }
+    return 0;
+}
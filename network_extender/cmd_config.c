@@ -36,46 +36,58 @@
 
 static void cmd_config_set_key(char* line, const void* storage)
 {
-    app_config_set_key(line);
+    uint8_t key[16];
+    int size = sizeof(key);
+
+    RPC_IF_EXPECT_ARGS(line, "b", key, &size);
+    if (size != sizeof(key)) {
+        rpc_interface_send_response(false, "Key is not 16 bytes");
+        return;
+    }
+    app_config_set_key(key);
     rpc_interface_send_response(true, NULL);
 }
 
 static void cmd_config_set_rate(char* line, const void* storage)
 {
-    char* endptr;
-    long rate = strtol(line, &endptr, 10);
-    if (*endptr != 0) {
-        rpc_interface_send_response(false, "Argument is not a number\n");
-    } else if (rate < 0 || rate > 15) {
-        rpc_interface_send_response(false, "Argument is not within 0..15\n");
-    } else {
-        app_config_set_rate(rate);
-        rpc_interface_send_response(true, NULL);
+    int rate;
+
+    RPC_IF_EXPECT_ARGS(line, "i", &rate);
+    if (rate < 0 || rate > 15) {
+        rpc_interface_send_response(false, "Argument is not within 0..15");
+        return;
     }
+    app_config_set_rate(rate);
+    rpc_interface_send_response(true, NULL);
 }
 
 static void cmd_config_set_pan_id(char* line, const void* storage)
 {
-    app_config_set_pan_id(line);
+    uint32_t pan_id;
+
+    RPC_IF_EXPECT_ARGS(line, "x", &pan_id);
+    app_config_set_pan_id(pan_id);
     rpc_interface_send_response(true, NULL);
 }
 
 static void cmd_config_set_antenna(char* line, const void* storage)
 {
-    char* endptr;
-    long antenna = strtol(line, &endptr, 10);
-    if (*endptr != 0) {
-        rpc_interface_send_response(false, "Argument is not a number\n");
-    } else if (antenna > UINT8_MAX) {
-        rpc_interface_send_response(false, "Argument is too large: %ld\n", antenna);
-    } else {
-        app_config_set_antenna((uint8_t)antenna);
+    int antenna;
+
+    RPC_IF_EXPECT_ARGS(line, "i", &antenna);
+    if (antenna < 0 || antenna > UINT8_MAX) {
+        rpc_interface_send_response(false, "Argument is not within 0..255");
+        return;
     }
+    app_config_set_antenna((uint8_t)antenna);
+    rpc_interface_send_response(true, NULL);
 }
 
 static void cmd_config_show(char* line, const void* storage)
 {
     print_config();
+    rpc_interface_send_result(
+      "xii", app_config.net_pan_id, (int)app_config.net_rate, (int)app_config.antenna);
 }
 
 const rpc_interface_command_t command_config_defs[] = RPC_IF_CMDS(
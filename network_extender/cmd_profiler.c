@@ -0,0 +1,76 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 LumenRadio AB
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include "rpc-interface.h"
+
+#include "cmd_profiler.h"
+#include "process_profiler.h"
+
+static void cmd_profiler_show(char* line, const void* storage)
+{
+    const process_profile_t* profile;
+    int index = 0;
+
+    if (!PROCESS_PROFILER) {
+        rpc_interface_send_response(false, "not built with PROCESS_PROFILER=1");
+        return;
+    }
+
+    RPC_IF_EXPECT_ARGS(line, ":i", &index);
+    for (profile = process_profiler_first(); profile != NULL && index > 0;
+         profile = profile->next) {
+        index--;
+    }
+    if (profile == NULL || index < 0) {
+        rpc_interface_send_response(false, "No such process");
+        return;
+    }
+
+    /*
+     * One process per request, as a result, so the statistics go out as a
+     * response frame in frame mode, and not as text between the frames
+     */
+    rpc_interface_send_result("sxxxxx",
+                              profile->name,
+                              profile->dispatches,
+                              profile->total_run_time_us,
+                              profile->max_run_time_us,
+                              profile->max_timer_lateness_ms,
+                              profile->timer_events > 0
+                                ? profile->total_timer_lateness_ms / profile->timer_events
+                                : 0);
+}
+
+static void cmd_profiler_reset(char* line, const void* storage)
+{
+    process_profiler_reset();
+    rpc_interface_send_response(true, NULL);
+}
+
+const rpc_interface_command_t command_profiler_defs[] = RPC_IF_CMDS(
+  RPC_IF_CMD_HANDLER("show", cmd_profiler_show, NULL, "[index]", "show statistics of a process"),
+  RPC_IF_CMD_HANDLER("reset", cmd_profiler_reset, NULL, "", "clear process statistics"));
@@ -30,8 +30,10 @@
 #include "rpc-interface.h"
 #include <mira.h>
 #include "reboot.h"
+#include "serial_input.h"
 
 #include "cmd_config.h"
+#include "cmd_profiler.h"
 
 static void command_reset(char* line, const void* storage)
 {
@@ -49,6 +51,22 @@ static void command_version(char* line, const void* storage)
     rpc_interface_send_response(true, NULL);
 }
 
+static void command_input(char* line, const void* storage)
+{
+    serial_input_stats_t uart;
+    serial_input_stats_t usb;
+
+    serial_input_get_stats(SERIAL_INPUT_UART, &uart);
+    serial_input_get_stats(SERIAL_INPUT_USB, &usb);
+    printf("UART: %lu bytes received, %lu overruns\n",
+           (unsigned long)uart.received,
+           (unsigned long)uart.overruns);
+    printf("USB: %lu bytes received, %lu overruns\n",
+           (unsigned long)usb.received,
+           (unsigned long)usb.overruns);
+    rpc_interface_send_result("xxxx", uart.received, uart.overruns, usb.received, usb.overruns);
+}
+
 const rpc_interface_command_t command_defs[] = RPC_IF_CMDS(
   RPC_IF_CMD_HANDLER("reset", command_reset, NULL, "", "Reset CPU"),
   RPC_IF_CMD_HANDLER("dfumode",
@@ -57,4 +75,6 @@ const rpc_interface_command_t command_defs[] = RPC_IF_CMDS(
                      "",
                      "Reset CPU to device firmware update mode"),
   RPC_IF_CMD_HANDLER("config", rpc_interface_command_handler, command_config_defs, "", ""),
+  RPC_IF_CMD_HANDLER("profiler", rpc_interface_command_handler, command_profiler_defs, "", ""),
+  RPC_IF_CMD_HANDLER("input", command_input, NULL, "", "Serial input statistics"),
   RPC_IF_CMD_HANDLER("version", command_version, NULL, "", "Version info"));
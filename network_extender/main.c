@@ -33,6 +33,14 @@
 #include "rpc-interface.h"
 #include "app-config.h"
 #include "reboot.h"
+#include "process_profiler.h"
+#include "net_watch.h"
+#include "serial_input.h"
+
+/* Size of the memory buffer given to Mira */
+#ifndef MIRA_MEM_BUFFER_SIZE
+#define MIRA_MEM_BUFFER_SIZE 8680
+#endif
 
 #if CONTIKI_TARGET_MKW41Z
 /* If target is mkw41z, assume rigado devboard pinout */
@@ -113,7 +121,7 @@ static void set_leds_joined(void)
     }
 }
 
-PROCESS(main_proc, "Main process");
+PROFILED_PROCESS(main_proc, "Main process");
 
 void mira_setup(void)
 {
@@ -121,7 +129,7 @@ void mira_setup(void)
     mira_uart_config_t uart_config = { .baudrate = 115200,
                                        .tx_pin = MIRA_GPIO_PIN(0, 6),
                                        .rx_pin = MIRA_GPIO_PIN(0, 8) };
-    MIRA_MEM_SET_BUFFER(8680);
+    MIRA_MEM_SET_BUFFER(MIRA_MEM_BUFFER_SIZE);
 
     uart_ret = mira_uart_init(0, &uart_config);
     if (uart_ret != MIRA_SUCCESS) {
@@ -137,19 +145,10 @@ void mira_setup(void)
     init_leds();
 
     rpc_interface_init(rpc_interface_command_handler, 1, command_defs);
+    serial_input_init();
     process_start(&main_proc, NULL);
 }
 
-static int serial_input_byte(unsigned char c, void* storage)
-{
-    (void)storage;
-
-    reboot_parser_input(c);
-    rpc_interface_input_byte(c);
-
-    return 0;
-}
-
 PROCESS_THREAD(main_proc, ev, data)
 {
     static struct etimer timer;
@@ -181,13 +180,13 @@ PROCESS_THREAD(main_proc, ev, data)
     mira_net_init(&netconf);
     print_config();
 
-    mira_status_t result = mira_uart_set_input_callback(0, serial_input_byte, NULL);
+    mira_status_t result = mira_uart_set_input_callback(0, serial_input_uart_callback, NULL);
     if (result != MIRA_SUCCESS) {
         printf("error: mira_uart_set_input_callback (%d)\n", result);
     }
 
 #if defined(NRF52840_XXAA) || defined(NRF52833_XXAA)
-    result = mira_usb_uart_set_input_callback(serial_input_byte, NULL);
+    result = mira_usb_uart_set_input_callback(serial_input_usb_callback, NULL);
     if (result != MIRA_SUCCESS) {
         printf("error: mira_usb_uart_set_input_callback (%d)\n", result);
     }
@@ -196,8 +195,14 @@ PROCESS_THREAD(main_proc, ev, data)
     /* Start fota process, which polls updates from network */
     mira_fota_init();
 
+    /* Update the LEDs when the network state changes, instead of polling it */
+    net_watch_init();
+    net_watch_subscribe(&main_proc);
+
     while (1) {
-        mira_net_state_t net_state = mira_net_get_state();
+        PROCESS_WAIT_EVENT_UNTIL(ev == net_watch_event || ev == PROCESS_EVENT_TIMER);
+
+        mira_net_state_t net_state = net_watch_get()->state;
 
         switch (net_state) {
             case MIRA_NET_STATE_NOT_ASSOCIATED:
@@ -219,8 +224,12 @@ PROCESS_THREAD(main_proc, ev, data)
             print_net_state();
         }
 
-        etimer_set(&timer, CLOCK_SECOND * 1);
-        PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&timer));
+        /* Only the joined state blinks, so only then is a timer needed */
+        if (net_state == MIRA_NET_STATE_JOINED || net_state == MIRA_NET_STATE_IS_COORDINATOR) {
+            etimer_set(&timer, CLOCK_SECOND * 1);
+        } else {
+            etimer_stop(&timer);
+        }
     }
 
     PROCESS_END();
@@ -34,6 +34,8 @@ import sys
 
 import serial
 
+import rpc_frame
+
 
 # Custom action, to parse hex values for address/length instead of plain int
 def arg_net_pan_id(value):
@@ -77,7 +79,8 @@ def arg_build_parser():
         "--hw-dev",
         dest="hw_dev",
         metavar="DEV",
-        help="Device for sniffer",
+        nargs="+",
+        help="Serial devices of the extenders, all are configured the same",
         required=True,
     )
 
@@ -125,38 +128,62 @@ def arg_build_parser():
     return parser
 
 
-if __name__ == "__main__":
-    import argparse
+def open_devices(paths):
+    devices = []
+    for path in paths:
+        try:
+            sdev = serial.Serial(path, 115200)
+        except serial.SerialException:
+            print("Could not open device: " + path)
+            sys.exit(-1)
+        devices.append((path, rpc_frame.RpcClient(sdev.fileno())))
+    return devices
+
+
+def wait_all(pending):
+    """Wait for the responses of each device, returns the devices that
+    answered all requests successfully"""
+    ok = []
+    for path, client, request_ids in pending:
+        try:
+            for request_id in request_ids:
+                rpc_frame.check(client.wait(request_id))
+        except rpc_frame.RpcError as e:
+            print(path + ": " + str(e))
+            continue
+        ok.append((path, client))
+    return ok
+
 
+if __name__ == "__main__":
     parser = arg_build_parser()
     args = parser.parse_args()
 
-    try:
-        sdev = serial.Serial(args.hw_dev, 115200)
-    except:
-        print("Could not open device: " + args.hw_dev)
-        sys.exit(-1)
-
-    sdev.timeout = 3
-    sdev.writeTimeout = 3
-    sdev.write(("\n").encode())
-    sdev.write(("version\n").encode())
-    try:
-        version = sdev.read_until("\n")
-    except serial.SerialTimeoutException:
-        print("Timeout while waiting for device")
-        sys.exit(-1)
-
-    if len(version) == 0 or str(version).startswith("MiraUSB Network Extender"):
-        print(version)
-        print("Not a MiraUSB Network Extender device")
+    devices = open_devices(args.hw_dev)
+
+    # The requests are sent to all devices before waiting for any response,
+    # so the devices are configured in parallel, each with its requests
+    # pipelined, in about one round trip.
+    found = []
+    for path, client in wait_all([(p, c, [c.send("version")]) for p, c in devices]):
+        if b"MiraUSB Network Extender" in client.text:
+            found.append((path, client))
+        else:
+            print(path + ": Not a MiraUSB Network Extender device")
+
+    config = [
+        ("config set_pan_id", args.net_pan_id),
+        ("config set_key", bytes.fromhex(args.net_key)),
+        ("config set_rate", args.net_rate),
+        ("config set_antenna", args.antenna),
+    ]
+    pending = [
+        (path, client, [client.send(command, value) for command, value in config])
+        for path, client in found
+    ]
+    configured = wait_all(pending)
+    for path, _ in configured:
+        print(path + ": MiraUSB Network Extender configured!")
+
+    if len(configured) != len(devices):
         sys.exit(-1)
-
-    print("MiraUSB Network Extender found!")
-    sdev.write(("config set_pan_id " + hex(args.net_pan_id)[2:] + "\n").encode())
-    sdev.write(("config set_key " + str(args.net_key) + "\n").encode())
-    sdev.write(("config set_rate " + str(args.net_rate) + "\n").encode())
-    sdev.write(("config set_antenna " + str(args.antenna) + "\n").encode())
-    print("MiraUSB Network Extender configured!")
-
-    sdev.close()
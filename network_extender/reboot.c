@@ -46,7 +46,7 @@ void reboot_parser_input(char c)
     const uint8_t reboot_cmd[] = { 0x7e, 0x02, 0xff, 0x8f, 0x33, 0x7e };
 
     if (c == reboot_cmd[reboot_position]) {
-        if (++reboot_position >= sizeof(reboot_cmd)) {
+        if (++reboot_position >= (int)sizeof(reboot_cmd)) {
             reboot_to_dfu();
         }
     } else {
@@ -31,13 +31,279 @@
 #include <stdarg.h>
 #include <string.h>
 #include <stdlib.h>
+#include <unistd.h>
+#include "process_profiler.h"
 
 static rpc_interface_handler_t rpc_interface_handler;
 static const void* rpc_interface_handler_storage;
 static int rpc_interface_reporting_fd;
 static char prefix_buffer[128];
+static size_t prefix_buffer_length;
+static char linebuf[256];
+static size_t linepos;
 
-PROCESS(rpc_interface_start_message, "RPC start message sender");
+/*
+ * Command lookup
+ *
+ * The command tables are written with RPC_IF_CMDS() and stay in flash. When
+ * the interface is initialized, every table reachable from the root table is
+ * given a minimal perfect hash index in RAM: the hash of the command token
+ * selects a bucket, the displacement of the bucket selects a slot, and the
+ * slot holds the only command in the table that can match. A command is then
+ * found with one pass over the token and one strcmp(), however many commands
+ * the table has.
+ *
+ * Tables that don't fit in RPC_IF_HASH_MAX_TABLES or RPC_IF_HASH_POOL_SIZE,
+ * have more than RPC_IF_HASH_MAX_COMMANDS commands, or have no perfect hash
+ * (only when a command is listed twice) are searched linearly instead.
+ */
+#ifndef RPC_IF_HASH_MAX_TABLES
+#define RPC_IF_HASH_MAX_TABLES 8
+#endif
+
+/* Two bytes per command, for all indexed tables */
+#ifndef RPC_IF_HASH_POOL_SIZE
+#define RPC_IF_HASH_POOL_SIZE 128
+#endif
+
+#ifndef RPC_IF_HASH_MAX_COMMANDS
+#define RPC_IF_HASH_MAX_COMMANDS 64
+#endif
+
+#define RPC_IF_HASH_EMPTY 0xff
+
+typedef struct
+{
+    const rpc_interface_command_t* table;
+    /* n_commands bucket displacements, followed by n_commands slots */
+    uint8_t* index;
+    uint8_t n_commands;
+} rpc_interface_hash_t;
+
+static rpc_interface_hash_t hash_tables[RPC_IF_HASH_MAX_TABLES];
+static int n_hash_tables;
+static uint8_t hash_pool[RPC_IF_HASH_POOL_SIZE];
+static size_t hash_pool_used;
+
+/* FNV-1a */
+static uint32_t rpc_interface_hash(const char* token)
+{
+    uint32_t hash = 2166136261u;
+    while (*token != '\0') {
+        hash ^= (uint8_t)*token++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static uint32_t rpc_interface_hash_slot(uint32_t hash, uint8_t displacement, uint8_t n_commands)
+{
+    hash ^= displacement * 0x9e3779b9u;
+    hash *= 0x85ebca6bu;
+    hash ^= hash >> 15;
+    return hash % n_commands;
+}
+
+static const rpc_interface_hash_t* rpc_interface_hash_find(const rpc_interface_command_t* table)
+{
+    int i;
+    for (i = 0; i < n_hash_tables; i++) {
+        if (hash_tables[i].table == table) {
+            return &hash_tables[i];
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Find a displacement for every bucket, largest buckets first, that moves
+ * all commands of the bucket to free slots. Returns false if there is none.
+ */
+static bool rpc_interface_hash_build(const rpc_interface_command_t* table,
+                                     uint8_t n_commands,
+                                     uint8_t* index)
+{
+    uint32_t hashes[RPC_IF_HASH_MAX_COMMANDS];
+    uint8_t bucket_size[RPC_IF_HASH_MAX_COMMANDS];
+    uint8_t* displacements = index;
+    uint8_t* slots = &index[n_commands];
+    uint8_t size;
+    uint8_t i;
+    uint8_t bucket;
+
+    memset(bucket_size, 0, n_commands);
+    memset(slots, RPC_IF_HASH_EMPTY, n_commands);
+    for (i = 0; i < n_commands; i++) {
+        hashes[i] = rpc_interface_hash(table[i].command);
+        bucket_size[hashes[i] % n_commands]++;
+    }
+
+    for (size = n_commands; size > 0; size--) {
+        for (bucket = 0; bucket < n_commands; bucket++) {
+            unsigned int displacement;
+            if (bucket_size[bucket] != size) {
+                continue;
+            }
+            for (displacement = 0; displacement <= UINT8_MAX; displacement++) {
+                bool placed = true;
+                for (i = 0; i < n_commands && placed; i++) {
+                    uint32_t slot;
+                    if (hashes[i] % n_commands != bucket) {
+                        continue;
+                    }
+                    slot = rpc_interface_hash_slot(hashes[i], displacement, n_commands);
+                    if (slots[slot] == RPC_IF_HASH_EMPTY) {
+                        slots[slot] = i;
+                    } else {
+                        placed = false;
+                    }
+                }
+                if (placed) {
+                    break;
+                }
+                /* Undo the commands of this bucket that were placed */
+                for (i = 0; i < n_commands; i++) {
+                    uint32_t slot = rpc_interface_hash_slot(hashes[i], displacement, n_commands);
+                    if (hashes[i] % n_commands == bucket && slots[slot] == i) {
+                        slots[slot] = RPC_IF_HASH_EMPTY;
+                    }
+                }
+            }
+            if (displacement > UINT8_MAX) {
+                return false;
+            }
+            displacements[bucket] = displacement;
+        }
+    }
+    return true;
+}
+
+static void rpc_interface_hash_tables(const rpc_interface_command_t* table)
+{
+    const rpc_interface_command_t* curcmd;
+    size_t n_commands = 0;
+
+    if (rpc_interface_hash_find(table) != NULL) {
+        return;
+    }
+
+    for (curcmd = table; curcmd->command != NULL; curcmd++) {
+        n_commands++;
+    }
+
+    if (n_hash_tables < RPC_IF_HASH_MAX_TABLES && n_commands > 0 &&
+        n_commands <= RPC_IF_HASH_MAX_COMMANDS &&
+        hash_pool_used + 2 * n_commands <= sizeof(hash_pool)) {
+        rpc_interface_hash_t* hash = &hash_tables[n_hash_tables];
+        hash->table = table;
+        hash->index = &hash_pool[hash_pool_used];
+        hash->n_commands = n_commands;
+        if (rpc_interface_hash_build(table, n_commands, hash->index)) {
+            n_hash_tables++;
+            hash_pool_used += 2 * n_commands;
+        }
+    }
+
+    for (curcmd = table; curcmd->command != NULL; curcmd++) {
+        if (curcmd->handler == rpc_interface_command_handler) {
+            rpc_interface_hash_tables(curcmd->storage);
+        }
+    }
+}
+
+static const rpc_interface_command_t* rpc_interface_lookup(const rpc_interface_command_t* table,
+                                                           const char* cmd)
+{
+    const rpc_interface_hash_t* hash = rpc_interface_hash_find(table);
+    const rpc_interface_command_t* curcmd;
+
+    if (hash != NULL) {
+        uint32_t token_hash = rpc_interface_hash(cmd);
+        uint8_t displacement = hash->index[token_hash % hash->n_commands];
+        uint32_t slot = rpc_interface_hash_slot(token_hash, displacement, hash->n_commands);
+        curcmd = &table[hash->index[hash->n_commands + slot]];
+        return strcmp(curcmd->command, cmd) == 0 ? curcmd : NULL;
+    }
+
+    for (curcmd = table; curcmd->command != NULL; curcmd++) {
+        if (strcmp(curcmd->command, cmd) == 0) {
+            return curcmd;
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Binary frames, see rpc-interface.h
+ *
+ * The frame buffer holds a received frame from the length to the crc, the
+ * response buffer a frame to send, from the magic to the crc.
+ */
+#define RPC_IF_FRAME_STATUS_SUCCESS 0
+#define RPC_IF_FRAME_STATUS_ERROR 1
+
+static uint8_t frame_buffer[2 + RPC_IF_FRAME_SIZE + 2];
+/* Number of bytes of the frame received, including the magic */
+static uint16_t frame_position;
+static uint16_t frame_length;
+
+/* Set while handling a request that came in a frame */
+static bool frame_request;
+static uint16_t frame_request_id;
+static const uint8_t* frame_values;
+static const uint8_t* frame_values_end;
+
+static uint8_t response_buffer[4 + RPC_IF_FRAME_SIZE + 2];
+static uint16_t response_length;
+static bool response_overflow;
+
+/*
+ * Requests for commands run as processes
+ *
+ * A process command runs for one request at a time. Requests for a process
+ * that is already running are queued, with a copy of their arguments, and
+ * started in order as it exits, instead of being rejected. The request of
+ * each running process is kept, so that a response sent by it later, after
+ * yielding, carries the right request ID, whatever has been handled in
+ * between. Responses can thereby complete out of order.
+ *
+ * RPC_IF_MAX_REQUESTS limits the running and queued requests together, and
+ * RPC_IF_REQUEST_DATA_SIZE the arguments of a queued request.
+ */
+#ifndef RPC_IF_MAX_REQUESTS
+#define RPC_IF_MAX_REQUESTS 4
+#endif
+
+#ifndef RPC_IF_REQUEST_DATA_SIZE
+#define RPC_IF_REQUEST_DATA_SIZE 64
+#endif
+
+typedef enum {
+    RPC_IF_REQUEST_FREE,
+    RPC_IF_REQUEST_QUEUED,
+    RPC_IF_REQUEST_RUNNING,
+} rpc_interface_request_state_t;
+
+typedef struct
+{
+    struct process* process;
+    uint8_t state;
+    bool frame;
+    uint16_t id;
+    /* Order of queueing, to start queued requests in order */
+    uint16_t sequence;
+    /* Length of the line, including the NUL, or 0 if none */
+    uint16_t line_length;
+    uint16_t values_length;
+    /* The line, followed by the values of a frame */
+    uint8_t data[RPC_IF_REQUEST_DATA_SIZE];
+} rpc_interface_request_t;
+
+static rpc_interface_request_t requests[RPC_IF_MAX_REQUESTS];
+static uint16_t request_sequence;
+
+PROFILED_PROCESS(rpc_interface_start_message, "RPC start message sender");
+PROFILED_PROCESS(rpc_interface_requests, "RPC requests");
 
 void rpc_interface_init(rpc_interface_handler_t handler, int report_fd, const void* storage)
 {
@@ -45,7 +311,12 @@ void rpc_interface_init(rpc_interface_handler_t handler, int report_fd, const vo
     rpc_interface_handler_storage = storage;
     rpc_interface_reporting_fd = report_fd;
 
+    if (handler == rpc_interface_command_handler) {
+        rpc_interface_hash_tables(storage);
+    }
+
     process_start(&rpc_interface_start_message, NULL);
+    process_start(&rpc_interface_requests, NULL);
 }
 
 PROCESS_THREAD(rpc_interface_start_message, ev, data)
@@ -55,49 +326,543 @@ PROCESS_THREAD(rpc_interface_start_message, ev, data)
     PROCESS_END();
 }
 
-void rpc_interface_input_byte(char byte)
+static rpc_interface_request_t* rpc_interface_request_alloc(struct process* proc)
 {
-    static char linebuf[256];
-    static int linepos = 0;
-    /* Got a line */
-    if (byte == '\n' || byte == '\r') {
-        if (linepos > 0) {
-            linebuf[linepos++] = 0;
-            linepos = 0;
-            prefix_buffer[0] = '\0'; /* So command handlers can have nice help output */
-            rpc_interface_handler(linebuf, rpc_interface_handler_storage);
+    int i;
+    for (i = 0; i < RPC_IF_MAX_REQUESTS; i++) {
+        if (requests[i].state == RPC_IF_REQUEST_FREE) {
+            requests[i].process = proc;
+            requests[i].frame = frame_request;
+            requests[i].id = frame_request_id;
+            return &requests[i];
+        }
+    }
+    return NULL;
+}
+
+static rpc_interface_request_t* rpc_interface_request_find(const struct process* proc, uint8_t state)
+{
+    rpc_interface_request_t* found = NULL;
+    int i;
+    for (i = 0; i < RPC_IF_MAX_REQUESTS; i++) {
+        if (requests[i].process == proc && requests[i].state == state &&
+            (found == NULL || (int16_t)(requests[i].sequence - found->sequence) < 0)) {
+            found = &requests[i];
+        }
+    }
+    return found;
+}
+
+/* Start the process of a request, with the arguments of the request */
+static void rpc_interface_request_start(rpc_interface_request_t* request, char* line)
+{
+    request->state = RPC_IF_REQUEST_RUNNING;
+    process_start(request->process, line);
+    if (!process_is_running(request->process)) {
+        /* Done already */
+        request->state = RPC_IF_REQUEST_FREE;
+    }
+}
+
+static void rpc_interface_request_start_queued(rpc_interface_request_t* request)
+{
+    bool saved_frame_request = frame_request;
+    uint16_t saved_frame_request_id = frame_request_id;
+    const uint8_t* saved_frame_values = frame_values;
+    const uint8_t* saved_frame_values_end = frame_values_end;
+
+    frame_request = request->frame;
+    frame_request_id = request->id;
+    frame_values = &request->data[request->line_length];
+    frame_values_end = &frame_values[request->values_length];
+    rpc_interface_request_start(request, request->line_length > 0 ? (char*)request->data : NULL);
+
+    frame_request = saved_frame_request;
+    frame_request_id = saved_frame_request_id;
+    frame_values = saved_frame_values;
+    frame_values_end = saved_frame_values_end;
+}
+
+/* Release the requests of processes that have exited, and start the next */
+static void rpc_interface_requests_update(void)
+{
+    rpc_interface_request_t* request;
+    bool started;
+    int i;
+
+    for (i = 0; i < RPC_IF_MAX_REQUESTS; i++) {
+        if (requests[i].state == RPC_IF_REQUEST_RUNNING &&
+            !process_is_running(requests[i].process)) {
+            requests[i].state = RPC_IF_REQUEST_FREE;
+        }
+    }
+
+    /* Again after a process that was done already, it may have more queued */
+    do {
+        started = false;
+        for (i = 0; i < RPC_IF_MAX_REQUESTS; i++) {
+            if (requests[i].state == RPC_IF_REQUEST_QUEUED &&
+                !process_is_running(requests[i].process)) {
+                request = rpc_interface_request_find(requests[i].process, RPC_IF_REQUEST_QUEUED);
+                rpc_interface_request_start_queued(request);
+                started = true;
+            }
         }
+    } while (started);
+}
+
+PROCESS_THREAD(rpc_interface_requests, ev, data)
+{
+    PROCESS_BEGIN();
+    while (1) {
+        PROCESS_WAIT_EVENT_UNTIL(ev == PROCESS_EVENT_EXITED || ev == PROCESS_EVENT_POLL);
+        rpc_interface_requests_update();
+    }
+    PROCESS_END();
+}
+
+/* CRC-16/CCITT-FALSE */
+static uint16_t rpc_interface_crc16(const uint8_t* data, size_t length)
+{
+    uint16_t crc = 0xffff;
+    while (length-- > 0) {
+        crc = (crc >> 8) | (crc << 8);
+        crc ^= *data++;
+        crc ^= (crc & 0xff) >> 4;
+        crc ^= crc << 12;
+        crc ^= (crc & 0xff) << 5;
+    }
+    return crc;
+}
+
+static void rpc_interface_frame_received(void)
+{
+    uint8_t* body = &frame_buffer[4];
+    uint8_t* end = &frame_buffer[2 + frame_length];
+    uint8_t* command_end = memchr(body, '\0', end - body);
+    uint16_t crc = end[0] | end[1] << 8;
+    bool saved_frame_request = frame_request;
+    uint16_t saved_frame_request_id = frame_request_id;
+    const uint8_t* saved_frame_values = frame_values;
+    const uint8_t* saved_frame_values_end = frame_values_end;
+
+    frame_request = true;
+    frame_request_id = frame_buffer[2] | frame_buffer[3] << 8;
+    frame_values = NULL;
+    frame_values_end = NULL;
+
+    if (crc != rpc_interface_crc16(frame_buffer, 2 + frame_length)) {
+        rpc_interface_send_response(false, "bad crc");
+    } else if (command_end == NULL) {
+        rpc_interface_send_response(false, "missing command");
     } else {
-        if (linepos < sizeof(linebuf) - 1) {
-            linebuf[linepos++] = byte;
+        frame_values = command_end + 1;
+        frame_values_end = end;
+        prefix_buffer[0] = '\0';
+        prefix_buffer_length = 0;
+        rpc_interface_handler((char*)body, rpc_interface_handler_storage);
+    }
+
+    /* Output after the request is not a response to it */
+    frame_request = saved_frame_request;
+    frame_request_id = saved_frame_request_id;
+    frame_values = saved_frame_values;
+    frame_values_end = saved_frame_values_end;
+}
+
+static size_t rpc_interface_line_input(const char* data, size_t length);
+
+static void rpc_interface_frame_input(uint8_t byte)
+{
+    if (frame_position == 1 && byte != RPC_IF_FRAME_MAGIC_1) {
+        /* Not a frame after all, the byte starts a command line instead */
+        frame_position = 0;
+        rpc_interface_line_input((const char*)&byte, 1);
+        return;
+    }
+    if (frame_position >= 2) {
+        frame_buffer[frame_position - 2] = byte;
+    }
+    frame_position++;
+
+    if (frame_position == 4) {
+        frame_length = frame_buffer[0] | frame_buffer[1] << 8;
+        /* At least a request id and an empty command */
+        if (frame_length < 3 || frame_length > RPC_IF_FRAME_SIZE) {
+            frame_position = 0;
         }
+    } else if (frame_position == 2 + 2 + frame_length + 2) {
+        frame_position = 0;
+        rpc_interface_frame_received();
     }
 }
 
+bool rpc_interface_frame_active(void)
+{
+    return frame_position > 0;
+}
+
+/*
+ * Bytes of a frame, up to the end of the frame. The bytes after the header
+ * are copied at once.
+ */
+static size_t rpc_interface_frame_input_bulk(const uint8_t* data, size_t length)
+{
+    size_t pos = 0;
+
+    while (pos < length && frame_position > 0 && frame_position < 4) {
+        rpc_interface_frame_input(data[pos++]);
+    }
+    if (pos < length && frame_position >= 4) {
+        /* All but the last byte of the frame, which is handled by itself */
+        size_t left = 2 + 2 + frame_length + 2 - frame_position;
+        size_t size = length - pos < left - 1 ? length - pos : left - 1;
+
+        memcpy(&frame_buffer[frame_position - 2], &data[pos], size);
+        frame_position += size;
+        pos += size;
+        if (pos < length) {
+            rpc_interface_frame_input(data[pos++]);
+        }
+    }
+    return pos;
+}
+
+/* Bytes of command lines, up to the start of a frame */
+static size_t rpc_interface_line_input(const char* data, size_t length)
+{
+    size_t pos;
+
+    for (pos = 0; pos < length; pos++) {
+        char byte = data[pos];
+
+        if (linepos == 0 && (uint8_t)byte == RPC_IF_FRAME_MAGIC_0) {
+            rpc_interface_frame_input(byte);
+            return pos + 1;
+        }
+
+        /* Got a line */
+        if (byte == '\n' || byte == '\r') {
+            if (linepos > 0) {
+                linebuf[linepos++] = 0;
+                linepos = 0;
+                frame_request = false;
+                prefix_buffer[0] = '\0'; /* So command handlers can have nice help output */
+                prefix_buffer_length = 0;
+                rpc_interface_handler(linebuf, rpc_interface_handler_storage);
+            }
+        } else {
+            if (linepos < sizeof(linebuf) - 1) {
+                linebuf[linepos++] = byte;
+            }
+        }
+    }
+    return length;
+}
+
+size_t rpc_interface_input(const char* data, size_t length)
+{
+    if (frame_position > 0) {
+        return rpc_interface_frame_input_bulk((const uint8_t*)data, length);
+    }
+    return rpc_interface_line_input(data, length);
+}
+
+void rpc_interface_input_byte(char byte)
+{
+    rpc_interface_input(&byte, 1);
+}
+
 static void rpc_interface_send_response_int(int fd, bool success, const char* fmt, va_list ap)
 {
-    if (success) {
-        dprintf(fd, "success");
+    const char* status = success ? "success" : "error";
+
+    if (fmt == NULL) {
+        dprintf(fd, "%s\n", status);
     } else {
-        dprintf(fd, "error");
+        dprintf(fd, "%s: ", status);
+        vdprintf(fd, fmt, ap);
+        dprintf(fd, "\n");
     }
+}
 
-    if (fmt != NULL) {
-        dprintf(fd, ": ");
-        vdprintf(fd, fmt, ap);
+/*
+ * Whether a response is to be sent in a frame, and with which request ID:
+ * those of the request of the running process command sending it, or else
+ * those of the request being handled.
+ */
+static bool rpc_interface_response_tag(uint16_t* id)
+{
+    const rpc_interface_request_t* request =
+      rpc_interface_request_find(PROCESS_CURRENT(), RPC_IF_REQUEST_RUNNING);
+
+    if (request != NULL) {
+        /* The process may exit next, let the next request start */
+        process_poll(&rpc_interface_requests);
+        *id = request->id;
+        return request->frame;
+    }
+    *id = frame_request_id;
+    return frame_request;
+}
+
+static void rpc_interface_response_begin(bool success, uint16_t id)
+{
+    response_buffer[0] = RPC_IF_FRAME_MAGIC_0;
+    response_buffer[1] = RPC_IF_FRAME_MAGIC_1;
+    response_buffer[4] = id;
+    response_buffer[5] = id >> 8;
+    response_buffer[6] = success ? RPC_IF_FRAME_STATUS_SUCCESS : RPC_IF_FRAME_STATUS_ERROR;
+    response_length = 7;
+    response_overflow = false;
+}
+
+/* Room for size more bytes in the response, or NULL if it doesn't fit */
+static uint8_t* rpc_interface_response_reserve(size_t size)
+{
+    uint8_t* pos = &response_buffer[response_length];
+    if (response_overflow || response_length + size > 4 + RPC_IF_FRAME_SIZE) {
+        response_overflow = true;
+        return NULL;
+    }
+    response_length += size;
+    return pos;
+}
+
+static void rpc_interface_response_put_u32(uint8_t type, uint32_t value)
+{
+    uint8_t* pos = rpc_interface_response_reserve(5);
+    if (pos != NULL) {
+        pos[0] = type;
+        pos[1] = value;
+        pos[2] = value >> 8;
+        pos[3] = value >> 16;
+        pos[4] = value >> 24;
     }
-    dprintf(fd, "\n");
+}
+
+static void rpc_interface_response_put_bytes(uint8_t type, const void* data, size_t size)
+{
+    uint8_t* pos = rpc_interface_response_reserve(1 + size);
+    if (pos != NULL) {
+        pos[0] = type;
+        memcpy(&pos[1], data, size);
+    }
+}
+
+static void rpc_interface_response_send(void)
+{
+    uint16_t crc;
+    uint16_t length;
+
+    if (response_overflow) {
+        static const char message[] = "response too large";
+        rpc_interface_response_begin(false, response_buffer[4] | response_buffer[5] << 8);
+        rpc_interface_response_put_bytes('s', message, sizeof(message));
+    }
+
+    length = response_length - 4;
+    response_buffer[2] = length;
+    response_buffer[3] = length >> 8;
+    crc = rpc_interface_crc16(&response_buffer[2], response_length - 2);
+    response_buffer[response_length++] = crc;
+    response_buffer[response_length++] = crc >> 8;
+
+    write(rpc_interface_reporting_fd, response_buffer, response_length);
 }
 
 void rpc_interface_send_response(bool success, const char* fmt, ...)
 {
+    uint16_t id;
     va_list ap;
 
     va_start(ap, fmt);
-    rpc_interface_send_response_int(rpc_interface_reporting_fd, success, fmt, ap);
+    if (rpc_interface_response_tag(&id)) {
+        rpc_interface_response_begin(success, id);
+        if (fmt != NULL) {
+            size_t space = 4 + RPC_IF_FRAME_SIZE - response_length - 1;
+            uint8_t* pos = rpc_interface_response_reserve(1);
+            *pos = 's';
+            /* Truncated to what fits */
+            vsnprintf((char*)&pos[1], space, fmt, ap);
+            response_length += strlen((char*)&pos[1]) + 1;
+        }
+        rpc_interface_response_send();
+    } else {
+        rpc_interface_send_response_int(rpc_interface_reporting_fd, success, fmt, ap);
+    }
     va_end(ap);
 }
 
+void rpc_interface_send_result(const char* fmt, ...)
+{
+    int fd = rpc_interface_reporting_fd;
+    uint16_t id;
+    bool frame = rpc_interface_response_tag(&id);
+    va_list ap;
+
+    va_start(ap, fmt);
+    if (frame) {
+        rpc_interface_response_begin(true, id);
+    } else {
+        dprintf(fd, "success:");
+    }
+
+    for (; *fmt != '\0'; fmt++) {
+        if (*fmt == 'i') {
+            int value = va_arg(ap, int);
+            if (frame) {
+                rpc_interface_response_put_u32('i', value);
+            } else {
+                dprintf(fd, " %d", value);
+            }
+        } else if (*fmt == 'x') {
+            uint32_t value = va_arg(ap, uint32_t);
+            if (frame) {
+                rpc_interface_response_put_u32('x', value);
+            } else {
+                dprintf(fd, " %lx", (unsigned long)value);
+            }
+        } else if (*fmt == 's') {
+            const char* value = va_arg(ap, const char*);
+            if (frame) {
+                rpc_interface_response_put_bytes('s', value, strlen(value) + 1);
+            } else {
+                dprintf(fd, " %s", value);
+            }
+        } else if (*fmt == 'b') {
+            const uint8_t* value = va_arg(ap, const uint8_t*);
+            int size = va_arg(ap, int);
+            if (frame) {
+                uint8_t* pos = rpc_interface_response_reserve(3 + size);
+                if (pos != NULL) {
+                    pos[0] = 'b';
+                    pos[1] = size;
+                    pos[2] = size >> 8;
+                    memcpy(&pos[3], value, size);
+                }
+            } else {
+                static const char digits[] = "0123456789abcdef";
+                char hex[64 + 1];
+                int i;
+                int pos = 0;
+                dprintf(fd, " ");
+                for (i = 0; i < size; i++) {
+                    hex[pos++] = digits[value[i] >> 4];
+                    hex[pos++] = digits[value[i] & 0xf];
+                    if (pos == sizeof(hex) - 1 || i == size - 1) {
+                        hex[pos] = '\0';
+                        dprintf(fd, "%s", hex);
+                        pos = 0;
+                    }
+                }
+            }
+        }
+    }
+
+    if (frame) {
+        rpc_interface_response_send();
+    } else {
+        dprintf(fd, "\n");
+    }
+    va_end(ap);
+}
+
+/*
+ * Size of the value at pos, including the type, or 0 if it is not a valid
+ * value within the frame
+ */
+static size_t rpc_interface_frame_value_size(const uint8_t* pos)
+{
+    size_t left = frame_values_end - pos;
+    const uint8_t* nul;
+
+    switch (pos[0]) {
+        case 'i':
+        case 'x':
+        case 'f':
+            return left >= 5 ? 5 : 0;
+        case 's':
+            nul = memchr(&pos[1], '\0', left - 1);
+            return nul != NULL ? nul - pos + 1 : 0;
+        case 'b':
+            if (left < 3 || left - 3 < (size_t)(pos[1] | pos[2] << 8)) {
+                return 0;
+            }
+            return 3 + (pos[1] | pos[2] << 8);
+        default:
+            return 0;
+    }
+}
+
+static uint32_t rpc_interface_frame_u32(const uint8_t* pos)
+{
+    return (uint32_t)pos[0] | (uint32_t)pos[1] << 8 | (uint32_t)pos[2] << 16
+           | (uint32_t)pos[3] << 24;
+}
+
+/* rpc_interface_get_args() for the values of a frame */
+static int rpc_interface_get_frame_args(const char* fmt, va_list ap)
+{
+    const uint8_t* pos = frame_values;
+    const char* curfmt;
+    int is_optional = 0;
+
+    for (curfmt = fmt; *curfmt != '\0'; curfmt++) {
+        size_t size;
+        uint8_t type;
+
+        if (*curfmt == ':') {
+            is_optional = 1;
+            continue;
+        }
+        if (pos >= frame_values_end) {
+            /* No more values, success if no more are expected */
+            return is_optional || *curfmt == '+' ? 0 : -3;
+        }
+
+        size = rpc_interface_frame_value_size(pos);
+        if (size == 0) {
+            return -4;
+        }
+        type = pos[0];
+
+        if (*curfmt == '.') {
+            /* Ignore value */
+        } else if ((*curfmt == 's' || *curfmt == '+') && type == 's') {
+            *va_arg(ap, const char**) = (const char*)&pos[1];
+        } else if (*curfmt == 'i' && (type == 'i' || type == 'x')) {
+            *va_arg(ap, int*) = (int32_t)rpc_interface_frame_u32(&pos[1]);
+        } else if (*curfmt == 'x' && (type == 'i' || type == 'x')) {
+            *va_arg(ap, uint32_t*) = rpc_interface_frame_u32(&pos[1]);
+        } else if (*curfmt == 'f' && type == 'f') {
+            uint32_t bits = rpc_interface_frame_u32(&pos[1]);
+            memcpy(va_arg(ap, float*), &bits, sizeof(float));
+        } else if (*curfmt == 'f' && type == 'i') {
+            *va_arg(ap, float*) = (int32_t)rpc_interface_frame_u32(&pos[1]);
+        } else if (*curfmt == 'b' && type == 'b') {
+            uint8_t* dst = va_arg(ap, uint8_t*);
+            int* dst_size = va_arg(ap, int*);
+            if (size - 3 > (size_t)*dst_size) {
+                return -4;
+            }
+            memcpy(dst, &pos[3], size - 3);
+            *dst_size = size - 3;
+        } else {
+            /* Wrong type */
+            return -4;
+        }
+        pos += size;
+
+        if (*curfmt == '+') {
+            break;
+        }
+    }
+
+    /* End of arguments, but still values left */
+    return pos < frame_values_end ? -1 : 0;
+}
+
 int rpc_interface_get_args(char* line, const char* fmt, ...)
 {
     int return_value = 0;
@@ -109,6 +874,12 @@ int rpc_interface_get_args(char* line, const char* fmt, ...)
 
     va_start(ap, fmt);
 
+    if (frame_request && frame_values < frame_values_end) {
+        return_value = rpc_interface_get_frame_args(fmt, ap);
+        va_end(ap);
+        return return_value;
+    }
+
     while (true) {
         if (*curfmt == '+') {
             /* The rest is treated as a string, as a whole, so don't split next */
@@ -116,6 +887,13 @@ int rpc_interface_get_args(char* line, const char* fmt, ...)
             break;
         }
 
+        if (*curfmt == ':') {
+            /* Next is optional, start over in loop with next fmt char */
+            is_optional = 1;
+            curfmt++;
+            continue;
+        }
+
         /* Get argument, if available */
         curarg = strsep(&tmpline, " ");
         if (curarg == NULL) {
@@ -131,12 +909,6 @@ int rpc_interface_get_args(char* line, const char* fmt, ...)
             return_value = -1;
             goto error;
         }
-        if (*curfmt == ':') {
-            /* Next is optional, start over in loop with next fmt char */
-            is_optional = 1;
-            curfmt++;
-            continue;
-        }
         /* Valid arguments */
         if (*curfmt == '.') {
             /* Ignore argument*/
@@ -145,9 +917,28 @@ int rpc_interface_get_args(char* line, const char* fmt, ...)
         } else if (*curfmt == 'f') {
             *va_arg(ap, float*) = (float)atof(curarg);
         } else if (*curfmt == 'i') {
-            *va_arg(ap, int*) = atoi(curarg);
+            char* endptr;
+            *va_arg(ap, int*) = strtol(curarg, &endptr, 10);
+            if (*endptr != '\0') {
+                return_value = -4;
+                goto error;
+            }
         } else if (*curfmt == 'x') {
-            *va_arg(ap, uint32_t*) = strtoul(curarg, NULL, 16);
+            char* endptr;
+            *va_arg(ap, uint32_t*) = strtoul(curarg, &endptr, 16);
+            if (*endptr != '\0') {
+                return_value = -4;
+                goto error;
+            }
+        } else if (*curfmt == 'b') {
+            uint8_t* dst = va_arg(ap, uint8_t*);
+            int* dst_size = va_arg(ap, int*);
+            int size = strlen(curarg) / 2;
+            if (size > *dst_size || rpc_interface_dehex(dst, curarg, size) != 0) {
+                return_value = -4;
+                goto error;
+            }
+            *dst_size = size;
         } else {
             return_value = -2;
             goto error;
@@ -216,16 +1007,18 @@ void rpc_interface_command_handler(char* line, const void* storage)
         return;
     }
 
-    for (curcmd = storage; curcmd->command != NULL; curcmd++) {
-        if (strcmp(curcmd->command, cmd) == 0) {
-            /* For help text prefixes */
-            snprintf(&prefix_buffer[strlen(prefix_buffer)],
-                     sizeof(prefix_buffer) - strlen(prefix_buffer),
-                     "%s ",
-                     curcmd->command);
-            curcmd->handler(line, curcmd->storage);
-            return;
+    curcmd = rpc_interface_lookup(storage, cmd);
+    if (curcmd != NULL) {
+        /* For help text prefixes */
+        size_t length = strlen(curcmd->command);
+        if (prefix_buffer_length + length + 1 < sizeof(prefix_buffer)) {
+            memcpy(&prefix_buffer[prefix_buffer_length], curcmd->command, length);
+            prefix_buffer_length += length;
+            prefix_buffer[prefix_buffer_length++] = ' ';
+            prefix_buffer[prefix_buffer_length] = '\0';
         }
+        curcmd->handler(line, curcmd->storage);
+        return;
     }
 
     printf("\nUnknown command '%s'\n\n", cmd);
@@ -237,18 +1030,36 @@ void rpc_interface_process_handler(char* line, const void* storage)
 {
     /* TODO: Make it possible not to cast away const, but still keep command tables in flash */
     struct process* proc = (struct process*)storage;
+    rpc_interface_request_t* request = rpc_interface_request_alloc(proc);
+    size_t line_length = line != NULL ? strlen(line) + 1 : 0;
+    size_t values_length = frame_request ? frame_values_end - frame_values : 0;
 
-    if (process_is_running(proc)) {
-        rpc_interface_send_response(false, "process already running");
+    if (request == NULL) {
+        rpc_interface_send_response(false, "too many requests");
+    } else if (!process_is_running(proc) &&
+               rpc_interface_request_find(proc, RPC_IF_REQUEST_QUEUED) == NULL) {
+        rpc_interface_request_start(request, line);
+    } else if (line_length + values_length > sizeof(request->data)) {
+        rpc_interface_send_response(false, "arguments too large to queue");
     } else {
-        process_start(proc, line);
+        /* Started when the process exits */
+        if (line_length > 0) {
+            memcpy(request->data, line, line_length);
+        }
+        if (values_length > 0) {
+            memcpy(&request->data[line_length], frame_values, values_length);
+        }
+        request->line_length = line_length;
+        request->values_length = values_length;
+        request->sequence = request_sequence++;
+        request->state = RPC_IF_REQUEST_QUEUED;
     }
 }
 
 int rpc_interface_dehex(uint8_t* dst, const char* src, int len)
 {
     int i;
-    if (strlen(src) != len * 2) {
+    if (len < 0 || strlen(src) != (size_t)len * 2) {
         return -1;
     }
 
@@ -30,6 +30,7 @@
 
 #include <stdarg.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 typedef void (*rpc_interface_handler_t)(char* line, const void* storage);
@@ -38,8 +39,74 @@ void rpc_interface_init(rpc_interface_handler_t handler, int report_fd, const vo
 
 void rpc_interface_input_byte(char byte);
 
+/*
+ * Handle a chunk of input, returns the number of bytes handled. It is less
+ * than length only when a frame starts or ends within the chunk, so that the
+ * caller can tell the bytes of frames from the rest with
+ * rpc_interface_frame_active(), and call again with the rest.
+ */
+size_t rpc_interface_input(const char* data, size_t length);
+
 void rpc_interface_send_response(bool success, const char* fmt, ...);
 
+/*
+ * Send a successful response with typed values
+ *
+ * fmt is a list of characters representing the types of the values:
+ *   i - int, sent as a 32 bit signed integer
+ *   x - uint32_t
+ *   s - string (const char *)
+ *   b - bytes, as two arguments: const uint8_t *, int length
+ *
+ * After a command line, the values are printed after "success:", separated
+ * by spaces, with x and b as hex. After a frame, they are sent in a response
+ * frame.
+ */
+void rpc_interface_send_result(const char* fmt, ...);
+
+/*
+ * Binary frames
+ *
+ * Besides command lines, the interface accepts binary frames, which start
+ * with the two magic bytes in place of the first character of a line. A
+ * first magic byte followed by anything else is dropped, and the line starts
+ * with the byte after it. All integers are little endian:
+ *
+ *   magic        2 bytes   0xa5 0x5a
+ *   length       2 bytes   length of request id, body and values
+ *   request id   2 bytes   echoed in the response
+ *   body         request:  command words, NUL terminated, like "config show"
+ *                response: status, 0 for success, 1 for error
+ *   values       typed values, a type character followed by the value:
+ *                  'i' 4 byte signed integer
+ *                  'x' 4 byte unsigned integer
+ *                  'f' 4 byte float
+ *                  's' string, NUL terminated
+ *                  'b' 2 byte length, followed by that many bytes
+ *   crc          2 bytes   CRC-16/CCITT-FALSE of length to values
+ *
+ * The values of a request are the arguments of the command, returned by
+ * rpc_interface_get_args(). The response has the message of
+ * rpc_interface_send_response() as a string value, or the values of
+ * rpc_interface_send_result(). Any other output, like help texts, is sent as
+ * text between frames.
+ *
+ * Frames have no hex encoding or parsing of numbers, and can carry up to
+ * RPC_IF_FRAME_SIZE bytes from the request id to the last value.
+ */
+#define RPC_IF_FRAME_MAGIC_0 0xa5
+#define RPC_IF_FRAME_MAGIC_1 0x5a
+
+#ifndef RPC_IF_FRAME_SIZE
+#define RPC_IF_FRAME_SIZE 512
+#endif
+
+/*
+ * True while in the middle of receiving a frame, when the input bytes are
+ * frame data, and not to be interpreted as anything else
+ */
+bool rpc_interface_frame_active(void);
+
 /*
  * Command argument processing
  */
@@ -53,12 +120,18 @@ void rpc_interface_send_response(bool success, const char* fmt, ...);
  *   f - double
  *   i - int
  *   s - string (char *)
+ *   x - uint32_t, as hex in a command line
+ *   b - bytes, as two arguments: uint8_t *, int * with the size of the buffer,
+ *       set to the number of bytes. As hex in a command line
  *   . - skip argument (useful to skip command name as first argument)
  *   : - following arguments in fmt are optional, and set only if available
  *   + - as last argument, return rest of line as string
  *
  * arguments following fmt are pointers to variables to store the value within.
  *
+ * For a frame with values, the arguments are taken from its values instead
+ * of the line.
+ *
  * returns enum value from command_status.
  *
  * Example:
@@ -125,6 +198,11 @@ typedef struct
 
 void rpc_interface_command_handler(char* line, const void* storage);
 
+/*
+ * Start the process in storage, with the line as data. If it is running
+ * already, the request is queued until it exits. Responses sent by the
+ * process are for the request it was started for.
+ */
 void rpc_interface_process_handler(char* line, const void* storage);
 
 /**
@@ -0,0 +1,228 @@
+#!/usr/bin/env python3
+
+# Host side of the binary frames of the network extender RPC interface,
+# described in rpc-interface.h
+#
+#
+# MIT License
+#
+# Copyright (c) 2023 LumenRadio AB
+#
+# SPDX-License-Identifier: MIT
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+#
+#
+
+import binascii
+import os
+import select
+import struct
+import time
+
+MAGIC = b"\xa5\x5a"
+FRAME_SIZE = 512
+
+STATUS_SUCCESS = 0
+
+
+class RpcError(Exception):
+    pass
+
+
+def crc16(data):
+    """CRC-16/CCITT-FALSE"""
+    return binascii.crc_hqx(data, 0xFFFF)
+
+
+def encode_value(value):
+    if isinstance(value, bool) or not isinstance(value, (int, float, str, bytes, bytearray)):
+        raise TypeError("Unsupported value: " + repr(value))
+    if isinstance(value, int):
+        if -(2**31) <= value < 2**31:
+            return b"i" + struct.pack("<i", value)
+        return b"x" + struct.pack("<I", value)
+    if isinstance(value, float):
+        return b"f" + struct.pack("<f", value)
+    if isinstance(value, str):
+        return b"s" + value.encode() + b"\0"
+    return b"b" + struct.pack("<H", len(value)) + bytes(value)
+
+
+def decode_values(data):
+    values = []
+    pos = 0
+    while pos < len(data):
+        kind = data[pos : pos + 1]
+        pos += 1
+        if kind in (b"i", b"x", b"f"):
+            fmt = {b"i": "<i", b"x": "<I", b"f": "<f"}[kind]
+            values.append(struct.unpack_from(fmt, data, pos)[0])
+            pos += 4
+        elif kind == b"s":
+            end = data.index(b"\0", pos)
+            values.append(data[pos:end].decode(errors="replace"))
+            pos = end + 1
+        elif kind == b"b":
+            (size,) = struct.unpack_from("<H", data, pos)
+            values.append(bytes(data[pos + 2 : pos + 2 + size]))
+            pos += 2 + size
+        else:
+            raise ValueError("Unknown value type: " + repr(kind))
+    return values
+
+
+def encode_request(request_id, command, *args):
+    body = struct.pack("<H", request_id & 0xFFFF) + command.encode() + b"\0"
+    body += b"".join(encode_value(arg) for arg in args)
+    if len(body) > FRAME_SIZE:
+        raise ValueError("Request too large")
+    frame = struct.pack("<H", len(body)) + body
+    return MAGIC + frame + struct.pack("<H", crc16(frame))
+
+
+class Response:
+    def __init__(self, request_id, success, values):
+        self.request_id = request_id
+        self.success = success
+        self.values = values
+
+    def __repr__(self):
+        return "Response(%d, %s, %r)" % (self.request_id, self.success, self.values)
+
+
+class FrameDecoder:
+    """Splits the output of the extender into response frames and text.
+
+    feed() returns a list of Response objects and bytes objects of text, in
+    the order they were received.
+    """
+
+    def __init__(self):
+        self.buffer = bytearray()
+
+    def feed(self, data):
+        self.buffer += data
+        events = []
+        while self.buffer:
+            start = self.buffer.find(MAGIC)
+            if start < 0:
+                # Keep a last byte that may be the start of the magic
+                keep = 1 if self.buffer[-1:] == MAGIC[:1] else 0
+                start = len(self.buffer) - keep
+            if start > 0:
+                events.append(bytes(self.buffer[:start]))
+                del self.buffer[:start]
+                continue
+            if len(self.buffer) < 4:
+                break
+            (length,) = struct.unpack_from("<H", self.buffer, 2)
+            if length < 3 or length > FRAME_SIZE:
+                events.append(bytes(self.buffer[:1]))
+                del self.buffer[:1]
+                continue
+            if len(self.buffer) < 4 + length + 2:
+                break
+            frame = bytes(self.buffer[2 : 4 + length])
+            (crc,) = struct.unpack_from("<H", self.buffer, 4 + length)
+            if crc != crc16(frame):
+                # Not a frame after all, but text with the magic in it
+                events.append(bytes(self.buffer[:1]))
+                del self.buffer[:1]
+                continue
+            del self.buffer[: 4 + length + 2]
+            request_id, status = struct.unpack_from("<HB", frame, 2)
+            events.append(
+                Response(request_id, status == STATUS_SUCCESS, decode_values(frame[5:]))
+            )
+        return events
+
+
+class RpcClient:
+    """Sends requests in frames on a file descriptor, like an open serial port
+    or pty, and waits for the responses.
+
+    Several requests can be outstanding at once, the responses are matched to
+    them by request ID, in whatever order they come. Text output from the
+    extender is collected in the text attribute.
+    """
+
+    def __init__(self, fd, timeout=3.0):
+        self.fd = fd
+        self.timeout = timeout
+        self.decoder = FrameDecoder()
+        self.next_id = 0
+        self.completed = {}
+        self.text = bytearray()
+
+    def _read(self, deadline):
+        left = deadline - time.monotonic()
+        if left <= 0 or not select.select([self.fd], [], [], left)[0]:
+            raise RpcError("Timeout while waiting for device")
+        for event in self.decoder.feed(os.read(self.fd, 4096)):
+            if isinstance(event, Response):
+                self.completed[event.request_id] = event
+            else:
+                self.text += event
+
+    def send(self, command, *args):
+        """Send a request without waiting, and return its request ID"""
+        request_id = self.next_id
+        self.next_id = (self.next_id + 1) & 0xFFFF
+        os.write(self.fd, encode_request(request_id, command, *args))
+        return request_id
+
+    def _wait_for(self, request_id):
+        deadline = time.monotonic() + self.timeout
+        while request_id not in self.completed:
+            self._read(deadline)
+
+    def wait(self, request_id):
+        """Wait for the Response to a request sent with send()"""
+        self._wait_for(request_id)
+        return self.completed.pop(request_id)
+
+    def request(self, command, *args):
+        """Send a request, and return its Response"""
+        return self.wait(self.send(command, *args))
+
+    def call(self, command, *args):
+        """Send a request, and return its values, or raise RpcError on error"""
+        return check(self.request(command, *args))
+
+    def pipeline(self, requests, window=4):
+        """Send (command, args) requests, with up to window of them
+        outstanding, and return their Responses in the same order.
+
+        Commands run as processes on the extender are queued there, up to
+        RPC_IF_MAX_REQUESTS (default 4) requests in total.
+        """
+        request_ids = []
+        for command, args in requests:
+            if len(request_ids) >= window:
+                self._wait_for(request_ids[-window])
+            request_ids.append(self.send(command, *args))
+        return [self.wait(request_id) for request_id in request_ids]
+
+
+def check(response):
+    """Values of a Response, or raise RpcError if it is an error"""
+    if not response.success:
+        raise RpcError(response.values[0] if response.values else "error")
+    return response.values
@@ -0,0 +1,177 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 LumenRadio AB
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+#include "serial_input.h"
+
+#include <mira.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "process_profiler.h"
+#include "reboot.h"
+#include "rpc-interface.h"
+
+#if (SERIAL_INPUT_BUFFER_SIZE & (SERIAL_INPUT_BUFFER_SIZE - 1)) != 0 || \
+  SERIAL_INPUT_BUFFER_SIZE > 32768
+#error "SERIAL_INPUT_BUFFER_SIZE must be a power of two, at most 32768"
+#endif
+
+#define BUFFER_MASK (SERIAL_INPUT_BUFFER_SIZE - 1)
+
+/*
+ * The indexes are free running, head only written by the producer, tail
+ * only by the consumer. The barriers keep the bytes written before the head
+ * is moved past them, and read before the tail is.
+ */
+typedef struct
+{
+    uint8_t buffer[SERIAL_INPUT_BUFFER_SIZE];
+    volatile uint16_t head;
+    volatile uint16_t tail;
+    /* Written by the producer only */
+    volatile uint32_t received;
+    volatile uint32_t overruns;
+} serial_input_ring_t;
+
+static serial_input_ring_t rings[SERIAL_INPUT_N_PORTS];
+
+PROFILED_PROCESS(serial_input_proc, "Serial input");
+
+void serial_input_init(void)
+{
+    memset(rings, 0, sizeof(rings));
+    process_start(&serial_input_proc, NULL);
+}
+
+size_t serial_input_push(serial_input_port_t port, const uint8_t* data, size_t length)
+{
+    serial_input_ring_t* ring = &rings[port];
+    uint16_t head = ring->head;
+    size_t room = serial_input_space(port);
+    size_t pushed = length < room ? length : room;
+    size_t first = SERIAL_INPUT_BUFFER_SIZE - (head & BUFFER_MASK);
+
+    if (first > pushed) {
+        first = pushed;
+    }
+    memcpy(&ring->buffer[head & BUFFER_MASK], data, first);
+    memcpy(ring->buffer, &data[first], pushed - first);
+    __sync_synchronize();
+    ring->head = head + pushed;
+
+    ring->received += pushed;
+    ring->overruns += length - pushed;
+    if (pushed > 0) {
+        process_poll(&serial_input_proc);
+    }
+    return pushed;
+}
+
+size_t serial_input_space(serial_input_port_t port)
+{
+    return SERIAL_INPUT_BUFFER_SIZE - (uint16_t)(rings[port].head - rings[port].tail);
+}
+
+int serial_input_uart_callback(unsigned char c, void* storage)
+{
+    (void)storage;
+    serial_input_push(SERIAL_INPUT_UART, &c, 1);
+    return 0;
+}
+
+int serial_input_usb_callback(unsigned char c, void* storage)
+{
+    (void)storage;
+    serial_input_push(SERIAL_INPUT_USB, &c, 1);
+    return 0;
+}
+
+void serial_input_get_stats(serial_input_port_t port, serial_input_stats_t* stats)
+{
+    stats->received = rings[port].received;
+    stats->overruns = rings[port].overruns;
+}
+
+/* Reboot parser for the bytes outside of frames, the RPC interface for all */
+static void serial_input_handle(const uint8_t* data, size_t length)
+{
+    while (length > 0) {
+        bool in_frame = rpc_interface_frame_active();
+        size_t handled = rpc_interface_input((const char*)data, length);
+        size_t i;
+
+        /* Binary frames can hold any bytes, also the reboot sequence */
+        if (!in_frame) {
+            for (i = 0; i < handled; i++) {
+                reboot_parser_input(data[i]);
+            }
+        }
+        data += handled;
+        length -= handled;
+    }
+}
+
+/* Handle the contiguous bytes at the tail of a ring */
+static void serial_input_drain(serial_input_ring_t* ring)
+{
+    uint16_t tail = ring->tail;
+    uint16_t available = ring->head - tail;
+    size_t first = SERIAL_INPUT_BUFFER_SIZE - (tail & BUFFER_MASK);
+
+    if (available == 0) {
+        return;
+    }
+    if (first > available) {
+        first = available;
+    }
+    __sync_synchronize();
+    serial_input_handle(&ring->buffer[tail & BUFFER_MASK], first);
+    __sync_synchronize();
+    ring->tail = tail + first;
+}
+
+PROCESS_THREAD(serial_input_proc, ev, data)
+{
+    int port;
+
+    PROCESS_BEGIN();
+
+    while (1) {
+        PROCESS_WAIT_EVENT_UNTIL(ev == PROCESS_EVENT_POLL);
+
+        /* A chunk per port at a time, to let other processes run between */
+        for (port = 0; port < SERIAL_INPUT_N_PORTS; port++) {
+            serial_input_drain(&rings[port]);
+        }
+        for (port = 0; port < SERIAL_INPUT_N_PORTS; port++) {
+            if (rings[port].head != rings[port].tail) {
+                process_poll(&serial_input_proc);
+            }
+        }
+    }
+
+    PROCESS_END();
+}
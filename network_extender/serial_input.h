@@ -0,0 +1,82 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 LumenRadio AB
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+#ifndef SERIAL_INPUT_H
+#define SERIAL_INPUT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Input from the UART and the USB serial port.
+ *
+ * The input callbacks only push the received bytes into a ring buffer per
+ * port, of SERIAL_INPUT_BUFFER_SIZE bytes, and poll the serial input
+ * process. The process hands the bytes to the reboot parser and to
+ * rpc_interface_input(), a chunk at a time, so the command handlers, and
+ * their output, run in the process and not in the input callbacks.
+ *
+ * Each ring has one producer, the input callback of its port, and one
+ * consumer, the process, and needs no locking. Bytes arriving when the ring
+ * is full are dropped and counted as overruns.
+ */
+
+/* Bytes per port, a power of two */
+#ifndef SERIAL_INPUT_BUFFER_SIZE
+#define SERIAL_INPUT_BUFFER_SIZE 1024
+#endif
+
+typedef enum {
+    SERIAL_INPUT_UART,
+    SERIAL_INPUT_USB,
+    SERIAL_INPUT_N_PORTS
+} serial_input_port_t;
+
+typedef struct
+{
+    uint32_t received;
+    uint32_t overruns;
+} serial_input_stats_t;
+
+void serial_input_init(void);
+
+/* Input callbacks, for mira_uart_set_input_callback() and
+ * mira_usb_uart_set_input_callback() */
+int serial_input_uart_callback(unsigned char c, void* storage);
+int serial_input_usb_callback(unsigned char c, void* storage);
+
+/*
+ * Push a chunk of received bytes from a port, from its producer side only.
+ * Returns the number of bytes pushed, the rest are counted as overruns.
+ */
+size_t serial_input_push(serial_input_port_t port, const uint8_t* data, size_t length);
+
+/* Free space in the ring of a port, for the producer side */
+size_t serial_input_space(serial_input_port_t port);
+
+void serial_input_get_stats(serial_input_port_t port, serial_input_stats_t* stats);
+
+#endif
@@ -0,0 +1,349 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 LumenRadio AB
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+/*
+ * Host benchmark of the compact sensor message encoding, see compact.h in
+ * the network_sender example, against printf style text and CBOR. Prints
+ * the encoded size and the encode and decode cost of each, for a message
+ * with all fields of the environment schema, and one with two fields.
+ *
+ * The CBOR baseline is a map from field number to value, with integers as
+ * CBOR integers and fixed point values as 32 bit floats, as a generic CBOR
+ * library would encode the same data.
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "compact.h"
+#include "compact_decode.h"
+#include "sensor_schema.h"
+
+#define ROUNDS 1000000
+
+static const compact_field_t environment_fields[] = { SENSOR_ENVIRONMENT_FIELDS(COMPACT_FIELD) };
+
+static const compact_schema_t schemas[] = {
+    { SENSOR_SCHEMA_ENVIRONMENT, "environment", environment_fields, SENSOR_ENVIRONMENT_N_FIELDS },
+};
+
+typedef struct
+{
+    const char* name;
+    uint32_t fields;
+    double values[SENSOR_ENVIRONMENT_N_FIELDS];
+} sample_t;
+
+static const sample_t samples[] = {
+    { "full", 0x7f, { 259200, 21.53, 45.2, 1013.2, 2987, -67, 1234 } },
+    { "sparse",
+      (1 << SENSOR_ENVIRONMENT_TEMPERATURE) | (1 << SENSOR_ENVIRONMENT_COUNTER),
+      { 0, 21.53, 0, 0, 0, 0, 1234 } },
+};
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/*
+ * Compact
+ */
+
+static int compact_encode_sample(const sample_t* sample, uint8_t* buf, int size)
+{
+    compact_writer_t writer;
+
+    compact_begin(&writer, buf, size, SENSOR_SCHEMA_ENVIRONMENT, sample->fields);
+    for (int field = 0; field < SENSOR_ENVIRONMENT_N_FIELDS; ++field) {
+        if ((sample->fields & (1 << field)) == 0) {
+            continue;
+        }
+        switch (environment_fields[field].type) {
+            case COMPACT_UINT:
+                compact_uint(&writer, sample->values[field]);
+                break;
+            case COMPACT_SINT:
+                compact_sint(&writer, sample->values[field]);
+                break;
+            default:
+                compact_fixed(&writer, sample->values[field], environment_fields[field].decimals);
+                break;
+        }
+    }
+    return compact_end(&writer);
+}
+
+static bool compact_decode_sample(const uint8_t* buf, int len, double* values)
+{
+    compact_message_t message;
+
+    if (!compact_decode(schemas, 1, buf, len, &message)) {
+        return false;
+    }
+    for (int field = 0; field < SENSOR_ENVIRONMENT_N_FIELDS; ++field) {
+        if (message.fields & (1 << field)) {
+            values[field] = compact_value(&message, field);
+        }
+    }
+    return true;
+}
+
+/*
+ * Text, as "name=value name=value"
+ */
+
+static int text_encode_sample(const sample_t* sample, uint8_t* buf, int size)
+{
+    char* out = (char*)buf;
+    int len = 0;
+
+    for (int field = 0; field < SENSOR_ENVIRONMENT_N_FIELDS; ++field) {
+        if ((sample->fields & (1 << field)) == 0) {
+            continue;
+        }
+        const compact_field_t* desc = &environment_fields[field];
+        len += snprintf(out + len,
+                        size - len,
+                        "%s%s=%.*f",
+                        len > 0 ? " " : "",
+                        desc->name,
+                        desc->type == COMPACT_FIXED ? desc->decimals : 0,
+                        sample->values[field]);
+    }
+    return len < size ? len : -1;
+}
+
+static bool text_decode_sample(const uint8_t* buf, int len, double* values)
+{
+    char text[256];
+    char* pos = text;
+
+    memcpy(text, buf, len);
+    text[len] = '\0';
+    while (*pos != '\0') {
+        char* eq = strchr(pos, '=');
+        if (eq == NULL) {
+            return false;
+        }
+        int field = 0;
+        while (field < SENSOR_ENVIRONMENT_N_FIELDS &&
+               (strncmp(environment_fields[field].name, pos, eq - pos) != 0 ||
+                environment_fields[field].name[eq - pos] != '\0')) {
+            field++;
+        }
+        if (field == SENSOR_ENVIRONMENT_N_FIELDS) {
+            return false;
+        }
+        values[field] = strtod(eq + 1, &pos);
+        while (*pos == ' ') {
+            pos++;
+        }
+    }
+    return true;
+}
+
+/*
+ * CBOR
+ */
+
+static int cbor_head(uint8_t* buf, uint8_t major, uint32_t value)
+{
+    if (value < 24) {
+        buf[0] = major << 5 | value;
+        return 1;
+    } else if (value < 0x100) {
+        buf[0] = major << 5 | 24;
+        buf[1] = value;
+        return 2;
+    } else if (value < 0x10000) {
+        buf[0] = major << 5 | 25;
+        buf[1] = value >> 8;
+        buf[2] = value;
+        return 3;
+    }
+    buf[0] = major << 5 | 26;
+    buf[1] = value >> 24;
+    buf[2] = value >> 16;
+    buf[3] = value >> 8;
+    buf[4] = value;
+    return 5;
+}
+
+static int cbor_encode_sample(const sample_t* sample, uint8_t* buf, int size)
+{
+    int n_fields = __builtin_popcount(sample->fields);
+    int len = 0;
+
+    if (size < 1 + n_fields * 10) {
+        return -1;
+    }
+    len += cbor_head(buf + len, 5, n_fields);
+    for (int field = 0; field < SENSOR_ENVIRONMENT_N_FIELDS; ++field) {
+        if ((sample->fields & (1 << field)) == 0) {
+            continue;
+        }
+        double value = sample->values[field];
+        len += cbor_head(buf + len, 0, field);
+        if (environment_fields[field].type == COMPACT_FIXED) {
+            float f = value;
+            uint32_t bits;
+            memcpy(&bits, &f, sizeof(bits));
+            buf[len++] = 0xfa;
+            buf[len++] = bits >> 24;
+            buf[len++] = bits >> 16;
+            buf[len++] = bits >> 8;
+            buf[len++] = bits;
+        } else if (value >= 0) {
+            len += cbor_head(buf + len, 0, value);
+        } else {
+            len += cbor_head(buf + len, 1, -1 - value);
+        }
+    }
+    return len;
+}
+
+static bool cbor_read_head(const uint8_t* buf, int len, int* pos, uint8_t* major, uint32_t* value)
+{
+    if (*pos >= len) {
+        return false;
+    }
+    uint8_t info = buf[*pos] & 0x1f;
+    int size = info < 24 ? 0 : info == 24 ? 1 : info == 25 ? 2 : info == 26 ? 4 : -1;
+
+    *major = buf[(*pos)++] >> 5;
+    if (size < 0 || *pos + size > len) {
+        return false;
+    }
+    *value = size == 0 ? info : 0;
+    for (int i = 0; i < size; ++i) {
+        *value = *value << 8 | buf[(*pos)++];
+    }
+    return true;
+}
+
+static bool cbor_decode_sample(const uint8_t* buf, int len, double* values)
+{
+    int pos = 0;
+    uint8_t major;
+    uint32_t n_fields;
+
+    if (!cbor_read_head(buf, len, &pos, &major, &n_fields) || major != 5) {
+        return false;
+    }
+    for (uint32_t i = 0; i < n_fields; ++i) {
+        uint32_t field;
+        uint32_t value;
+        if (!cbor_read_head(buf, len, &pos, &major, &field) || major != 0 ||
+            field >= SENSOR_ENVIRONMENT_N_FIELDS) {
+            return false;
+        }
+        uint8_t info = pos < len ? buf[pos] : 0;
+        if (!cbor_read_head(buf, len, &pos, &major, &value)) {
+            return false;
+        }
+        if (major == 0) {
+            values[field] = value;
+        } else if (major == 1) {
+            values[field] = -1.0 - value;
+        } else if (major == 7 && info == 0xfa) {
+            float f;
+            memcpy(&f, &value, sizeof(f));
+            values[field] = f;
+        } else {
+            return false;
+        }
+    }
+    return pos == len;
+}
+
+typedef struct
+{
+    const char* name;
+    int (*encode)(const sample_t* sample, uint8_t* buf, int size);
+    bool (*decode)(const uint8_t* buf, int len, double* values);
+} codec_t;
+
+static const codec_t codecs[] = {
+    { "compact", compact_encode_sample, compact_decode_sample },
+    { "text", text_encode_sample, text_decode_sample },
+    { "cbor", cbor_encode_sample, cbor_decode_sample },
+};
+
+int main(void)
+{
+    uint8_t buf[256];
+    double values[SENSOR_ENVIRONMENT_N_FIELDS];
+    volatile int sink = 0;
+
+    for (size_t s = 0; s < sizeof(samples) / sizeof(samples[0]); ++s) {
+        const sample_t* sample = &samples[s];
+        for (size_t c = 0; c < sizeof(codecs) / sizeof(codecs[0]); ++c) {
+            const codec_t* codec = &codecs[c];
+            int len = codec->encode(sample, buf, sizeof(buf));
+
+            memset(values, 0, sizeof(values));
+            if (len < 0 || !codec->decode(buf, len, values)) {
+                fprintf(stderr, "%s: %s failed\n", sample->name, codec->name);
+                return 1;
+            }
+            for (int field = 0; field < SENSOR_ENVIRONMENT_N_FIELDS; ++field) {
+                double diff = values[field] - sample->values[field];
+                if (diff > 0.001 || diff < -0.001) {
+                    fprintf(stderr, "%s: %s field %d differs\n", sample->name, codec->name, field);
+                    return 1;
+                }
+            }
+
+            double start = now_ns();
+            for (int i = 0; i < ROUNDS; ++i) {
+                sink += codec->encode(sample, buf, sizeof(buf));
+            }
+            double encode_ns = (now_ns() - start) / ROUNDS;
+
+            start = now_ns();
+            for (int i = 0; i < ROUNDS; ++i) {
+                sink += codec->decode(buf, len, values);
+            }
+            double decode_ns = (now_ns() - start) / ROUNDS;
+
+            printf("{\"message\": \"%s\", \"codec\": \"%s\", \"bytes\": %d, \"encode_ns\": %.1f, "
+                   "\"decode_ns\": %.1f}\n",
+                   sample->name,
+                   codec->name,
+                   len,
+                   encode_ns,
+                   decode_ns);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,177 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 LumenRadio AB
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+/*
+ * Host benchmark of node_ids.c, built once per number of nodes, see the
+ * Makefile. Prints the cost of inserting all nodes, of looking up known and
+ * unknown nodes, and of a linear search through the addresses, for
+ * comparison.
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* Included, to be able to reset the table between rounds */
+#include "../node_ids.c"
+
+#ifndef BENCH_NODES
+#define BENCH_NODES NODE_IDS_MAX_NODES
+#endif
+
+#define INSERT_ROUNDS 2000
+#define LOOKUPS 2000000
+
+static mira_net_address_t nodes[BENCH_NODES];
+static mira_net_address_t unknown[BENCH_NODES];
+static uint16_t order[65536];
+
+static uint32_t rng_state = 2463534242u;
+
+static uint32_t rng(void)
+{
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/*
+ * Mesh addresses: one prefix, and interface identifiers made from a MAC
+ * address with the same upper bytes, as for nodes from one production batch.
+ */
+static void make_address(mira_net_address_t* addr, uint32_t serial)
+{
+    static const uint8_t prefix[8] = { 0xfd, 0x00, 0x13, 0x24, 0x35, 0x46, 0x00, 0x00 };
+    memcpy(addr->u8, prefix, sizeof(prefix));
+    addr->u8[8] = 0xf6;
+    addr->u8[9] = 0xce;
+    addr->u8[10] = 0x36;
+    addr->u8[11] = 0xff;
+    addr->u8[12] = 0xfe;
+    addr->u8[13] = serial >> 16;
+    addr->u8[14] = serial >> 8;
+    addr->u8[15] = serial;
+}
+
+static void reset_table(void)
+{
+    memset(slots, 0, sizeof(slots));
+    n_ids = 0;
+}
+
+static int linear_lookup(const mira_net_address_t* addr)
+{
+    for (int i = 0; i < n_ids; ++i) {
+        if (memcmp(&addresses[i], addr, sizeof(*addr)) == 0) {
+            return i;
+        }
+    }
+    return NODE_IDS_NONE;
+}
+
+int main(void)
+{
+    volatile long sink = 0;
+    double start;
+
+    /* Serials are spread out, but unique */
+    for (int i = 0; i < BENCH_NODES; ++i) {
+        make_address(&nodes[i], i * 7919 + 1);
+        make_address(&unknown[i], i * 7919 + 2);
+    }
+    for (int i = 0; i < 65536; ++i) {
+        order[i] = rng() % BENCH_NODES;
+    }
+
+    start = now_ns();
+    for (int round = 0; round < INSERT_ROUNDS; ++round) {
+        reset_table();
+        for (int i = 0; i < BENCH_NODES; ++i) {
+            sink += node_ids_intern(&nodes[i]);
+        }
+    }
+    double insert_ns = (now_ns() - start) / ((double)INSERT_ROUNDS * BENCH_NODES);
+
+    for (int i = 0; i < BENCH_NODES; ++i) {
+        if (node_ids_lookup(&nodes[i]) != i || node_ids_lookup(&unknown[i]) != NODE_IDS_NONE) {
+            fprintf(stderr, "lookup of node %d failed\n", i);
+            return 1;
+        }
+    }
+
+    start = now_ns();
+    for (int i = 0; i < LOOKUPS; ++i) {
+        sink += node_ids_intern(&nodes[order[i & 0xffff]]);
+    }
+    double hit_ns = (now_ns() - start) / LOOKUPS;
+
+    start = now_ns();
+    for (int i = 0; i < LOOKUPS; ++i) {
+        sink += node_ids_lookup(&unknown[order[i & 0xffff]]);
+    }
+    double miss_ns = (now_ns() - start) / LOOKUPS;
+
+    start = now_ns();
+    for (int i = 0; i < LOOKUPS / 10; ++i) {
+        sink += linear_lookup(&nodes[order[i & 0xffff]]);
+    }
+    double linear_ns = (now_ns() - start) / (LOOKUPS / 10);
+
+    /* Average number of slots looked at to find a known node */
+    long probes = 0;
+    for (int i = 0; i < BENCH_NODES; ++i) {
+        uint32_t idx = node_ids_hash(&nodes[i]) & TABLE_MASK;
+        while (slots[idx].id_plus_one != i + 1) {
+            idx = (idx + 1) & TABLE_MASK;
+            probes++;
+        }
+        probes++;
+    }
+
+    printf("{\"nodes\": %d, \"slots\": %d, \"insert_ns\": %.1f, \"lookup_hit_ns\": %.1f, "
+           "\"lookup_miss_ns\": %.1f, \"linear_ns\": %.1f, \"avg_probes\": %.2f, "
+           "\"ram_bytes\": %zu}\n",
+           BENCH_NODES,
+           NODE_IDS_TABLE_SIZE,
+           insert_ns,
+           hit_ns,
+           miss_ns,
+           linear_ns,
+           (double)probes / BENCH_NODES,
+           sizeof(slots) + sizeof(addresses));
+    return 0;
+}
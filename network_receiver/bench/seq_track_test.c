@@ -0,0 +1,323 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 LumenRadio AB
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+/*
+ * Host test of seq_track.c, built with and without reordering, see the
+ * Makefile. Feeds sequence numbered packets from a few nodes, and checks
+ * what is delivered, in which order, and the counters. Prints the failed
+ * checks, and exits with an error if any failed.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Included, to reach the held packets and the reorder timeout */
+#include "../node_ids.c"
+#include "../seq_track.c"
+
+#define MAX_DELIVERED 64
+
+struct process* process_current;
+
+static clock_time_t now;
+static int failures;
+
+static uint16_t delivered[MAX_DELIVERED];
+static int n_delivered;
+
+#define CHECK(c)                                                         \
+    do {                                                                 \
+        if (!(c)) {                                                      \
+            printf("%s:%d: %s: failed: %s\n", __FILE__, __LINE__, __func__, #c); \
+            failures++;                                                  \
+        }                                                                \
+    } while (0)
+
+void process_start(struct process* p, process_data_t data)
+{
+    (void)p;
+    (void)data;
+}
+
+int process_post(struct process* p, process_event_t ev, process_data_t data)
+{
+    (void)p;
+    (void)ev;
+    (void)data;
+    return 0;
+}
+
+void process_poll(struct process* p)
+{
+    (void)p;
+}
+
+clock_time_t clock_time(void)
+{
+    return now;
+}
+
+void etimer_set(struct etimer* et, clock_time_t interval)
+{
+    et->start = now;
+    et->interval = interval;
+    et->expired = 0;
+}
+
+void etimer_reset(struct etimer* et)
+{
+    et->start += et->interval;
+    et->expired = 0;
+}
+
+void etimer_stop(struct etimer* et)
+{
+    et->expired = 1;
+}
+
+int etimer_expired(struct etimer* et)
+{
+    return et->expired || (clock_time_t)(now - et->start) >= et->interval;
+}
+
+static void record(const mira_net_address_t* source,
+                   uint16_t source_port,
+                   uint16_t seq,
+                   const uint8_t* payload,
+                   uint16_t len)
+{
+    (void)source;
+    (void)source_port;
+    (void)payload;
+    (void)len;
+    if (n_delivered < MAX_DELIVERED) {
+        delivered[n_delivered] = seq;
+    }
+    n_delivered++;
+}
+
+static void node_address(mira_net_address_t* addr, int node)
+{
+    memset(addr, 0, sizeof(*addr));
+    addr->u8[0] = 0xfd;
+    addr->u8[15] = node;
+}
+
+static void send(int node, uint16_t seq)
+{
+    mira_net_address_t addr;
+    uint8_t packet[SEQ_HEADER_SIZE + 4] = { seq & 0xff, seq >> 8, 1, 2, 3, 4 };
+
+    node_address(&addr, node);
+    seq_track_input(&addr, 1000, packet, sizeof(packet));
+}
+
+static void get_stats(int node, seq_track_stats_t* stats)
+{
+    mira_net_address_t addr;
+
+    node_address(&addr, node);
+    memset(stats, 0, sizeof(*stats));
+    CHECK(seq_track_get_stats(node_ids_lookup(&addr), stats));
+}
+
+/* Check the sequence numbers delivered since the last check */
+static int delivered_are(const uint16_t* expected, int n)
+{
+    int ok = n_delivered == n && memcmp(delivered, expected, n * sizeof(uint16_t)) == 0;
+
+    if (!ok) {
+        printf("  delivered:");
+        for (int i = 0; i < n_delivered && i < MAX_DELIVERED; ++i) {
+            printf(" %04x", delivered[i]);
+        }
+        printf("\n");
+    }
+    n_delivered = 0;
+    return ok;
+}
+
+/* Give up the gaps of the held packets, and forget what was delivered */
+static void flush(void)
+{
+#if SEQ_TRACK_REORDER_MS > 0
+    now += MS_TO_TICKS(SEQ_TRACK_REORDER_MS);
+    reorder_timeout();
+    CHECK(n_held == 0);
+#endif
+    n_delivered = 0;
+}
+
+static void test_wrap(void)
+{
+    static const uint16_t in_order[] = { 0xfffe, 0xffff, 0x0000, 0x0001 };
+    seq_track_stats_t stats;
+
+    for (int i = 0; i < 4; ++i) {
+        send(1, in_order[i]);
+    }
+    CHECK(delivered_are(in_order, 4));
+    get_stats(1, &stats);
+    CHECK(stats.received == 4);
+    CHECK(stats.lost == 0);
+    CHECK(stats.duplicates == 0);
+    CHECK(stats.restarts == 0);
+
+    /* Across the wrap, with a gap that is filled late */
+    send(2, 0xfffe);
+    send(2, 0x0001);
+    send(2, 0xffff);
+    send(2, 0x0000);
+#if SEQ_TRACK_REORDER_MS > 0
+    CHECK(delivered_are(in_order, 4));
+#else
+    static const uint16_t as_received[] = { 0xfffe, 0x0001, 0xffff, 0x0000 };
+    CHECK(delivered_are(as_received, 4));
+#endif
+    get_stats(2, &stats);
+    CHECK(stats.received == 4);
+    CHECK(stats.lost == 0);
+    CHECK(stats.reordered == 2);
+    CHECK(stats.restarts == 0);
+
+    /* A gap across the wrap, 0xffff and 0x0000, is lost when it leaves the window */
+    send(3, 0xfffe);
+    send(3, 0x0001);
+    send(3, (uint16_t)(0xffff + SEQ_TRACK_WINDOW - 1));
+    get_stats(3, &stats);
+    CHECK(stats.lost == 0);
+    send(3, SEQ_TRACK_WINDOW);
+    get_stats(3, &stats);
+    CHECK(stats.lost == 2);
+    flush();
+}
+
+static void test_restart(void)
+{
+    seq_track_stats_t stats;
+
+    /* Far behind restarts at once */
+    for (uint16_t seq = 2000; seq < 2010; ++seq) {
+        send(4, seq);
+    }
+    send(4, 0);
+    send(4, 1);
+    get_stats(4, &stats);
+    CHECK(stats.restarts == 1);
+    CHECK(stats.received == 12);
+    CHECK(stats.duplicates == 0);
+
+    /* Behind the window, but not far, restarts on the third in a row */
+    for (uint16_t seq = 100; seq < 110; ++seq) {
+        send(5, seq);
+    }
+    n_delivered = 0;
+    send(5, 0);
+    send(5, 1);
+    get_stats(5, &stats);
+    CHECK(stats.restarts == 0);
+    CHECK(stats.duplicates == 2);
+    send(5, 2);
+    get_stats(5, &stats);
+    CHECK(stats.restarts == 1);
+    CHECK(stats.received == 11);
+    static const uint16_t after_restart[] = { 2 };
+    CHECK(delivered_are(after_restart, 1));
+}
+
+static void test_duplicates(void)
+{
+    static const uint16_t once[] = { 10, 11, 12 };
+    seq_track_stats_t stats;
+
+    send(6, 10);
+    send(6, 11);
+    send(6, 11);
+    send(6, 10);
+    send(6, 12);
+    send(6, 12);
+    CHECK(delivered_are(once, 3));
+    get_stats(6, &stats);
+    CHECK(stats.received == 3);
+    CHECK(stats.duplicates == 3);
+    CHECK(stats.lost == 0);
+}
+
+#if SEQ_TRACK_REORDER_MS > 0
+static void test_full_pool(void)
+{
+    static const uint16_t released_then_late[] = { 0, 5, 6, 7, 8, 3, 9 };
+    static const uint16_t released_up_to[] = { 0, 2, 3, 4, 5, 6, 7 };
+
+    /*
+     * The oldest held packet is of the same node, and releasing it delivers
+     * past the packet arriving, which is then delivered at once
+     */
+    send(7, 0);
+    for (uint16_t seq = 5; seq < 5 + SEQ_TRACK_REORDER_SLOTS; ++seq) {
+        now++;
+        send(7, seq);
+    }
+    CHECK(n_held == SEQ_TRACK_REORDER_SLOTS);
+    send(7, 3);
+    CHECK(n_held == 0);
+
+    /* The timeout has nothing to give up, and next stays put */
+    now += MS_TO_TICKS(SEQ_TRACK_REORDER_MS) + 1;
+    reorder_timeout();
+    send(7, 5 + SEQ_TRACK_REORDER_SLOTS);
+    CHECK(delivered_are(released_then_late, 7));
+    CHECK(n_held == 0);
+
+    /* Releasing delivers up to the packet arriving, which is next in order */
+    send(8, 0);
+    send(8, 2);
+    send(8, 3);
+    send(8, 5);
+    send(8, 6);
+    CHECK(n_held == SEQ_TRACK_REORDER_SLOTS);
+    send(8, 4);
+    CHECK(n_held == 0);
+    send(8, 7);
+    CHECK(delivered_are(released_up_to, 7));
+}
+#endif
+
+int main(void)
+{
+    seq_track_init(record);
+
+    test_wrap();
+    test_restart();
+    test_duplicates();
+#if SEQ_TRACK_REORDER_MS > 0
+    test_full_pool();
+#endif
+
+    printf("seq_track, reorder %d ms: %s\n", SEQ_TRACK_REORDER_MS, failures ? "FAILED" : "ok");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,142 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 LumenRadio AB
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+#include <stdio.h>
+#include "compact_decode.h"
+
+static const uint32_t powers_of_ten[] = { 1, 10, 100, 1000, 10000, 100000, 1000000 };
+
+/* Returns the position after the MBI, or NULL if truncated or too large */
+static const uint8_t* compact_read_mbi(const uint8_t* pos, const uint8_t* end, uint32_t* value)
+{
+    uint32_t result = 0;
+
+    /* At most 5 bytes, 4 * 7 + 4 bits */
+    for (int i = 0; i < 5 && pos < end; ++i) {
+        uint8_t byte = *pos++;
+        if ((result >> 25) != 0) {
+            return NULL;
+        }
+        result = (result << 7) | (byte & 0x7f);
+        if ((byte & 0x80) == 0) {
+            *value = result;
+            return pos;
+        }
+    }
+    return NULL;
+}
+
+bool compact_decode(const compact_schema_t* schemas,
+                    int n_schemas,
+                    const void* data,
+                    uint16_t len,
+                    compact_message_t* message)
+{
+    const uint8_t* pos = data;
+    const uint8_t* end = pos + len;
+    uint32_t id;
+
+    pos = compact_read_mbi(pos, end, &id);
+    if (pos == NULL || (pos = compact_read_mbi(pos, end, &message->fields)) == NULL) {
+        return false;
+    }
+
+    message->schema = NULL;
+    for (int i = 0; i < n_schemas; ++i) {
+        if (schemas[i].id == id) {
+            message->schema = &schemas[i];
+            break;
+        }
+    }
+    if (message->schema == NULL) {
+        return false;
+    }
+
+    const compact_schema_t* schema = message->schema;
+    if (schema->n_fields < COMPACT_MAX_FIELDS && (message->fields >> schema->n_fields) != 0) {
+        return false;
+    }
+
+    uint32_t fields = message->fields;
+    for (int field = 0; fields != 0; ++field, fields >>= 1) {
+        uint32_t value;
+        if ((fields & 1) == 0) {
+            continue;
+        }
+        /* Most values fit in one byte */
+        if (pos < end && (*pos & 0x80) == 0) {
+            value = *pos++;
+        } else if ((pos = compact_read_mbi(pos, end, &value)) == NULL) {
+            return false;
+        }
+        if (schema->fields[field].type != COMPACT_UINT) {
+            /* Undo the zig-zag encoding */
+            value = (value >> 1) ^ -(value & 1);
+        }
+        message->values[field] = value;
+    }
+
+    return pos == end;
+}
+
+double compact_value(const compact_message_t* message, int field)
+{
+    const compact_field_t* desc = &message->schema->fields[field];
+    uint32_t value = message->values[field];
+
+    switch (desc->type) {
+        case COMPACT_SINT:
+            return (int32_t)value;
+        case COMPACT_FIXED:
+            return (double)(int32_t)value / powers_of_ten[desc->decimals > 6 ? 6 : desc->decimals];
+        default:
+            return value;
+    }
+}
+
+int compact_format(const compact_message_t* message, int field, char* buf, int size)
+{
+    const compact_field_t* desc = &message->schema->fields[field];
+    uint32_t value = message->values[field];
+
+    if (desc->type == COMPACT_UINT) {
+        return snprintf(buf, size, "%lu", (unsigned long)value);
+    }
+    if (desc->type == COMPACT_SINT || desc->decimals == 0) {
+        return snprintf(buf, size, "%ld", (long)(int32_t)value);
+    }
+
+    int decimals = desc->decimals > 6 ? 6 : desc->decimals;
+    bool negative = (int32_t)value < 0;
+    uint32_t magnitude = negative ? -value : value;
+    return snprintf(buf,
+                    size,
+                    "%s%lu.%0*lu",
+                    negative ? "-" : "",
+                    (unsigned long)(magnitude / powers_of_ten[decimals]),
+                    decimals,
+                    (unsigned long)(magnitude % powers_of_ten[decimals]));
+}
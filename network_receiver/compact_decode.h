@@ -0,0 +1,98 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 LumenRadio AB
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+#ifndef COMPACT_DECODE_H
+#define COMPACT_DECODE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Decoding of the compact sensor messages, see compact.h in the
+ * network_sender example.
+ *
+ * Only depends on the C library, so it can be built on a host.
+ */
+
+/* Max number of fields in a schema, one bit each in the bit field */
+#define COMPACT_MAX_FIELDS 32
+
+typedef enum {
+    COMPACT_UINT,
+    COMPACT_SINT,
+    COMPACT_FIXED,
+} compact_type_t;
+
+typedef struct
+{
+    const char* name;
+    uint8_t type;     /* compact_type_t */
+    uint8_t decimals; /* For COMPACT_FIXED */
+} compact_field_t;
+
+typedef struct
+{
+    uint32_t id;
+    const char* name;
+    const compact_field_t* fields;
+    uint8_t n_fields;
+} compact_schema_t;
+
+/* Expands a FIELD() entry of sensor_schema.h into a compact_field_t */
+#define COMPACT_FIELD(ID, NAME, TYPE, DECIMALS) { NAME, COMPACT_##TYPE, DECIMALS },
+
+typedef struct
+{
+    const compact_schema_t* schema;
+    uint32_t fields; /* Bit per field that was sent */
+    /* Signed and fixed point values are stored as int32_t */
+    uint32_t values[COMPACT_MAX_FIELDS];
+} compact_message_t;
+
+/*
+ * Decode a message, with one of the given schemas.
+ *
+ * Returns false if the schema is unknown, if the bit field has fields the
+ * schema doesn't, or if the message is truncated or has data left over.
+ */
+bool compact_decode(const compact_schema_t* schemas,
+                    int n_schemas,
+                    const void* data,
+                    uint16_t len,
+                    compact_message_t* message);
+
+/* Value of a field that was sent, scaled if fixed point */
+double compact_value(const compact_message_t* message, int field);
+
+/*
+ * Format the value of a field that was sent, with integer math only, so it
+ * can be used without printf support for floating point.
+ *
+ * Returns the length, as snprintf.
+ */
+int compact_format(const compact_message_t* message, int field, char* buf, int size);
+
+#endif
@@ -0,0 +1,189 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 LumenRadio AB
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+#include <mira.h>
+#include <string.h>
+#include "frame_input.h"
+#include "frame_output.h"
+
+#if (FRAME_INPUT_QUEUE_SIZE & (FRAME_INPUT_QUEUE_SIZE - 1)) != 0 || FRAME_INPUT_QUEUE_SIZE > 128
+#error "FRAME_INPUT_QUEUE_SIZE must be a power of two, at most 128"
+#endif
+
+#define MAX_FRAME_SIZE (FRAME_INPUT_HEADER_SIZE + FRAME_INPUT_MAX_PAYLOAD + FRAME_OUTPUT_CRC_SIZE)
+
+typedef struct
+{
+    uint16_t len;
+    uint8_t data[MAX_FRAME_SIZE];
+} frame_t;
+
+/*
+ * Filled by frame_input_byte(), emptied by the process. The indexes are free
+ * running, and each is only written by one side.
+ */
+static frame_t queue[FRAME_INPUT_QUEUE_SIZE];
+static volatile uint8_t queue_head;
+static volatile uint8_t queue_tail;
+
+/* COBS decoder state, decoding into queue[queue_head] */
+static uint16_t frame_len;
+static uint8_t block_left;
+static bool zero_pending;
+static bool discarding;
+static bool no_room;
+
+static mira_net_udp_connection_t* send_connection;
+static frame_input_stats_t stats;
+
+PROCESS(frame_input_proc, "Frame input");
+
+static void decoder_reset(void)
+{
+    frame_len = 0;
+    block_left = 0;
+    zero_pending = false;
+    discarding = false;
+    no_room = false;
+}
+
+/* Checks the frame, and queues it. The trailing implied zero is never added */
+static void frame_end(void)
+{
+    frame_t* frame = &queue[queue_head % FRAME_INPUT_QUEUE_SIZE];
+
+    if (no_room || (frame_len == 0 && !discarding)) {
+        /* Already counted, or empty, the leading delimiter of a frame */
+        return;
+    }
+    if (discarding || block_left != 0 ||
+        frame_len < FRAME_INPUT_HEADER_SIZE + FRAME_OUTPUT_CRC_SIZE ||
+        frame->data[0] != FRAME_INPUT_TYPE_SEND) {
+        stats.invalid++;
+        return;
+    }
+
+    uint16_t crc = frame->data[frame_len - 2] | (frame->data[frame_len - 1] << 8);
+    if (frame_output_crc(FRAME_OUTPUT_CRC_INIT, frame->data, frame_len - 2) != crc) {
+        stats.invalid++;
+        return;
+    }
+
+    frame->len = frame_len - FRAME_OUTPUT_CRC_SIZE;
+    queue_head++;
+    process_poll(&frame_input_proc);
+}
+
+void frame_input_byte(uint8_t byte)
+{
+    if (byte == 0) {
+        frame_end();
+        decoder_reset();
+        return;
+    }
+    if (discarding) {
+        return;
+    }
+    if ((uint8_t)(queue_head - queue_tail) == FRAME_INPUT_QUEUE_SIZE) {
+        /* No room, drop the frame when it ends */
+        stats.dropped++;
+        discarding = true;
+        no_room = true;
+        return;
+    }
+
+    frame_t* frame = &queue[queue_head % FRAME_INPUT_QUEUE_SIZE];
+    if (block_left == 0) {
+        /* A code byte, starting a new block */
+        if (zero_pending) {
+            if (frame_len == MAX_FRAME_SIZE) {
+                discarding = true;
+                return;
+            }
+            frame->data[frame_len++] = 0;
+        }
+        block_left = byte - 1;
+        zero_pending = byte != 0xff;
+        return;
+    }
+
+    if (frame_len == MAX_FRAME_SIZE) {
+        discarding = true;
+        return;
+    }
+    frame->data[frame_len++] = byte;
+    block_left--;
+}
+
+void frame_input_get_stats(frame_input_stats_t* stats_out)
+{
+    *stats_out = stats;
+}
+
+static void reply_callback(mira_net_udp_connection_t* connection,
+                           const void* data,
+                           uint16_t data_len,
+                           const mira_net_udp_callback_metadata_t* metadata,
+                           void* storage)
+{
+    frame_output_udp(
+      metadata->source_address, metadata->source_port, FRAME_INPUT_REPLY_PORT, data, data_len);
+}
+
+void frame_input_init(void)
+{
+    send_connection = mira_net_udp_connect(NULL, 0, reply_callback, NULL);
+    process_start(&frame_input_proc, NULL);
+}
+
+PROCESS_THREAD(frame_input_proc, ev, data)
+{
+    PROCESS_BEGIN();
+
+    while (1) {
+        PROCESS_WAIT_EVENT_UNTIL(ev == PROCESS_EVENT_POLL);
+
+        while (queue_tail != queue_head) {
+            frame_t* frame = &queue[queue_tail % FRAME_INPUT_QUEUE_SIZE];
+            mira_net_address_t addr;
+            uint16_t port = frame->data[17] | (frame->data[18] << 8);
+
+            memcpy(addr.u8, &frame->data[1], 16);
+            if (mira_net_udp_send_to(send_connection,
+                                     &addr,
+                                     port,
+                                     &frame->data[FRAME_INPUT_HEADER_SIZE],
+                                     frame->len - FRAME_INPUT_HEADER_SIZE) == MIRA_SUCCESS) {
+                stats.sent++;
+            } else {
+                stats.dropped++;
+            }
+            queue_tail++;
+        }
+    }
+
+    PROCESS_END();
+}
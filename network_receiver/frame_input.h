@@ -0,0 +1,86 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 LumenRadio AB
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+#ifndef FRAME_INPUT_H
+#define FRAME_INPUT_H
+
+#include <mira.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Packets from the host to send into the network, the counterpart of
+ * frame_output.h, for example from the gateway in gateway/.
+ *
+ * Frames are COBS encoded and delimited by zero bytes, like the output
+ * frames. Before encoding, a frame is:
+ *
+ * <FRAME_INPUT_TYPE_SEND> (1 byte)
+ * <destination address> (16 bytes)
+ * <destination port> (2 bytes)
+ * <payload>
+ * <CRC-16/CCITT-FALSE of the above> (2 bytes)
+ *
+ * Packets are sent from one UDP connection. Replies to it are written as
+ * output frames with FRAME_INPUT_REPLY_PORT as local port.
+ *
+ * Frames are decoded as bytes arrive, into a queue of
+ * FRAME_INPUT_QUEUE_SIZE frames. Frames arriving when the queue is full, or
+ * that are malformed, are dropped and counted.
+ */
+
+#define FRAME_INPUT_TYPE_SEND 2
+
+#define FRAME_INPUT_HEADER_SIZE 19
+
+/* Local port in output frames of replies to sent packets */
+#define FRAME_INPUT_REPLY_PORT 0
+
+/* Longest payload accepted */
+#ifndef FRAME_INPUT_MAX_PAYLOAD
+#define FRAME_INPUT_MAX_PAYLOAD 256
+#endif
+
+/* Number of frames waiting to be sent */
+#ifndef FRAME_INPUT_QUEUE_SIZE
+#define FRAME_INPUT_QUEUE_SIZE 4
+#endif
+
+typedef struct
+{
+    uint32_t sent;
+    uint32_t dropped; /* Queue full, or sending failed */
+    uint32_t invalid;
+} frame_input_stats_t;
+
+void frame_input_init(void);
+
+/* Called with each byte read from the serial port */
+void frame_input_byte(uint8_t byte);
+
+void frame_input_get_stats(frame_input_stats_t* stats);
+
+#endif
@@ -0,0 +1,203 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 LumenRadio AB
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+#include <mira.h>
+#include <string.h>
+#include <unistd.h>
+#include "frame_output.h"
+
+#if (FRAME_OUTPUT_BUFFER_SIZE & (FRAME_OUTPUT_BUFFER_SIZE - 1)) != 0 || \
+  FRAME_OUTPUT_BUFFER_SIZE > 32768
+#error "FRAME_OUTPUT_BUFFER_SIZE must be a power of two, at most 32768"
+#endif
+
+#define BUFFER_MASK (FRAME_OUTPUT_BUFFER_SIZE - 1)
+
+/*
+ * Encoded size of a frame: a COBS code byte for every 254 bytes, started or
+ * not, and the two delimiters.
+ */
+#define ENCODED_SIZE(len) ((len) + (len) / 254 + 1 + 2)
+
+/*
+ * Free running indexes, the buffer position is the index masked. Frames are
+ * only queued and written from processes, which don't preempt each other, so
+ * no locking is needed.
+ */
+static uint8_t buffer[FRAME_OUTPUT_BUFFER_SIZE];
+static uint16_t head;
+static uint16_t tail;
+
+/* COBS encoder state, for the frame being queued */
+static uint16_t code_index;
+static uint8_t code;
+static uint16_t frame_crc;
+
+static frame_output_stats_t stats;
+
+PROCESS(frame_output_proc, "Frame output");
+
+static uint16_t buffer_free(void)
+{
+    return FRAME_OUTPUT_BUFFER_SIZE - (uint16_t)(head - tail);
+}
+
+static void encode_start(void)
+{
+    buffer[head++ & BUFFER_MASK] = 0;
+    code_index = head++;
+    code = 1;
+    frame_crc = FRAME_OUTPUT_CRC_INIT;
+}
+
+static void encode_byte(uint8_t byte)
+{
+    if (byte != 0) {
+        buffer[head++ & BUFFER_MASK] = byte;
+        code++;
+    }
+    if (byte == 0 || code == 0xff) {
+        buffer[code_index & BUFFER_MASK] = code;
+        code_index = head++;
+        code = 1;
+    }
+}
+
+uint16_t frame_output_crc(uint16_t crc, const uint8_t* data, uint16_t len)
+{
+    for (uint16_t i = 0; i < len; ++i) {
+        crc ^= (uint16_t)data[i] << 8;
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+static void encode_data(const uint8_t* data, uint16_t len)
+{
+    frame_crc = frame_output_crc(frame_crc, data, len);
+    for (uint16_t i = 0; i < len; ++i) {
+        encode_byte(data[i]);
+    }
+}
+
+static void encode_end(void)
+{
+    uint8_t crc_bytes[FRAME_OUTPUT_CRC_SIZE] = { frame_crc, frame_crc >> 8 };
+
+    encode_byte(crc_bytes[0]);
+    encode_byte(crc_bytes[1]);
+    buffer[code_index & BUFFER_MASK] = code;
+    buffer[head++ & BUFFER_MASK] = 0;
+}
+
+bool frame_output_has_room(uint16_t len)
+{
+    uint32_t frame_len = (uint32_t)FRAME_OUTPUT_HEADER_SIZE + len + FRAME_OUTPUT_CRC_SIZE;
+    return ENCODED_SIZE(frame_len) <= buffer_free();
+}
+
+bool frame_output_udp(const mira_net_address_t* source,
+                      uint16_t source_port,
+                      uint16_t local_port,
+                      const void* payload,
+                      uint16_t len)
+{
+    uint8_t header[FRAME_OUTPUT_HEADER_SIZE];
+    uint32_t now = clock_time() * 1000ULL / CLOCK_SECOND;
+    uint16_t start = head;
+
+    if (!frame_output_has_room(len)) {
+        stats.dropped++;
+        return false;
+    }
+
+    header[0] = FRAME_OUTPUT_TYPE_UDP;
+    memcpy(&header[1], source->u8, 16);
+    header[17] = source_port;
+    header[18] = source_port >> 8;
+    header[19] = local_port;
+    header[20] = local_port >> 8;
+    header[21] = now;
+    header[22] = now >> 8;
+    header[23] = now >> 16;
+    header[24] = now >> 24;
+
+    encode_start();
+    encode_data(header, sizeof(header));
+    encode_data(payload, len);
+    encode_end();
+
+    stats.frames++;
+    stats.bytes += (uint16_t)(head - start);
+    process_poll(&frame_output_proc);
+    return true;
+}
+
+uint16_t frame_output_pending(void)
+{
+    return head - tail;
+}
+
+void frame_output_get_stats(frame_output_stats_t* stats_out)
+{
+    *stats_out = stats;
+}
+
+void frame_output_init(void)
+{
+    process_start(&frame_output_proc, NULL);
+}
+
+PROCESS_THREAD(frame_output_proc, ev, data)
+{
+    PROCESS_BEGIN();
+
+    while (1) {
+        PROCESS_WAIT_EVENT_UNTIL(ev == PROCESS_EVENT_POLL);
+
+        /*
+         * Write all queued frames before yielding, so text printed by other
+         * processes to the same output only ends up between frames.
+         */
+        while (head != tail) {
+            uint16_t len = head - tail;
+            uint16_t until_end = FRAME_OUTPUT_BUFFER_SIZE - (tail & BUFFER_MASK);
+            if (len > until_end) {
+                len = until_end;
+            }
+
+            int written = write(FRAME_OUTPUT_FD, &buffer[tail & BUFFER_MASK], len);
+            if (written <= 0) {
+                break;
+            }
+            tail += written;
+        }
+    }
+
+    PROCESS_END();
+}
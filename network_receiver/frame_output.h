@@ -0,0 +1,103 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 LumenRadio AB
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+#ifndef FRAME_OUTPUT_H
+#define FRAME_OUTPUT_H
+
+#include <mira.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Binary output of received packets, as an alternative to printing them as
+ * text.
+ *
+ * Each packet is written as one frame, COBS encoded and delimited by a zero
+ * byte before and after, so a reader can find the next frame after an error,
+ * and text printed in between frames is skipped. Before encoding, a frame is:
+ *
+ * <FRAME_OUTPUT_TYPE_UDP> (1 byte)
+ * <source address> (16 bytes)
+ * <source port> (2 bytes)
+ * <local port> (2 bytes)
+ * <time, in milliseconds since start> (4 bytes)
+ * <payload>
+ * <CRC-16/CCITT-FALSE of the above> (2 bytes)
+ *
+ * All numbers are little endian. Frames are put in a ring buffer, and written
+ * by a separate process, so receiving doesn't wait for the UART. Frames that
+ * don't fit in the buffer are dropped and counted.
+ *
+ * frame_reader.py decodes the frames on the host.
+ */
+
+#define FRAME_OUTPUT_TYPE_UDP 1
+
+#define FRAME_OUTPUT_HEADER_SIZE 25
+#define FRAME_OUTPUT_CRC_SIZE 2
+#define FRAME_OUTPUT_CRC_INIT 0xffff
+
+/* Size of the ring buffer, a power of two */
+#ifndef FRAME_OUTPUT_BUFFER_SIZE
+#define FRAME_OUTPUT_BUFFER_SIZE 4096
+#endif
+
+/* File descriptor the frames are written to, see MIRA_IODEFS */
+#ifndef FRAME_OUTPUT_FD
+#define FRAME_OUTPUT_FD 1
+#endif
+
+typedef struct
+{
+    uint32_t frames;
+    uint32_t bytes; /* Encoded, including delimiters */
+    uint32_t dropped;
+} frame_output_stats_t;
+
+void frame_output_init(void);
+
+/*
+ * Queue a frame. Returns false, and counts the frame as dropped, if there
+ * isn't room in the buffer.
+ */
+bool frame_output_udp(const mira_net_address_t* source,
+                      uint16_t source_port,
+                      uint16_t local_port,
+                      const void* payload,
+                      uint16_t len);
+
+/* True if a frame of len bytes of payload fits in the buffer right now */
+bool frame_output_has_room(uint16_t len);
+
+/* Number of bytes in the buffer, not yet written */
+uint16_t frame_output_pending(void);
+
+void frame_output_get_stats(frame_output_stats_t* stats);
+
+/* Continue a CRC-16/CCITT-FALSE, started with FRAME_OUTPUT_CRC_INIT */
+uint16_t frame_output_crc(uint16_t crc, const uint8_t* data, uint16_t len);
+
+#endif
@@ -0,0 +1,190 @@
+#!/usr/bin/env python3
+
+# Reader for the binary frames written by network_receiver, see frame_output.h
+#
+#
+# MIT License
+#
+# Copyright (c) 2023 LumenRadio AB
+#
+# SPDX-License-Identifier: MIT
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+#
+#
+#
+# Reads frames from a serial port, a file or stdin, and prints one line per
+# packet. Text printed by the receiver in between frames is passed through.
+#
+# A serial port should be set to raw mode first, for example:
+#   stty -F /dev/ttyACM0 raw 1000000
+#   ./frame_reader.py /dev/ttyACM0
+
+import argparse
+import ipaddress
+import json
+import sys
+import time
+
+FRAME_OUTPUT_TYPE_UDP = 1
+FRAME_OUTPUT_HEADER_SIZE = 25
+
+
+class FrameError(Exception):
+    pass
+
+
+def cobs_decode(data):
+    out = bytearray()
+    pos = 0
+    while pos < len(data):
+        code = data[pos]
+        if code == 0 or pos + code > len(data):
+            raise FrameError("invalid COBS code")
+        out += data[pos + 1 : pos + code]
+        pos += code
+        if code < 0xFF and pos < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+def crc16_ccitt(data):
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else crc << 1
+            crc &= 0xFFFF
+    return crc
+
+
+def decode_frame(encoded):
+    frame = cobs_decode(encoded)
+    if len(frame) < FRAME_OUTPUT_HEADER_SIZE + 2:
+        raise FrameError("short frame")
+    if crc16_ccitt(frame[:-2]) != int.from_bytes(frame[-2:], "little"):
+        raise FrameError("CRC mismatch")
+    if frame[0] != FRAME_OUTPUT_TYPE_UDP:
+        raise FrameError("unknown frame type %d" % frame[0])
+    return {
+        "source": str(ipaddress.IPv6Address(frame[1:17])),
+        "source_port": int.from_bytes(frame[17:19], "little"),
+        "port": int.from_bytes(frame[19:21], "little"),
+        "time_ms": int.from_bytes(frame[21:25], "little"),
+        "payload": frame[25:-2],
+    }
+
+
+class FrameReader:
+    """Splits a byte stream in frames and text.
+
+    feed() returns a list of ("frame", packet) and ("text", line) tuples.
+    """
+
+    def __init__(self):
+        self.pending = bytearray()
+        self.errors = 0
+
+    def feed(self, data):
+        self.pending += data
+        results = []
+        while True:
+            end = self.pending.find(0)
+            if end < 0:
+                break
+            chunk = bytes(self.pending[:end])
+            del self.pending[: end + 1]
+            if not chunk:
+                continue
+            try:
+                results.append(("frame", decode_frame(chunk)))
+            except FrameError:
+                text = chunk.decode(errors="replace").strip()
+                # Text printed in between frames has newlines, broken frames don't
+                if b"\n" in chunk:
+                    results.append(("text", text))
+                else:
+                    self.errors += 1
+        return results
+
+
+def arg_build_parser():
+    parser = argparse.ArgumentParser(description="network_receiver frame reader")
+    parser.add_argument(
+        "input",
+        nargs="?",
+        help="Serial port or file to read from (default: stdin)",
+    )
+    parser.add_argument(
+        "--json", action="store_true", help="Print packets as JSON objects"
+    )
+    parser.add_argument(
+        "--stats",
+        type=float,
+        metavar="SECONDS",
+        help="Only print frames and bytes per second, every SECONDS",
+    )
+    return parser
+
+
+def format_packet(packet, as_json):
+    if as_json:
+        return json.dumps(dict(packet, payload=packet["payload"].hex()))
+    return "Received message from [%s]:%u: %s" % (
+        packet["source"],
+        packet["source_port"],
+        packet["payload"].hex(),
+    )
+
+
+if __name__ == "__main__":
+    args = arg_build_parser().parse_args()
+    stream = open(args.input, "rb", buffering=0) if args.input else sys.stdin.buffer
+    reader = FrameReader()
+
+    frames = 0
+    n_bytes = 0
+    last_report = time.monotonic()
+    while True:
+        data = stream.read(4096)
+        if not data:
+            break
+        n_bytes += len(data)
+        for kind, item in reader.feed(data):
+            if kind == "frame":
+                frames += 1
+                if args.stats is None:
+                    print(format_packet(item, args.json), flush=True)
+            elif args.stats is None:
+                print(item, flush=True)
+
+        now = time.monotonic()
+        if args.stats is not None and now - last_report >= args.stats:
+            print(
+                "frames/s: %.1f bytes/s: %.0f errors: %d"
+                % (
+                    frames / (now - last_report),
+                    n_bytes / (now - last_report),
+                    reader.errors,
+                ),
+                flush=True,
+            )
+            frames = 0
+            n_bytes = 0
+            last_report = now
@@ -0,0 +1,108 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 LumenRadio AB
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+#include "frame.h"
+
+uint16_t frame_crc(uint16_t crc, const uint8_t* data, size_t len)
+{
+    for (size_t i = 0; i < len; ++i) {
+        crc ^= (uint16_t)data[i] << 8;
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+typedef struct
+{
+    uint8_t* out;
+    size_t pos;
+    size_t code_pos;
+    uint8_t code;
+} encoder_t;
+
+static void encode_bytes(encoder_t* enc, const uint8_t* data, size_t len)
+{
+    for (size_t i = 0; i < len; ++i) {
+        if (data[i] != 0) {
+            enc->out[enc->pos++] = data[i];
+            enc->code++;
+        }
+        if (data[i] == 0 || enc->code == 0xff) {
+            enc->out[enc->code_pos] = enc->code;
+            enc->code_pos = enc->pos++;
+            enc->code = 1;
+        }
+    }
+}
+
+size_t frame_encode(uint8_t* out, const uint8_t* part1, size_t len1, const uint8_t* part2,
+                    size_t len2)
+{
+    encoder_t enc = { out, 2, 1, 1 };
+    uint16_t crc = frame_crc(0xffff, part1, len1);
+    crc = frame_crc(crc, part2, len2);
+    uint8_t crc_bytes[FRAME_CRC_SIZE] = { crc, crc >> 8 };
+
+    out[0] = 0;
+    encode_bytes(&enc, part1, len1);
+    encode_bytes(&enc, part2, len2);
+    encode_bytes(&enc, crc_bytes, sizeof(crc_bytes));
+    out[enc.code_pos] = enc.code;
+    out[enc.pos++] = 0;
+    return enc.pos;
+}
+
+long frame_decode(uint8_t* data, size_t len)
+{
+    size_t in = 0;
+    size_t out = 0;
+
+    while (in < len) {
+        uint8_t code = data[in];
+        if (code == 0 || in + code > len) {
+            return -1;
+        }
+        /* The output never passes the input, so decoding in place is safe */
+        for (uint8_t i = 1; i < code; ++i) {
+            data[out++] = data[in + i];
+        }
+        in += code;
+        if (code != 0xff && in < len) {
+            data[out++] = 0;
+        }
+    }
+
+    if (out < FRAME_CRC_SIZE) {
+        return -1;
+    }
+    out -= FRAME_CRC_SIZE;
+    if (frame_crc(0xffff, data, out) != (data[out] | (data[out + 1] << 8))) {
+        return -1;
+    }
+    return out;
+}
@@ -0,0 +1,67 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 LumenRadio AB
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+#ifndef FRAME_H
+#define FRAME_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Host side of the frames in ../frame_output.h and ../frame_input.h:
+ * COBS encoding, delimited by zero bytes, with a CRC-16/CCITT-FALSE.
+ */
+
+#define FRAME_TYPE_UDP 1  /* Root to host, FRAME_OUTPUT_TYPE_UDP */
+#define FRAME_TYPE_SEND 2 /* Host to root, FRAME_INPUT_TYPE_SEND */
+
+#define FRAME_UDP_HEADER_SIZE 25
+#define FRAME_SEND_HEADER_SIZE 19
+#define FRAME_CRC_SIZE 2
+
+/* Local port of replies to packets sent by the host, FRAME_INPUT_REPLY_PORT */
+#define FRAME_REPLY_PORT 0
+
+/* Max encoded size of a frame of len bytes, including CRC and delimiters */
+#define FRAME_ENCODED_MAX(len) ((len) + FRAME_CRC_SIZE + ((len) + FRAME_CRC_SIZE) / 254 + 3)
+
+uint16_t frame_crc(uint16_t crc, const uint8_t* data, size_t len);
+
+/*
+ * Encode a frame from two parts, adding the CRC and the delimiters. out must
+ * have room for FRAME_ENCODED_MAX(len1 + len2) bytes. Returns the encoded
+ * length.
+ */
+size_t frame_encode(uint8_t* out, const uint8_t* part1, size_t len1, const uint8_t* part2,
+                    size_t len2);
+
+/*
+ * Decode the COBS data between two delimiters, in place, and check the CRC.
+ * Returns the frame length without the CRC, or -1 if the frame is invalid.
+ */
+long frame_decode(uint8_t* data, size_t len);
+
+#endif
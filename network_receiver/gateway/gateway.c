@@ -0,0 +1,585 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 LumenRadio AB
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+/*
+ * Gateway between the root running network_receiver with BINARY_OUTPUT=1 and
+ * UDP sockets on the host.
+ *
+ * Packets received by the root on a mesh port are sent to the host port
+ * mapped to it with -p. Datagrams sent to the gateway's port, -i, are sent
+ * into the mesh. On the host, each datagram starts with the mesh address and
+ * port, of the source for received packets and of the destination for sent
+ * packets:
+ *
+ * <mesh address> (16 bytes)
+ * <mesh port> (2 bytes, little endian)
+ * <payload>
+ *
+ * Received packets are sent from the gateway's port, so a host application
+ * can answer to the address it received from. Replies from the mesh to sent
+ * packets go back to the host socket that sent to that mesh address and
+ * port last.
+ */
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include "frame.h"
+
+/* Datagrams read or sent per system call */
+#define BATCH_SIZE 64
+
+#define MAX_PORTS 32
+
+/* Longest payload the root accepts, FRAME_INPUT_MAX_PAYLOAD */
+#define DEFAULT_MAX_PAYLOAD 256
+
+#define DEFAULT_INJECT_PORT 4560
+
+#define HOST_HEADER_SIZE 18
+
+#define RX_BUFFER_SIZE 65536
+#define TX_BUFFER_SIZE 65536
+
+/* Max size of a datagram from the host, larger ones are truncated and dropped */
+#define HOST_DATAGRAM_SIZE 2048
+
+/* Senders of packets into the mesh, for the replies */
+#define REPLY_TABLE_SIZE 256
+
+typedef struct
+{
+    uint16_t mesh_port;
+    struct sockaddr_in host;
+} port_map_t;
+
+typedef struct
+{
+    bool used;
+    uint8_t mesh_address[16];
+    uint16_t mesh_port;
+    struct sockaddr_in host;
+} reply_route_t;
+
+typedef struct
+{
+    uint64_t rx_frames;
+    uint64_t rx_invalid;
+    uint64_t rx_unmapped;
+    uint64_t tx_frames;
+    uint64_t tx_invalid;
+    uint64_t tx_paused;
+} gateway_stats_t;
+
+static port_map_t port_maps[MAX_PORTS];
+static int n_port_maps;
+static reply_route_t reply_routes[REPLY_TABLE_SIZE];
+
+static int epoll_fd;
+static int serial_fd;
+static int host_fd;
+static size_t max_payload = DEFAULT_MAX_PAYLOAD;
+
+/* Bytes read from the serial port, frames are decoded in place */
+static uint8_t rx_buffer[RX_BUFFER_SIZE];
+static size_t rx_len;
+
+/* Encoded frames not yet written to the serial port */
+static uint8_t tx_buffer[TX_BUFFER_SIZE];
+static size_t tx_start;
+static size_t tx_end;
+static bool tx_waiting;  /* Waiting for the serial port to be writable */
+static bool host_paused; /* Not reading from the host, the serial port is full */
+
+/* Datagrams to the host, pointing into rx_buffer until sent */
+static struct mmsghdr out_msgs[BATCH_SIZE];
+static struct iovec out_iovs[BATCH_SIZE][2];
+static int n_out_msgs;
+
+/* Datagrams from the host */
+static uint8_t in_buffers[BATCH_SIZE][HOST_DATAGRAM_SIZE];
+static struct mmsghdr in_msgs[BATCH_SIZE];
+static struct iovec in_iovs[BATCH_SIZE];
+static struct sockaddr_in in_addrs[BATCH_SIZE];
+
+static gateway_stats_t stats;
+static volatile sig_atomic_t running = 1;
+
+static uint16_t get_u16(const uint8_t* p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+static unsigned reply_hash(const uint8_t* mesh_address, uint16_t mesh_port)
+{
+    /* FNV-1a of the interface ID and the port */
+    uint32_t hash = 2166136261u;
+    for (int i = 8; i < 16; ++i) {
+        hash = (hash ^ mesh_address[i]) * 16777619u;
+    }
+    hash = (hash ^ (mesh_port & 0xff)) * 16777619u;
+    hash = (hash ^ (mesh_port >> 8)) * 16777619u;
+    return hash % REPLY_TABLE_SIZE;
+}
+
+/* Only the latest sender per slot is kept, which is enough for replies */
+static void reply_route_set(const uint8_t* mesh_address, uint16_t mesh_port,
+                            const struct sockaddr_in* host)
+{
+    reply_route_t* route = &reply_routes[reply_hash(mesh_address, mesh_port)];
+    route->used = true;
+    memcpy(route->mesh_address, mesh_address, 16);
+    route->mesh_port = mesh_port;
+    route->host = *host;
+}
+
+static const struct sockaddr_in* reply_route_get(const uint8_t* mesh_address, uint16_t mesh_port)
+{
+    reply_route_t* route = &reply_routes[reply_hash(mesh_address, mesh_port)];
+    if (route->used && route->mesh_port == mesh_port &&
+        memcmp(route->mesh_address, mesh_address, 16) == 0) {
+        return &route->host;
+    }
+    return NULL;
+}
+
+static const struct sockaddr_in* port_map_get(uint16_t mesh_port)
+{
+    for (int i = 0; i < n_port_maps; ++i) {
+        if (port_maps[i].mesh_port == mesh_port) {
+            return &port_maps[i].host;
+        }
+    }
+    return NULL;
+}
+
+static void epoll_update(int fd, uint32_t events)
+{
+    struct epoll_event ev = { .events = events, .data.fd = fd };
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_MOD, fd, &ev) < 0) {
+        perror("epoll_ctl");
+        exit(1);
+    }
+}
+
+static void flush_out_msgs(void)
+{
+    int sent = 0;
+
+    while (sent < n_out_msgs) {
+        int n = sendmmsg(host_fd, &out_msgs[sent], n_out_msgs - sent, 0);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            /* A full socket buffer or an unreachable port drops the rest */
+            break;
+        }
+        sent += n;
+    }
+    n_out_msgs = 0;
+}
+
+/* Queue a received frame to the host, without copying the payload */
+static void handle_rx_frame(uint8_t* frame, long len)
+{
+    if (len < FRAME_UDP_HEADER_SIZE || frame[0] != FRAME_TYPE_UDP) {
+        stats.rx_invalid++;
+        return;
+    }
+
+    uint16_t source_port = get_u16(&frame[17]);
+    uint16_t local_port = get_u16(&frame[19]);
+    const struct sockaddr_in* host = local_port == FRAME_REPLY_PORT
+                                       ? reply_route_get(&frame[1], source_port)
+                                       : NULL;
+    if (host == NULL) {
+        host = port_map_get(local_port);
+    }
+    if (host == NULL) {
+        stats.rx_unmapped++;
+        return;
+    }
+
+    /* Address and source port are already next to each other in the frame */
+    struct mmsghdr* msg = &out_msgs[n_out_msgs];
+    out_iovs[n_out_msgs][0].iov_base = &frame[1];
+    out_iovs[n_out_msgs][0].iov_len = HOST_HEADER_SIZE;
+    out_iovs[n_out_msgs][1].iov_base = &frame[FRAME_UDP_HEADER_SIZE];
+    out_iovs[n_out_msgs][1].iov_len = len - FRAME_UDP_HEADER_SIZE;
+    memset(msg, 0, sizeof(*msg));
+    msg->msg_hdr.msg_name = (void*)host;
+    msg->msg_hdr.msg_namelen = sizeof(*host);
+    msg->msg_hdr.msg_iov = out_iovs[n_out_msgs];
+    msg->msg_hdr.msg_iovlen = 2;
+
+    stats.rx_frames++;
+    if (++n_out_msgs == BATCH_SIZE) {
+        flush_out_msgs();
+    }
+}
+
+/* Text printed by the root in between frames */
+static void handle_rx_text(const uint8_t* text, size_t len)
+{
+    if (len == 0) {
+        stats.rx_invalid++;
+        return;
+    }
+    fwrite(text, 1, len, stdout);
+    fflush(stdout);
+}
+
+static void serial_read(void)
+{
+    while (1) {
+        ssize_t n = read(serial_fd, &rx_buffer[rx_len], sizeof(rx_buffer) - rx_len);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n == 0 || (n < 0 && errno != EAGAIN)) {
+            fprintf(stderr, "Serial port closed\n");
+            running = 0;
+            return;
+        }
+        if (n < 0) {
+            break;
+        }
+        rx_len += n;
+
+        /* Decode all complete frames, the payloads stay in rx_buffer until sent */
+        size_t start = 0;
+        uint8_t* end;
+        while ((end = memchr(&rx_buffer[start], 0, rx_len - start)) != NULL) {
+            size_t len = end - &rx_buffer[start];
+            if (len > 0) {
+                /* Decoding is in place, so keep what may be a line of text */
+                uint8_t text[256];
+                size_t text_len = 0;
+                if (memchr(&rx_buffer[start], '\n', len) != NULL) {
+                    text_len = len < sizeof(text) ? len : sizeof(text);
+                    memcpy(text, &rx_buffer[start], text_len);
+                }
+
+                long frame_len = frame_decode(&rx_buffer[start], len);
+                if (frame_len >= 0) {
+                    handle_rx_frame(&rx_buffer[start], frame_len);
+                } else {
+                    handle_rx_text(text, text_len);
+                }
+            }
+            start += len + 1;
+        }
+        flush_out_msgs();
+
+        /* Keep the start of an incomplete frame, drop it if it can't fit */
+        if (start == 0 && rx_len == sizeof(rx_buffer)) {
+            stats.rx_invalid++;
+            rx_len = 0;
+        } else {
+            memmove(rx_buffer, &rx_buffer[start], rx_len - start);
+            rx_len -= start;
+        }
+    }
+}
+
+static void serial_write(void)
+{
+    while (tx_start < tx_end) {
+        ssize_t n = write(serial_fd, &tx_buffer[tx_start], tx_end - tx_start);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN) {
+                perror("write");
+                running = 0;
+            }
+            break;
+        }
+        tx_start += n;
+    }
+    if (tx_start == tx_end) {
+        tx_start = tx_end = 0;
+    }
+
+    /*
+     * Back-pressure: stop reading from the host while a full batch doesn't fit,
+     * and let the socket buffer hold the datagrams meanwhile.
+     */
+    bool full = TX_BUFFER_SIZE - (tx_end - tx_start) <
+                BATCH_SIZE * FRAME_ENCODED_MAX(FRAME_SEND_HEADER_SIZE + max_payload);
+    bool pending = tx_start < tx_end;
+    if (full != host_paused) {
+        host_paused = full;
+        epoll_update(host_fd, full ? 0 : EPOLLIN);
+        if (full) {
+            stats.tx_paused++;
+        }
+    }
+    if (pending != tx_waiting) {
+        tx_waiting = pending;
+        epoll_update(serial_fd, pending ? EPOLLIN | EPOLLOUT : EPOLLIN);
+    }
+}
+
+static void host_read(void)
+{
+    while (!host_paused) {
+        /* Not paused, so a full batch fits after moving the unwritten data first */
+        if (tx_start > 0) {
+            memmove(tx_buffer, &tx_buffer[tx_start], tx_end - tx_start);
+            tx_end -= tx_start;
+            tx_start = 0;
+        }
+
+        for (int i = 0; i < BATCH_SIZE; ++i) {
+            in_iovs[i].iov_base = in_buffers[i];
+            in_iovs[i].iov_len = HOST_DATAGRAM_SIZE;
+            memset(&in_msgs[i], 0, sizeof(in_msgs[i]));
+            in_msgs[i].msg_hdr.msg_iov = &in_iovs[i];
+            in_msgs[i].msg_hdr.msg_iovlen = 1;
+            in_msgs[i].msg_hdr.msg_name = &in_addrs[i];
+            in_msgs[i].msg_hdr.msg_namelen = sizeof(in_addrs[i]);
+        }
+
+        int n = recvmmsg(host_fd, in_msgs, BATCH_SIZE, MSG_DONTWAIT, NULL);
+        if (n <= 0) {
+            break;
+        }
+
+        for (int i = 0; i < n; ++i) {
+            uint8_t* datagram = in_buffers[i];
+            size_t len = in_msgs[i].msg_len;
+            if (len < HOST_HEADER_SIZE || len - HOST_HEADER_SIZE > max_payload ||
+                (in_msgs[i].msg_hdr.msg_flags & MSG_TRUNC)) {
+                stats.tx_invalid++;
+                continue;
+            }
+
+            uint8_t header[FRAME_SEND_HEADER_SIZE];
+            header[0] = FRAME_TYPE_SEND;
+            memcpy(&header[1], datagram, HOST_HEADER_SIZE);
+            tx_end += frame_encode(&tx_buffer[tx_end],
+                                   header,
+                                   sizeof(header),
+                                   &datagram[HOST_HEADER_SIZE],
+                                   len - HOST_HEADER_SIZE);
+            reply_route_set(datagram, get_u16(&datagram[16]), &in_addrs[i]);
+            stats.tx_frames++;
+        }
+
+        /* Write the whole batch at once, and pause reading if the port is full */
+        serial_write();
+        if (n < BATCH_SIZE) {
+            break;
+        }
+    }
+}
+
+static speed_t baud_to_speed(long baud)
+{
+    switch (baud) {
+        case 115200: return B115200;
+        case 230400: return B230400;
+        case 460800: return B460800;
+        case 921600: return B921600;
+        case 1000000: return B1000000;
+        default: return B0;
+    }
+}
+
+static int serial_open(const char* path, long baud)
+{
+    int fd = open(path, O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (fd < 0) {
+        perror(path);
+        return -1;
+    }
+
+    struct termios tio;
+    if (tcgetattr(fd, &tio) == 0) {
+        cfmakeraw(&tio);
+        if (baud > 0) {
+            cfsetspeed(&tio, baud_to_speed(baud));
+        }
+        if (tcsetattr(fd, TCSANOW, &tio) < 0) {
+            perror("tcsetattr");
+        }
+    }
+    return fd;
+}
+
+static int host_open(uint16_t port)
+{
+    int fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(port),
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+    };
+    if (fd < 0 || bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        perror("bind");
+        return -1;
+    }
+    return fd;
+}
+
+static void print_stats(void)
+{
+    fprintf(stderr,
+            "gateway: rx frames: %llu invalid: %llu unmapped: %llu "
+            "tx frames: %llu invalid: %llu paused: %llu\n",
+            (unsigned long long)stats.rx_frames,
+            (unsigned long long)stats.rx_invalid,
+            (unsigned long long)stats.rx_unmapped,
+            (unsigned long long)stats.tx_frames,
+            (unsigned long long)stats.tx_invalid,
+            (unsigned long long)stats.tx_paused);
+}
+
+static void stop(int sig)
+{
+    (void)sig;
+    running = 0;
+}
+
+static void usage(const char* name)
+{
+    fprintf(stderr,
+            "Usage: %s [options] <serial port>\n"
+            "  -p <mesh port>:<host port>  Send packets received on the mesh port to\n"
+            "                              127.0.0.1:<host port>, can be repeated\n"
+            "  -i <port>                   Port for packets to send into the mesh\n"
+            "                              (default %d)\n"
+            "  -b <baud rate>              Set the baud rate of a UART\n"
+            "  -m <bytes>                  Longest payload the root accepts (default %d)\n"
+            "  -s <seconds>                Print statistics periodically\n",
+            name,
+            DEFAULT_INJECT_PORT,
+            DEFAULT_MAX_PAYLOAD);
+}
+
+int main(int argc, char** argv)
+{
+    long baud = 0;
+    int inject_port = DEFAULT_INJECT_PORT;
+    int stats_interval = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "p:i:b:m:s:")) != -1) {
+        unsigned mesh_port;
+        unsigned host_port;
+        switch (opt) {
+            case 'p':
+                if (n_port_maps == MAX_PORTS ||
+                    sscanf(optarg, "%u:%u", &mesh_port, &host_port) != 2 || mesh_port > 0xffff ||
+                    host_port > 0xffff) {
+                    usage(argv[0]);
+                    return 1;
+                }
+                port_maps[n_port_maps].mesh_port = mesh_port;
+                port_maps[n_port_maps].host.sin_family = AF_INET;
+                port_maps[n_port_maps].host.sin_port = htons(host_port);
+                port_maps[n_port_maps].host.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+                n_port_maps++;
+                break;
+            case 'i': inject_port = atoi(optarg); break;
+            case 'b':
+                baud = atol(optarg);
+                if (baud_to_speed(baud) == B0) {
+                    fprintf(stderr, "Unsupported baud rate %ld\n", baud);
+                    return 1;
+                }
+                break;
+            case 'm': max_payload = atoi(optarg); break;
+            case 's': stats_interval = atoi(optarg); break;
+            default: usage(argv[0]); return 1;
+        }
+    }
+    if (optind != argc - 1) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    serial_fd = serial_open(argv[optind], baud);
+    host_fd = host_open(inject_port);
+    if (serial_fd < 0 || host_fd < 0) {
+        return 1;
+    }
+
+    epoll_fd = epoll_create1(0);
+    struct epoll_event ev = { .events = EPOLLIN, .data.fd = serial_fd };
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, serial_fd, &ev);
+    ev.data.fd = host_fd;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, host_fd, &ev);
+
+    signal(SIGINT, stop);
+    signal(SIGTERM, stop);
+
+    time_t last_stats = time(NULL);
+    while (running) {
+        struct epoll_event events[4];
+        int n = epoll_wait(epoll_fd, events, 4, 1000);
+        if (n < 0 && errno != EINTR) {
+            perror("epoll_wait");
+            break;
+        }
+
+        for (int i = 0; i < n; ++i) {
+            if (events[i].data.fd == serial_fd) {
+                if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+                    serial_read();
+                }
+                if (events[i].events & EPOLLOUT) {
+                    serial_write();
+                }
+            } else if (events[i].data.fd == host_fd) {
+                host_read();
+            }
+        }
+
+        if (stats_interval > 0 && time(NULL) - last_stats >= stats_interval) {
+            last_stats = time(NULL);
+            print_stats();
+        }
+    }
+
+    print_stats();
+    return 0;
+}
@@ -0,0 +1,285 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 LumenRadio AB
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+/*
+ * Throughput and latency benchmark of the gateway, over a pty instead of a
+ * root node.
+ *
+ * The gateway is started on the pty, and a thread on the other end of it
+ * plays the root: every packet sent into the mesh is sent back as received
+ * from the destination, on the destination port. The benchmark sends
+ * packets to the gateway, with a window of packets in flight, and times each
+ * round trip through the gateway and the pty, both ways.
+ */
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include "frame.h"
+
+#define MESH_PORT 456
+#define MAX_PAYLOAD 256
+#define HOST_HEADER_SIZE 18
+
+static int pty_fd;
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+static void write_all(int fd, const uint8_t* data, size_t len)
+{
+    while (len > 0) {
+        ssize_t n = write(fd, data, len);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return;
+        }
+        data += n;
+        len -= n;
+    }
+}
+
+/* Plays the root, sending every packet back as received from the destination */
+static void* root_thread(void* arg)
+{
+    static uint8_t buffer[65536];
+    static uint8_t out[FRAME_ENCODED_MAX(FRAME_UDP_HEADER_SIZE + MAX_PAYLOAD)];
+    size_t len = 0;
+    (void)arg;
+
+    while (1) {
+        ssize_t n = read(pty_fd, &buffer[len], sizeof(buffer) - len);
+        if (n <= 0) {
+            return NULL;
+        }
+        len += n;
+
+        size_t start = 0;
+        uint8_t* end;
+        while ((end = memchr(&buffer[start], 0, len - start)) != NULL) {
+            uint8_t* frame = &buffer[start];
+            long frame_len = frame_decode(frame, end - frame);
+            start = end - buffer + 1;
+            if (frame_len < FRAME_SEND_HEADER_SIZE || frame[0] != FRAME_TYPE_SEND) {
+                continue;
+            }
+
+            uint8_t header[FRAME_UDP_HEADER_SIZE] = { FRAME_TYPE_UDP };
+            memcpy(&header[1], &frame[1], 18);  /* Address and port */
+            memcpy(&header[19], &frame[17], 2); /* Local port, the same */
+            write_all(pty_fd,
+                      out,
+                      frame_encode(out,
+                                   header,
+                                   sizeof(header),
+                                   &frame[FRAME_SEND_HEADER_SIZE],
+                                   frame_len - FRAME_SEND_HEADER_SIZE));
+        }
+        memmove(buffer, &buffer[start], len - start);
+        len -= start;
+    }
+}
+
+static int udp_open(uint16_t port)
+{
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(port),
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+    };
+    if (fd < 0 || bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        perror("bind");
+        exit(1);
+    }
+    return fd;
+}
+
+static uint16_t udp_port(int fd)
+{
+    struct sockaddr_in addr;
+    socklen_t len = sizeof(addr);
+    getsockname(fd, (struct sockaddr*)&addr, &len);
+    return ntohs(addr.sin_port);
+}
+
+static int compare_u32(const void* a, const void* b)
+{
+    uint32_t x = *(const uint32_t*)a;
+    uint32_t y = *(const uint32_t*)b;
+    return x < y ? -1 : x > y;
+}
+
+int main(int argc, char** argv)
+{
+    const char* gateway = "./gateway";
+    long n_packets = 100000;
+    int payload_size = 64;
+    int window = 32;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "g:n:s:w:")) != -1) {
+        switch (opt) {
+            case 'g': gateway = optarg; break;
+            case 'n': n_packets = atol(optarg); break;
+            case 's': payload_size = atoi(optarg); break;
+            case 'w': window = atoi(optarg); break;
+            default:
+                fprintf(stderr,
+                        "Usage: %s [-g gateway] [-n packets] [-s payload size] [-w window]\n",
+                        argv[0]);
+                return 1;
+        }
+    }
+    if (payload_size < 12 || payload_size > MAX_PAYLOAD || n_packets <= 0 || window <= 0) {
+        fprintf(stderr, "Payload size must be 12 to %d bytes\n", MAX_PAYLOAD);
+        return 1;
+    }
+
+    pty_fd = posix_openpt(O_RDWR | O_NOCTTY);
+    if (pty_fd < 0 || grantpt(pty_fd) < 0 || unlockpt(pty_fd) < 0) {
+        perror("posix_openpt");
+        return 1;
+    }
+    struct termios tio;
+    tcgetattr(pty_fd, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(pty_fd, TCSANOW, &tio);
+
+    /* The host application, and a free port for the gateway */
+    int app_fd = udp_open(0);
+    int probe_fd = udp_open(0);
+    uint16_t gateway_port = udp_port(probe_fd);
+    close(probe_fd);
+
+    char port_map[32];
+    char inject_port[8];
+    snprintf(port_map, sizeof(port_map), "%d:%u", MESH_PORT, udp_port(app_fd));
+    snprintf(inject_port, sizeof(inject_port), "%u", gateway_port);
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        execl(gateway, gateway, "-p", port_map, "-i", inject_port, ptsname(pty_fd), (char*)NULL);
+        perror(gateway);
+        _exit(1);
+    }
+
+    pthread_t thread;
+    pthread_create(&thread, NULL, root_thread, NULL);
+    usleep(200000);
+
+    struct sockaddr_in gateway_addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(gateway_port),
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+    };
+    uint8_t packet[HOST_HEADER_SIZE + MAX_PAYLOAD] = { 0xfd };
+    packet[15] = 1;
+    packet[16] = MESH_PORT & 0xff;
+    packet[17] = MESH_PORT >> 8;
+    memset(&packet[HOST_HEADER_SIZE], 0x55, payload_size);
+
+    uint32_t* latencies = calloc(n_packets, sizeof(uint32_t));
+    long sent = 0;
+    long received = 0;
+    uint64_t start = now_ns();
+
+    while (received < n_packets) {
+        /* Keep the window full */
+        while (sent < n_packets && sent - received < window) {
+            uint64_t t = now_ns();
+            memcpy(&packet[HOST_HEADER_SIZE], &sent, 4);
+            memcpy(&packet[HOST_HEADER_SIZE + 4], &t, 8);
+            sendto(app_fd,
+                   packet,
+                   HOST_HEADER_SIZE + payload_size,
+                   0,
+                   (struct sockaddr*)&gateway_addr,
+                   sizeof(gateway_addr));
+            sent++;
+        }
+
+        struct pollfd pfd = { .fd = app_fd, .events = POLLIN };
+        if (poll(&pfd, 1, 1000) <= 0) {
+            /* Whatever is still in flight is lost */
+            break;
+        }
+
+        uint8_t reply[HOST_HEADER_SIZE + MAX_PAYLOAD];
+        ssize_t n = recv(app_fd, reply, sizeof(reply), 0);
+        if (n != HOST_HEADER_SIZE + payload_size) {
+            continue;
+        }
+        uint64_t t;
+        memcpy(&t, &reply[HOST_HEADER_SIZE + 4], 8);
+        latencies[received++] = (now_ns() - t) / 1000;
+    }
+
+    double seconds = (now_ns() - start) / 1e9;
+    kill(pid, SIGTERM);
+    waitpid(pid, NULL, 0);
+
+    if (received == 0) {
+        fprintf(stderr, "No packets came back\n");
+        return 1;
+    }
+    qsort(latencies, received, sizeof(uint32_t), compare_u32);
+    printf("{\"packets\":%ld,\"received\":%ld,\"payload\":%d,\"window\":%d,\"seconds\":%.3f,"
+           "\"packets_per_s\":%.0f,\"payload_bytes_per_s\":%.0f,"
+           "\"latency_us\":{\"p50\":%u,\"p90\":%u,\"p99\":%u,\"max\":%u}}\n",
+           n_packets,
+           received,
+           payload_size,
+           window,
+           seconds,
+           received / seconds,
+           received * payload_size / seconds,
+           latencies[received / 2],
+           latencies[received * 9 / 10],
+           latencies[received * 99 / 100],
+           latencies[received - 1]);
+    return 0;
+}
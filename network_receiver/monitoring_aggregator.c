@@ -0,0 +1,400 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 LumenRadio AB
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include <mira.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include "mem_watermark.h"
+#include "monitoring.h"
+#include "monitoring_aggregator.h"
+#include "monitoring_config.h"
+#include "monitoring_parser.h"
+#include "monitoring_slot.h"
+#include "node_ids.h"
+
+#define N_MAC_STATS_FIELDS 11
+
+/* Fields with min/max/sum, as MIRA_MON_CONF_MAC_STATS_* bits */
+static const uint8_t tracked_fields[] = {
+    MIRA_MON_CONF_MAC_STATS_TX_DROPPED,
+    MIRA_MON_CONF_MAC_STATS_TX_FAILED,
+    MIRA_MON_CONF_MAC_STATS_RX_MISSED_SLOTS,
+    MIRA_MON_CONF_MAC_STATS_USED_TX_QUEUE,
+};
+#define N_TRACKED_FIELDS (sizeof(tracked_fields) / sizeof(tracked_fields[0]))
+
+typedef struct
+{
+    uint16_t min;
+    uint16_t max;
+    uint32_t sum;
+} field_stats_t;
+
+/*
+ * Latency buckets, in network time ticks. Bucket n holds latencies below
+ * 2 << n ticks, the last one everything above.
+ */
+#define N_LATENCY_BUCKETS 8
+
+typedef struct
+{
+    uint16_t buckets[N_LATENCY_BUCKETS];
+    uint16_t min;
+    uint16_t max;
+    uint32_t sum;
+    uint16_t count;
+    uint16_t rtt; /* Latest round trip time reported by the node */
+} latency_stats_t;
+
+typedef struct
+{
+    uint16_t latest[N_MAC_STATS_FIELDS];
+    uint16_t has_latest; /* Bit per field in latest */
+    uint16_t n_reports;  /* Reports since the last summary */
+    bool used;
+    field_stats_t stats[N_TRACKED_FIELDS];
+    latency_stats_t latency;
+} node_entry_t;
+
+/* Indexed by node ID, see node_ids.h */
+static node_entry_t nodes[MONITORING_AGGREGATOR_MAX_NODES];
+static int n_nodes;
+static uint32_t n_nodes_dropped;
+
+/*
+ * Find the entry of a node, or add it if not found.
+ *
+ * Returns NULL if the node has no ID, or an ID above the max number of nodes.
+ */
+static node_entry_t* aggregator_lookup(const mira_net_address_t* addr)
+{
+    int id = node_ids_intern(addr);
+
+    if (id == NODE_IDS_NONE || id >= MONITORING_AGGREGATOR_MAX_NODES) {
+        return NULL;
+    }
+    if (!nodes[id].used) {
+        nodes[id].used = true;
+        n_nodes++;
+    }
+    return &nodes[id];
+}
+
+static void aggregator_add_mac_stats(node_entry_t* entry, monitoring_reader_t* record)
+{
+    uint32_t fields;
+
+    if (!monitoring_reader_mbi(record, &fields)) {
+        return;
+    }
+
+    for (int field = 0; field < N_MAC_STATS_FIELDS; ++field) {
+        if ((fields & (1 << field)) == 0) {
+            continue;
+        }
+        uint16_t value;
+        if (field == MIRA_MON_CONF_MAC_STATS_USED_TX_QUEUE) {
+            uint8_t byte;
+            if (!monitoring_reader_u8(record, &byte)) {
+                return;
+            }
+            value = byte;
+        } else if (!monitoring_reader_u16(record, &value)) {
+            return;
+        }
+
+        entry->latest[field] = value;
+        entry->has_latest |= 1 << field;
+
+        for (int i = 0; i < N_TRACKED_FIELDS; ++i) {
+            if (tracked_fields[i] != field) {
+                continue;
+            }
+            field_stats_t* stats = &entry->stats[i];
+            if (entry->n_reports == 0 || value < stats->min) {
+                stats->min = value;
+            }
+            if (entry->n_reports == 0 || value > stats->max) {
+                stats->max = value;
+            }
+            stats->sum += value;
+        }
+    }
+}
+
+static void aggregator_add_latency(latency_stats_t* latency, uint32_t ticks)
+{
+    uint16_t value = ticks > UINT16_MAX ? UINT16_MAX : ticks;
+    int bucket = 0;
+    while (bucket < N_LATENCY_BUCKETS - 1 && value >= (2 << bucket)) {
+        bucket++;
+    }
+    if (latency->buckets[bucket] < UINT16_MAX) {
+        latency->buckets[bucket]++;
+    }
+    if (latency->count == 0 || value < latency->min) {
+        latency->min = value;
+    }
+    if (latency->count == 0 || value > latency->max) {
+        latency->max = value;
+    }
+    latency->sum += value;
+    latency->count++;
+}
+
+static void aggregator_add_latency_probe(node_entry_t* entry,
+                                         monitoring_reader_t* record,
+                                         mira_net_udp_connection_t* connection,
+                                         const mira_net_udp_callback_metadata_t* metadata)
+{
+    uint32_t fields;
+    uint8_t seq;
+    uint32_t tx_time;
+    uint32_t now;
+
+    if (!monitoring_reader_mbi(record, &fields) || !monitoring_reader_u8(record, &seq) ||
+        !monitoring_reader_u32(record, &tx_time)) {
+        return;
+    }
+
+    if (fields & (1 << MIRA_MON_CONF_LATENCY_PROBE_ECHO)) {
+        uint8_t echo[2 + 5] = {
+            MIRA_MON_ID_LATENCY_ECHO, 5, seq, tx_time, tx_time >> 8, tx_time >> 16, tx_time >> 24,
+        };
+        /* To the port the nodes listen on, not the port the probe came from */
+        mira_net_udp_send_to(
+          connection, metadata->source_address, MONITOR_UDP_PORT, echo, sizeof(echo));
+    }
+
+    if (mira_net_time_get_time(&now) == MIRA_SUCCESS) {
+        int32_t latency = now - tx_time;
+        aggregator_add_latency(&entry->latency, latency < 0 ? 0 : latency);
+    }
+
+    uint32_t rtt;
+    if ((fields & (1 << MIRA_MON_CONF_LATENCY_PROBE_RTT)) && monitoring_reader_mbi(record, &rtt)) {
+        entry->latency.rtt = rtt > UINT16_MAX ? UINT16_MAX : rtt;
+    }
+}
+
+#if MONITORING_AGGREGATOR_REPORT_SLOTS
+static void aggregator_assign_report_slot(int node,
+                                          mira_net_udp_connection_t* connection,
+                                          const mira_net_udp_callback_metadata_t* metadata)
+{
+    uint16_t slot = monitoring_slot_assign(node);
+    uint8_t assign[2 + 2] = {
+        MIRA_MON_ID_REPORT_SLOT_ASSIGN, 2, slot, slot >> 8,
+    };
+    mira_net_udp_send_to(
+      connection, metadata->source_address, MONITOR_UDP_PORT, assign, sizeof(assign));
+}
+#endif
+
+/*
+ * Upper limit, in network time ticks, of the bucket holding the given
+ * percentile of the latencies since the last summary.
+ */
+static uint32_t aggregator_latency_percentile(const latency_stats_t* latency, int percentile)
+{
+    uint32_t wanted = ((uint32_t)latency->count * percentile + 99) / 100;
+    uint32_t seen = 0;
+    for (int bucket = 0; bucket < N_LATENCY_BUCKETS - 1; ++bucket) {
+        seen += latency->buckets[bucket];
+        if (seen >= wanted) {
+            return 2 << bucket;
+        }
+    }
+    return latency->max;
+}
+
+static void udp_listen_callback(mira_net_udp_connection_t* connection,
+                                const void* data,
+                                uint16_t data_len,
+                                const mira_net_udp_callback_metadata_t* metadata,
+                                void* storage)
+{
+    monitoring_reader_t reader;
+    monitoring_reader_t record;
+    uint32_t id;
+
+    node_entry_t* entry = aggregator_lookup(metadata->source_address);
+    if (entry == NULL) {
+        n_nodes_dropped++;
+        return;
+    }
+
+    bool has_mac_stats = false;
+    int config_version = -1;
+#if MONITORING_AGGREGATOR_REPORT_SLOTS
+    int report_slot = -1;
+#endif
+    monitoring_reader_init(&reader, data, data_len);
+    while (monitoring_reader_record(&reader, &id, &record)) {
+        if (id == MIRA_MON_ID_MAC_STATS) {
+            aggregator_add_mac_stats(entry, &record);
+            has_mac_stats = true;
+        } else if (id == MIRA_MON_ID_LATENCY_PROBE) {
+            aggregator_add_latency_probe(entry, &record, connection, metadata);
+        } else if (id == MIRA_MON_ID_CONFIG_VERSION) {
+            uint8_t version;
+            if (monitoring_reader_u8(&record, &version)) {
+                config_version = version;
+            }
+        }
+#if MONITORING_AGGREGATOR_REPORT_SLOTS
+        else if (id == MIRA_MON_ID_REPORT_SLOT) {
+            uint16_t slot;
+            if (monitoring_reader_u16(&record, &slot)) {
+                report_slot = slot;
+            }
+        }
+#endif
+    }
+
+    if (has_mac_stats) {
+        entry->n_reports++;
+    }
+
+    /* Only the first packet of a report has the MAC statistics and version */
+    if (has_mac_stats || config_version >= 0) {
+        monitoring_config_node_seen(entry - nodes, metadata->source_address, config_version);
+    }
+
+#if MONITORING_AGGREGATOR_REPORT_SLOTS
+    /*
+     * The node has the slot when its reports carry it, resent until they do.
+     * Config acks only carry the config version, and don't tell.
+     */
+    if ((has_mac_stats || report_slot >= 0) &&
+        report_slot != monitoring_slot_assign(entry - nodes)) {
+        aggregator_assign_report_slot(entry - nodes, connection, metadata);
+    }
+#endif
+}
+
+static void aggregator_print_summary(int node, node_entry_t* entry)
+{
+    const mira_net_address_t* addr = node_ids_address(node);
+
+    printf("mon ");
+    for (int i = 8; i < 16; ++i) {
+        printf("%02x", addr->u8[i]);
+    }
+    printf(" %u", entry->n_reports);
+    for (int field = 0; field < N_MAC_STATS_FIELDS; ++field) {
+        if (entry->has_latest & (1 << field)) {
+            printf(" %u", entry->latest[field]);
+        } else {
+            printf(" -1");
+        }
+    }
+    for (int i = 0; i < N_TRACKED_FIELDS; ++i) {
+        printf(" %u %u %lu",
+               entry->stats[i].min,
+               entry->stats[i].max,
+               (unsigned long)entry->stats[i].sum);
+    }
+    if (entry->latency.count > 0) {
+        printf(" %u %u %u %lu %lu %lu %lu %u",
+               entry->latency.count,
+               entry->latency.min,
+               entry->latency.max,
+               (unsigned long)entry->latency.sum,
+               (unsigned long)aggregator_latency_percentile(&entry->latency, 50),
+               (unsigned long)aggregator_latency_percentile(&entry->latency, 90),
+               (unsigned long)aggregator_latency_percentile(&entry->latency, 99),
+               entry->latency.rtt);
+    }
+    printf("\n");
+}
+
+int monitoring_aggregator_n_nodes(void)
+{
+    return n_nodes;
+}
+
+bool monitoring_aggregator_node_address(int node, mira_net_address_t* addr)
+{
+    if (node < 0 || node >= MONITORING_AGGREGATOR_MAX_NODES || !nodes[node].used) {
+        return false;
+    }
+    memcpy(addr, node_ids_address(node), sizeof(*addr));
+    return true;
+}
+
+PROCESS(monitoring_aggregator_proc, "Monitoring aggregator");
+
+void monitoring_aggregator_init(void)
+{
+    process_start(&monitoring_aggregator_proc, NULL);
+}
+
+PROCESS_THREAD(monitoring_aggregator_proc, ev, data)
+{
+    static struct etimer timer;
+    static int idx;
+
+    PROCESS_BEGIN();
+    /* Pause once, so we don't run anything before finish of startup */
+    PROCESS_PAUSE();
+
+    mira_net_udp_listen(MONITOR_UDP_PORT, udp_listen_callback, NULL);
+
+    etimer_set(&timer, MONITORING_AGGREGATOR_SUMMARY_INTERVAL * CLOCK_SECOND);
+    while (1) {
+        PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&timer));
+        etimer_reset(&timer);
+
+        printf("mon-summary nodes: %d dropped: %lu stack: %lu/%lu heap: %lu\n",
+               n_nodes,
+               (unsigned long)n_nodes_dropped,
+               (unsigned long)mem_watermark_stack_peak(),
+               (unsigned long)mem_watermark_stack_size(),
+               (unsigned long)mem_watermark_heap_peak());
+        for (idx = 0; idx < MONITORING_AGGREGATOR_MAX_NODES; ++idx) {
+            node_entry_t* entry = &nodes[idx];
+            if (!entry->used || (entry->n_reports == 0 && entry->latency.count == 0)) {
+                continue;
+            }
+            aggregator_print_summary(idx, entry);
+            entry->n_reports = 0;
+            memset(entry->stats, 0, sizeof(entry->stats));
+            uint16_t rtt = entry->latency.rtt;
+            memset(&entry->latency, 0, sizeof(entry->latency));
+            entry->latency.rtt = rtt;
+
+            /* Let other processes run while the summary is printed */
+            if ((idx % 16) == 15) {
+                PROCESS_PAUSE();
+            }
+        }
+    }
+
+    PROCESS_END();
+}
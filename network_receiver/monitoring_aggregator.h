@@ -0,0 +1,91 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 LumenRadio AB
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#ifndef MONITORING_AGGREGATOR_H
+#define MONITORING_AGGREGATOR_H
+
+#include <mira.h>
+#include <stdbool.h>
+#include "node_ids.h"
+
+/*
+ * Collects the monitoring reports sent to the root, see monitoring.h in the
+ * monitoring example, and sends summaries to the host instead of every report.
+ *
+ * Per node, the latest MAC statistics are kept, together with min/max/sum of
+ * a few of the fields since the last summary. Only nodes that have reported
+ * since the last summary are included in the next one.
+ *
+ * Summary format, one line per node:
+ * mon <interface identifier> <reports> <latest field 0..10>
+ *     <min max sum of tx_dropped, tx_failed, rx_missed_slots, used_tx_queue>
+ *     [<latency count> <min> <max> <sum> <p50> <p90> <p99> <round trip time>]
+ *
+ * Latest fields that never have been reported are printed as -1.
+ *
+ * The latency fields are only printed if the node has sent latency probes
+ * since the last summary. Latencies are in network time ticks (10ms). The
+ * percentiles are upper limits of power of two buckets, so p50 of 8 means
+ * half of the latencies were below 80ms.
+ */
+
+/*
+ * Max number of nodes to keep track of. Nodes are kept by node ID, see
+ * node_ids.h, so only nodes with IDs below this are tracked.
+ */
+#ifndef MONITORING_AGGREGATOR_MAX_NODES
+#define MONITORING_AGGREGATOR_MAX_NODES NODE_IDS_MAX_NODES
+#endif
+
+/*
+ * Assign each node a report slot from its node ID, see monitoring_slot.h in
+ * the monitoring example. A node whose report doesn't carry its slot is sent
+ * it. Set to 0 to leave the nodes with their hashed slots.
+ */
+#ifndef MONITORING_AGGREGATOR_REPORT_SLOTS
+#define MONITORING_AGGREGATOR_REPORT_SLOTS 1
+#endif
+
+/* How often, in seconds, summaries are sent to the host */
+#ifndef MONITORING_AGGREGATOR_SUMMARY_INTERVAL
+#define MONITORING_AGGREGATOR_SUMMARY_INTERVAL 60
+#endif
+
+void monitoring_aggregator_init(void);
+
+/* Number of nodes that have sent reports */
+int monitoring_aggregator_n_nodes(void);
+
+/*
+ * Get the address of the node with the given node ID, 0 up to
+ * MONITORING_AGGREGATOR_MAX_NODES.
+ *
+ * Returns false if there's no node with that index.
+ */
+bool monitoring_aggregator_node_address(int node, mira_net_address_t* addr);
+
+#endif
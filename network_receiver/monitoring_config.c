@@ -0,0 +1,216 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 LumenRadio AB
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+#include <mira.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include "monitoring.h"
+#include "monitoring_aggregator.h"
+#include "monitoring_config.h"
+
+#define N_NODES MONITORING_AGGREGATOR_MAX_NODES
+
+static mira_net_udp_connection_t* config_connection;
+
+/* The MIRA_MON_ID_CONFIG record, as sent */
+static uint8_t config_packet[2 + 1 + MONITORING_CONFIG_MAX_LEN];
+static int config_packet_len;
+static uint8_t config_version;
+
+/* Bit per node ID, set when the node has the current version */
+static uint8_t acked[(N_NODES + 7) / 8];
+static int n_acked;
+
+static bool active;
+static bool pushed;
+static clock_time_t push_time;
+
+PROCESS(monitoring_config_proc, "Monitoring config");
+
+static bool is_acked(int node)
+{
+    return (acked[node / 8] & (1 << (node % 8))) != 0;
+}
+
+static uint32_t seconds_since_push(void)
+{
+    return (clock_time() - push_time) / CLOCK_SECOND;
+}
+
+static void print_progress(void)
+{
+    monitoring_config_progress_t progress;
+    monitoring_config_get_progress(&progress);
+    if (progress.active) {
+        printf("mon-config version: %u acked: %d/%d time: %lu\n",
+               progress.version,
+               progress.n_acked,
+               progress.n_nodes,
+               (unsigned long)progress.seconds);
+    } else {
+        printf("mon-config done version: %u nodes: %d time: %lu\n",
+               progress.version,
+               progress.n_acked,
+               (unsigned long)progress.seconds);
+    }
+}
+
+static void send_config(const mira_net_address_t* addr)
+{
+    mira_net_udp_send_to(
+      config_connection, addr, MONITOR_UDP_PORT, config_packet, config_packet_len);
+}
+
+void monitoring_config_init(void)
+{
+    process_start(&monitoring_config_proc, NULL);
+}
+
+bool monitoring_config_push(const uint8_t* config, int len)
+{
+    if (len > MONITORING_CONFIG_MAX_LEN) {
+        return false;
+    }
+
+    /* Version 0 means not configured */
+    config_version++;
+    if (config_version == 0) {
+        config_version = 1;
+    }
+
+    config_packet[0] = MIRA_MON_ID_CONFIG;
+    config_packet[1] = 1 + len;
+    config_packet[2] = config_version;
+    memcpy(&config_packet[3], config, len);
+    config_packet_len = 3 + len;
+
+    memset(acked, 0, sizeof(acked));
+    n_acked = 0;
+    push_time = clock_time();
+    active = true;
+    pushed = true;
+
+    process_poll(&monitoring_config_proc);
+    return true;
+}
+
+void monitoring_config_get_progress(monitoring_config_progress_t* progress)
+{
+    progress->version = config_version;
+    progress->active = active;
+    progress->n_acked = n_acked;
+    progress->n_nodes = monitoring_aggregator_n_nodes();
+    progress->seconds = seconds_since_push();
+}
+
+void monitoring_config_node_seen(int node, const mira_net_address_t* addr, int version)
+{
+    if (config_version == 0 || node < 0 || node >= N_NODES) {
+        return;
+    }
+
+    if (version == config_version) {
+        if (!is_acked(node)) {
+            acked[node / 8] |= 1 << (node % 8);
+            n_acked++;
+            if (active && n_acked >= monitoring_aggregator_n_nodes()) {
+                active = false;
+                print_progress();
+            }
+        }
+    } else {
+        /* A new node, or one that lost the config in a reboot, is retried */
+        if (is_acked(node)) {
+            acked[node / 8] &= ~(1 << (node % 8));
+            n_acked--;
+        }
+        if (!active) {
+            active = true;
+            process_poll(&monitoring_config_proc);
+        }
+    }
+}
+
+PROCESS_THREAD(monitoring_config_proc, ev, data)
+{
+    static struct etimer timer;
+    static int round;
+    static int node;
+    static int sent;
+
+    PROCESS_BEGIN();
+
+    config_connection = mira_net_udp_connect(NULL, MONITOR_UDP_PORT, NULL, NULL);
+
+    while (1) {
+        /* The poll may already have been taken by a wait below */
+        if (!pushed && !active) {
+            PROCESS_WAIT_EVENT_UNTIL(pushed || active);
+        }
+        round = 0;
+
+        if (pushed) {
+            pushed = false;
+#if MONITORING_CONFIG_MULTICAST
+            mira_net_address_t multicast_addr;
+            if (mira_net_toolkit_parse_address(&multicast_addr,
+                                               MONITORING_CONFIG_MULTICAST_ADDR) == MIRA_SUCCESS) {
+                send_config(&multicast_addr);
+            }
+            round = 1;
+#endif
+        }
+
+        /* Retry rounds over all known nodes, until all have acknowledged */
+        while (active && !pushed) {
+            if (round > 0) {
+                etimer_set(&timer, MONITORING_CONFIG_RETRY_DELAY * CLOCK_SECOND);
+                PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&timer) || pushed);
+                if (pushed || !active) {
+                    break;
+                }
+                print_progress();
+            }
+            round++;
+
+            sent = 0;
+            for (node = 0; active && !pushed && node < N_NODES; ++node) {
+                mira_net_address_t addr;
+                if (is_acked(node) || !monitoring_aggregator_node_address(node, &addr)) {
+                    continue;
+                }
+                send_config(&addr);
+                if (++sent % MONITORING_CONFIG_RETRY_RATE == 0) {
+                    etimer_set(&timer, CLOCK_SECOND);
+                    PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&timer) || pushed);
+                }
+            }
+        }
+    }
+
+    PROCESS_END();
+}
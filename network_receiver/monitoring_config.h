@@ -0,0 +1,104 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 LumenRadio AB
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+#ifndef MONITORING_CONFIG_H
+#define MONITORING_CONFIG_H
+
+#include <mira.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Distributes a MIRA_MON_ID_CONFIG to all nodes known by the monitoring
+ * aggregator, see monitoring.h in the monitoring example.
+ *
+ * The config is first sent once by multicast. Nodes acknowledge it by sending
+ * their new config version, and the acknowledged nodes are tracked in a
+ * bitmap. After MONITORING_CONFIG_RETRY_DELAY seconds, the nodes that haven't
+ * acknowledged are sent the config by unicast, a few at a time, until all
+ * nodes have it. A node that reports an old version after acknowledging, as
+ * after a reboot, is no longer counted as acknowledged and is retried too.
+ *
+ * Progress is printed as:
+ * mon-config version: <version> acked: <nodes>/<known nodes> time: <seconds>
+ * and when all known nodes have acknowledged:
+ * mon-config done version: <version> nodes: <nodes> time: <seconds>
+ */
+
+/* Address the config is multicast to */
+#ifndef MONITORING_CONFIG_MULTICAST_ADDR
+#define MONITORING_CONFIG_MULTICAST_ADDR "ff03::1"
+#endif
+
+/* Set to 0 to only use unicast, for comparison */
+#ifndef MONITORING_CONFIG_MULTICAST
+#define MONITORING_CONFIG_MULTICAST 1
+#endif
+
+/* Seconds from a multicast, or a round of retries, until the next round */
+#ifndef MONITORING_CONFIG_RETRY_DELAY
+#define MONITORING_CONFIG_RETRY_DELAY 30
+#endif
+
+/* Max number of unicast retries sent per second */
+#ifndef MONITORING_CONFIG_RETRY_RATE
+#define MONITORING_CONFIG_RETRY_RATE 4
+#endif
+
+/* Longest config, excluding the version */
+#define MONITORING_CONFIG_MAX_LEN 32
+
+typedef struct
+{
+    uint8_t version;
+    bool active; /* False when all known nodes have acknowledged */
+    int n_acked;
+    int n_nodes;
+    uint32_t seconds; /* Since the config was pushed */
+} monitoring_config_progress_t;
+
+void monitoring_config_init(void);
+
+/*
+ * Send a new config to all nodes.
+ *
+ * The config is the MIRA_MON_ID_CONFIG data after the config version, which
+ * is assigned here. It should enable MIRA_MON_CONF_CONFIG_VERSION, so nodes
+ * keep sending their version in the reports.
+ *
+ * Returns false if the config is too long.
+ */
+bool monitoring_config_push(const uint8_t* config, int len);
+
+void monitoring_config_get_progress(monitoring_config_progress_t* progress);
+
+/*
+ * Called by the aggregator for each report from a node. The version is -1
+ * if the report has no config version.
+ */
+void monitoring_config_node_seen(int node, const mira_net_address_t* addr, int version);
+
+#endif
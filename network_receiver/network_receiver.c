@@ -28,9 +28,95 @@
 #include <mira.h>
 #include <stdint.h>
 #include <stdio.h>
+#include "coalescer.h"
+#include "compact_decode.h"
+#include "frame_input.h"
+#include "frame_output.h"
+#include "mem_watermark.h"
+#include "monitoring.h"
+#include "monitoring_aggregator.h"
+#include "monitoring_config.h"
+#include "seq_header.h"
+#include "seq_track.h"
+#include "sensor_schema.h"
 
 #define UDP_PORT 456
 
+/* Size of the memory buffer given to Mira */
+#ifndef MIRA_MEM_BUFFER_SIZE
+#define MIRA_MEM_BUFFER_SIZE 14944
+#endif
+
+/* UART baud rate, higher rates are needed for high packet rates */
+#ifndef UART_BAUDRATE
+#define UART_BAUDRATE 115200
+#endif
+
+/*
+ * Write received packets as binary frames, see frame_output.h, instead of as
+ * text. 0 to print as text.
+ */
+#ifndef BINARY_OUTPUT
+#define BINARY_OUTPUT 0
+#endif
+
+/* Write the binary frames to USB, on targets with USB, and text to the UART */
+#ifndef BINARY_OUTPUT_USB
+#define BINARY_OUTPUT_USB 0
+#endif
+
+/*
+ * Write this many packets of OUTPUT_BENCHMARK_SIZE bytes as text, and then
+ * as binary frames, at start, and print the time each took. 0 to disable.
+ */
+#ifndef OUTPUT_BENCHMARK
+#define OUTPUT_BENCHMARK 0
+#endif
+
+#ifndef OUTPUT_BENCHMARK_SIZE
+#define OUTPUT_BENCHMARK_SIZE 64
+#endif
+
+/*
+ * Collect the monitoring reports from the nodes, and distribute configs to
+ * them, see monitoring_aggregator.h. Takes 88 bytes of RAM per node, and the
+ * node IDs. 0 to leave out.
+ */
+#ifndef MONITORING_AGGREGATOR
+#define MONITORING_AGGREGATOR 0
+#endif
+
+/*
+ * Receive the sequence numbered packets, drop the duplicated ones, and count
+ * the lost ones, see seq_track.h. Takes 24 bytes of RAM per node, and the
+ * node IDs. 0 to leave out.
+ */
+#ifndef SEQ_TRACK
+#define SEQ_TRACK 0
+#endif
+
+/* Decode the compact sensor messages, see compact_decode.h. 0 to leave out. */
+#ifndef SENSOR_INPUT
+#define SENSOR_INPUT 0
+#endif
+
+/* Unpack the datagrams of the coalescer, see coalescer.h. 0 to leave out. */
+#ifndef COALESCED_INPUT
+#define COALESCED_INPUT 0
+#endif
+
+/*
+ * Seconds after start until a monitoring config is pushed to all nodes, to
+ * measure the time until all nodes have it. 0 to disable.
+ */
+#ifndef MONITORING_CONFIG_PUSH_DELAY
+#define MONITORING_CONFIG_PUSH_DELAY 0
+#endif
+
+#if MONITORING_CONFIG_PUSH_DELAY > 0 && !MONITORING_AGGREGATOR
+#error "MONITORING_CONFIG_PUSH_DELAY requires MONITORING_AGGREGATOR"
+#endif
+
 /*
  * Identifies as a root.
  * Retrieves data from the nodes.
@@ -64,11 +150,39 @@ static const mira_net_config_t net_config = {
     .prefix = NULL /* default prefix */
 };
 
+#if BINARY_OUTPUT_USB
+MIRA_IODEFS(MIRA_IODEF_NONE,    /* fd 0: stdin */
+            MIRA_IODEF_UART(0), /* fd 1: stdout */
+            MIRA_IODEF_NONE,    /* fd 2: stderr */
+            MIRA_IODEF_USB      /* fd 3: binary frames, FRAME_OUTPUT_FD */
+);
+
+/* The name of the USB device: */
+uint8_t mira_usb_product_name[] = "MIRA-NETWORK-RECEIVER";
+#else
 MIRA_IODEFS(MIRA_IODEF_NONE,    /* fd 0: stdin */
             MIRA_IODEF_UART(0), /* fd 1: stdout */
             MIRA_IODEF_NONE     /* fd 2: stderr */
                                 /* More file descriptors can be added, for use with dprintf(); */
 );
+#endif
+
+static void print_packet(const mira_net_address_t* source,
+                         uint16_t source_port,
+                         const void* data,
+                         uint16_t data_len)
+{
+    char buffer[MIRA_NET_MAX_ADDRESS_STR_LEN];
+    uint16_t i;
+
+    printf("Received message from [%s]:%u: ",
+           mira_net_toolkit_format_address(buffer, source),
+           source_port);
+    for (i = 0; i < data_len; i++) {
+        printf("%c", ((char*)data)[i]);
+    }
+    printf("\n");
+}
 
 static void udp_listen_callback(mira_net_udp_connection_t* connection,
                                 const void* data,
@@ -76,25 +190,197 @@ static void udp_listen_callback(mira_net_udp_connection_t* connection,
                                 const mira_net_udp_callback_metadata_t* metadata,
                                 void* storage)
 {
+#if BINARY_OUTPUT
+    frame_output_udp(metadata->source_address, metadata->source_port, UDP_PORT, data, data_len);
+#else
+    print_packet(metadata->source_address, metadata->source_port, data, data_len);
+#endif
+}
+
+#if COALESCED_INPUT
+static void print_record(const uint8_t* record, uint16_t len, void* storage)
+{
+    const mira_net_udp_callback_metadata_t* metadata = storage;
+#if BINARY_OUTPUT
+    frame_output_udp(
+      metadata->source_address, metadata->source_port, COALESCER_UDP_PORT, record, len);
+#else
     char buffer[MIRA_NET_MAX_ADDRESS_STR_LEN];
     uint16_t i;
 
-    printf("Received message from [%s]:%u: ",
-           mira_net_toolkit_format_address(buffer, metadata->source_address),
-           metadata->source_port);
-    for (i = 0; i < data_len; i++) {
-        printf("%c", ((char*)data)[i]);
+    printf("Received record from [%s]: ",
+           mira_net_toolkit_format_address(buffer, metadata->source_address));
+    for (i = 0; i < len; i++) {
+        printf("%02x", record[i]);
+    }
+    printf("\n");
+#endif
+}
+
+/* Datagrams packed by the coalescer in the network_sender example */
+static void coalesced_listen_callback(mira_net_udp_connection_t* connection,
+                                      const void* data,
+                                      uint16_t data_len,
+                                      const mira_net_udp_callback_metadata_t* metadata,
+                                      void* storage)
+{
+    if (coalescer_unpack(data, data_len, print_record, (void*)metadata) < 0) {
+        char buffer[MIRA_NET_MAX_ADDRESS_STR_LEN];
+        printf("Malformed datagram from [%s]\n",
+               mira_net_toolkit_format_address(buffer, metadata->source_address));
+    }
+}
+#endif
+
+#if SEQ_TRACK
+/* Sequence numbered packets, after duplicates are dropped */
+static void print_seq_packet(const mira_net_address_t* source,
+                             uint16_t source_port,
+                             uint16_t seq,
+                             const uint8_t* payload,
+                             uint16_t len)
+{
+#if BINARY_OUTPUT
+    frame_output_udp(source, source_port, SEQ_HEADER_UDP_PORT, payload, len);
+#else
+    char buffer[MIRA_NET_MAX_ADDRESS_STR_LEN];
+    uint16_t i;
+
+    printf("Received message %u from [%s]:%u: ",
+           seq,
+           mira_net_toolkit_format_address(buffer, source),
+           source_port);
+    for (i = 0; i < len; i++) {
+        printf("%c", payload[i]);
+    }
+    printf("\n");
+#endif
+}
+
+static void seq_listen_callback(mira_net_udp_connection_t* connection,
+                                const void* data,
+                                uint16_t data_len,
+                                const mira_net_udp_callback_metadata_t* metadata,
+                                void* storage)
+{
+    seq_track_input(metadata->source_address, metadata->source_port, data, data_len);
+}
+#endif
+
+#if SENSOR_INPUT
+static const compact_field_t environment_fields[] = { SENSOR_ENVIRONMENT_FIELDS(COMPACT_FIELD) };
+
+static const compact_schema_t sensor_schemas[] = {
+    { SENSOR_SCHEMA_ENVIRONMENT, "environment", environment_fields, SENSOR_ENVIRONMENT_N_FIELDS },
+};
+
+/* Compact sensor messages, see compact.h in the network_sender example */
+static void sensor_listen_callback(mira_net_udp_connection_t* connection,
+                                   const void* data,
+                                   uint16_t data_len,
+                                   const mira_net_udp_callback_metadata_t* metadata,
+                                   void* storage)
+{
+#if BINARY_OUTPUT
+    frame_output_udp(
+      metadata->source_address, metadata->source_port, SENSOR_UDP_PORT, data, data_len);
+#else
+    static compact_message_t message;
+    char buffer[MIRA_NET_MAX_ADDRESS_STR_LEN];
+    char value[16];
+
+    if (!compact_decode(sensor_schemas,
+                        sizeof(sensor_schemas) / sizeof(sensor_schemas[0]),
+                        data,
+                        data_len,
+                        &message)) {
+        printf("Malformed sensor message from [%s]\n",
+               mira_net_toolkit_format_address(buffer, metadata->source_address));
+        return;
+    }
+
+    printf("Received %s message from [%s]:",
+           message.schema->name,
+           mira_net_toolkit_format_address(buffer, metadata->source_address));
+    for (int field = 0; field < message.schema->n_fields; ++field) {
+        if (message.fields & (1UL << field)) {
+            compact_format(&message, field, value, sizeof(value));
+            printf(" %s=%s", message.schema->fields[field].name, value);
+        }
     }
     printf("\n");
+#endif
+}
+#endif
+
+#if BINARY_OUTPUT
+/* Frames from the host, with packets to send into the network */
+static int serial_input_byte(unsigned char c, void* storage)
+{
+    frame_input_byte(c);
+    return 0;
+}
+#endif
+
+#if OUTPUT_BENCHMARK > 0
+PROCESS(output_benchmark_proc, "Output benchmark");
+
+PROCESS_THREAD(output_benchmark_proc, ev, data)
+{
+    static uint8_t payload[OUTPUT_BENCHMARK_SIZE];
+    static mira_net_address_t address;
+    static clock_time_t start;
+    static clock_time_t text_time;
+    static uint32_t i;
+
+    PROCESS_BEGIN();
+
+    mira_net_get_address(&address);
+    for (i = 0; i < sizeof(payload); ++i) {
+        payload[i] = 'a' + i % 26;
+    }
+
+    /* The text output waits for the UART in printf */
+    start = clock_time();
+    for (i = 0; i < OUTPUT_BENCHMARK; ++i) {
+        print_packet(&address, UDP_PORT, payload, sizeof(payload));
+    }
+    text_time = clock_time() - start;
+
+    /* The binary output is timed until all frames are written */
+    start = clock_time();
+    for (i = 0; i < OUTPUT_BENCHMARK; ++i) {
+        while (!frame_output_has_room(sizeof(payload))) {
+            PROCESS_PAUSE();
+        }
+        frame_output_udp(&address, UDP_PORT, UDP_PORT, payload, sizeof(payload));
+    }
+    while (frame_output_pending() > 0) {
+        PROCESS_PAUSE();
+    }
+
+    printf("Output benchmark: packets: %d size: %d text: %lu ms binary: %lu ms\n",
+           OUTPUT_BENCHMARK,
+           OUTPUT_BENCHMARK_SIZE,
+           (unsigned long)(text_time * 1000UL / CLOCK_SECOND),
+           (unsigned long)((clock_time() - start) * 1000UL / CLOCK_SECOND));
+
+    PROCESS_END();
 }
+#endif
 
 PROCESS(main_proc, "Main process");
 
 void mira_setup(void)
 {
     mira_status_t uart_ret;
+
+#if MONITORING_AGGREGATOR
+    /* For the high-water marks in the summaries */
+    mem_watermark_init();
+#endif
     mira_uart_config_t uart_config = {
-        .baudrate = 115200,
+        .baudrate = UART_BAUDRATE,
 #if MIRA_PLATFORM_MKW41Z
         .tx_pin = MIRA_GPIO_PIN('C', 7),
         .rx_pin = MIRA_GPIO_PIN('C', 6)
@@ -104,18 +390,40 @@ void mira_setup(void)
 #endif
     };
 
-    MIRA_MEM_SET_BUFFER(14944);
+    MIRA_MEM_SET_BUFFER(MIRA_MEM_BUFFER_SIZE);
 
     uart_ret = mira_uart_init(0, &uart_config);
     if (uart_ret != MIRA_SUCCESS) {
         /* Nowhere to send an error message */
     }
 
+#if BINARY_OUTPUT_USB
+    mira_usb_config_t usb_config = {
+        .vendor_id = 0x1915,  // Nordic Semiconductor's
+        .product_id = 0x520f, // Product ID from Nordic's SDK example
+    };
+
+    if (mira_usb_uart_init(&usb_config) != MIRA_SUCCESS) {
+        printf("mira_usb_init failed\n");
+    }
+#endif
+
     process_start(&main_proc, NULL);
 }
 
 PROCESS_THREAD(main_proc, ev, data)
 {
+#if MONITORING_CONFIG_PUSH_DELAY > 0
+    static struct etimer timer;
+    /* Send MAC statistics and the config version every minute */
+    static const uint8_t config[] = {
+        1,
+        (1 << MIRA_MON_CONF_MAC_STATS) | (1 << MIRA_MON_CONF_CONFIG_VERSION),
+        0x8f,
+        0x7f,
+    };
+#endif
+
     PROCESS_BEGIN();
     /* Pause once, so we don't run anything before finish of startup. */
     PROCESS_PAUSE();
@@ -129,8 +437,46 @@ PROCESS_THREAD(main_proc, ev, data)
             ;
     }
 
+#if BINARY_OUTPUT || OUTPUT_BENCHMARK > 0
+    frame_output_init();
+#endif
+#if BINARY_OUTPUT
+    frame_input_init();
+#if BINARY_OUTPUT_USB
+    mira_usb_uart_set_input_callback(serial_input_byte, NULL);
+#else
+    mira_uart_set_input_callback(0, serial_input_byte, NULL);
+#endif
+#endif
+
     /* Start listening for connections on the given UDP Port. */
     mira_net_udp_listen(UDP_PORT, udp_listen_callback, NULL);
+#if COALESCED_INPUT
+    mira_net_udp_listen(COALESCER_UDP_PORT, coalesced_listen_callback, NULL);
+#endif
+#if SEQ_TRACK
+    seq_track_init(print_seq_packet);
+    mira_net_udp_listen(SEQ_HEADER_UDP_PORT, seq_listen_callback, NULL);
+#endif
+#if SENSOR_INPUT
+    mira_net_udp_listen(SENSOR_UDP_PORT, sensor_listen_callback, NULL);
+#endif
+
+#if MONITORING_AGGREGATOR
+    /* Collect monitoring reports from the nodes running the monitoring example */
+    monitoring_aggregator_init();
+    monitoring_config_init();
+#endif
+
+#if OUTPUT_BENCHMARK > 0
+    process_start(&output_benchmark_proc, NULL);
+#endif
+
+#if MONITORING_CONFIG_PUSH_DELAY > 0
+    etimer_set(&timer, MONITORING_CONFIG_PUSH_DELAY * CLOCK_SECOND);
+    PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&timer));
+    monitoring_config_push(config, sizeof(config));
+#endif
 
     PROCESS_END();
 }
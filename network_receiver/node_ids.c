@@ -0,0 +1,126 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 LumenRadio AB
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+#include <mira.h>
+#include <string.h>
+#include "node_ids.h"
+
+#if (NODE_IDS_TABLE_SIZE & (NODE_IDS_TABLE_SIZE - 1)) != 0 || NODE_IDS_TABLE_SIZE > 32768
+#error "NODE_IDS_TABLE_SIZE must be a power of two, at most 32768"
+#endif
+
+#if NODE_IDS_TABLE_SIZE < NODE_IDS_MAX_NODES + 1
+#error "NODE_IDS_TABLE_SIZE must be larger than NODE_IDS_MAX_NODES"
+#endif
+
+#define TABLE_MASK (NODE_IDS_TABLE_SIZE - 1)
+
+typedef struct
+{
+    uint16_t id_plus_one; /* 0 for an empty slot */
+    uint16_t tag;         /* Upper 16 bits of the address hash */
+} slot_t;
+
+static slot_t slots[NODE_IDS_TABLE_SIZE];
+static mira_net_address_t addresses[NODE_IDS_MAX_NODES];
+static int n_ids;
+
+static uint32_t node_ids_hash(const mira_net_address_t* addr)
+{
+    uint32_t words[4];
+    uint32_t hash;
+
+    /* The prefix is usually the same for all nodes, but cheap to include */
+    memcpy(words, addr->u8, sizeof(words));
+    hash = (words[0] ^ words[1]) * 0x9e3779b1u;
+    hash = (hash ^ words[2]) * 0x85ebca6bu;
+    hash = (hash ^ words[3]) * 0xc2b2ae35u;
+    return hash ^ (hash >> 15);
+}
+
+/*
+ * Find the slot of a node, or the empty slot where it would be added.
+ *
+ * The table never fills up, as it's larger than NODE_IDS_MAX_NODES, so the
+ * probing always ends.
+ */
+static slot_t* node_ids_find(const mira_net_address_t* addr, uint16_t* tag)
+{
+    uint32_t hash = node_ids_hash(addr);
+    uint32_t idx = hash & TABLE_MASK;
+
+    *tag = hash >> 16;
+    while (1) {
+        slot_t* slot = &slots[idx];
+        if (slot->id_plus_one == 0) {
+            return slot;
+        }
+        if (slot->tag == *tag &&
+            memcmp(&addresses[slot->id_plus_one - 1], addr, sizeof(*addr)) == 0) {
+            return slot;
+        }
+        idx = (idx + 1) & TABLE_MASK;
+    }
+}
+
+int node_ids_intern(const mira_net_address_t* addr)
+{
+    uint16_t tag;
+    slot_t* slot = node_ids_find(addr, &tag);
+
+    if (slot->id_plus_one != 0) {
+        return slot->id_plus_one - 1;
+    }
+    if (n_ids >= NODE_IDS_MAX_NODES) {
+        return NODE_IDS_NONE;
+    }
+
+    memcpy(&addresses[n_ids], addr, sizeof(*addr));
+    slot->tag = tag;
+    slot->id_plus_one = ++n_ids;
+    return n_ids - 1;
+}
+
+int node_ids_lookup(const mira_net_address_t* addr)
+{
+    uint16_t tag;
+    slot_t* slot = node_ids_find(addr, &tag);
+
+    return slot->id_plus_one != 0 ? slot->id_plus_one - 1 : NODE_IDS_NONE;
+}
+
+const mira_net_address_t* node_ids_address(int id)
+{
+    if (id < 0 || id >= n_ids) {
+        return NULL;
+    }
+    return &addresses[id];
+}
+
+int node_ids_count(void)
+{
+    return n_ids;
+}
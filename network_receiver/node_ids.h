@@ -0,0 +1,83 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 LumenRadio AB
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+#ifndef NODE_IDS_H
+#define NODE_IDS_H
+
+#include <mira.h>
+#include <stdint.h>
+
+/*
+ * Maps node addresses to small node IDs, 0 up to NODE_IDS_MAX_NODES, given
+ * in the order the nodes are first seen. Per node state can then be kept in
+ * flat arrays indexed by node ID, instead of each module keeping its own
+ * table of 16 byte addresses.
+ *
+ * The IDs are found through an open addressing hash table of
+ * NODE_IDS_TABLE_SIZE slots, with linear probing. Each slot holds the node
+ * ID and 16 bits of the address hash, so most probes that don't match are
+ * skipped without comparing addresses. Nodes are never removed, so a node
+ * keeps its ID until restart.
+ *
+ * RAM use is 16 bytes per node, for the addresses, and 4 bytes per slot.
+ */
+
+#ifndef NODE_IDS_MAX_NODES
+#define NODE_IDS_MAX_NODES 250
+#endif
+
+/* Smallest power of two keeping the table at most 80% full */
+#ifndef NODE_IDS_TABLE_SIZE
+#define NODE_IDS_TABLE_SIZE                      \
+    (NODE_IDS_MAX_NODES * 5 / 4 <= 64     ? 64   \
+     : NODE_IDS_MAX_NODES * 5 / 4 <= 128  ? 128  \
+     : NODE_IDS_MAX_NODES * 5 / 4 <= 256  ? 256  \
+     : NODE_IDS_MAX_NODES * 5 / 4 <= 512  ? 512  \
+     : NODE_IDS_MAX_NODES * 5 / 4 <= 1024 ? 1024 \
+     : NODE_IDS_MAX_NODES * 5 / 4 <= 2048 ? 2048 \
+                                          : 4096)
+#endif
+
+/* Returned when a node has no ID */
+#define NODE_IDS_NONE (-1)
+
+/*
+ * Get the ID of a node, giving it the next free ID if it hasn't got one.
+ *
+ * Returns NODE_IDS_NONE if all IDs are taken.
+ */
+int node_ids_intern(const mira_net_address_t* addr);
+
+/* Get the ID of a node, or NODE_IDS_NONE if it hasn't got one */
+int node_ids_lookup(const mira_net_address_t* addr);
+
+/* Get the address of a node ID, or NULL if the ID isn't used */
+const mira_net_address_t* node_ids_address(int id);
+
+/* Number of IDs given, the IDs in use are 0 up to this */
+int node_ids_count(void);
+
+#endif
@@ -0,0 +1,429 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 LumenRadio AB
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+#include <mira.h>
+#include <stdio.h>
+#include <string.h>
+#include "seq_header.h"
+#include "seq_track.h"
+
+/* At least one clock tick */
+#define MS_TO_TICKS(ms) ((ms) * CLOCK_SECOND >= 1000 ? (ms) * CLOCK_SECOND / 1000 : 1)
+
+/* This many packets in a row older than the window restarts tracking */
+#define TOO_OLD_RESTART 3
+
+typedef struct
+{
+    uint32_t window; /* Bit n is set if highest - n has been received */
+    uint32_t received;
+    uint32_t lost;
+    uint16_t highest;
+    uint16_t next; /* Next sequence number to deliver, when reordering */
+    uint16_t duplicates;
+    uint16_t reordered;
+    uint8_t restarts;
+    uint8_t too_old : 7; /* Packets in a row older than the window */
+    uint8_t started : 1;
+} node_state_t;
+
+static node_state_t nodes[SEQ_TRACK_MAX_NODES];
+static seq_track_deliver_t deliver;
+static uint32_t n_malformed;
+
+PROCESS(seq_track_proc, "Sequence tracking");
+
+static int bit_count(uint32_t bits)
+{
+    int count = 0;
+    while (bits != 0) {
+        bits &= bits - 1;
+        count++;
+    }
+    return count;
+}
+
+#if SEQ_TRACK_REORDER_MS > 0
+typedef struct
+{
+    clock_time_t since;
+    uint16_t node_plus_one; /* 0 for a free slot */
+    uint16_t seq;
+    uint16_t source_port;
+    uint8_t len;
+    uint8_t payload[SEQ_TRACK_REORDER_MAX_PAYLOAD];
+} held_packet_t;
+
+static held_packet_t held[SEQ_TRACK_REORDER_SLOTS];
+static int n_held;
+static struct etimer reorder_timer;
+
+static void deliver_held(held_packet_t* packet)
+{
+    deliver(node_ids_address(packet->node_plus_one - 1),
+            packet->source_port,
+            packet->seq,
+            packet->payload,
+            packet->len);
+    packet->node_plus_one = 0;
+    n_held--;
+}
+
+/* Deliver the held packets of a node that are next in order */
+static void reorder_drain(int node)
+{
+    node_state_t* state = &nodes[node];
+    bool found = true;
+
+    while (found) {
+        found = false;
+        for (int i = 0; i < SEQ_TRACK_REORDER_SLOTS; ++i) {
+            if (held[i].node_plus_one == node + 1 && held[i].seq == state->next) {
+                deliver_held(&held[i]);
+                state->next++;
+                found = true;
+            }
+        }
+    }
+}
+
+static held_packet_t* reorder_lowest(int node)
+{
+    held_packet_t* lowest = NULL;
+
+    for (int i = 0; i < SEQ_TRACK_REORDER_SLOTS; ++i) {
+        if (held[i].node_plus_one == node + 1 &&
+            (lowest == NULL || (int16_t)(held[i].seq - lowest->seq) < 0)) {
+            lowest = &held[i];
+        }
+    }
+    return lowest;
+}
+
+/*
+ * Give up waiting for the gap before the lowest held packet of a node, and
+ * deliver from there. Returns false if the node has no held packets.
+ */
+static bool reorder_release(int node)
+{
+    held_packet_t* lowest = reorder_lowest(node);
+
+    if (lowest == NULL) {
+        return false;
+    }
+    nodes[node].next = lowest->seq;
+    reorder_drain(node);
+    return true;
+}
+
+static held_packet_t* reorder_free_slot(void)
+{
+    for (int i = 0; i < SEQ_TRACK_REORDER_SLOTS; ++i) {
+        if (held[i].node_plus_one == 0) {
+            return &held[i];
+        }
+    }
+    return NULL;
+}
+
+/* When the pool is full, make room by giving up the gap of the oldest packet */
+static void reorder_release_oldest(void)
+{
+    clock_time_t now = clock_time();
+    held_packet_t* oldest = &held[0];
+
+    for (int i = 1; i < SEQ_TRACK_REORDER_SLOTS; ++i) {
+        if ((clock_time_t)(now - held[i].since) > (clock_time_t)(now - oldest->since)) {
+            oldest = &held[i];
+        }
+    }
+    reorder_release(oldest->node_plus_one - 1);
+}
+
+static void reorder_input(int node,
+                          uint16_t source_port,
+                          uint16_t seq,
+                          const uint8_t* payload,
+                          uint16_t len)
+{
+    node_state_t* state = &nodes[node];
+    int16_t ahead = seq - state->next;
+    held_packet_t* slot = NULL;
+
+    if (ahead > 0 && len <= SEQ_TRACK_REORDER_MAX_PAYLOAD) {
+        slot = reorder_free_slot();
+        while (slot == NULL && ahead > 0) {
+            /*
+             * The oldest packet may be this node's, and releasing it deliver
+             * up to or past this packet, which is then not to be held
+             */
+            reorder_release_oldest();
+            ahead = seq - state->next;
+            slot = reorder_free_slot();
+        }
+    }
+
+    if (ahead < 0) {
+        /* The gap it would have filled has been given up already */
+        deliver(node_ids_address(node), source_port, seq, payload, len);
+        return;
+    }
+
+    if (ahead > 0 && slot != NULL) {
+        slot->since = clock_time();
+        slot->node_plus_one = node + 1;
+        slot->seq = seq;
+        slot->source_port = source_port;
+        slot->len = len;
+        memcpy(slot->payload, payload, len);
+        n_held++;
+
+        /* The timer is set from the process, so it belongs to it */
+        if (etimer_expired(&reorder_timer)) {
+            process_poll(&seq_track_proc);
+        }
+        return;
+    }
+
+    /* Next in order, or too large to hold, which gives up the gap before it */
+    held_packet_t* lowest;
+    while ((lowest = reorder_lowest(node)) != NULL && (int16_t)(lowest->seq - seq) < 0) {
+        state->next = lowest->seq;
+        reorder_drain(node);
+    }
+    deliver(node_ids_address(node), source_port, seq, payload, len);
+    state->next = seq + 1;
+    reorder_drain(node);
+}
+
+/* Deliver the packets that have been held for too long */
+static void reorder_timeout(void)
+{
+    clock_time_t now = clock_time();
+    clock_time_t next_timeout = MS_TO_TICKS(SEQ_TRACK_REORDER_MS);
+
+    for (int i = 0; i < SEQ_TRACK_REORDER_SLOTS; ++i) {
+        if (held[i].node_plus_one == 0) {
+            continue;
+        }
+        clock_time_t age = now - held[i].since;
+        if (age >= MS_TO_TICKS(SEQ_TRACK_REORDER_MS)) {
+            /* May deliver other slots too, start over */
+            reorder_release(held[i].node_plus_one - 1);
+            i = -1;
+            next_timeout = MS_TO_TICKS(SEQ_TRACK_REORDER_MS);
+        } else if (MS_TO_TICKS(SEQ_TRACK_REORDER_MS) - age < next_timeout) {
+            next_timeout = MS_TO_TICKS(SEQ_TRACK_REORDER_MS) - age;
+        }
+    }
+
+    if (n_held > 0) {
+        etimer_set(&reorder_timer, next_timeout);
+    } else {
+        etimer_stop(&reorder_timer);
+    }
+}
+#endif
+
+/* Start over, after the sender has restarted */
+static void seq_track_restart(int node, uint16_t seq)
+{
+    node_state_t* state = &nodes[node];
+
+#if SEQ_TRACK_REORDER_MS > 0
+    while (reorder_release(node)) {
+    }
+#endif
+    if (state->started) {
+        state->restarts++;
+    }
+    state->started = 1;
+    state->too_old = 0;
+    state->highest = seq;
+    /* Nothing before the first packet is expected */
+    state->window = 0xffffffff;
+    state->next = seq;
+}
+
+void seq_track_input(const mira_net_address_t* source,
+                     uint16_t source_port,
+                     const void* data,
+                     uint16_t len)
+{
+    const uint8_t* packet = data;
+
+    if (len < SEQ_HEADER_SIZE) {
+        n_malformed++;
+        return;
+    }
+    uint16_t seq = packet[0] | (uint16_t)packet[1] << 8;
+    const uint8_t* payload = packet + SEQ_HEADER_SIZE;
+    len -= SEQ_HEADER_SIZE;
+
+    int node = node_ids_intern(source);
+    if (node == NODE_IDS_NONE || node >= SEQ_TRACK_MAX_NODES) {
+        deliver(source, source_port, seq, payload, len);
+        return;
+    }
+
+    node_state_t* state = &nodes[node];
+    int16_t ahead = seq - state->highest;
+
+    if (!state->started) {
+        seq_track_restart(node, seq);
+    } else if (ahead > 0) {
+        /* Count the sequence numbers leaving the window without being received */
+        if (ahead >= SEQ_TRACK_WINDOW) {
+            state->lost += SEQ_TRACK_WINDOW - bit_count(state->window);
+            state->lost += ahead - SEQ_TRACK_WINDOW;
+            state->window = 1;
+        } else {
+            state->lost += ahead - bit_count(state->window >> (SEQ_TRACK_WINDOW - ahead));
+            state->window = (state->window << ahead) | 1;
+        }
+        state->highest = seq;
+    } else {
+        uint16_t behind = state->highest - seq;
+
+        if (behind >= SEQ_TRACK_RESTART_GAP ||
+            (behind >= SEQ_TRACK_WINDOW && state->too_old + 1 >= TOO_OLD_RESTART)) {
+            seq_track_restart(node, seq);
+        } else if (behind >= SEQ_TRACK_WINDOW) {
+            state->too_old++;
+            state->duplicates++;
+            return;
+        } else if (state->window & (1UL << behind)) {
+            state->duplicates++;
+            return;
+        } else {
+            state->window |= 1UL << behind;
+            state->reordered++;
+        }
+    }
+
+    state->too_old = 0;
+    state->received++;
+
+#if SEQ_TRACK_REORDER_MS > 0
+    reorder_input(node, source_port, seq, payload, len);
+#else
+    deliver(source, source_port, seq, payload, len);
+#endif
+}
+
+bool seq_track_get_stats(int node, seq_track_stats_t* stats)
+{
+    if (node < 0 || node >= SEQ_TRACK_MAX_NODES || !nodes[node].started) {
+        return false;
+    }
+    stats->received = nodes[node].received;
+    stats->lost = nodes[node].lost;
+    stats->duplicates = nodes[node].duplicates;
+    stats->reordered = nodes[node].reordered;
+    stats->restarts = nodes[node].restarts;
+    return true;
+}
+
+void seq_track_init(seq_track_deliver_t deliver_fn)
+{
+    deliver = deliver_fn;
+#if SEQ_TRACK_REORDER_MS > 0 || SEQ_TRACK_SUMMARY_INTERVAL > 0
+    process_start(&seq_track_proc, NULL);
+#endif
+}
+
+#if SEQ_TRACK_SUMMARY_INTERVAL > 0
+static void seq_track_print_summary(int node)
+{
+    const mira_net_address_t* addr = node_ids_address(node);
+    node_state_t* state = &nodes[node];
+
+    printf("seq ");
+    for (int i = 8; i < 16; ++i) {
+        printf("%02x", addr->u8[i]);
+    }
+    printf(" %lu %lu %u %u %u\n",
+           (unsigned long)state->received,
+           (unsigned long)state->lost,
+           state->duplicates,
+           state->reordered,
+           state->restarts);
+}
+#endif
+
+PROCESS_THREAD(seq_track_proc, ev, data)
+{
+#if SEQ_TRACK_SUMMARY_INTERVAL > 0
+    static struct etimer summary_timer;
+    static int idx;
+#endif
+
+    PROCESS_BEGIN();
+
+#if SEQ_TRACK_SUMMARY_INTERVAL > 0
+    etimer_set(&summary_timer, SEQ_TRACK_SUMMARY_INTERVAL * CLOCK_SECOND);
+#endif
+
+    while (1) {
+        PROCESS_WAIT_EVENT_UNTIL(ev == PROCESS_EVENT_POLL || ev == PROCESS_EVENT_TIMER);
+
+#if SEQ_TRACK_REORDER_MS > 0
+        if (ev == PROCESS_EVENT_POLL || data == &reorder_timer) {
+            reorder_timeout();
+        }
+#endif
+
+#if SEQ_TRACK_SUMMARY_INTERVAL > 0
+        if (ev == PROCESS_EVENT_TIMER && data == &summary_timer) {
+            etimer_reset(&summary_timer);
+            int n_tracked = 0;
+            for (idx = 0; idx < SEQ_TRACK_MAX_NODES; ++idx) {
+                n_tracked += nodes[idx].started;
+            }
+            printf("seq-summary nodes: %d malformed: %lu\n",
+                   n_tracked,
+                   (unsigned long)n_malformed);
+            for (idx = 0; idx < SEQ_TRACK_MAX_NODES; ++idx) {
+                if (!nodes[idx].started) {
+                    continue;
+                }
+                seq_track_print_summary(idx);
+
+                /* Let other processes run while the summary is printed */
+                if ((idx % 16) == 15) {
+                    PROCESS_PAUSE();
+                }
+            }
+#if SEQ_TRACK_REORDER_MS > 0
+            /* A poll while paused is lost, so check the held packets */
+            reorder_timeout();
+#endif
+        }
+#endif
+    }
+
+    PROCESS_END();
+}
@@ -0,0 +1,121 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 LumenRadio AB
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+#ifndef SEQ_TRACK_H
+#define SEQ_TRACK_H
+
+#include <mira.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "node_ids.h"
+
+/*
+ * Tracks the sequence numbers of the packets from each node, see
+ * seq_header.h in the network_sender example, to drop duplicates and count
+ * lost packets.
+ *
+ * Per node, the highest sequence number seen is kept together with a bitmap
+ * of which of the SEQ_TRACK_WINDOW sequence numbers up to it have been
+ * received. A packet already in the bitmap is a duplicate, and dropped. A
+ * sequence number that leaves the window without having been received is
+ * counted as lost. A packet older than the window is dropped, as it can't be
+ * told apart from a duplicate, unless it's more than SEQ_TRACK_RESTART_GAP
+ * behind, or the third such packet in a row, which is taken as the sender
+ * having restarted.
+ *
+ * With SEQ_TRACK_REORDER_MS, packets arriving ahead of a gap are held for at
+ * most that long, waiting for the missing packets, and delivered in order.
+ * Held packets are kept in a pool of SEQ_TRACK_REORDER_SLOTS shared by all
+ * nodes. When the pool is full, or the oldest held packet has waited long
+ * enough, the gap before it is given up.
+ *
+ * The state per node is constant, 24 bytes, and kept by node ID.
+ */
+
+/* Max number of nodes tracked, nodes with higher node IDs are passed through */
+#ifndef SEQ_TRACK_MAX_NODES
+#define SEQ_TRACK_MAX_NODES NODE_IDS_MAX_NODES
+#endif
+
+/* Bits in the duplicate window */
+#define SEQ_TRACK_WINDOW 32
+
+/* A packet this far behind the highest sequence number restarts tracking */
+#ifndef SEQ_TRACK_RESTART_GAP
+#define SEQ_TRACK_RESTART_GAP 1024
+#endif
+
+/* Max time a packet is held to deliver in order, 0 to deliver at once */
+#ifndef SEQ_TRACK_REORDER_MS
+#define SEQ_TRACK_REORDER_MS 0
+#endif
+
+/* Number of packets that can be held, for all nodes */
+#ifndef SEQ_TRACK_REORDER_SLOTS
+#define SEQ_TRACK_REORDER_SLOTS 8
+#endif
+
+/* Max payload of a held packet, larger packets are delivered at once */
+#ifndef SEQ_TRACK_REORDER_MAX_PAYLOAD
+#define SEQ_TRACK_REORDER_MAX_PAYLOAD 64
+#endif
+
+/* How often, in seconds, the counters are printed, 0 to not print them */
+#ifndef SEQ_TRACK_SUMMARY_INTERVAL
+#define SEQ_TRACK_SUMMARY_INTERVAL 60
+#endif
+
+typedef struct
+{
+    uint32_t received;   /* Delivered, not counting duplicates */
+    uint32_t lost;       /* Left the window without being received */
+    uint16_t duplicates; /* Including packets older than the window */
+    uint16_t reordered;  /* Received after a higher sequence number */
+    uint8_t restarts;
+} seq_track_stats_t;
+
+/*
+ * Called with each packet to deliver, without the sequence number header,
+ * in order if SEQ_TRACK_REORDER_MS is set.
+ */
+typedef void (*seq_track_deliver_t)(const mira_net_address_t* source,
+                                    uint16_t source_port,
+                                    uint16_t seq,
+                                    const uint8_t* payload,
+                                    uint16_t len);
+
+void seq_track_init(seq_track_deliver_t deliver);
+
+/* Handle a packet received on SEQ_HEADER_UDP_PORT */
+void seq_track_input(const mira_net_address_t* source,
+                     uint16_t source_port,
+                     const void* data,
+                     uint16_t len);
+
+/* Returns false if the node has no node ID, or isn't tracked */
+bool seq_track_get_stats(int node, seq_track_stats_t* stats);
+
+#endif
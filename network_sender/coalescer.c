@@ -0,0 +1,165 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 LumenRadio AB
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+#include <mira.h>
+#include <stdbool.h>
+#include <string.h>
+#include "coalescer.h"
+
+#if COALESCER_MAX_SIZE < 2
+#error "COALESCER_MAX_SIZE must hold at least one record"
+#endif
+
+/* At least one clock tick */
+#define MAX_DELAY_TICKS                                                                     \
+    (COALESCER_MAX_DELAY_MS * CLOCK_SECOND >= 1000 ? COALESCER_MAX_DELAY_MS * CLOCK_SECOND / 1000 \
+                                                   : 1)
+
+static mira_net_udp_connection_t* coalescer_connection;
+static mira_net_address_t buffer_addr;
+static uint8_t buffer[COALESCER_MAX_SIZE];
+static uint16_t buffer_len;
+static uint16_t buffer_records;
+/* Sum of the times the buffered records were added, to compute the delay */
+static uint32_t buffer_added_sum;
+static clock_time_t buffer_oldest;
+static coalescer_stats_t stats;
+
+PROCESS(coalescer_proc, "Coalescer");
+
+void coalescer_init(mira_net_udp_connection_t* connection)
+{
+    coalescer_connection = connection;
+    process_start(&coalescer_proc, NULL);
+}
+
+void coalescer_flush(void)
+{
+    if (buffer_len == 0) {
+        return;
+    }
+
+    if (mira_net_udp_send_to(
+          coalescer_connection, &buffer_addr, COALESCER_UDP_PORT, buffer, buffer_len) !=
+        MIRA_SUCCESS) {
+        stats.send_failed++;
+    }
+
+    clock_time_t now = clock_time();
+    stats.datagrams++;
+    stats.total_delay += (uint32_t)now * buffer_records - buffer_added_sum;
+    if (now - buffer_oldest > stats.max_delay) {
+        stats.max_delay = now - buffer_oldest;
+    }
+
+    buffer_len = 0;
+    buffer_records = 0;
+    buffer_added_sum = 0;
+}
+
+mira_status_t coalescer_send(const mira_net_address_t* addr, const void* record, uint16_t len)
+{
+    if (len == 0 || len > 255 || len + 1 > COALESCER_MAX_SIZE) {
+        return MIRA_ERROR_INVALID_VALUE;
+    }
+
+    if (buffer_len > 0 && (memcmp(addr, &buffer_addr, sizeof(buffer_addr)) != 0 ||
+                           buffer_len + 1 + len > COALESCER_MAX_SIZE)) {
+        coalescer_flush();
+    }
+
+    clock_time_t now = clock_time();
+    if (buffer_len == 0) {
+        memcpy(&buffer_addr, addr, sizeof(buffer_addr));
+        buffer_oldest = now;
+        /* Start the max delay timer */
+        process_poll(&coalescer_proc);
+    }
+    buffer[buffer_len++] = len;
+    memcpy(&buffer[buffer_len], record, len);
+    buffer_len += len;
+    buffer_records++;
+    buffer_added_sum += now;
+    stats.records++;
+
+    if (buffer_len + COALESCER_FLUSH_MARGIN >= COALESCER_MAX_SIZE) {
+        coalescer_flush();
+    }
+    return MIRA_SUCCESS;
+}
+
+void coalescer_get_stats(coalescer_stats_t* result)
+{
+    memcpy(result, &stats, sizeof(stats));
+}
+
+int coalescer_unpack(const void* data,
+                     uint16_t data_len,
+                     coalescer_record_callback_t callback,
+                     void* storage)
+{
+    const uint8_t* datagram = data;
+    uint16_t pos = 0;
+    int records = 0;
+
+    while (pos < data_len) {
+        uint8_t len = datagram[pos++];
+        if (len == 0 || len > data_len - pos) {
+            return -1;
+        }
+        callback(&datagram[pos], len, storage);
+        pos += len;
+        records++;
+    }
+    return records;
+}
+
+PROCESS_THREAD(coalescer_proc, ev, data)
+{
+    static struct etimer timer;
+    static clock_time_t oldest;
+
+    PROCESS_BEGIN();
+
+    while (1) {
+        PROCESS_WAIT_EVENT_UNTIL(ev == PROCESS_EVENT_POLL);
+
+        /* Records may have been sent since the poll, check the oldest one */
+        while (buffer_len > 0) {
+            oldest = buffer_oldest;
+            clock_time_t waited = clock_time() - oldest;
+            if (waited < MAX_DELAY_TICKS) {
+                etimer_set(&timer, MAX_DELAY_TICKS - waited);
+                PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&timer));
+            }
+            if (buffer_len > 0 && buffer_oldest == oldest) {
+                coalescer_flush();
+            }
+        }
+    }
+
+    PROCESS_END();
+}
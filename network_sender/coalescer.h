@@ -0,0 +1,103 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 LumenRadio AB
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+#ifndef COALESCER_H
+#define COALESCER_H
+
+#include <mira.h>
+#include <stdint.h>
+
+/*
+ * Packs small records into one UDP datagram, to save frames and TX queue
+ * slots compared to sending each record by itself.
+ *
+ * Datagram format, sent to COALESCER_UDP_PORT:
+ * For each record:
+ * <record length> (1 byte, 1..255)
+ * <record> (record length bytes)
+ *
+ * The datagram is sent when the next record wouldn't fit, when it's within
+ * COALESCER_FLUSH_MARGIN bytes of full, when the oldest record has waited
+ * COALESCER_MAX_DELAY_MS, or on coalescer_flush().
+ */
+
+#define COALESCER_UDP_PORT 458
+
+/* Max datagram size. Keep it within one frame to save frames */
+#ifndef COALESCER_MAX_SIZE
+#define COALESCER_MAX_SIZE 80
+#endif
+
+/* Send when this few bytes, or less, are left */
+#ifndef COALESCER_FLUSH_MARGIN
+#define COALESCER_FLUSH_MARGIN 8
+#endif
+
+/* Max time a record waits before it's sent */
+#ifndef COALESCER_MAX_DELAY_MS
+#define COALESCER_MAX_DELAY_MS 1000
+#endif
+
+typedef struct
+{
+    uint32_t records;
+    uint32_t datagrams;
+    uint32_t send_failed;
+    /* Time from adding a record until it's sent, in clock ticks */
+    uint32_t total_delay;
+    uint32_t max_delay;
+} coalescer_stats_t;
+
+/* Sends the datagrams on the given connection */
+void coalescer_init(mira_net_udp_connection_t* connection);
+
+/*
+ * Add a record to send to the given address. Records to different addresses
+ * aren't packed together, a new address sends what's buffered first.
+ *
+ * Returns MIRA_ERROR_INVALID_VALUE if the record is empty or too large.
+ */
+mira_status_t coalescer_send(const mira_net_address_t* addr, const void* record, uint16_t len);
+
+/* Send the buffered records now */
+void coalescer_flush(void);
+
+void coalescer_get_stats(coalescer_stats_t* stats);
+
+typedef void (*coalescer_record_callback_t)(const uint8_t* record, uint16_t len, void* storage);
+
+/*
+ * Call the callback for each record in a received datagram.
+ *
+ * Returns the number of records, or -1 if the datagram is malformed, in
+ * which case the records before the error have been passed on.
+ */
+int coalescer_unpack(const void* data,
+                     uint16_t data_len,
+                     coalescer_record_callback_t callback,
+                     void* storage);
+
+#endif
@@ -0,0 +1,94 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 LumenRadio AB
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+#include "compact.h"
+
+static const float powers_of_ten[] = { 1, 10, 100, 1000, 10000, 100000, 1000000 };
+
+static void compact_mbi(compact_writer_t* writer, uint32_t value)
+{
+    /* Most values fit in one byte */
+    if (value < 0x80 && writer->len < writer->size) {
+        writer->data[writer->len++] = value;
+        return;
+    }
+
+    int size = 1;
+    while (size < 5 && value >= (1UL << (7 * size))) {
+        size++;
+    }
+
+    if (writer->len + size > writer->size) {
+        writer->overflow = true;
+        return;
+    }
+    for (int i = size - 1; i > 0; --i) {
+        writer->data[writer->len++] = 0x80 | (value >> (7 * i));
+    }
+    writer->data[writer->len++] = value & 0x7f;
+}
+
+void compact_begin(compact_writer_t* writer,
+                   uint8_t* data,
+                   uint16_t size,
+                   uint32_t schema,
+                   uint32_t fields)
+{
+    writer->data = data;
+    writer->size = size;
+    writer->len = 0;
+    writer->overflow = false;
+    compact_mbi(writer, schema);
+    compact_mbi(writer, fields);
+}
+
+void compact_uint(compact_writer_t* writer, uint32_t value)
+{
+    compact_mbi(writer, value);
+}
+
+void compact_sint(compact_writer_t* writer, int32_t value)
+{
+    compact_mbi(writer, ((uint32_t)value << 1) ^ (uint32_t)(value >> 31));
+}
+
+void compact_fixed(compact_writer_t* writer, float value, uint8_t decimals)
+{
+    float scaled = value * powers_of_ten[decimals > 6 ? 6 : decimals];
+
+    if (scaled >= 2147483647.0f) {
+        compact_sint(writer, INT32_MAX);
+    } else if (scaled <= -2147483648.0f) {
+        compact_sint(writer, INT32_MIN);
+    } else {
+        compact_sint(writer, (int32_t)(scaled >= 0 ? scaled + 0.5f : scaled - 0.5f));
+    }
+}
+
+int compact_end(compact_writer_t* writer)
+{
+    return writer->overflow ? -1 : writer->len;
+}
@@ -0,0 +1,75 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 LumenRadio AB
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+#ifndef COMPACT_H
+#define COMPACT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Compact binary encoding of sensor messages, instead of text.
+ *
+ * Message format:
+ * <schema ID> (MBI)
+ * <MBI encoded bit field saying which fields of the schema are sent>
+ * <The fields according to the bit field, in field order>
+ *
+ * MBIs are encoded as in monitoring.h in the monitoring example. The type of
+ * each field is given by the schema, see sensor_schema.h:
+ * - unsigned: MBI
+ * - signed: zig-zag encoded, 0, -1, 1, -2, 2 ... as 0, 1, 2, 3, 4 ..., then MBI
+ * - fixed point: the value times 10^decimals, rounded, as signed
+ *
+ * So small values, positive or negative, take one byte, and fields that
+ * aren't sent take one bit. Only depends on the C library, so it can be
+ * built on a host.
+ */
+
+typedef struct
+{
+    uint8_t* data;
+    uint16_t size;
+    uint16_t len;
+    bool overflow;
+} compact_writer_t;
+
+/* Start a message, the fields bit field must list the fields that follow */
+void compact_begin(compact_writer_t* writer,
+                   uint8_t* data,
+                   uint16_t size,
+                   uint32_t schema,
+                   uint32_t fields);
+
+void compact_uint(compact_writer_t* writer, uint32_t value);
+void compact_sint(compact_writer_t* writer, int32_t value);
+/* decimals must match the schema, at most 6 */
+void compact_fixed(compact_writer_t* writer, float value, uint8_t decimals);
+
+/* Returns the length of the message, or -1 if it didn't fit */
+int compact_end(compact_writer_t* writer);
+
+#endif
@@ -0,0 +1,177 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 LumenRadio AB
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+#include <mira.h>
+#include <string.h>
+#include "net_watch.h"
+
+/* At least one clock tick */
+#define MS_TO_TICKS(ms) ((ms) * CLOCK_SECOND >= 1000 ? (ms) * CLOCK_SECOND / 1000 : 1)
+
+process_event_t net_watch_event;
+
+static struct process* subscribers[NET_WATCH_MAX_SUBSCRIBERS];
+static net_watch_info_t info;
+static net_watch_stats_t stats;
+static clock_time_t interval;
+
+PROCESS(net_watch_proc, "Net watch");
+
+static void notify(net_watch_change_t change)
+{
+    stats.changes++;
+    for (int i = 0; i < NET_WATCH_MAX_SUBSCRIBERS; ++i) {
+        if (subscribers[i] != NULL) {
+            process_post(subscribers[i], net_watch_event, (process_data_t)(uintptr_t)change);
+        }
+    }
+}
+
+/* Returns true if anything changed */
+static bool check(void)
+{
+    bool changed = false;
+    mira_net_state_t state = mira_net_get_state();
+    mira_net_address_t addr;
+
+    if (state != info.state) {
+        info.state = state;
+        if (state == MIRA_NET_STATE_JOINED && info.joined_at == 0) {
+            info.joined_at = clock_time();
+        } else if (state != MIRA_NET_STATE_JOINED) {
+            info.joined_at = 0;
+        }
+        notify(NET_WATCH_STATE_CHANGED);
+        changed = true;
+    }
+
+    bool has_root = mira_net_get_root_address(&addr) == MIRA_SUCCESS;
+    if (has_root && (!info.has_root || memcmp(&addr, &info.root, sizeof(addr)) != 0)) {
+        info.has_root = true;
+        memcpy(&info.root, &addr, sizeof(addr));
+        notify(NET_WATCH_ROOT_AVAILABLE);
+        changed = true;
+    } else if (!has_root && info.has_root) {
+        info.has_root = false;
+        notify(NET_WATCH_ROOT_LOST);
+        changed = true;
+    }
+
+    bool has_parent = mira_net_get_parent_address(&addr) == MIRA_SUCCESS;
+    if (has_parent != info.has_parent ||
+        (has_parent && memcmp(&addr, &info.parent, sizeof(addr)) != 0)) {
+        info.has_parent = has_parent;
+        memcpy(&info.parent, &addr, sizeof(addr));
+        notify(NET_WATCH_PARENT_CHANGED);
+        changed = true;
+    }
+
+    return changed;
+}
+
+static clock_time_t max_interval(void)
+{
+    switch (info.state) {
+        case MIRA_NET_STATE_NOT_ASSOCIATED:
+            return MS_TO_TICKS(NET_WATCH_MAX_INTERVAL_SCANNING_MS);
+
+        case MIRA_NET_STATE_JOINED:
+        case MIRA_NET_STATE_IS_COORDINATOR:
+            if (info.has_root) {
+                return MS_TO_TICKS(NET_WATCH_MAX_INTERVAL_MS);
+            }
+            break;
+
+        default:
+            break;
+    }
+    return MS_TO_TICKS(NET_WATCH_MAX_INTERVAL_JOINING_MS);
+}
+
+void net_watch_init(void)
+{
+    if (net_watch_event != 0) {
+        return;
+    }
+    net_watch_event = process_alloc_event();
+    info.state = MIRA_NET_STATE_NOT_ASSOCIATED;
+    process_start(&net_watch_proc, NULL);
+}
+
+bool net_watch_subscribe(struct process* process)
+{
+    for (int i = 0; i < NET_WATCH_MAX_SUBSCRIBERS; ++i) {
+        if (subscribers[i] == NULL || subscribers[i] == process) {
+            subscribers[i] = process;
+            process_post(
+              process, net_watch_event, (process_data_t)(uintptr_t)NET_WATCH_STATE_CHANGED);
+            return true;
+        }
+    }
+    return false;
+}
+
+void net_watch_unsubscribe(struct process* process)
+{
+    for (int i = 0; i < NET_WATCH_MAX_SUBSCRIBERS; ++i) {
+        if (subscribers[i] == process) {
+            subscribers[i] = NULL;
+        }
+    }
+}
+
+const net_watch_info_t* net_watch_get(void)
+{
+    return &info;
+}
+
+void net_watch_get_stats(net_watch_stats_t* stats_out)
+{
+    *stats_out = stats;
+}
+
+PROCESS_THREAD(net_watch_proc, ev, data)
+{
+    static struct etimer timer;
+
+    PROCESS_BEGIN();
+
+    interval = MS_TO_TICKS(NET_WATCH_MIN_INTERVAL_MS);
+    while (1) {
+        stats.wakeups++;
+        if (check()) {
+            interval = MS_TO_TICKS(NET_WATCH_MIN_INTERVAL_MS);
+        } else {
+            clock_time_t max = max_interval();
+            interval = interval * 2 < max ? interval * 2 : max;
+        }
+
+        etimer_set(&timer, interval);
+        PROCESS_WAIT_EVENT_UNTIL(ev == PROCESS_EVENT_TIMER);
+    }
+
+    PROCESS_END();
+}
@@ -0,0 +1,115 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 LumenRadio AB
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+#ifndef NET_WATCH_H
+#define NET_WATCH_H
+
+#include <mira.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Tells processes about changes of the network state, so they don't each
+ * have to poll it.
+ *
+ * Mira has no callback for state changes, so the watcher polls the state,
+ * the root address and the parent address, for all subscribers at once.
+ * After a change, it polls every NET_WATCH_MIN_INTERVAL_MS, and doubles the
+ * interval while nothing changes, up to:
+ *  - NET_WATCH_MAX_INTERVAL_SCANNING_MS while not associated,
+ *  - NET_WATCH_MAX_INTERVAL_JOINING_MS while associated, or joined without a
+ *    root address, since the join is expected soon,
+ *  - NET_WATCH_MAX_INTERVAL_MS once joined with a root address.
+ * This way, a join is seen soon after it happens, and a joined node rarely
+ * wakes up.
+ *
+ * On each change, net_watch_event is posted to the subscribers, with the
+ * net_watch_change_t as data. The full state is read with net_watch_get().
+ */
+
+#ifndef NET_WATCH_MIN_INTERVAL_MS
+#define NET_WATCH_MIN_INTERVAL_MS 50
+#endif
+
+#ifndef NET_WATCH_MAX_INTERVAL_SCANNING_MS
+#define NET_WATCH_MAX_INTERVAL_SCANNING_MS 1000
+#endif
+
+#ifndef NET_WATCH_MAX_INTERVAL_JOINING_MS
+#define NET_WATCH_MAX_INTERVAL_JOINING_MS 250
+#endif
+
+#ifndef NET_WATCH_MAX_INTERVAL_MS
+#define NET_WATCH_MAX_INTERVAL_MS 10000
+#endif
+
+#ifndef NET_WATCH_MAX_SUBSCRIBERS
+#define NET_WATCH_MAX_SUBSCRIBERS 4
+#endif
+
+typedef enum {
+    NET_WATCH_STATE_CHANGED,  /* Not associated, associated or joined */
+    NET_WATCH_ROOT_AVAILABLE, /* The root address is known, or has changed */
+    NET_WATCH_ROOT_LOST,
+    NET_WATCH_PARENT_CHANGED,
+} net_watch_change_t;
+
+typedef struct
+{
+    mira_net_state_t state;
+    bool has_root;
+    mira_net_address_t root;
+    bool has_parent;
+    mira_net_address_t parent;
+    clock_time_t joined_at; /* When joined was first seen, 0 if not joined */
+} net_watch_info_t;
+
+typedef struct
+{
+    uint32_t wakeups;
+    uint32_t changes;
+} net_watch_stats_t;
+
+extern process_event_t net_watch_event;
+
+/* Start watching. Safe to call more than once */
+void net_watch_init(void);
+
+/*
+ * Post net_watch_event to the process on changes. The process gets one
+ * NET_WATCH_STATE_CHANGED event right away, to start from the current state.
+ *
+ * Returns false if there are too many subscribers.
+ */
+bool net_watch_subscribe(struct process* process);
+
+void net_watch_unsubscribe(struct process* process);
+
+const net_watch_info_t* net_watch_get(void);
+
+void net_watch_get_stats(net_watch_stats_t* stats);
+
+#endif
@@ -28,10 +28,83 @@
 #include <mira.h>
 #include <stdio.h>
 #include <string.h>
+#include "coalescer.h"
+#include "compact.h"
+#include "net_watch.h"
+#include "seq_header.h"
+#include "sensor_schema.h"
+#include "tx_queue.h"
+
+/* Size of the memory buffer given to Mira */
+#ifndef MIRA_MEM_BUFFER_SIZE
+#define MIRA_MEM_BUFFER_SIZE 8340
+#endif
 
 #define UDP_PORT 456
 #define SEND_INTERVAL 60
-#define CHECK_NET_INTERVAL 1
+
+/*
+ * Milliseconds between simulated sensor readings, sent through the
+ * coalescer, see coalescer.h. 0 to disable.
+ */
+#ifndef READING_INTERVAL_MS
+#define READING_INTERVAL_MS 0
+#endif
+
+/* At least one clock tick */
+#define READING_INTERVAL_TICKS \
+    (READING_INTERVAL_MS * CLOCK_SECOND >= 1000 ? READING_INTERVAL_MS * CLOCK_SECOND / 1000 : 1)
+
+/*
+ * Send the hello packets with a sequence number, see seq_header.h, so the
+ * root can count lost and duplicated packets. 0 to send them as plain text.
+ */
+#ifndef SEQ_HEADER
+#define SEQ_HEADER 0
+#endif
+
+/*
+ * Send a simulated environment sensor message, encoded as described in
+ * compact.h, instead of the hello packets. 0 to send the hello packets.
+ */
+#ifndef SENSOR_PAYLOAD
+#define SENSOR_PAYLOAD 0
+#endif
+
+/*
+ * Print the coalescer, TX queue and net watch statistics every minute. 0 to
+ * leave them out.
+ */
+#ifndef STATS
+#define STATS 0
+#endif
+
+/* How often, in seconds, the coalescer statistics are printed */
+#define COALESCER_STATS_INTERVAL 60
+
+/*
+ * Overload test of the TX queue, see tx_queue.h: milliseconds between alarm
+ * packets, and between low priority filler packets. 0 to disable.
+ */
+#ifndef ALARM_INTERVAL_MS
+#define ALARM_INTERVAL_MS 0
+#endif
+
+#ifndef FILLER_INTERVAL_MS
+#define FILLER_INTERVAL_MS 0
+#endif
+
+/* Size of the filler packets */
+#define FILLER_SIZE 48
+
+/* How often, in seconds, the TX queue and net watch statistics are printed */
+#define STATS_INTERVAL 60
+
+/* The load process prints the statistics and sends the test packets */
+#define LOAD_PROC (STATS || ALARM_INTERVAL_MS > 0 || FILLER_INTERVAL_MS > 0)
+
+/* At least one clock tick */
+#define MS_TO_TICKS(ms) ((ms) * CLOCK_SECOND >= 1000 ? (ms) * CLOCK_SECOND / 1000 : 1)
 
 /*
  * Identifies as a node.
@@ -87,6 +160,10 @@ static void udp_listen_callback(mira_net_udp_connection_t* connection,
 }
 
 PROCESS(main_proc, "Main process");
+PROCESS(readings_proc, "Readings process");
+#if LOAD_PROC
+PROCESS(load_proc, "Load process");
+#endif
 
 void mira_setup(void)
 {
@@ -102,7 +179,7 @@ void mira_setup(void)
 #endif
     };
 
-    MIRA_MEM_SET_BUFFER(8340);
+    MIRA_MEM_SET_BUFFER(MIRA_MEM_BUFFER_SIZE);
 
     uart_ret = mira_uart_init(0, &uart_config);
     if (uart_ret != MIRA_SUCCESS) {
@@ -118,15 +195,29 @@ PROCESS_THREAD(main_proc, ev, data)
 
     static mira_net_udp_connection_t* udp_connection;
 
-    static mira_net_address_t net_address;
+    static const net_watch_info_t* net;
     static char buffer[MIRA_NET_MAX_ADDRESS_STR_LEN];
-    static mira_status_t res;
+#if SENSOR_PAYLOAD
+    static uint8_t packet[32];
+    static uint32_t counter;
+    compact_writer_t writer;
+#else
     static const char* message = "Hello Network";
+#if SEQ_HEADER
+    static uint8_t packet[SEQ_HEADER_SIZE + 32];
+    static uint16_t seq;
+#endif
+#endif
+    static bool sending;
+    static bool first_packet = true;
+    static clock_time_t start_time;
 
     PROCESS_BEGIN();
     /* Pause once, so we don't run anything before finish of startup */
     PROCESS_PAUSE();
 
+    start_time = clock_time();
+
     printf("Starting Node (Sender).\n");
     printf("Sending one packet every %d seconds\n", SEND_INTERVAL);
 
@@ -143,39 +234,260 @@ PROCESS_THREAD(main_proc, ev, data)
      */
     udp_connection = mira_net_udp_connect(NULL, 0, udp_listen_callback, NULL);
 
+#if READING_INTERVAL_MS > 0
+    coalescer_init(udp_connection);
+    process_start(&readings_proc, NULL);
+#endif
+
+    /* All other packets go through the prioritized TX queue */
+    tx_queue_init(udp_connection);
+#if LOAD_PROC
+    process_start(&load_proc, NULL);
+#endif
+
+    /* Get an event when the network state changes, instead of polling it */
+    net_watch_init();
+    net_watch_subscribe(&main_proc);
+
     while (1) {
-        mira_net_state_t net_state = mira_net_get_state();
-
-        if (net_state != MIRA_NET_STATE_JOINED) {
-            printf("Waiting for network (state is %s)\n",
-                   net_state == MIRA_NET_STATE_NOT_ASSOCIATED ? "not associated"
-                   : net_state == MIRA_NET_STATE_ASSOCIATED   ? "associated"
-                   : net_state == MIRA_NET_STATE_JOINED       ? "joined"
-                                                              : "UNKNOWN");
-            etimer_set(&timer, CHECK_NET_INTERVAL * CLOCK_SECOND);
-        } else {
-            /* Try to retrieve the root address. */
-            res = mira_net_get_root_address(&net_address);
-
-            if (res != MIRA_SUCCESS) {
-                printf("Waiting for root address (res: %d)\n", res);
-                etimer_set(&timer, CHECK_NET_INTERVAL * CLOCK_SECOND);
-            } else {
-                /*
-                 * Root address is successfully retrieved, send a message to the
-                 * root node on the given UDP Port.
-                 */
-                printf("Sending to address: %s\n",
-                       mira_net_toolkit_format_address(buffer, &net_address));
-                mira_net_udp_send_to(
-                  udp_connection, &net_address, UDP_PORT, message, strlen(message));
-                etimer_set(&timer, SEND_INTERVAL * CLOCK_SECOND);
+        PROCESS_WAIT_EVENT_UNTIL(ev == net_watch_event || ev == PROCESS_EVENT_TIMER);
+        net = net_watch_get();
+
+        if (ev == net_watch_event) {
+            if (net->state != MIRA_NET_STATE_JOINED || !net->has_root) {
+                if ((net_watch_change_t)(uintptr_t)data == NET_WATCH_STATE_CHANGED) {
+                    printf("Waiting for network (state is %s)\n",
+                           net->state == MIRA_NET_STATE_NOT_ASSOCIATED ? "not associated"
+                           : net->state == MIRA_NET_STATE_ASSOCIATED   ? "associated"
+                           : net->state == MIRA_NET_STATE_JOINED       ? "joined"
+                                                                       : "UNKNOWN");
+                }
+                etimer_stop(&timer);
+                sending = false;
+                continue;
+            }
+            if (sending) {
+                /* Already sending, a new root address is used from the next packet */
+                continue;
+            }
+            /* Just joined, send right away */
+            sending = true;
+            if (first_packet) {
+                first_packet = false;
+                printf("First packet %lu ms after start, %lu ms after join\n",
+                       (unsigned long)((clock_time() - start_time) * 1000 / CLOCK_SECOND),
+                       (unsigned long)((clock_time() - net->joined_at) * 1000 / CLOCK_SECOND));
             }
         }
-        PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&timer));
+
+        /* Send a message to the root node on the given UDP Port. */
+        printf("Sending to address: %s\n", mira_net_toolkit_format_address(buffer, &net->root));
+#if SENSOR_PAYLOAD
+        /* Only the fields that have values are sent, the rest take one bit */
+        compact_begin(&writer,
+                      packet,
+                      sizeof(packet),
+                      SENSOR_SCHEMA_ENVIRONMENT,
+                      (1 << SENSOR_ENVIRONMENT_UPTIME) | (1 << SENSOR_ENVIRONMENT_TEMPERATURE) |
+                        (1 << SENSOR_ENVIRONMENT_HUMIDITY) | (1 << SENSOR_ENVIRONMENT_COUNTER));
+        compact_uint(&writer, clock_seconds());
+        compact_fixed(&writer, 21.5f + (counter % 10) * 0.25f, 2);
+        compact_fixed(&writer, 45.0f - (counter % 20) * 0.5f, 1);
+        compact_uint(&writer, counter++);
+        tx_queue_send(
+          TX_QUEUE_NORMAL, &net->root, SENSOR_UDP_PORT, packet, compact_end(&writer));
+#elif SEQ_HEADER
+        packet[0] = seq;
+        packet[1] = seq >> 8;
+        memcpy(&packet[SEQ_HEADER_SIZE], message, strlen(message));
+        tx_queue_send(TX_QUEUE_NORMAL,
+                      &net->root,
+                      SEQ_HEADER_UDP_PORT,
+                      packet,
+                      SEQ_HEADER_SIZE + strlen(message));
+        seq++;
+#else
+        tx_queue_send(TX_QUEUE_NORMAL, &net->root, UDP_PORT, message, strlen(message));
+#endif
+        etimer_set(&timer, SEND_INTERVAL * CLOCK_SECOND);
     }
 
     mira_net_udp_close(udp_connection);
 
     PROCESS_END();
 }
+
+#if STATS
+static void print_coalescer_stats(void)
+{
+    coalescer_stats_t stats;
+    coalescer_get_stats(&stats);
+    printf("Coalescer: %lu records in %lu datagrams, %lu frames saved, %lu failed, "
+           "delay avg %lu ms max %lu ms\n",
+           (unsigned long)stats.records,
+           (unsigned long)stats.datagrams,
+           (unsigned long)(stats.records - stats.datagrams),
+           (unsigned long)stats.send_failed,
+           (unsigned long)(stats.records > 0 ? (uint64_t)stats.total_delay * 1000 /
+                                                 CLOCK_SECOND / stats.records
+                                             : 0),
+           (unsigned long)((uint64_t)stats.max_delay * 1000 / CLOCK_SECOND));
+}
+#endif
+
+PROCESS_THREAD(readings_proc, ev, data)
+{
+    static struct etimer timer;
+#if STATS
+    static struct etimer stats_timer;
+#endif
+    static mira_net_address_t root_address;
+    static uint32_t counter;
+
+    PROCESS_BEGIN();
+
+#if STATS
+    etimer_set(&stats_timer, COALESCER_STATS_INTERVAL * CLOCK_SECOND);
+#endif
+    etimer_set(&timer, READING_INTERVAL_TICKS);
+    while (1) {
+#if STATS
+        PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&timer) || etimer_expired(&stats_timer));
+
+        if (etimer_expired(&stats_timer)) {
+            print_coalescer_stats();
+            etimer_reset(&stats_timer);
+        }
+        if (!etimer_expired(&timer)) {
+            continue;
+        }
+#else
+        PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&timer));
+#endif
+        etimer_reset(&timer);
+
+        if (mira_net_get_root_address(&root_address) != MIRA_SUCCESS) {
+            continue;
+        }
+
+        /* A small reading: a counter and the time it was taken */
+        uint32_t now = clock_time();
+        uint8_t reading[8] = {
+            counter, counter >> 8, counter >> 16, counter >> 24, now, now >> 8, now >> 16, now >> 24,
+        };
+        counter++;
+        coalescer_send(&root_address, reading, sizeof(reading));
+    }
+
+    PROCESS_END();
+}
+
+#if LOAD_PROC
+#if STATS
+static void print_stats(void)
+{
+    static const char* names[TX_QUEUE_N_CLASSES] = { "alarm", "normal", "bulk" };
+    tx_queue_stats_t stats;
+    net_watch_stats_t net_stats;
+    unsigned long seconds = clock_seconds();
+
+    net_watch_get_stats(&net_stats);
+    printf("Net watch: %lu wakeups, %lu per hour, %lu changes\n",
+           (unsigned long)net_stats.wakeups,
+           (unsigned long)((uint64_t)net_stats.wakeups * 3600 / (seconds > 0 ? seconds : 1)),
+           (unsigned long)net_stats.changes);
+
+    for (int i = 0; i < TX_QUEUE_N_CLASSES; ++i) {
+        tx_queue_get_stats(i, &stats);
+        printf("TX queue %s: queued %lu sent %lu dropped %lu aged out %lu failed %lu "
+               "delay avg %lu ms max %lu ms\n",
+               names[i],
+               (unsigned long)stats.queued,
+               (unsigned long)stats.sent,
+               (unsigned long)stats.dropped,
+               (unsigned long)stats.aged_out,
+               (unsigned long)stats.failed,
+               (unsigned long)(stats.sent > 0 ? (uint64_t)stats.total_delay * 1000 /
+                                                  CLOCK_SECOND / stats.sent
+                                              : 0),
+               (unsigned long)((uint64_t)stats.max_delay * 1000 / CLOCK_SECOND));
+    }
+}
+#endif
+
+/*
+ * Prints the TX queue and net watch statistics with STATS, and loads the
+ * network with low priority filler packets while sending alarms, to test that
+ * alarms still get through quickly.
+ */
+PROCESS_THREAD(load_proc, ev, data)
+{
+#if STATS
+    static struct etimer stats_timer;
+#endif
+#if ALARM_INTERVAL_MS > 0
+    static struct etimer alarm_timer;
+#endif
+#if FILLER_INTERVAL_MS > 0
+    static struct etimer filler_timer;
+    static uint8_t filler[FILLER_SIZE];
+#endif
+#if ALARM_INTERVAL_MS > 0 || FILLER_INTERVAL_MS > 0
+    static mira_net_address_t root_address;
+    static uint32_t counter;
+#endif
+
+    PROCESS_BEGIN();
+
+#if STATS
+    etimer_set(&stats_timer, STATS_INTERVAL * CLOCK_SECOND);
+#endif
+#if ALARM_INTERVAL_MS > 0
+    etimer_set(&alarm_timer, MS_TO_TICKS(ALARM_INTERVAL_MS));
+#endif
+#if FILLER_INTERVAL_MS > 0
+    etimer_set(&filler_timer, MS_TO_TICKS(FILLER_INTERVAL_MS));
+#endif
+
+    while (1) {
+        PROCESS_WAIT_EVENT_UNTIL(ev == PROCESS_EVENT_TIMER);
+
+#if STATS
+        if (data == &stats_timer) {
+            print_stats();
+            etimer_reset(&stats_timer);
+            continue;
+        }
+#endif
+#if ALARM_INTERVAL_MS > 0 || FILLER_INTERVAL_MS > 0
+        if (mira_net_get_root_address(&root_address) != MIRA_SUCCESS) {
+            etimer_reset(data);
+            continue;
+        }
+
+        /* A counter and the time, so the root can compute the latency */
+        uint32_t now = clock_time();
+        uint8_t header[8] = {
+            counter, counter >> 8, counter >> 16, counter >> 24, now, now >> 8, now >> 16, now >> 24,
+        };
+        counter++;
+
+#if ALARM_INTERVAL_MS > 0
+        if (data == &alarm_timer) {
+            tx_queue_send(TX_QUEUE_ALARM, &root_address, UDP_PORT, header, sizeof(header));
+            etimer_reset(&alarm_timer);
+        }
+#endif
+#if FILLER_INTERVAL_MS > 0
+        if (data == &filler_timer) {
+            memcpy(filler, header, sizeof(header));
+            tx_queue_send(TX_QUEUE_BULK, &root_address, UDP_PORT, filler, sizeof(filler));
+            etimer_reset(&filler_timer);
+        }
+#endif
+#endif
+    }
+
+    PROCESS_END();
+}
+#endif
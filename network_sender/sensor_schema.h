@@ -0,0 +1,61 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 LumenRadio AB
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+#ifndef SENSOR_SCHEMA_H
+#define SENSOR_SCHEMA_H
+
+/*
+ * Schemas of the sensor messages, encoded as described in compact.h, and
+ * sent to SENSOR_UDP_PORT.
+ *
+ * The fields of each schema are listed once, as
+ * FIELD(<ID>, <name>, <type: UINT, SINT or FIXED>, <decimals, for FIXED>),
+ * so the nodes and the decoders use the same field numbers. The field
+ * number is the position in the list. Fields may be added at the end, but
+ * never removed or reordered, as old messages then would be misread.
+ */
+
+#define SENSOR_UDP_PORT 461
+
+/* Environment sensor */
+#define SENSOR_SCHEMA_ENVIRONMENT 1
+
+#define SENSOR_ENVIRONMENT_FIELDS(FIELD)          \
+    FIELD(UPTIME, "uptime_s", UINT, 0)            \
+    FIELD(TEMPERATURE, "temperature_c", FIXED, 2) \
+    FIELD(HUMIDITY, "humidity_pct", FIXED, 1)     \
+    FIELD(PRESSURE, "pressure_hpa", FIXED, 1)     \
+    FIELD(BATTERY, "battery_mv", UINT, 0)         \
+    FIELD(RSSI, "rssi_dbm", SINT, 0)              \
+    FIELD(COUNTER, "counter", UINT, 0)
+
+#define SENSOR_FIELD_ENUM(ID, NAME, TYPE, DECIMALS) SENSOR_ENVIRONMENT_##ID,
+
+enum {
+    SENSOR_ENVIRONMENT_FIELDS(SENSOR_FIELD_ENUM) SENSOR_ENVIRONMENT_N_FIELDS
+};
+
+#endif
@@ -0,0 +1,254 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 LumenRadio AB
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+#include <mira.h>
+#include <string.h>
+#include "tx_queue.h"
+
+/* Time to wait for room in the MAC TX queue */
+#define MAC_QUEUE_WAIT (CLOCK_SECOND / 16 > 0 ? CLOCK_SECOND / 16 : 1)
+
+typedef struct tx_packet
+{
+    struct tx_packet* next;
+    mira_net_address_t addr;
+    uint16_t port;
+    uint16_t len;
+    clock_time_t queued_at;
+    uint8_t data[TX_QUEUE_MAX_PAYLOAD];
+} tx_packet_t;
+
+typedef struct
+{
+    tx_packet_t* head; /* Oldest */
+    tx_packet_t* tail;
+    uint8_t count;
+} tx_class_t;
+
+static const uint8_t class_limits[TX_QUEUE_N_CLASSES] = {
+    TX_QUEUE_LIMIT_ALARM,
+    TX_QUEUE_LIMIT_NORMAL,
+    TX_QUEUE_LIMIT_BULK,
+};
+
+static const clock_time_t class_max_ages[TX_QUEUE_N_CLASSES] = {
+    TX_QUEUE_MAX_AGE_ALARM * CLOCK_SECOND,
+    TX_QUEUE_MAX_AGE_NORMAL * CLOCK_SECOND,
+    TX_QUEUE_MAX_AGE_BULK * CLOCK_SECOND,
+};
+
+static tx_packet_t pool[TX_QUEUE_POOL_SIZE];
+static tx_packet_t* free_list;
+static tx_class_t classes[TX_QUEUE_N_CLASSES];
+static tx_queue_stats_t stats[TX_QUEUE_N_CLASSES];
+static mira_net_udp_connection_t* tx_connection;
+
+PROCESS(tx_queue_proc, "TX queue");
+
+static tx_packet_t* class_pop(tx_class_t* queue)
+{
+    tx_packet_t* packet = queue->head;
+    if (packet != NULL) {
+        queue->head = packet->next;
+        if (queue->head == NULL) {
+            queue->tail = NULL;
+        }
+        queue->count--;
+    }
+    return packet;
+}
+
+static void class_push(tx_class_t* queue, tx_packet_t* packet)
+{
+    packet->next = NULL;
+    if (queue->tail != NULL) {
+        queue->tail->next = packet;
+    } else {
+        queue->head = packet;
+    }
+    queue->tail = packet;
+    queue->count++;
+}
+
+static void packet_free(tx_packet_t* packet)
+{
+    packet->next = free_list;
+    free_list = packet;
+}
+
+/* Drop the oldest packet of a class, to make room */
+static void drop_oldest(tx_queue_class_t prio)
+{
+    packet_free(class_pop(&classes[prio]));
+    stats[prio].dropped++;
+}
+
+/* Get a free packet for a class, dropping queued packets if needed */
+static tx_packet_t* packet_alloc(tx_queue_class_t prio)
+{
+    if (classes[prio].count >= class_limits[prio]) {
+        drop_oldest(prio);
+    }
+
+    if (free_list == NULL) {
+        /* Make room by dropping from the lowest class, below this one */
+        for (int lower = TX_QUEUE_N_CLASSES - 1; lower > (int)prio; --lower) {
+            if (classes[lower].count > 0) {
+                drop_oldest(lower);
+                break;
+            }
+        }
+    }
+    if (free_list == NULL && classes[prio].count > 0) {
+        drop_oldest(prio);
+    }
+    if (free_list == NULL) {
+        return NULL;
+    }
+
+    tx_packet_t* packet = free_list;
+    free_list = packet->next;
+    return packet;
+}
+
+void tx_queue_init(mira_net_udp_connection_t* connection)
+{
+    tx_connection = connection;
+    for (int i = 0; i < TX_QUEUE_POOL_SIZE; ++i) {
+        packet_free(&pool[i]);
+    }
+    process_start(&tx_queue_proc, NULL);
+}
+
+mira_status_t tx_queue_send(tx_queue_class_t prio,
+                            const mira_net_address_t* addr,
+                            uint16_t port,
+                            const void* data,
+                            uint16_t len)
+{
+    if (prio >= TX_QUEUE_N_CLASSES || len > TX_QUEUE_MAX_PAYLOAD) {
+        return MIRA_ERROR_INVALID_VALUE;
+    }
+
+    tx_packet_t* packet = packet_alloc(prio);
+    if (packet == NULL) {
+        stats[prio].dropped++;
+        return MIRA_ERROR_RESOURCE_NOT_AVAILABLE;
+    }
+
+    memcpy(&packet->addr, addr, sizeof(packet->addr));
+    packet->port = port;
+    packet->len = len;
+    packet->queued_at = clock_time();
+    memcpy(packet->data, data, len);
+    class_push(&classes[prio], packet);
+    stats[prio].queued++;
+
+    process_poll(&tx_queue_proc);
+    return MIRA_SUCCESS;
+}
+
+void tx_queue_get_stats(tx_queue_class_t prio, tx_queue_stats_t* stats_out)
+{
+    *stats_out = stats[prio];
+}
+
+/* Packets the MAC TX queue can take, for the highest class with packets */
+static int mac_queue_room(tx_queue_class_t prio)
+{
+    mira_diag_mac_statistics_t mac_stats;
+    int limit = TX_QUEUE_MAC_LIMIT + (prio == TX_QUEUE_ALARM ? TX_QUEUE_ALARM_RESERVE : 0);
+
+    if (mira_diag_mac_get_statistics(&mac_stats) != MIRA_SUCCESS) {
+        return 1;
+    }
+    return limit - mac_stats.used_tx_queue;
+}
+
+/* Drop the packets at the head of a class that are too old to send */
+static void drop_aged_out(tx_queue_class_t prio)
+{
+    while (classes[prio].count > 0 &&
+           clock_time() - classes[prio].head->queued_at > class_max_ages[prio]) {
+        packet_free(class_pop(&classes[prio]));
+        stats[prio].aged_out++;
+    }
+}
+
+/*
+ * Send queued packets, highest class first. Aged out packets are dropped
+ * first, also while the MAC is busy, so they don't hold pool entries.
+ * Returns false if the MAC is busy
+ */
+static bool send_queued(void)
+{
+    bool sent_all = true;
+
+    for (tx_queue_class_t prio = TX_QUEUE_ALARM; prio < TX_QUEUE_N_CLASSES; ++prio) {
+        drop_aged_out(prio);
+        while (sent_all && classes[prio].count > 0) {
+            if (mac_queue_room(prio) <= 0) {
+                sent_all = false;
+                break;
+            }
+
+            tx_packet_t* packet = class_pop(&classes[prio]);
+            clock_time_t delay = clock_time() - packet->queued_at;
+            if (mira_net_udp_send_to(
+                  tx_connection, &packet->addr, packet->port, packet->data, packet->len) !=
+                MIRA_SUCCESS) {
+                stats[prio].failed++;
+            } else {
+                stats[prio].sent++;
+                stats[prio].total_delay += delay;
+                if (delay > stats[prio].max_delay) {
+                    stats[prio].max_delay = delay;
+                }
+            }
+            packet_free(packet);
+            drop_aged_out(prio);
+        }
+    }
+    return sent_all;
+}
+
+PROCESS_THREAD(tx_queue_proc, ev, data)
+{
+    static struct etimer timer;
+
+    PROCESS_BEGIN();
+
+    while (1) {
+        PROCESS_WAIT_EVENT_UNTIL(ev == PROCESS_EVENT_POLL || ev == PROCESS_EVENT_TIMER);
+
+        if (!send_queued()) {
+            /* The MAC doesn't tell when there's room, so check again soon */
+            etimer_set(&timer, MAC_QUEUE_WAIT);
+        }
+    }
+
+    PROCESS_END();
+}
@@ -0,0 +1,129 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 LumenRadio AB
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+#ifndef TX_QUEUE_H
+#define TX_QUEUE_H
+
+#include <mira.h>
+#include <stdint.h>
+
+/*
+ * Prioritized transmit queue for application packets.
+ *
+ * Packets are queued per priority class, and sent only while the MAC TX
+ * queue has room, as reported by used_tx_queue in the MAC statistics. The
+ * highest class with packets is sent first, and alarms may use
+ * TX_QUEUE_ALARM_RESERVE more MAC queue slots than the other classes, so
+ * they get through also when the queue is busy with other traffic.
+ *
+ * Each class holds at most its limit of packets, and all classes share a
+ * pool of TX_QUEUE_POOL_SIZE packets. When a class is full, its oldest packet
+ * is dropped. When the pool is full, the oldest packet of the lowest class
+ * below the new packet's class is dropped, and if there is none, the new
+ * packet is. Packets that have waited longer than their class's max age are
+ * dropped when they come up for sending, and counted as aged out.
+ */
+
+typedef enum {
+    TX_QUEUE_ALARM,  /* Highest priority */
+    TX_QUEUE_NORMAL,
+    TX_QUEUE_BULK,   /* Lowest priority, dropped first */
+    TX_QUEUE_N_CLASSES
+} tx_queue_class_t;
+
+/* Longest packet payload */
+#ifndef TX_QUEUE_MAX_PAYLOAD
+#define TX_QUEUE_MAX_PAYLOAD 64
+#endif
+
+/* Packets queued in total */
+#ifndef TX_QUEUE_POOL_SIZE
+#define TX_QUEUE_POOL_SIZE 12
+#endif
+
+/* Packets queued per class */
+#ifndef TX_QUEUE_LIMIT_ALARM
+#define TX_QUEUE_LIMIT_ALARM 4
+#endif
+#ifndef TX_QUEUE_LIMIT_NORMAL
+#define TX_QUEUE_LIMIT_NORMAL 8
+#endif
+#ifndef TX_QUEUE_LIMIT_BULK
+#define TX_QUEUE_LIMIT_BULK 8
+#endif
+
+/* Max time in the queue, in seconds, before a packet is dropped */
+#ifndef TX_QUEUE_MAX_AGE_ALARM
+#define TX_QUEUE_MAX_AGE_ALARM 60
+#endif
+#ifndef TX_QUEUE_MAX_AGE_NORMAL
+#define TX_QUEUE_MAX_AGE_NORMAL 30
+#endif
+#ifndef TX_QUEUE_MAX_AGE_BULK
+#define TX_QUEUE_MAX_AGE_BULK 10
+#endif
+
+/* Send only while the MAC TX queue has fewer packets than this */
+#ifndef TX_QUEUE_MAC_LIMIT
+#define TX_QUEUE_MAC_LIMIT 4
+#endif
+
+/* Extra MAC TX queue slots alarms may use */
+#ifndef TX_QUEUE_ALARM_RESERVE
+#define TX_QUEUE_ALARM_RESERVE 2
+#endif
+
+typedef struct
+{
+    uint32_t queued;
+    uint32_t sent;
+    uint32_t dropped;  /* Class or pool full */
+    uint32_t aged_out;
+    uint32_t failed;   /* mira_net_udp_send_to() failed */
+    /* Time from queueing until sent, in clock ticks */
+    uint32_t total_delay;
+    uint32_t max_delay;
+} tx_queue_stats_t;
+
+/* Sends the packets on the given connection */
+void tx_queue_init(mira_net_udp_connection_t* connection);
+
+/*
+ * Queue a packet to send.
+ *
+ * Returns MIRA_ERROR_INVALID_VALUE if the packet is too long, and
+ * MIRA_ERROR_RESOURCE_NOT_AVAILABLE if it was dropped because the queue is
+ * full of packets of the same or higher classes.
+ */
+mira_status_t tx_queue_send(tx_queue_class_t prio,
+                            const mira_net_address_t* addr,
+                            uint16_t port,
+                            const void* data,
+                            uint16_t len);
+
+void tx_queue_get_stats(tx_queue_class_t prio, tx_queue_stats_t* stats);
+
+#endif
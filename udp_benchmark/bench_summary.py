@@ -0,0 +1,98 @@
+#!/usr/bin/env python3
+
+# Summary of UDP benchmark results
+#
+#
+# MIT License
+#
+# Copyright (c) 2023 LumenRadio AB
+#
+# SPDX-License-Identifier: MIT
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+#
+#
+#
+# Reads the output of the benchmark receiver, and optionally the senders, and
+# prints one JSON object with the latest results per sender and the totals.
+
+import argparse
+import json
+import sys
+
+
+def read_results(files):
+    senders = {}
+    done = {}
+    for f in files:
+        for line in f:
+            line = line.strip()
+            if not line.startswith("{"):
+                continue
+            try:
+                record = json.loads(line)
+            except ValueError:
+                continue
+            if record.get("type") == "bench":
+                # Later results replace earlier ones, they are cumulative
+                senders[record["sender"]] = record
+            elif record.get("type") == "bench_done":
+                done[record["run"]] = record
+    return senders, done
+
+
+def summarize(senders, done):
+    results = sorted(senders.values(), key=lambda r: r["sender"])
+    for result in results:
+        if result["run"] in done:
+            result["sent"] = done[result["run"]]["sent"]
+            result["send_failed"] = done[result["run"]]["send_failed"]
+
+    received = sum(r["received"] for r in results)
+    lost = sum(r["lost"] for r in results)
+    p99 = sorted(r["latency_ms"]["p99"] for r in results if r["latency_ms"]["count"])
+    return {
+        "senders": len(results),
+        "received": received,
+        "lost": lost,
+        "loss_ratio": lost / (received + lost) if received + lost else 0,
+        "duplicates": sum(r["duplicates"] for r in results),
+        "reordered": sum(r["reordered"] for r in results),
+        "goodput_bps": sum(r["goodput_bps"] for r in results),
+        "worst_p99_latency_ms": p99[-1] if p99 else None,
+        "median_p99_latency_ms": p99[len(p99) // 2] if p99 else None,
+        "per_sender": results,
+    }
+
+
+def arg_build_parser():
+    parser = argparse.ArgumentParser(description="UDP benchmark result summary")
+    parser.add_argument(
+        "logs",
+        nargs="*",
+        type=argparse.FileType("r"),
+        default=[sys.stdin],
+        help="Output of the receiver, and optionally the senders (default: stdin)",
+    )
+    return parser
+
+
+if __name__ == "__main__":
+    args = arg_build_parser().parse_args()
+    print(json.dumps(summarize(*read_results(args.logs))))
@@ -0,0 +1,354 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 LumenRadio AB
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+#include <mira.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "udp_benchmark.h"
+
+/* Size of the memory buffer given to Mira */
+#ifndef MIRA_MEM_BUFFER_SIZE
+#define MIRA_MEM_BUFFER_SIZE 14944
+#endif
+
+/* Max number of senders to keep statistics for */
+#ifndef BENCH_MAX_SENDERS
+#define BENCH_MAX_SENDERS 100
+#endif
+
+/* How often, in seconds, results are printed */
+#ifndef BENCH_REPORT_INTERVAL
+#define BENCH_REPORT_INTERVAL 10
+#endif
+
+/* Keep the table at most 80% full, to keep probe sequences short */
+#define TABLE_SIZE ((BENCH_MAX_SENDERS * 5 + 3) / 4)
+
+/*
+ * Latency buckets, in network time ticks. Bucket n holds latencies below
+ * 1 << n ticks, the last one everything above.
+ */
+#define N_LATENCY_BUCKETS 16
+
+typedef struct
+{
+    mira_net_address_t addr;
+    bool used;
+    uint16_t run_id;
+    uint32_t first_seq;
+    uint32_t highest_seq;
+    /* Bit n set if highest_seq - n has been received */
+    uint64_t window;
+    uint32_t received; /* Unique packets */
+    uint32_t duplicates;
+    uint32_t reordered; /* Arrived after a higher sequence number */
+    uint32_t bytes;
+    uint16_t first_len; /* Length of the first packet, which marks the start */
+    clock_time_t first_rx;
+    clock_time_t last_rx;
+    uint32_t latency_buckets[N_LATENCY_BUCKETS];
+    uint32_t latency_count;
+    uint32_t latency_max;
+} sender_entry_t;
+
+static sender_entry_t senders[TABLE_SIZE];
+static int n_senders;
+static uint32_t n_dropped;
+static uint32_t n_invalid;
+
+static const mira_net_config_t net_config = {
+    .pan_id = UDP_BENCHMARK_PAN_ID,
+    .key = UDP_BENCHMARK_KEY,
+    /* Prioritize initial network startup, which is good for testing.
+     *
+     * This has the drawback that the network takes a much
+     * longer time to recover if the root node is restarted. */
+    .mode = MIRA_NET_MODE_ROOT_NO_RECONNECT,
+
+    .rate = UDP_BENCHMARK_NET_RATE,
+    .antenna = 0,
+    .prefix = NULL /* default prefix */
+};
+
+MIRA_IODEFS(MIRA_IODEF_NONE,    /* fd 0: stdin */
+            MIRA_IODEF_UART(0), /* fd 1: stdout */
+            MIRA_IODEF_NONE     /* fd 2: stderr */
+                                /* More file descriptors can be added, for use with dprintf(); */
+);
+
+static uint32_t get_u32(const uint8_t* p)
+{
+    return p[0] | (p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/*
+ * Find the entry of a sender, or add it if not found.
+ *
+ * Returns NULL if the table is full.
+ */
+static sender_entry_t* sender_lookup(const mira_net_address_t* addr)
+{
+    uint32_t hash = 2166136261u;
+    for (int i = 8; i < 16; ++i) {
+        hash ^= addr->u8[i];
+        hash *= 16777619u;
+    }
+
+    /* Linear probing. Entries are never removed, so no tombstones needed */
+    uint32_t idx = hash % TABLE_SIZE;
+    for (int i = 0; i < TABLE_SIZE; ++i) {
+        sender_entry_t* entry = &senders[idx];
+        if (!entry->used) {
+            if (n_senders >= BENCH_MAX_SENDERS) {
+                return NULL;
+            }
+            memset(entry, 0, sizeof(*entry));
+            memcpy(&entry->addr, addr, sizeof(entry->addr));
+            entry->used = true;
+            n_senders++;
+            return entry;
+        }
+        if (memcmp(&entry->addr, addr, sizeof(entry->addr)) == 0) {
+            return entry;
+        }
+        idx = (idx + 1) % TABLE_SIZE;
+    }
+    return NULL;
+}
+
+static void sender_start_run(sender_entry_t* entry, uint16_t run_id, uint32_t seq, uint16_t len)
+{
+    mira_net_address_t addr;
+    memcpy(&addr, &entry->addr, sizeof(addr));
+    memset(entry, 0, sizeof(*entry));
+    memcpy(&entry->addr, &addr, sizeof(addr));
+    entry->used = true;
+    entry->run_id = run_id;
+    entry->first_seq = seq;
+    entry->highest_seq = seq;
+    entry->window = 1;
+    entry->first_len = len;
+    entry->first_rx = clock_time();
+}
+
+/* Returns false if the packet is a duplicate */
+static bool sender_add_seq(sender_entry_t* entry, uint32_t seq)
+{
+    if ((int32_t)(seq - entry->highest_seq) > 0) {
+        uint32_t shift = seq - entry->highest_seq;
+        entry->window = shift >= 64 ? 0 : entry->window << shift;
+        entry->window |= 1;
+        entry->highest_seq = seq;
+        return true;
+    }
+
+    uint32_t age = entry->highest_seq - seq;
+    if (age >= 64) {
+        /* Too old to tell if it's a duplicate, count it as reordered */
+        entry->reordered++;
+        return true;
+    }
+    if (entry->window & ((uint64_t)1 << age)) {
+        entry->duplicates++;
+        return false;
+    }
+    entry->window |= (uint64_t)1 << age;
+    entry->reordered++;
+    return true;
+}
+
+static void sender_add_latency(sender_entry_t* entry, uint32_t ticks)
+{
+    int bucket = 0;
+    while (bucket < N_LATENCY_BUCKETS - 1 && ticks >= ((uint32_t)1 << bucket)) {
+        bucket++;
+    }
+    entry->latency_buckets[bucket]++;
+    entry->latency_count++;
+    if (ticks > entry->latency_max) {
+        entry->latency_max = ticks;
+    }
+}
+
+/*
+ * Upper limit, in milliseconds, of the bucket holding the given percentile
+ * of the latencies, at most the max latency.
+ */
+static uint32_t sender_latency_percentile(const sender_entry_t* entry, int percentile)
+{
+    uint32_t wanted = (entry->latency_count * percentile + 99) / 100;
+    uint32_t seen = 0;
+    for (int bucket = 0; bucket < N_LATENCY_BUCKETS - 1; ++bucket) {
+        seen += entry->latency_buckets[bucket];
+        if (seen >= wanted) {
+            uint32_t limit = (uint32_t)1 << bucket;
+            if (limit > entry->latency_max) {
+                limit = entry->latency_max;
+            }
+            return limit * UDP_BENCHMARK_NET_TIME_TICK_MS;
+        }
+    }
+    return entry->latency_max * UDP_BENCHMARK_NET_TIME_TICK_MS;
+}
+
+static void udp_listen_callback(mira_net_udp_connection_t* connection,
+                                const void* data,
+                                uint16_t data_len,
+                                const mira_net_udp_callback_metadata_t* metadata,
+                                void* storage)
+{
+    const uint8_t* packet = data;
+    uint32_t now;
+
+    if (data_len < UDP_BENCHMARK_HEADER_SIZE || packet[0] != UDP_BENCHMARK_VERSION) {
+        n_invalid++;
+        return;
+    }
+    uint16_t run_id = packet[1] | (packet[2] << 8);
+    uint32_t seq = get_u32(&packet[3]);
+    uint32_t tx_time = get_u32(&packet[7]);
+
+    sender_entry_t* entry = sender_lookup(metadata->source_address);
+    if (entry == NULL) {
+        n_dropped++;
+        return;
+    }
+    if (entry->received == 0 || entry->run_id != run_id) {
+        /* A new sender, or the sender has restarted */
+        sender_start_run(entry, run_id, seq, data_len);
+    } else if (!sender_add_seq(entry, seq)) {
+        return;
+    }
+    entry->received++;
+    entry->bytes += data_len;
+    entry->last_rx = clock_time();
+
+    if (tx_time != 0 && mira_net_time_get_time(&now) == MIRA_SUCCESS) {
+        int32_t latency = now - tx_time;
+        sender_add_latency(entry, latency < 0 ? 0 : latency);
+    }
+}
+
+static void print_sender(const sender_entry_t* entry)
+{
+    char buffer[MIRA_NET_MAX_ADDRESS_STR_LEN];
+    uint32_t expected = entry->highest_seq - entry->first_seq + 1;
+    uint32_t lost = expected > entry->received ? expected - entry->received : 0;
+    clock_time_t elapsed = entry->last_rx - entry->first_rx;
+    /* The first packet only marks the start */
+    uint32_t goodput_bps =
+      elapsed > 0 ? (uint64_t)(entry->bytes - entry->first_len) * 8 * CLOCK_SECOND / elapsed : 0;
+
+    printf("{\"type\":\"bench\",\"sender\":\"%s\",\"run\":%u,\"received\":%lu,\"bytes\":%lu,"
+           "\"lost\":%lu,\"duplicates\":%lu,\"reordered\":%lu,\"seconds\":%lu,"
+           "\"goodput_bps\":%lu,\"latency_ms\":{\"count\":%lu,\"p50\":%lu,\"p90\":%lu,"
+           "\"p99\":%lu,\"max\":%lu}}\n",
+           mira_net_toolkit_format_address(buffer, &entry->addr),
+           entry->run_id,
+           (unsigned long)entry->received,
+           (unsigned long)entry->bytes,
+           (unsigned long)lost,
+           (unsigned long)entry->duplicates,
+           (unsigned long)entry->reordered,
+           (unsigned long)(elapsed / CLOCK_SECOND),
+           (unsigned long)goodput_bps,
+           (unsigned long)entry->latency_count,
+           (unsigned long)sender_latency_percentile(entry, 50),
+           (unsigned long)sender_latency_percentile(entry, 90),
+           (unsigned long)sender_latency_percentile(entry, 99),
+           (unsigned long)(entry->latency_max * UDP_BENCHMARK_NET_TIME_TICK_MS));
+}
+
+PROCESS(main_proc, "Main process");
+
+void mira_setup(void)
+{
+    mira_status_t uart_ret;
+    mira_uart_config_t uart_config = {
+        .baudrate = 115200,
+#if MIRA_PLATFORM_MKW41Z
+        .tx_pin = MIRA_GPIO_PIN('C', 7),
+        .rx_pin = MIRA_GPIO_PIN('C', 6)
+#else
+        .tx_pin = MIRA_GPIO_PIN(0, 6),
+        .rx_pin = MIRA_GPIO_PIN(0, 8)
+#endif
+    };
+
+    MIRA_MEM_SET_BUFFER(MIRA_MEM_BUFFER_SIZE);
+
+    uart_ret = mira_uart_init(0, &uart_config);
+    if (uart_ret != MIRA_SUCCESS) {
+        /* Nowhere to send an error message */
+    }
+
+    process_start(&main_proc, NULL);
+}
+
+PROCESS_THREAD(main_proc, ev, data)
+{
+    static struct etimer timer;
+    static int idx;
+
+    PROCESS_BEGIN();
+    /* Pause once, so we don't run anything before finish of startup. */
+    PROCESS_PAUSE();
+
+    mira_status_t result = mira_net_init(&net_config);
+    if (result) {
+        printf("FAILURE: mira_net_init returned %d\n", result);
+        while (1)
+            ;
+    }
+
+    mira_net_udp_listen(UDP_BENCHMARK_PORT, udp_listen_callback, NULL);
+
+    etimer_set(&timer, BENCH_REPORT_INTERVAL * CLOCK_SECOND);
+    while (1) {
+        PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&timer));
+        etimer_reset(&timer);
+
+        printf("{\"type\":\"bench_summary\",\"senders\":%d,\"dropped\":%lu,\"invalid\":%lu}\n",
+               n_senders,
+               (unsigned long)n_dropped,
+               (unsigned long)n_invalid);
+        for (idx = 0; idx < TABLE_SIZE; ++idx) {
+            if (!senders[idx].used || senders[idx].received == 0) {
+                continue;
+            }
+            print_sender(&senders[idx]);
+
+            /* Let other processes run while the results are printed */
+            if ((idx % 8) == 7) {
+                PROCESS_PAUSE();
+            }
+        }
+    }
+
+    PROCESS_END();
+}
@@ -0,0 +1,208 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 LumenRadio AB
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+#include <mira.h>
+#include <stdio.h>
+#include <string.h>
+#include "udp_benchmark.h"
+
+/* Size of the memory buffer given to Mira */
+#ifndef MIRA_MEM_BUFFER_SIZE
+#define MIRA_MEM_BUFFER_SIZE 8340
+#endif
+
+/* Total UDP payload size, including the benchmark header */
+#ifndef BENCH_PAYLOAD_SIZE
+#define BENCH_PAYLOAD_SIZE 64
+#endif
+
+/* Time between bursts, in milliseconds */
+#ifndef BENCH_INTERVAL_MS
+#define BENCH_INTERVAL_MS 1000
+#endif
+
+/* Packets sent back to back in each burst */
+#ifndef BENCH_BURST
+#define BENCH_BURST 1
+#endif
+
+/* Seconds to send for, 0 to send forever */
+#ifndef BENCH_DURATION
+#define BENCH_DURATION 0
+#endif
+
+#if BENCH_PAYLOAD_SIZE < UDP_BENCHMARK_HEADER_SIZE
+#error "BENCH_PAYLOAD_SIZE must hold the benchmark header"
+#endif
+
+#define CHECK_NET_INTERVAL 1
+
+/* At least one clock tick */
+#define BENCH_INTERVAL_TICKS \
+    (BENCH_INTERVAL_MS * CLOCK_SECOND >= 1000 ? BENCH_INTERVAL_MS * CLOCK_SECOND / 1000 : 1)
+
+static const mira_net_config_t net_config = {
+    .pan_id = UDP_BENCHMARK_PAN_ID,
+    .key = UDP_BENCHMARK_KEY,
+    .mode = MIRA_NET_MODE_MESH,
+    .rate = UDP_BENCHMARK_NET_RATE,
+    .antenna = 0,
+    .prefix = NULL, /* default prefix */
+    .max_connections = 1,
+};
+
+MIRA_IODEFS(MIRA_IODEF_NONE,    /* fd 0: stdin */
+            MIRA_IODEF_UART(0), /* fd 1: stdout */
+            MIRA_IODEF_NONE     /* fd 2: stderr */
+                                /* More file descriptors can be added, for use with dprintf(); */
+);
+
+static uint8_t packet[BENCH_PAYLOAD_SIZE];
+static uint16_t run_id;
+static uint32_t seq;
+static uint32_t n_send_failed;
+
+static void put_u16(uint8_t* p, uint16_t value)
+{
+    p[0] = value;
+    p[1] = value >> 8;
+}
+
+static void put_u32(uint8_t* p, uint32_t value)
+{
+    put_u16(p, value);
+    put_u16(p + 2, value >> 16);
+}
+
+static void send_packet(mira_net_udp_connection_t* connection, const mira_net_address_t* root)
+{
+    uint32_t now;
+    if (mira_net_time_get_time(&now) != MIRA_SUCCESS) {
+        now = 0;
+    }
+
+    packet[0] = UDP_BENCHMARK_VERSION;
+    put_u16(&packet[1], run_id);
+    put_u32(&packet[3], seq);
+    put_u32(&packet[7], now);
+
+    if (mira_net_udp_send_to(connection, root, UDP_BENCHMARK_PORT, packet, sizeof(packet)) !=
+        MIRA_SUCCESS) {
+        n_send_failed++;
+    }
+    /* Also failed packets use up a sequence number, so they count as lost */
+    seq++;
+}
+
+PROCESS(main_proc, "Main process");
+
+void mira_setup(void)
+{
+    mira_status_t uart_ret;
+    mira_uart_config_t uart_config = {
+        .baudrate = 115200,
+#if MIRA_PLATFORM_MKW41Z
+        .tx_pin = MIRA_GPIO_PIN('C', 7),
+        .rx_pin = MIRA_GPIO_PIN('C', 6)
+#else
+        .tx_pin = MIRA_GPIO_PIN(0, 6),
+        .rx_pin = MIRA_GPIO_PIN(0, 8)
+#endif
+    };
+
+    MIRA_MEM_SET_BUFFER(MIRA_MEM_BUFFER_SIZE);
+
+    uart_ret = mira_uart_init(0, &uart_config);
+    if (uart_ret != MIRA_SUCCESS) {
+        /* Nowhere to send an error message */
+    }
+
+    process_start(&main_proc, NULL);
+}
+
+PROCESS_THREAD(main_proc, ev, data)
+{
+    static struct etimer timer;
+    static mira_net_udp_connection_t* udp_connection;
+    static mira_net_address_t root_address;
+    static clock_time_t start_time;
+    static int i;
+
+    PROCESS_BEGIN();
+    /* Pause once, so we don't run anything before finish of startup */
+    PROCESS_PAUSE();
+
+    run_id = mira_random_generate();
+    for (i = UDP_BENCHMARK_HEADER_SIZE; i < sizeof(packet); ++i) {
+        packet[i] = i;
+    }
+
+    printf("{\"type\":\"bench_config\",\"run\":%u,\"payload\":%d,\"interval_ms\":%d,"
+           "\"burst\":%d,\"duration\":%d}\n",
+           run_id,
+           BENCH_PAYLOAD_SIZE,
+           BENCH_INTERVAL_MS,
+           BENCH_BURST,
+           BENCH_DURATION);
+
+    mira_status_t result = mira_net_init(&net_config);
+    if (result) {
+        printf("FAILURE: mira_net_init returned %d\n", result);
+        while (1)
+            ;
+    }
+
+    udp_connection = mira_net_udp_connect(NULL, 0, NULL, NULL);
+
+    /* Wait for the network and the root address before starting */
+    while (mira_net_get_state() != MIRA_NET_STATE_JOINED ||
+           mira_net_get_root_address(&root_address) != MIRA_SUCCESS) {
+        etimer_set(&timer, CHECK_NET_INTERVAL * CLOCK_SECOND);
+        PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&timer));
+    }
+
+    start_time = clock_time();
+    etimer_set(&timer, BENCH_INTERVAL_TICKS);
+    while (BENCH_DURATION == 0 ||
+           clock_time() - start_time < (clock_time_t)BENCH_DURATION * CLOCK_SECOND) {
+        PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&timer));
+        /* Keep a steady rate, also if sending takes time */
+        etimer_reset(&timer);
+
+        /* The root address can change, if the root restarts */
+        mira_net_get_root_address(&root_address);
+        for (i = 0; i < BENCH_BURST; ++i) {
+            send_packet(udp_connection, &root_address);
+        }
+    }
+
+    printf("{\"type\":\"bench_done\",\"run\":%u,\"sent\":%lu,\"send_failed\":%lu}\n",
+           run_id,
+           (unsigned long)seq,
+           (unsigned long)n_send_failed);
+
+    PROCESS_END();
+}
@@ -0,0 +1,62 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 LumenRadio AB
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+#ifndef UDP_BENCHMARK_H
+#define UDP_BENCHMARK_H
+
+#include <mira.h>
+
+#define UDP_BENCHMARK_PORT 457
+
+/*
+ * Benchmark packet format, all fields little endian:
+ *
+ * <version> (1 byte, UDP_BENCHMARK_VERSION)
+ * <run id> (2 bytes, random per start of the sender)
+ * <sequence number> (4 bytes, starting at 0 for each run)
+ * <transmit time> (4 bytes, network time when sent, 0 if not known)
+ * Filler up to the configured payload size.
+ */
+#define UDP_BENCHMARK_VERSION 1
+#define UDP_BENCHMARK_HEADER_SIZE 11
+
+/* Same network settings for the sender and the receiver */
+#ifndef UDP_BENCHMARK_NET_RATE
+#define UDP_BENCHMARK_NET_RATE MIRA_NET_RATE_MID
+#endif
+
+#define UDP_BENCHMARK_PAN_ID 0x13243547
+
+#define UDP_BENCHMARK_KEY                                                                      \
+    {                                                                                          \
+        0x11, 0x12, 0x13, 0x14, 0x21, 0x22, 0x23, 0x24, 0x31, 0x32, 0x33, 0x34, 0x41, 0x42, \
+          0x43, 0x45                                                                         \
+    }
+
+/* Network time is assumed to run with 10ms ticks */
+#define UDP_BENCHMARK_NET_TIME_TICK_MS 10
+
+#endif